@@ -0,0 +1,37 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_bitarray.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures expanding (attach) and packing (sync) of CABitarray, and 
+#  count_true, any? and all? on the bits against a boolean array.
+#
+#    ruby benchmark/bench_bitarray.rb [bytes] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 5 ).to_i
+
+a = CArray.uint8(N).seq!.mul!(7919)
+bits = a.bits
+flags = bits.to_ca
+
+puts "bytes = #{N} (bits = #{8*N}), repeat = #{R}"
+puts
+
+Benchmark.bm(28) do |bm|
+  bm.report("expand (bits.to_ca)") { R.times { bits.to_ca } }
+  bm.report("pack (bits[] = boolean)") { R.times { bits[] = flags } }
+  bm.report("bits.count_true") { R.times { bits.count_true } }
+  bm.report("bits.any? / all?") { R.times { bits.any?; bits.all? } }
+  bm.report("boolean count_true") { R.times { flags.count_true } }
+end
@@ -0,0 +1,40 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_describe.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Compares CArray#describe (single pass) with the separate calls of 
+#  count_valid, min, max, min_addr, max_addr, sum, mean and variance.
+#
+#    ruby benchmark/bench_describe.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 5 ).to_i
+
+a = CArray.float64(N).seq!.sin!
+b = a.to_ca
+b[0] = UNDEF
+
+puts "elements = #{N}, repeat = #{R}"
+puts
+printf("  %-10s %12s %12s %8s\n", "", "separate [s]", "describe [s]", "ratio")
+[["no mask", a], ["masked", b]].each do |name, x|
+  t1 = Benchmark.realtime { 
+    R.times { 
+      [x.count_valid, x.min, x.max, x.min_addr, x.max_addr, 
+       x.sum, x.mean, x.variance]
+    }
+  }
+  t0 = Benchmark.realtime { R.times { x.describe } }
+  printf("  %-10s %12.4f %12.4f %8.2f\n", name, t1, t0, t1/t0)
+end
@@ -0,0 +1,40 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_group_reduce.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures group_reduce with dense (small integer) and hashed (float)
+#  keys against the loop over the groups by CArray#eq.
+#
+#    ruby benchmark/bench_group_reduce.rb [elements] [groups] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+G = ( ARGV[1] || 1000 ).to_i
+R = ( ARGV[2] || 5 ).to_i
+
+a = CArray.float64(N).seq!.sin!
+k = CArray.int32(N).seq!.mul!(7919).mod!(G)
+f = k.float64.div!(3)
+
+puts "elements = #{N}, groups = #{G}, repeat = #{R}"
+puts
+
+Benchmark.bm(28) do |bm|
+  bm.report("loop over groups (sum)") { 
+    (0...G).each { |g| a[k.eq(g)].sum } 
+  }
+  bm.report("group_reduce :sum") { R.times { a.group_reduce(k, :sum) } }
+  bm.report("group_reduce :mean") { R.times { a.group_reduce(k, :mean) } }
+  bm.report("group_reduce :max") { R.times { a.group_reduce(k, :max) } }
+  bm.report("group_reduce :sum (float key)") { R.times { a.group_reduce(f, :sum) } }
+end
@@ -0,0 +1,45 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_lazy.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Compares the eager evaluation of elementwise expressions, which creates
+#  an intermediate array for each operation, with the chunked evaluation
+#  by CALazy.
+#
+#    ruby benchmark/bench_lazy.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 10 ).to_i
+
+EXPRS = {
+  "a * b + c"           => lambda { |a, b, c| a * b + c },
+  "(a - b) * (a + b)"   => lambda { |a, b, c| (a - b) * (a + b) },
+  "(a * 2 + b).sqrt"    => lambda { |a, b, c| (a * 2 + b).sqrt },
+  "(a*a + b*b + c*c)/3" => lambda { |a, b, c| (a*a + b*b + c*c) / 3 },
+}
+
+puts "elements = #{N}, repeat = #{R}"
+puts
+
+[CA_FLOAT32, CA_FLOAT64].each do |type|
+  a, b, c = 3.times.map { CArray.new(type, [N]).seq!(1, 1.0/N) }
+  puts CArray.data_type_name(type)
+  printf("  %-22s %12s %12s %8s\n", "expr", "eager [s]", "lazy [s]", "ratio")
+  EXPRS.each do |name, expr|
+    t0 = Benchmark.realtime { R.times { expr[a, b, c] } }
+    t1 = Benchmark.realtime { R.times { expr[a.lazy, b.lazy, c.lazy].to_ca } }
+    printf("  %-22s %12.4f %12.4f %8.2f\n", name, t0, t1, t0/t1)
+  end
+  puts
+end
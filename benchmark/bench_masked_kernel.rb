@@ -0,0 +1,66 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_masked_kernel.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures the masked loops of the generated kernels (float32 add and 
+#  comparison) for a sparse mask, a mask of large masked blocks and a 
+#  dense random mask, a mask without masked elements (after unmask), and
+#  packing the mask by CArray#mask_bits. The dense mask is also measured
+#  with the packed mask (CArray.packed_mask) for the result only and for
+#  both of the operands and the result.
+#
+#    ruby benchmark/bench_masked_kernel.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 10 ).to_i
+
+a = CArray.float32(N).seq!
+b = CArray.float32(N).seq!
+
+sparse = a.to_ca
+sparse[CArray.int64(N/10_000).seq!.mul!(10_000)] = UNDEF
+blocks = a.to_ca
+blocks[(CArray.int64(N).seq! / 4096) % 2 == 1] = UNDEF
+clean = sparse.to_ca
+clean.unmask
+dense = a.to_ca
+dense[CArray.int64(N).seq!.mul!(7919).mod!(3) == 0] = UNDEF
+
+CArray.packed_mask = true
+packed = CArray.float32(N).seq!
+packed.mask_bits = dense.mask_bits
+packed_b = CArray.float32(N).seq!
+packed_b.mask_bits = sparse.mask_bits
+CArray.packed_mask = false
+
+puts "elements = #{N}, repeat = #{R}"
+puts "mask bytes = #{N} (mask array), #{8*((N+63)/64)} (packed mask)"
+puts
+
+Benchmark.bm(24) do |bm|
+  bm.report("add (no mask)") { R.times { a + b } }
+  bm.report("add (sparse mask)") { R.times { sparse + b } }
+  bm.report("add (masked blocks)") { R.times { blocks + b } }
+  bm.report("add (dense mask)") { R.times { dense + b } }
+  bm.report("add (clean mask)") { R.times { clean + b } }
+  bm.report("sum (clean mask)") { R.times { clean.sum } }
+  bm.report("gt (sparse mask)") { R.times { sparse > b } }
+  bm.report("mask_bits (dense mask)") { R.times { dense.mask_bits } }
+  CArray.packed_mask = true
+  bm.report("add (dense, packed out)") { R.times { dense + sparse } }
+  bm.report("add (dense, packed all)") { R.times { packed + packed_b } }
+  bm.report("count_masked (packed)") { R.times { packed.count_masked } }
+  CArray.packed_mask = false
+  bm.report("add (dense, mask array)") { R.times { dense + sparse } }
+end
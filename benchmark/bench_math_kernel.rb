@@ -0,0 +1,66 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_math_kernel.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Compares the contiguous mask-free loops of the kernels generated by
+#  ext/mkmath.rb with the general strided loops.
+#
+#  The general loop is taken when the operands have a mask array. 
+#  The mask array used here has no masked element, so both measurements
+#  give the same result. Note that the timings of the general loop also
+#  include the overhead of copying the mask array.
+#
+#    ruby benchmark/bench_math_kernel.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 10 ).to_i
+
+def unmasked (type)
+  CArray.new(type, [N]).seq!(1, 1.0/N)
+end
+
+def masked (type)
+  a = unmasked(type)
+  a.mask = 0                     ### mask exists, but nothing is masked
+  return a
+end
+
+OPS = {
+  "a + b"   => lambda { |a, b| a + b },
+  "a - b"   => lambda { |a, b| a - b },
+  "a * b"   => lambda { |a, b| a * b },
+  "a / b"   => lambda { |a, b| a / b },
+  "a * 2"   => lambda { |a, b| a * 2 },
+  "a < b"   => lambda { |a, b| a < b },
+  "a.sqrt"  => lambda { |a, b| a.sqrt },
+  "a.exp"   => lambda { |a, b| a.exp },
+  "a.add!(b)" => lambda { |a, b| a.add!(b) },
+}
+
+puts "elements = #{N}, repeat = #{R}"
+puts
+
+[CA_FLOAT32, CA_FLOAT64, CA_INT32].each do |type|
+  a0, b0 = unmasked(type), unmasked(type)
+  a1, b1 = masked(type), masked(type)
+  puts CArray.data_type_name(type)
+  printf("  %-12s %12s %12s %8s\n", "op", "general [s]", "contig [s]", "ratio")
+  OPS.each do |name, op|
+    next if type == CA_INT32 and name =~ /sqrt|exp/
+    t1 = Benchmark.realtime { R.times { op[a1, b1] } }
+    t0 = Benchmark.realtime { R.times { op[a0, b0] } }
+    printf("  %-12s %12.4f %12.4f %8.2f\n", name, t1, t0, t1/t0)
+  end
+  puts
+end
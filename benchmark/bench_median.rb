@@ -0,0 +1,37 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_median.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures median and percentile (whole array and along an axis) 
+#  against sorting the whole array.
+#
+#    ruby benchmark/bench_median.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 5 ).to_i
+
+a = CArray.float64(N).seq!.sin!
+n = Math.sqrt(N).to_i
+b = CArray.float64(n, n).seq!.sin!
+
+puts "elements = #{N}, repeat = #{R}"
+puts
+
+Benchmark.bm(28) do |bm|
+  bm.report("sort") { R.times { a.sort } }
+  bm.report("median") { R.times { a.median } }
+  bm.report("percentile(5,25,50,75,95)") { R.times { a.percentile(5, 25, 50, 75, 95) } }
+  bm.report("median(1) #{n}x#{n}") { R.times { b.median(1) } }
+  bm.report("percentile(25,75,axis:1)") { R.times { b.percentile(25, 75, axis: 1) } }
+end
@@ -0,0 +1,39 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_nlargest.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures nlargest and nlargest_addr (random and ascending data, 
+#  along an axis) against sorting the whole array.
+#
+#    ruby benchmark/bench_nlargest.rb [elements] [n] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+K = ( ARGV[1] || 1000 ).to_i
+R = ( ARGV[2] || 5 ).to_i
+
+a = CArray.float64(N).seq!.sin!
+s = CArray.float64(N).seq!
+m = Math.sqrt(N).to_i
+b = CArray.float64(m, m).seq!.sin!
+
+puts "elements = #{N}, n = #{K}, repeat = #{R}"
+puts
+
+Benchmark.bm(28) do |bm|
+  bm.report("sort") { R.times { a.sort } }
+  bm.report("nlargest") { R.times { a.nlargest(K) } }
+  bm.report("nlargest_addr") { R.times { a.nlargest_addr(K) } }
+  bm.report("nlargest (ascending)") { R.times { s.nlargest(K) } }
+  bm.report("nsmallest(10, 1) #{m}x#{m}") { R.times { b.nsmallest(10, 1) } }
+end
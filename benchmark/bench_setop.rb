@@ -0,0 +1,38 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_setop.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures isin, intersect1d, union1d and setdiff1d between int64 ID 
+#  arrays (the other array small and large) against Array#&.
+#
+#    ruby benchmark/bench_setop.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 3 ).to_i
+
+a = CArray.int64(N).seq!.mul!(7919).mod!(2*N)
+b = CArray.int64(N).seq!.mul!(104729).mod!(2*N)
+s = b[0...N/100].to_ca
+
+puts "elements = #{N}, repeat = #{R}"
+puts
+
+Benchmark.bm(28) do |bm|
+  bm.report("Array#& (once)") { a.to_a & b.to_a }
+  bm.report("isin (small other, hash)") { R.times { a.isin(s) } }
+  bm.report("isin (large other, merge)") { R.times { a.isin(b) } }
+  bm.report("intersect1d") { R.times { a.intersect1d(b) } }
+  bm.report("union1d") { R.times { a.union1d(b) } }
+  bm.report("setdiff1d") { R.times { a.setdiff1d(b) } }
+end
@@ -0,0 +1,49 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_shift.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures shifting and rolling arrays (CArray#shift, roll, roll! and
+#  storing through CAShift) as in time-stepping loops.
+#
+#    ruby benchmark/bench_shift.rb [size] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 2000 ).to_i
+R = ( ARGV[1] || 20 ).to_i
+
+a = CArray.float64(N, N).seq!
+b = CArray.float32(64, 64, 64).seq!
+
+puts "array = #{N}x#{N} (float64), 64x64x64 (float32), repeat = #{R}"
+puts
+
+Benchmark.bm(36) do |bm|
+  bm.report("shift(1, 0)") {
+    R.times { a.shift(1, 0) }
+  }
+  bm.report("shift(0, -1)") {
+    R.times { a.shift(0, -1) }
+  }
+  bm.report("roll(3, -5)") {
+    R.times { a.roll(3, -5) }
+  }
+  bm.report("roll!(3, -5)") {
+    R.times { a.roll!(3, -5) }
+  }
+  bm.report("shifted(1, 1)[] = a") {
+    R.times { a.shifted(1, 1)[] = a }
+  }
+  bm.report("roll(1, -1, 1) 3-D") {
+    (R*10).times { b.roll(1, -1, 1) }
+  }
+end
@@ -0,0 +1,55 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_simd_level.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Compares the ISA variants of the kernels selected by CArray.simd_level
+#  for each level supported by the CPU. Use an array fitting in the cache
+#  to see the difference of the instruction sets rather than the memory
+#  bandwidth.
+#
+#    ruby benchmark/bench_simd_level.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 100_000 ).to_i
+R = ( ARGV[1] || 1000 ).to_i
+
+a = CArray.float32(N).seq!(1, 1.0/N)
+b = CArray.float32(N).seq!(2, 1.0/N)
+i = CArray.int32(N).seq!
+c = CArray.float32(N)
+d = CArray.boolean(N)
+
+OPS = {
+  "a + b"      => lambda { a.add(b, out: c) },
+  "a * b"      => lambda { a.mul(b, out: c) },
+  "a.sqrt"     => lambda { a.sqrt(out: c) },
+  "a < b"      => lambda { a.lt(b, out: d) },
+  "i.float32"  => lambda { c[] = i },
+}
+
+puts "elements = #{N}, repeat = #{R}, detected = #{CArray.simd_level}"
+puts
+
+saved = CArray.simd_level
+printf("  %-12s", "op")
+CArray.simd_levels.each { |level| printf(" %10s", level) }
+puts
+OPS.each do |name, op|
+  printf("  %-12s", name)
+  CArray.simd_levels.each do |level|
+    CArray.simd_level = level
+    printf(" %10.4f", Benchmark.realtime { R.times { op[] } })
+  end
+  puts
+end
+CArray.simd_level = saved
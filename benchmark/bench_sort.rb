@@ -0,0 +1,49 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_sort.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures sort and sort_addr of integer and float arrays for the number 
+#  of threads 1, 2, 4, ... up to CArray.num_threads.
+#
+#    ruby benchmark/bench_sort.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 3 ).to_i
+
+i = CArray.int32(N).seq!.mul!(7919).add!(13)
+f = CArray.float32(N).seq!.sin!.mul!(1000)
+d = CArray.float64(N).seq!.sin!
+
+puts "elements = #{N}, repeat = #{R}"
+puts
+
+nmax = CArray.num_threads
+nthreads = [1]
+nthreads << nthreads.last*2 while nthreads.last*2 <= nmax
+
+printf("  %-8s %10s %10s %10s %10s %10s %10s\n", "threads", 
+       "int32", "float32", "float64", "addr:i32", "addr:f64", "with")
+nthreads.each do |n|
+  CArray.num_threads = n
+  t = [
+    Benchmark.realtime { R.times { i.sort } },
+    Benchmark.realtime { R.times { f.sort } },
+    Benchmark.realtime { R.times { d.sort } },
+    Benchmark.realtime { R.times { i.sort_addr } },
+    Benchmark.realtime { R.times { d.sort_addr } },
+    Benchmark.realtime { R.times { CA.sort_addr(i % 100, d) } },
+  ]
+  printf("  %-8i %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f\n", n, *t)
+end
+CArray.num_threads = nmax
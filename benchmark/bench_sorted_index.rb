@@ -0,0 +1,39 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_sorted_index.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures the batched lookups of CASortedIndex (section, bsearch and 
+#  lower_bound) against CArray#section and CArray#bsearch on the same keys.
+#
+#    ruby benchmark/bench_sorted_index.rb [keys] [queries] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 1_000_000 ).to_i
+M = ( ARGV[1] || 1_000_000 ).to_i
+R = ( ARGV[2] || 3 ).to_i
+
+x = CArray.float64(N).seq!.sqrt
+y = CArray.float64(M).seq!.mul!(7919).mod!(N).sqrt
+si = nil
+
+puts "keys = #{N}, queries = #{M}, repeat = #{R}"
+puts
+
+Benchmark.bm(28) do |bm|
+  bm.report("CASortedIndex.new") { R.times { si = x.sorted_index } }
+  bm.report("CArray#section") { R.times { x.section(y) } }
+  bm.report("CASortedIndex#section") { R.times { si.section(y) } }
+  bm.report("CArray#bsearch") { R.times { x.bsearch(y) } }
+  bm.report("CASortedIndex#bsearch") { R.times { si.bsearch(y) } }
+  bm.report("CASortedIndex#lower_bound") { R.times { si.lower_bound(y) } }
+end
@@ -0,0 +1,41 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_strided_view.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures the operators on the slices and the transposes (strided views
+#  operated without attaching) against the same operations on the copies.
+#
+#    ruby benchmark/bench_strided_view.rb [size] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 2000 ).to_i
+R = ( ARGV[1] || 10 ).to_i
+
+a = CArray.float64(N, N).seq!
+s = a[1..-2, [nil, 2]]
+t = a.transposed
+sc = s.to_ca
+tc = t.to_ca
+
+puts "array = #{N}x#{N}, repeat = #{R}"
+puts
+
+Benchmark.bm(28) do |bm|
+  bm.report("slice + 1") { R.times { s + 1 } }
+  bm.report("slice.to_ca + 1") { R.times { sc + 1 } }
+  bm.report("slice.add!(1)") { R.times { s.add!(1) } }
+  bm.report("slice > 0") { R.times { s > 0 } }
+  bm.report("transposed * transposed") { R.times { t * t } }
+  bm.report("transposed.to_ca * same") { R.times { tc * tc } }
+  bm.report("transposed + array") { R.times { t + tc } }
+end
@@ -0,0 +1,49 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_sum.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures sum, mean, variance and wsum for the number of threads 
+#  1, 2, 4, ... up to CArray.num_threads, and shows the error of the sum
+#  of float32 values against the exact sum.
+#
+#    ruby benchmark/bench_sum.rb [elements] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+R = ( ARGV[1] || 5 ).to_i
+
+a = CArray.float64(N).seq!.sin!
+f = CArray.float32(N) { 0.1 }
+x = [0.1].pack("f").unpack1("f")
+
+puts "elements = #{N}, repeat = #{R}"
+puts
+printf("  float32 sum error: %g\n", (f.sum - x*N).abs/(x*N))
+puts
+
+nmax = CArray.num_threads
+nthreads = [1]
+nthreads << nthreads.last*2 while nthreads.last*2 <= nmax
+
+printf("  %-8s %10s %10s %10s %10s\n", "threads", "sum", "mean", "variance", "wsum")
+nthreads.each do |n|
+  CArray.num_threads = n
+  t = [
+    Benchmark.realtime { R.times { a.sum } },
+    Benchmark.realtime { R.times { a.mean } },
+    Benchmark.realtime { R.times { a.variance } },
+    Benchmark.realtime { R.times { a.wsum(a) } },
+  ]
+  printf("  %-8i %10.4f %10.4f %10.4f %10.4f\n", n, *t)
+end
+CArray.num_threads = nmax
@@ -0,0 +1,54 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_transpose.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures copying transposed views (CATranspose#to_ca, storing through
+#  CATranspose and CArray#transpose!) for 2-D matrices and the (H,W,C) to
+#  (C,H,W) reorder of images.
+#
+#    ruby benchmark/bench_transpose.rb [height] [width] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+H = ( ARGV[0] || 2160 ).to_i
+W = ( ARGV[1] || 3840 ).to_i
+R = ( ARGV[2] || 5 ).to_i
+
+img = CArray.float32(H, W, 3).seq!
+mat = CArray.float64(H, W).seq!
+m8  = CArray.uint8(H, W).seq!
+chw = img.transposed(2, 0, 1).to_ca
+
+puts "image = #{H}x#{W}x3, repeat = #{R}"
+puts
+
+Benchmark.bm(36) do |bm|
+  bm.report("float32 (H,W,C) -> (C,H,W) to_ca") {
+    R.times { img.transposed(2, 0, 1).to_ca }
+  }
+  bm.report("float32 (C,H,W) -> (H,W,C) to_ca") {
+    R.times { chw.transposed(1, 2, 0).to_ca }
+  }
+  bm.report("float64 (H,W) transposed.to_ca") {
+    R.times { mat.transposed.to_ca }
+  }
+  bm.report("uint8 (H,W) transposed.to_ca") {
+    R.times { m8.transposed.to_ca }
+  }
+  bm.report("float64 transposed[] = x") {
+    x = mat.transposed.to_ca
+    R.times { mat.transposed[] = x }
+  }
+  bm.report("float64 transpose!") {
+    R.times { mat.transpose! }
+  }
+end
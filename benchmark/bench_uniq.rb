@@ -0,0 +1,41 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_uniq.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures uniq, uniq_counts and uniq_inverse (int32, float64 and fixlen)
+#  against Array#uniq.
+#
+#    ruby benchmark/bench_uniq.rb [elements] [distinct] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 10_000_000 ).to_i
+D = ( ARGV[1] || 100_000 ).to_i
+R = ( ARGV[2] || 5 ).to_i
+
+i = CArray.int32(N).seq!.mul!(7919).mod!(D)
+f = i.float64.div!(3)
+s = CArray.fixlen(N, :bytes => 8)
+s.load_binary(i.int64.to_s)
+
+puts "elements = #{N}, distinct = #{D}, repeat = #{R}"
+puts
+
+Benchmark.bm(28) do |bm|
+  bm.report("Array#uniq (int32)") { R.times { i.to_a.uniq } }
+  bm.report("uniq (int32)") { R.times { i.uniq } }
+  bm.report("uniq(sorted: true) (int32)") { R.times { i.uniq(sorted: true) } }
+  bm.report("uniq_counts (int32)") { R.times { i.uniq_counts } }
+  bm.report("uniq_inverse (int32)") { R.times { i.uniq_inverse } }
+  bm.report("uniq (float64)") { R.times { f.uniq } }
+  bm.report("uniq (fixlen 8 bytes)") { R.times { s.uniq } }
+end
@@ -0,0 +1,42 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_view_chain.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures creating and reading small views at the end of nested view
+#  chains (blocks of blocks, transposes of blocks, and so on) in a loop.
+#
+#    ruby benchmark/bench_view_chain.rb [size] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 1000 ).to_i
+R = ( ARGV[1] || 1000 ).to_i
+
+a = CArray.float64(N, N).seq!
+
+puts "array = #{N}x#{N}, repeat = #{R}"
+puts
+
+Benchmark.bm(36) do |bm|
+  bm.report("a[..][..][..].sum (blocks)") {
+    R.times { |i| a[1..-2, nil][0..99, 1..-2][i % 90, 0..9].sum }
+  }
+  bm.report("a.t.t[..][..] + 1") {
+    R.times { |i| a.transposed.transposed[i % 900..-1, nil][0..9, 0..9] + 1 }
+  }
+  bm.report("a.t[..].t[..].to_ca (4 levels)") {
+    R.times { |i| a.transposed[0..99, nil].transposed[i % 900, 0..9].to_ca }
+  }
+  bm.report("a.t[..].t[..][..].t.to_ca (6 levels)") {
+    R.times { |i| a.transposed[0..99, nil].transposed[i % 900..-1, nil][0..9, 0..9].transposed.to_ca }
+  }
+end
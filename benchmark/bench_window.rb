@@ -0,0 +1,48 @@
+# ----------------------------------------------------------------------------
+#
+#  benchmark/bench_window.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+#
+#  Measures attaching, storing and filling sliding windows (CAWindow) over
+#  an image, with windows mostly in the interior and at the boundary.
+#
+#    ruby benchmark/bench_window.rb [size] [tile] [repeat]
+#
+# ----------------------------------------------------------------------------
+
+require "carray"
+require "benchmark"
+
+N = ( ARGV[0] || 2000 ).to_i
+T = ( ARGV[1] || 64 ).to_i
+R = ( ARGV[2] || 2000 ).to_i
+
+img = CArray.float32(N, N).seq!
+pos = Array.new(R) { |i| [(i * 37) % (N - T), (i * 91) % (N - T)] }
+edge = Array.new(R) { |i| [(i * 37) % N - T/2, N - T/2] }
+
+puts "image = #{N}x#{N}, tile = #{T}x#{T}, repeat = #{R}"
+puts
+
+Benchmark.bm(36) do |bm|
+  bm.report("window.to_ca (interior)") {
+    pos.each { |i, j| img.window(i-2...i+T+2, j-2...j+T+2).to_ca }
+  }
+  bm.report("window.to_ca (reflect, boundary)") {
+    edge.each { |i, j| img.window(i...i+T, j...j+T, :bounds=>"reflect").to_ca }
+  }
+  bm.report("window.to_ca (full rows)") {
+    pos.each { |i, j| img.window(i...i+T, nil).to_ca }
+  }
+  bm.report("window[] = x (interior)") {
+    pos.each { |i, j| img.window(i...i+T, j...j+T)[] = 1.0 }
+  }
+  bm.report("window.add!(1) (periodic, boundary)") {
+    edge.each { |i, j| img.window(i...i+T, j...j+T, :bounds=>"periodic").add!(1) }
+  }
+end
@@ -251,6 +251,7 @@ carray_setup_i (CArray *ca,
   }
 
   ca->mask = NULL;
+  ca->mask_bits = NULL;
   if ( mask ) {
     ca_setup_mask(ca, mask);
   }
@@ -344,6 +345,7 @@ free_carray (void *ap)
   if ( ca != NULL ) {
     ca_mem_usage -= (double)(ca_length(ca));
     ca_free(ca->mask);
+    free(ca->mask_bits);
     free(ca->ptr);
     xfree(ca->dim);
     xfree(ca);
@@ -357,6 +359,7 @@ free_ca_wrap (void *ap)
   if ( ca != NULL ) {
     /* free(ca->ptr); */ /* don't free ca->ptr for CAWrap */
     ca_free(ca->mask);
+    free(ca->mask_bits);
     xfree(ca->dim);
     xfree(ca);
   }
@@ -450,6 +453,9 @@ ca_array_func_clone (void *ap)
   CArray *ca = (CArray *) ap;
   CArray *co;
   co = carray_new(ca->data_type, ca->ndim, ca->dim, ca->bytes, ca->mask);
+  if ( ca->mask_bits ) {
+    ca_setup_mask_bits(co, ca->mask_bits);
+  }
   memcpy(co->ptr, ca->ptr, ca_length(ca));
   return co;
 }
@@ -609,6 +615,11 @@ ca_array_func_create_mask (void *ap)
 {
   CArray *ca = (CArray *) ap;
   ca->mask = carray_new_safe(CA_BOOLEAN, ca->ndim, ca->dim, 0, NULL);
+  if ( ca->mask_bits ) {         /* expands the packed mask */
+    ca_mask_unpack(ca->mask_bits, ca->elements, (boolean8_t *) ca->mask->ptr);
+    free(ca->mask_bits);
+    ca->mask_bits = NULL;
+  }
 }
 
 ca_operation_function_t ca_array_func = {
@@ -1019,8 +1030,14 @@ rb_ca_initialize_copy (VALUE self, VALUE other)
   TypedData_Get_Struct(self,  CArray, &carray_data_type, ca);
   TypedData_Get_Struct(other, CArray, &carray_data_type, cs);
 
-  ca_update_mask(cs);
-  carray_setup(ca, cs->data_type, cs->ndim, cs->dim, cs->bytes, cs->mask);
+  if ( ca_mask_is_packed(cs) ) {
+    carray_setup(ca, cs->data_type, cs->ndim, cs->dim, cs->bytes, NULL);
+    ca_setup_mask_bits(ca, cs->mask_bits);
+  }
+  else {
+    ca_update_mask(cs);
+    carray_setup(ca, cs->data_type, cs->ndim, cs->dim, cs->bytes, cs->mask);
+  }
 
   memcpy(ca->ptr, cs->ptr, ca_length(cs));
 
@@ -357,94 +357,107 @@ ca_operation_function_t ca_bitarray_func = {
 
 /* ------------------------------------------------------------------- */
 
+/*
+  The bits are expanded and packed by a byte (8 elements) at a time.
+  ca_bit_expand[b] holds the 8 boolean bytes of the byte b in the memory
+  order, so a byte is expanded by storing a word, and 8 boolean bytes are
+  packed by ca_mask_byte8() (see carray.h). The loops over the bytes of
+  the parent run on the worker pool for large arrays.
+*/
+
+static uint64_t ca_bit_expand[256];
+
 static void
-ca_bitarray_attach (CABitarray *ca)
+ca_bit_expand_setup (void)
 {
-  boolean8_t *p = (boolean8_t *)ca_ptr_at_addr(ca, 0);
-  uint8_t *q = (uint8_t *)ca_ptr_at_addr(ca->parent, 0);
-  uint8_t *r;
-  uint8_t rr;
-  ca_size_t elements = ca->parent->elements;
-  ca_size_t bytes = ca->parent->bytes;
-  ca_size_t n, m;
-  if ( ca_endian == CA_BIG_ENDIAN &&
-       ca->parent->bytes != 1 &&
-       ( ! ca_is_fixlen_type(ca->parent) ) ) {
-    n = elements;
-    while ( n-- ) {
-      m = bytes;
-      r = q + bytes - 1;
-      while ( m-- ) {
-        rr = *r;
-        *p++ = (rr & 1);
-        *p++ = (rr & 2)   >> 1;
-        *p++ = (rr & 4)   >> 2;
-        *p++ = (rr & 8)   >> 3;
-        *p++ = (rr & 16)  >> 4;
-        *p++ = (rr & 32)  >> 5;
-        *p++ = (rr & 64)  >> 6;
-        *p++ = (rr & 128) >> 7;
-        r--;
-      }
-      q += bytes;
+  uint8_t v[8];
+  int b, i;
+  for (b=0; b<256; b++) {
+    for (i=0; i<8; i++) {
+      v[i] = ( b >> i ) & 1;
+    }
+    memcpy(&ca_bit_expand[b], v, 8);
+  }
+}
+
+/* for big endian, the bytes of each element are taken in reversed order */
+
+#define ca_bitarray_is_swapped(ca) \
+  ( ca_endian == CA_BIG_ENDIAN && \
+    (ca)->parent->bytes != 1 && \
+    ( ! ca_is_fixlen_type((ca)->parent) ) )
+
+typedef struct {
+  boolean8_t *p;
+  uint8_t    *q;
+  ca_size_t   bytes;
+  int         swapped;
+} ca_bitarray_job_t;
+
+static void
+ca_bitarray_expand_body (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_bitarray_job_t *job = (ca_bitarray_job_t *) arg;
+  boolean8_t *p = job->p + 8*start;
+  uint8_t *q = job->q;
+  ca_size_t bytes = job->bytes;
+  ca_size_t k;
+  if ( job->swapped ) {
+    for (k=start; k<end; k++, p+=8) {
+      memcpy(p, &ca_bit_expand[q[(k/bytes)*bytes + bytes - 1 - k%bytes]], 8);
     }
   }
   else {
-    n = elements * bytes;
-    while ( n-- ) {
-      rr = *q++;
-      *p++ = (rr & 1);
-      *p++ = (rr & 2)   >> 1;
-      *p++ = (rr & 4)   >> 2;
-      *p++ = (rr & 8)   >> 3;
-      *p++ = (rr & 16)  >> 4;
-      *p++ = (rr & 32)  >> 5;
-      *p++ = (rr & 64)  >> 6;
-      *p++ = (rr & 128) >> 7;
+    for (k=start; k<end; k++, p+=8) {
+      memcpy(p, &ca_bit_expand[q[k]], 8);
     }
   }
 }
 
 static void
-ca_bitarray_sync (CABitarray *ca)
+ca_bitarray_pack_body (ca_size_t start, ca_size_t end, void *arg)
 {
-  boolean8_t *p = (boolean8_t *)ca_ptr_at_addr(ca, 0);
-  uint8_t *q = (uint8_t *)ca_ptr_at_addr(ca->parent, 0);
-  uint8_t *r;
-  ca_size_t elements = ca->parent->elements;
-  ca_size_t bytes = ca->parent->bytes;
-  ca_size_t n, m, i;
-  if ( ca_endian == CA_BIG_ENDIAN &&
-       ca->parent->bytes != 1 &&
-       ( ! ca_is_fixlen_type(ca->parent) ) ) {
-    n = elements;
-    while ( n-- ) {
-      m = bytes;
-      r = q + bytes - 1;
-      while ( m-- ) {
-        *r = 0;
-        for (i=0; i<8; i++) {
-          *r += (*p) * bits[i];
-          p++;
-        }
-        r--;
-      }
-      q += bytes;
+  ca_bitarray_job_t *job = (ca_bitarray_job_t *) arg;
+  boolean8_t *p = job->p + 8*start;
+  uint8_t *q = job->q;
+  ca_size_t bytes = job->bytes;
+  ca_size_t k;
+  if ( job->swapped ) {
+    for (k=start; k<end; k++, p+=8) {
+      q[(k/bytes)*bytes + bytes - 1 - k%bytes] = (uint8_t) ca_mask_byte8(p);
     }
   }
   else {
-    n = elements * bytes;
-    while ( n-- ) {
-      *q = 0;
-      for (i=0; i<8; i++) {
-        *q += (*p) * bits[i];
-        p++;
-      }
-      q++;
+    for (k=start; k<end; k++, p+=8) {
+      q[k] = (uint8_t) ca_mask_byte8(p);
     }
   }
 }
 
+static void
+ca_bitarray_attach (CABitarray *ca)
+{
+  ca_bitarray_job_t job;
+  job.p       = (boolean8_t *) ca_ptr_at_addr(ca, 0);
+  job.q       = (uint8_t *) ca_ptr_at_addr(ca->parent, 0);
+  job.bytes   = ca->parent->bytes;
+  job.swapped = ca_bitarray_is_swapped(ca);
+  ca_parallel_for(ca->parent->elements * ca->parent->bytes, 1,
+                  ca_bitarray_expand_body, &job);
+}
+
+static void
+ca_bitarray_sync (CABitarray *ca)
+{
+  ca_bitarray_job_t job;
+  job.p       = (boolean8_t *) ca_ptr_at_addr(ca, 0);
+  job.q       = (uint8_t *) ca_ptr_at_addr(ca->parent, 0);
+  job.bytes   = ca->parent->bytes;
+  job.swapped = ca_bitarray_is_swapped(ca);
+  ca_parallel_for(ca->parent->elements * ca->parent->bytes, 1,
+                  ca_bitarray_pack_body, &job);
+}
+
 static void
 ca_bitarray_fill (CABitarray *ca, char *ptr)
 {
@@ -492,6 +505,138 @@ rb_ca_bitarray (VALUE self)
   return obj;
 }
 
+/* ------------------------------------------------------------------- */
+
+/*
+  count_true, any? and all? of CABitarray count the bits of the parent
+  directly by popcount without expanding them. The bits of a masked
+  element of the parent are all masked in the bitarray.
+*/
+
+typedef struct {
+  uint8_t    *q;
+  boolean8_t *m;
+  ca_size_t   bytes;
+  ca_size_t   count[CA_PARALLEL_THREADS_MAX];
+  ca_size_t   valid[CA_PARALLEL_THREADS_MAX];
+} ca_bitarray_count_t;
+
+static ca_size_t
+ca_popcount_bytes (const uint8_t *q, ca_size_t n)
+{
+  uint64_t w;
+  ca_size_t k, count = 0;
+  for (k=0; k+8<=n; k+=8) {
+    memcpy(&w, q + k, 8);
+    count += ca_popcount64(w);
+  }
+  for (; k<n; k++) {
+    count += ca_popcount64(q[k]);
+  }
+  return count;
+}
+
+static void
+ca_bitarray_count_body (int chunk, ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_bitarray_count_t *job = (ca_bitarray_count_t *) arg;
+  ca_size_t bytes = job->bytes;
+  ca_size_t i, count = 0, valid = 0;
+  if ( job->m ) {
+    for (i=start; i<end; i++) {
+      if ( ! job->m[i] ) {
+        count += ca_popcount_bytes(job->q + i*bytes, bytes);
+        valid++;
+      }
+    }
+  }
+  else {
+    count = ca_popcount_bytes(job->q + start*bytes, (end-start)*bytes);
+    valid = end - start;
+  }
+  job->count[chunk] = count;
+  job->valid[chunk] = valid;
+}
+
+/* returns the number of true bits, and the number of unmasked bits
+   to *nvalid */
+
+static ca_size_t
+ca_bitarray_count (CABitarray *ca, ca_size_t *nvalid)
+{
+  ca_bitarray_count_t job;
+  CArray *parent = ca->parent;
+  ca_size_t count = 0, valid = 0;
+  int i, nchunk;
+
+  ca_attach(parent);
+  job.q     = (uint8_t *) parent->ptr;
+  job.m     = ca_mask_ptr_any(parent);
+  job.bytes = parent->bytes;
+  nchunk = ca_parallel_reduce(parent->elements, 1,
+                              ca_bitarray_count_body, &job);
+  ca_detach(parent);
+
+  for (i=0; i<nchunk; i++) {
+    count += job.count[i];
+    valid += job.valid[i];
+  }
+
+  *nvalid = valid * ca->bitlen;
+  return count;
+}
+
+static CABitarray *
+rb_ca_bitarray_get (VALUE self)
+{
+  CABitarray *ca;
+  TypedData_Get_Struct(self, CABitarray, &cabitarray_data_type, ca);
+  return ca;
+}
+
+/* @overload count_true
+
+Returns the number of true bits (the masked bits are not counted),
+counted by popcount without expanding the bits. With the arguments
+(min_count, fill_value), same as CArray#count_true.
+*/
+
+static VALUE
+rb_ca_bitarray_count_true (int argc, VALUE *argv, VALUE self)
+{
+  ca_size_t nvalid;
+  if ( argc > 0 ) {
+    return rb_call_super(argc, argv);
+  }
+  return SIZE2NUM(ca_bitarray_count(rb_ca_bitarray_get(self), &nvalid));
+}
+
+/* @overload any?
+
+Returns true if any of the bits (not masked) is true.
+*/
+
+static VALUE
+rb_ca_bitarray_is_any (VALUE self)
+{
+  ca_size_t nvalid;
+  return ( ca_bitarray_count(rb_ca_bitarray_get(self), &nvalid) > 0 ) ?
+                                                             Qtrue : Qfalse;
+}
+
+/* @overload all?
+
+Returns true if all of the bits (not masked) are true.
+*/
+
+static VALUE
+rb_ca_bitarray_is_all (VALUE self)
+{
+  ca_size_t nvalid;
+  return ( ca_bitarray_count(rb_ca_bitarray_get(self), &nvalid) == nvalid ) ?
+                                                             Qtrue : Qfalse;
+}
+
 static VALUE
 rb_ca_bitarray_s_allocate (VALUE klass)
 {
@@ -529,5 +674,12 @@ Init_ca_obj_bitarray ()
   rb_define_alloc_func(rb_cCABitarray, rb_ca_bitarray_s_allocate);
   rb_define_method(rb_cCABitarray, "initialize_copy",
                                       rb_ca_bitarray_initialize_copy, 1);
+
+  rb_define_method(rb_cCABitarray, "count_true",
+                                      rb_ca_bitarray_count_true, -1);
+  rb_define_method(rb_cCABitarray, "any?", rb_ca_bitarray_is_any, 0);
+  rb_define_method(rb_cCABitarray, "all?", rb_ca_bitarray_is_all, 0);
+
+  ca_bit_expand_setup();
 }
 
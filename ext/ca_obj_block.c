@@ -337,6 +337,65 @@ ca_operation_function_t ca_block_func = {
 
 /* ------------------------------------------------------------------- */
 
+/*
+  The block of a CABlock (or of a CARefer which reshapes without
+  reinterpreting the elements) is folded into the block of the
+  grandparent, so that nested slices such as a[10..99, nil][0..9, 2..5]
+  do not build a chain of views to be walked on every access and attach.
+  The arguments are updated for the grandparent, and 0 is returned if
+  the views do not compose. The folding is done on the C structure only,
+  CArray#parent still returns the array sliced (which keeps the root
+  array alive).
+*/
+
+static int
+ca_block_fold (CArray **parentp, int8_t ndim, ca_size_t *dim,
+               ca_size_t *start, ca_size_t *step, ca_size_t *offset)
+{
+  CArray *parent = *parentp;
+  int8_t i;
+
+  /* the attached parent may hold the elements not synchronized yet,
+     and the value array hides the mask of its parent */
+  if ( ca_is_entity(parent) || ca_is_attached(parent) ||
+       ca_is_readonly(parent) || ca_is_value_array(parent) ) {
+    return 0;
+  }
+
+  if ( parent->obj_type == CA_OBJ_BLOCK ) {
+    CABlock *cb = (CABlock *) parent;
+    if ( *offset != 0 || ndim != cb->ndim ) {
+      return 0;
+    }
+    for (i=0; i<ndim; i++) {
+      if ( dim[i] != cb->count[i] ) {
+        return 0;
+      }
+    }
+    for (i=0; i<ndim; i++) {
+      start[i] = cb->start[i] + start[i] * cb->step[i];
+      step[i] *= cb->step[i];
+      dim[i]   = cb->size0[i];
+    }
+    *offset  = cb->offset;
+    *parentp = cb->parent;
+  }
+  else if ( parent->obj_type == CA_OBJ_REFER ) {
+    CARefer *cr = (CARefer *) parent;
+    if ( ( cr->is_deformed != 0 && cr->is_deformed != 1 ) ||
+         cr->data_type != cr->parent->data_type ) {
+      return 0;
+    }
+    *offset += cr->offset;
+    *parentp = cr->parent;
+  }
+  else {
+    return 0;
+  }
+
+  return 1;
+}
+
 VALUE
 rb_ca_block_new (VALUE cary, int8_t ndim, ca_size_t *dim,
                 ca_size_t *start, ca_size_t *step, ca_size_t *count, ca_size_t offset)
@@ -344,10 +403,19 @@ rb_ca_block_new (VALUE cary, int8_t ndim, ca_size_t *dim,
   volatile VALUE obj;
   CArray *parent;
   CABlock *ca;
+  ca_size_t dim0[CA_RANK_MAX], start0[CA_RANK_MAX], step0[CA_RANK_MAX];
 
   rb_check_carray_object(cary);
   TypedData_Get_Struct(cary, CArray, &carray_data_type, parent);
-  ca = ca_block_new(parent, ndim, dim, start, step, count, offset);
+
+  memcpy(dim0,   dim,   ndim * sizeof(ca_size_t));
+  memcpy(start0, start, ndim * sizeof(ca_size_t));
+  memcpy(step0,  step,  ndim * sizeof(ca_size_t));
+  while ( ca_block_fold(&parent, ndim, dim0, start0, step0, &offset) ) {
+    ;
+  }
+
+  ca = ca_block_new(parent, ndim, dim0, start0, step0, count, offset);
   obj = ca_wrap_struct(ca);
   rb_ca_set_parent(obj, cary);
   rb_ca_data_type_inherit(obj, cary);
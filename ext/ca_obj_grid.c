@@ -126,7 +126,7 @@ ca_grid_setup (CAGrid *ca, CArray *parent, ca_size_t *dim,
           boolean8_t *m;
           ca_size_t n;
           ca->grid[i] = carray_new(CA_SIZE, 1, &gsize, 0, NULL);
-          m = (boolean8_t *)grid[i]->mask->ptr;
+          m = ca_mask_ptr(grid[i]);
           n = 0;
           for (j=0; j<grid[i]->elements; j++) {
             if ( ! *m ) {
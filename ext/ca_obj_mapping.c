@@ -354,221 +354,126 @@ ca_operation_function_t ca_mapping_func = {
 
 /* ------------------------------------------------------------------- */
 
-static void
-ca_mapping_attach (CAMapping *ca)
-{
-  ca_size_t *ip = (ca_size_t*) ca_ptr_at_addr(ca->mapper, 0);
-  ca_size_t i;
+/*
+  The loops of attach, sync and fill are processed by the worker pool
+  without GVL for large arrays (see carray_parallel.c), except for
+  CA_OBJECT.
+*/
 
-#define proc_mapping_attach(type) \
+typedef struct {
+  ca_size_t  bytes;
+  ca_size_t *ip;    /* mapper */
+  char      *p;     /* data of mapping array */
+  char      *q;     /* data of parent */
+  char      *fval;  /* fill value */
+} ca_mapping_loop_t;
+
+#define proc_mapping_loop(type, expr) \
   { \
-    type *p = (type*)ca_ptr_at_addr(ca, 0); \
-    type *q = (type*)ca_ptr_at_addr(ca->parent, 0); \
-    for (i=0; i<ca->elements; i++) { \
-      *(p+i) = *(q+(*(ip+i))); \
+    type *p = (type *) c->p; \
+    type *q = (type *) c->q; \
+    type fval = ( c->fval ) ? *(type *) c->fval : 0; \
+    for (i=start; i<end; i++) { \
+      expr; \
     } \
+    (void) p; (void) q; (void) fval; \
   }
-  
-  switch ( ca->bytes ) {
-  case 1: 
-    { 
-      int8_t *p = (int8_t *)ca_ptr_at_addr(ca, 0); 
-      int8_t *q = (int8_t *)ca_ptr_at_addr(ca->parent, 0); 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(p+i) = *(q+(*(ip+i))); 
-      }
-      break;
-    }
-  case 2: 
-    { 
-      int16_t *p = (int16_t *)ca_ptr_at_addr(ca, 0); 
-      int16_t *q = (int16_t *)ca_ptr_at_addr(ca->parent, 0); 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(p+i) = *(q+(*(ip+i))); 
-      } 
-      break;
-    }
-  case 4: 
-    { 
-      int32_t *p = (int32_t *)ca_ptr_at_addr(ca, 0); 
-      int32_t *q = (int32_t *)ca_ptr_at_addr(ca->parent, 0); 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(p+i) = *(q+(*(ip+i))); 
-      } 
-      break;
-    }
-  case 8: 
-    { 
-      float64_t *p = (float64_t *)ca_ptr_at_addr(ca, 0); 
-      float64_t *q = (float64_t *)ca_ptr_at_addr(ca->parent, 0); 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(p+i) = *(q+(*(ip+i))); 
-      } 
-      break;
-    }
+
+static void
+ca_mapping_attach_chunk (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_mapping_loop_t *c = (ca_mapping_loop_t *) arg;
+  ca_size_t *ip = c->ip;
+  ca_size_t i;
+
+  switch ( c->bytes ) {
+  case 1: proc_mapping_loop(int8_t,    *(p+i) = *(q+(*(ip+i)))); break;
+  case 2: proc_mapping_loop(int16_t,   *(p+i) = *(q+(*(ip+i)))); break;
+  case 4: proc_mapping_loop(int32_t,   *(p+i) = *(q+(*(ip+i)))); break;
+  case 8: proc_mapping_loop(float64_t, *(p+i) = *(q+(*(ip+i)))); break;
   default:
-    {
-      char *p = ca_ptr_at_addr(ca, 0);
-      char *q = ca_ptr_at_addr(ca->parent, 0);
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) {
-        memcpy(p + i * ca->bytes, q + (*(ip+i)) * ca->bytes, ca->bytes);
-      }
+    for (i=start; i<end; i++) {
+      memcpy(c->p + i * c->bytes, c->q + (*(ip+i)) * c->bytes, c->bytes);
     }
   }
 }
 
 static void
-ca_mapping_sync (CAMapping *ca)
+ca_mapping_sync_chunk (ca_size_t start, ca_size_t end, void *arg)
 {
-  ca_size_t *ip = (ca_size_t*) ca_ptr_at_addr(ca->mapper, 0);
+  ca_mapping_loop_t *c = (ca_mapping_loop_t *) arg;
+  ca_size_t *ip = c->ip;
   ca_size_t i;
 
-  switch ( ca->bytes ) {
-  case 1: 
-    { 
-      int8_t *p = (int8_t *)ca_ptr_at_addr(ca, 0); 
-      int8_t *q = (int8_t *)ca_ptr_at_addr(ca->parent, 0); 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(q+*(ip+i)) = *(p+i); 
-      } 
-      break;
-    }
-  case 2: 
-    { 
-      int16_t *p = (int16_t *)ca_ptr_at_addr(ca, 0); 
-      int16_t *q = (int16_t *)ca_ptr_at_addr(ca->parent, 0); 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(q+*(ip+i)) = *(p+i); 
-      } 
-      break;
-    }
-  case 4: 
-    { 
-      int32_t *p = (int32_t *)ca_ptr_at_addr(ca, 0); 
-      int32_t *q = (int32_t *)ca_ptr_at_addr(ca->parent, 0); 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(q+*(ip+i)) = *(p+i); 
-      } 
-      break;
-    }
-  case 8: 
-    { 
-      float64_t *p = (float64_t *)ca_ptr_at_addr(ca, 0); 
-      float64_t *q = (float64_t *)ca_ptr_at_addr(ca->parent, 0); 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(q+*(ip+i)) = *(p+i); 
-      } 
-      break;
-    }
+  switch ( c->bytes ) {
+  case 1: proc_mapping_loop(int8_t,    *(q+*(ip+i)) = *(p+i)); break;
+  case 2: proc_mapping_loop(int16_t,   *(q+*(ip+i)) = *(p+i)); break;
+  case 4: proc_mapping_loop(int32_t,   *(q+*(ip+i)) = *(p+i)); break;
+  case 8: proc_mapping_loop(float64_t, *(q+*(ip+i)) = *(p+i)); break;
   default:
-    {
-      char *p = ca_ptr_at_addr(ca, 0);
-      char *q = ca_ptr_at_addr(ca->parent, 0);
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) {
-        memcpy(q + (*(ip+i)) * ca->bytes, p + i * ca->bytes, ca->bytes);
-      }
+    for (i=start; i<end; i++) {
+      memcpy(c->q + (*(ip+i)) * c->bytes, c->p + i * c->bytes, c->bytes);
     }
   }
 }
 
 static void
-ca_mapping_fill (CAMapping *ca, char *ptr)
+ca_mapping_fill_chunk (ca_size_t start, ca_size_t end, void *arg)
 {
-  ca_size_t *ip = (ca_size_t*) ca_ptr_at_addr(ca->mapper, 0);
+  ca_mapping_loop_t *c = (ca_mapping_loop_t *) arg;
+  ca_size_t *ip = c->ip;
   ca_size_t i;
 
-  switch ( ca->bytes ) {
-  case 1: 
-    { 
-      int8_t *q = (int8_t *)ca_ptr_at_addr(ca->parent, 0); 
-      int8_t fval = *(int8_t *)ptr; 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(q+*(ip+i)) = fval; 
-      } 
-      break;
-    }
-  case 2: 
-    { 
-      int16_t *q = (int16_t *)ca_ptr_at_addr(ca->parent, 0); 
-      int16_t fval = *(int16_t *)ptr; 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(q+*(ip+i)) = fval; 
-      } 
-      break;
-    }
-  case 4: 
-    { 
-      int32_t *q = (int32_t *)ca_ptr_at_addr(ca->parent, 0); 
-      int32_t fval = *(int32_t *)ptr; 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(q+*(ip+i)) = fval; 
-      } 
-      break;
-    }
-  case 8: 
-    { 
-      float64_t *q = (float64_t *)ca_ptr_at_addr(ca->parent, 0); 
-      float64_t fval = *(float64_t *)ptr; 
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) { 
-        *(q+*(ip+i)) = fval; 
-      } 
-      break;
-    }
+  switch ( c->bytes ) {
+  case 1: proc_mapping_loop(int8_t,    *(q+*(ip+i)) = fval); break;
+  case 2: proc_mapping_loop(int16_t,   *(q+*(ip+i)) = fval); break;
+  case 4: proc_mapping_loop(int32_t,   *(q+*(ip+i)) = fval); break;
+  case 8: proc_mapping_loop(float64_t, *(q+*(ip+i)) = fval); break;
   default:
-    {
-      char *q = ca_ptr_at_addr(ca->parent, 0);
-      #ifdef _OPENMP
-      #pragma omp parallel for
-      #endif
-      for (i=0; i<ca->elements; i++) {
-        memcpy(q + (*(ip+i)) * ca->bytes, ptr, ca->bytes);
-      }
+    for (i=start; i<end; i++) {
+      memcpy(c->q + (*(ip+i)) * c->bytes, c->fval, c->bytes);
     }
   }
 }
 
+#undef proc_mapping_loop
+
+static void
+ca_mapping_attach (CAMapping *ca)
+{
+  ca_mapping_loop_t c = { ca->bytes, 
+                          (ca_size_t *) ca_ptr_at_addr(ca->mapper, 0),
+                          ca_ptr_at_addr(ca, 0),
+                          ca_ptr_at_addr(ca->parent, 0),
+                          NULL };
+  ca_parallel_for(ca->elements, ! ca_is_object_type(ca), 
+                  ca_mapping_attach_chunk, &c);
+}
+
+static void
+ca_mapping_sync (CAMapping *ca)
+{
+  ca_mapping_loop_t c = { ca->bytes, 
+                          (ca_size_t *) ca_ptr_at_addr(ca->mapper, 0),
+                          ca_ptr_at_addr(ca, 0),
+                          ca_ptr_at_addr(ca->parent, 0),
+                          NULL };
+  /* serial, the last one wins for the duplicated entries of the mapper */
+  ca_mapping_sync_chunk(0, ca->elements, &c);
+}
+
+static void
+ca_mapping_fill (CAMapping *ca, char *ptr)
+{
+  ca_mapping_loop_t c = { ca->bytes, 
+                          (ca_size_t *) ca_ptr_at_addr(ca->mapper, 0),
+                          NULL,
+                          ca_ptr_at_addr(ca->parent, 0),
+                          ptr };
+  ca_parallel_for(ca->elements, ! ca_is_object_type(ca), 
+                  ca_mapping_fill_chunk, &c);
+}
+
 /* ------------------------------------------------------------------- */
 
 VALUE
@@ -142,19 +142,6 @@ static void ca_shift_attach (CAShift *ca);
 static void ca_shift_sync (CAShift *ca);
 static void ca_shift_fill (CAShift *ca, char *ptr);
 
-static ca_size_t
-ca_shift_normalized_roll_shift (CAShift *ca, ca_size_t i)
-{
-  ca_size_t dim   = ca->dim[i];
-  ca_size_t shift = ca->shift[i];
-  if ( shift >= 0 ) {
-    return shift % dim;
-  }
-  else {
-    return -((-shift) % dim);
-  }
-}
-
 static ca_size_t
 ca_shift_rolled_index (CAShift *ca, ca_size_t i, ca_size_t k)
 {
@@ -416,401 +403,228 @@ ca_operation_function_t ca_shift_func = {
 
 /* ------------------------------------------------------------------- */
 
+/*
+  A shift (or roll) along a dimension moves at most two contiguous
+  segments of the indices, the rest is filled. The segments are
+  precomputed for each dimension as (dst, src, len) with src = -1 for the
+  filled segment, and the dimensions after the last shifted one are
+  merged into the element, so that the innermost segments are moved by
+  memcpy and filled by ca_shift_memfill() in one call.
+*/
+
+typedef struct {
+  ca_size_t dst;
+  ca_size_t src;     /* -1 for fill */
+  ca_size_t len;
+} ca_shift_seg_t;
+
+typedef struct {
+  int8_t         ndim;    /* dimensions up to the last shifted one */
+  ca_size_t      bytes;
+  char          *fill;
+  int            nseg[CA_RANK_MAX];
+  ca_shift_seg_t seg[CA_RANK_MAX][2];
+  ca_size_t      stride[CA_RANK_MAX];  /* in bytes */
+} ca_shift_plan_t;
+
 static void
-ca_shift_attach_loop (CAShift *ca, int16_t level, ca_size_t *idx, ca_size_t *idx0,
-                                                                  int32_t fill)
+ca_shift_plan_setup (ca_shift_plan_t *w, int8_t ndim, ca_size_t *dim,
+                     ca_size_t bytes, ca_size_t *shift, int8_t *roll,
+                     char *fill)
 {
-  ca_size_t dim   = ca->dim[level];
-  ca_size_t shift = ca->shift[level];
-  int8_t roll = ca->roll[level];
-  ca_size_t i;
+  ca_shift_seg_t *seg;
+  ca_size_t d, s, m, stride;
+  int8_t i, last = 0;
 
-  if ( level == ca->ndim - 1 ) {
-    if ( fill ) {
-      for (i=0; i<ca->dim[level]; i++) {
-        idx[level] = i;
-        memcpy(ca_ptr_at_index(ca, idx), ca->fill, ca->bytes);
-      }
-    }
-    else if ( ! shift ) {
-      idx[level] = 0;
-      idx0[level] = 0;
-      memcpy(ca_ptr_at_index(ca, idx), ca_ptr_at_index(ca->parent, idx0), dim * ca->bytes);
-    }
-    else if ( roll ) {
-      shift = ca_shift_normalized_roll_shift(ca, level);
-      if ( shift > 0 ) {
-        idx[level] = 0;
-        idx0[level] = dim-shift;
-        memcpy(ca_ptr_at_index(ca,idx), ca_ptr_at_index(ca->parent,idx0), shift*ca->bytes);
-        idx[level] = shift;
-        idx0[level] = 0;
-        memcpy(ca_ptr_at_index(ca,idx), ca_ptr_at_index(ca->parent,idx0), (dim-shift)*ca->bytes);
-      }
-      else {
-        idx[level]  = 0;
-        idx0[level] = -shift;
-        memcpy(ca_ptr_at_index(ca,idx), ca_ptr_at_index(ca->parent,idx0), (dim+shift)*ca->bytes);
-        idx[level] = dim + shift;
-        idx0[level] = 0;
-        memcpy(ca_ptr_at_index(ca,idx), ca_ptr_at_index(ca->parent,idx0), (-shift)*ca->bytes);
-      }
-    }
-    else {
-      if ( shift > 0 ) {
-        shift = ( shift >= dim ) ? dim : shift;
-
-        for (i=0; i<shift; i++) {
-          idx[level] = i;
-          memcpy(ca_ptr_at_index(ca, idx), ca->fill, ca->bytes);
-        }
-
-        if ( shift < dim ) {
-          idx[level] = shift;
-          idx0[level] = 0;
-          memcpy(ca_ptr_at_index(ca,idx), ca_ptr_at_index(ca->parent,idx0),(dim-shift)*ca->bytes);
-        }
-      }
-      else {
-        shift = ( -shift >= dim ) ? -dim : shift;
-
-        if ( -shift < dim ) {
-          idx[level]  = 0;
-          idx0[level] = -shift;
-          memcpy(ca_ptr_at_index(ca,idx), ca_ptr_at_index(ca->parent,idx0),(dim+shift)*ca->bytes);
-        }
-
-        for (i=0; i<-shift; i++) {
-          idx[level] = dim+shift+i;
-          memcpy(ca_ptr_at_index(ca, idx), ca->fill, ca->bytes);
-        }
-      }
+  w->bytes = bytes;
+  w->fill  = fill;
+  w->ndim  = 0;
+
+  for (i=0; i<ndim; i++) {
+    if ( dim[i] == 0 ) {
+      return;                     /* no elements */
     }
   }
-  else {
-    if ( fill ) {
-      for (i=0; i<dim; i++) {
-        idx[level]  = i;
-        ca_shift_attach_loop(ca, level+1, idx, idx0, 1); /* fill */
-      }
+
+  for (i=0; i<ndim; i++) {
+    d   = dim[i];
+    s   = shift[i];
+    seg = w->seg[i];
+    if ( roll[i] ) {
+      s = ( s >= 0 ) ? s % d : d - ((-s) % d);
+      s = ( s == d ) ? 0 : s;
     }
-    else if ( ! shift ) {
-      for (i=0; i<dim; i++) {
-        idx[level]  = i;
-        idx0[level] = i;
-        ca_shift_attach_loop(ca, level+1, idx, idx0, 0);
-      }
+    if ( s == 0 ) {
+      w->nseg[i] = 1;
+      seg[0].dst = 0; seg[0].src = 0; seg[0].len = d;
+      continue;
     }
-    else if ( roll ) {
-      shift = ca_shift_normalized_roll_shift(ca, level);
-
-      if ( shift > 0 ) {
-        for (i=0; i<shift; i++) {
-          idx[level] = i;
-          idx0[level] = dim-shift+i;
-          ca_shift_attach_loop(ca, level+1, idx, idx0, 0);
-        }
-
-        for (i=0; i<dim-shift; i++) {
-          idx[level] = shift+i;
-          idx0[level] = i;
-          ca_shift_attach_loop(ca, level+1, idx, idx0, 0);
-        }
-      }
-      else {
-        for (i=0; i<dim+shift; i++) {
-          idx[level]  = i;
-          idx0[level] = -shift+i;
-          ca_shift_attach_loop(ca, level+1, idx, idx0, 0);
-        }
-
-        for (i=0; i<-shift; i++) {
-          idx[level] = dim + shift + i;
-          idx0[level] = i;
-          ca_shift_attach_loop(ca, level+1, idx, idx0, 0);
-        }
-      }
+    last = i;
+    if ( roll[i] ) {
+      w->nseg[i] = 2;
+      seg[0].dst = 0; seg[0].src = d - s; seg[0].len = s;
+      seg[1].dst = s; seg[1].src = 0;     seg[1].len = d - s;
+    }
+    else if ( s > 0 ) {
+      m = ( s >= d ) ? d : s;
+      w->nseg[i] = ( m < d ) ? 2 : 1;
+      seg[0].dst = 0; seg[0].src = -1; seg[0].len = m;
+      seg[1].dst = m; seg[1].src = 0;  seg[1].len = d - m;
     }
     else {
-      if ( shift > 0 ) {
-        shift = ( shift >= dim ) ? dim : shift;
-
-        for (i=0; i<shift; i++) {
-          idx[level] = i;
-          ca_shift_attach_loop(ca, level+1, idx, idx0, 1); /* fill */
-        }
-
-        if ( shift < dim ) {
-          for (i=0; i<dim-shift; i++) {
-            idx[level] = shift+i;
-            idx0[level] = i;
-            ca_shift_attach_loop(ca, level+1, idx, idx0, 0);
-          }
-        }
+      m = ( -s >= d ) ? d : -s;
+      w->nseg[i] = ( m < d ) ? 2 : 1;
+      if ( m < d ) {
+        seg[0].dst = 0;     seg[0].src = m;  seg[0].len = d - m;
+        seg[1].dst = d - m; seg[1].src = -1; seg[1].len = m;
       }
       else {
-        shift = ( -shift >= dim ) ? -dim : shift;
-
-        if ( -shift < dim ) {
-          for (i=0; i<dim+shift; i++) {
-            idx[level]  = i;
-            idx0[level] = -shift+i;
-            ca_shift_attach_loop(ca, level+1, idx, idx0, 0);
-          }
-        }
-
-        for (i=0; i<-shift; i++) {
-          idx[level] = dim+shift+i;
-          ca_shift_attach_loop(ca, level+1, idx, idx0, 1); /* fill */
-        }
+        seg[0].dst = 0;     seg[0].src = -1; seg[0].len = d;
       }
     }
   }
+
+  stride = bytes;
+  for (i=ndim-1; i>last; i--) {
+    stride *= dim[i];
+  }
+  for (i=last; i>=0; i--) {
+    w->stride[i] = stride;
+    stride *= dim[i];
+  }
+  w->ndim = last + 1;
 }
 
+/* fills n elements of the given bytes at p with the value v */
+
 static void
-ca_shift_attach (CAShift *ca)
+ca_shift_memfill (char *p, char *v, ca_size_t bytes, ca_size_t n)
 {
-  ca_size_t idx[CA_RANK_MAX];
-  ca_size_t idx0[CA_RANK_MAX];
-  ca_shift_attach_loop(ca, (int16_t) 0, idx, idx0, 0);
+  ca_size_t len = bytes * n, done, m;
+  if ( n <= 0 ) {
+    return;
+  }
+  if ( bytes == 1 ) {
+    memset(p, *(uint8_t *)v, n);
+    return;
+  }
+  memcpy(p, v, bytes);
+  done = bytes;
+  while ( done < len ) {
+    m = ( len - done < done ) ? len - done : done;
+    memcpy(p + done, p, m);
+    done += m;
+  }
 }
 
+/* p : buffer of the shifted array, q : buffer of the parent */
+
 static void
-ca_shift_sync_loop (CAShift *ca, int16_t level, ca_size_t *idx, ca_size_t *idx0)
+ca_shift_attach_loop (ca_shift_plan_t *w, int8_t level, char *p, char *q)
 {
-  ca_size_t dim   = ca->dim[level];
-  ca_size_t shift = ca->shift[level];
-  int8_t roll = ca->roll[level];
+  ca_size_t st = w->stride[level];
+  ca_shift_seg_t *seg;
   ca_size_t i;
+  int k;
 
-  if ( level == ca->ndim - 1 ) {
-    if ( ! shift ) {
-      idx[level] = 0;
-      idx0[level] = 0;
-      memcpy(ca_ptr_at_index(ca->parent, idx0), ca_ptr_at_index(ca, idx), dim * ca->bytes);
-    }
-    else if ( roll ) {
-      shift = ca_shift_normalized_roll_shift(ca, level);
-
-      if ( shift > 0 ) {
-        idx[level] = 0;
-        idx0[level] = dim-shift;
-        memcpy(ca_ptr_at_index(ca->parent,idx0), ca_ptr_at_index(ca,idx), shift*ca->bytes);
-        idx[level] = shift;
-        idx0[level] = 0;
-        memcpy(ca_ptr_at_index(ca->parent,idx0), ca_ptr_at_index(ca,idx), (dim-shift)*ca->bytes);
-      }
-      else {
-        idx[level]  = 0;
-        idx0[level] = -shift;
-        memcpy(ca_ptr_at_index(ca->parent,idx0), ca_ptr_at_index(ca,idx), (dim+shift)*ca->bytes);
-        idx[level] = dim + shift;
-        idx0[level] = 0;
-        memcpy(ca_ptr_at_index(ca->parent,idx0), ca_ptr_at_index(ca,idx), (-shift)*ca->bytes);
-      }
+  for (k=0; k<w->nseg[level]; k++) {
+    seg = &w->seg[level][k];
+    if ( seg->src < 0 ) {
+      ca_shift_memfill(p + st*seg->dst, w->fill, w->bytes,
+                       st/w->bytes*seg->len);
+    }
+    else if ( level == w->ndim - 1 ) {
+      memcpy(p + st*seg->dst, q + st*seg->src, st*seg->len);
     }
     else {
-      if ( shift > 0 ) {
-        shift = ( shift >= dim ) ? dim : shift;
-
-        for (i=0; i<shift; i++) {
-          ; /* do nothing */
-        }
-
-        if ( shift < dim ) {
-          idx[level] = shift;
-          idx0[level] = 0;
-          memcpy(ca_ptr_at_index(ca->parent,idx0), ca_ptr_at_index(ca,idx),(dim-shift)*ca->bytes);
-        }
-      }
-      else {
-        shift = ( -shift >= dim ) ? -dim : shift;
-
-        if ( -shift < dim ) {
-          idx[level]  = 0;
-          idx0[level] = -shift;
-          memcpy(ca_ptr_at_index(ca->parent,idx0), ca_ptr_at_index(ca,idx),(dim+shift)*ca->bytes);
-        }
-
-        for (i=0; i<-shift; i++) {
-          ; /* do nothing */
-        }
+      for (i=0; i<seg->len; i++) {
+        ca_shift_attach_loop(w, level+1,
+                             p + st*(seg->dst+i), q + st*(seg->src+i));
       }
     }
   }
-  else {
-    if ( ! shift ) {
-      for (i=0; i<dim; i++) {
-        idx[level]  = i;
-        idx0[level] = i;
-        ca_shift_sync_loop(ca, level+1, idx, idx0);
-      }
+}
+
+static void
+ca_shift_sync_loop (ca_shift_plan_t *w, int8_t level, char *p, char *q)
+{
+  ca_size_t st = w->stride[level];
+  ca_shift_seg_t *seg;
+  ca_size_t i;
+  int k;
+
+  for (k=0; k<w->nseg[level]; k++) {
+    seg = &w->seg[level][k];
+    if ( seg->src < 0 ) {
+      continue;
     }
-    else if ( roll ) {
-      shift = ca_shift_normalized_roll_shift(ca, level);
-      if ( shift > 0 ) {
-        for (i=0; i<shift; i++) {
-          idx[level] = i;
-          idx0[level] = dim-shift+i;
-          ca_shift_sync_loop(ca, level+1, idx, idx0);
-        }
-
-        for (i=0; i<dim-shift; i++) {
-          idx[level] = shift+i;
-          idx0[level] = i;
-          ca_shift_sync_loop(ca, level+1, idx, idx0);
-        }
-      }
-      else {
-        for (i=0; i<dim+shift; i++) {
-          idx[level]  = i;
-          idx0[level] = -shift+i;
-          ca_shift_sync_loop(ca, level+1, idx, idx0);
-        }
-
-        for (i=0; i<-shift; i++) {
-          idx[level] = dim + shift + i;
-          idx0[level] = i;
-          ca_shift_sync_loop(ca, level+1, idx, idx0);
-        }
-      }
+    else if ( level == w->ndim - 1 ) {
+      memcpy(q + st*seg->src, p + st*seg->dst, st*seg->len);
     }
     else {
-      if ( shift > 0 ) {
-        shift = ( shift >= dim ) ? dim : shift;
-
-        for (i=0; i<shift; i++) {
-          ; /* do nothing */
-        }
-
-        if ( shift < dim ) {
-          for (i=0; i<dim-shift; i++) {
-            idx[level] = shift+i;
-            idx0[level] = i;
-            ca_shift_sync_loop(ca, level+1, idx, idx0);
-          }
-        }
-      }
-      else {
-        shift = ( -shift >= dim ) ? -dim : shift;
-
-        if ( -shift < dim ) {
-          for (i=0; i<dim+shift; i++) {
-            idx[level]  = i;
-            idx0[level] = -shift+i;
-            ca_shift_sync_loop(ca, level+1, idx, idx0);
-          }
-        }
-
-        for (i=0; i<-shift; i++) {
-          ; /* do nothing */
-        }
+      for (i=0; i<seg->len; i++) {
+        ca_shift_sync_loop(w, level+1,
+                           p + st*(seg->dst+i), q + st*(seg->src+i));
       }
     }
   }
 }
 
 static void
-ca_shift_sync (CAShift *ca)
+ca_shift_fill_loop (ca_shift_plan_t *w, int8_t level, char *v, char *q)
 {
-  ca_size_t idx[CA_RANK_MAX];
-  ca_size_t idx0[CA_RANK_MAX];
-  ca_shift_sync_loop(ca, (int16_t) 0, idx, idx0);
-}
-
-static void
-ca_shift_fill_loop (CAShift *ca, char *ptr,
-                  int16_t level, ca_size_t *idx0)
-{
-  ca_size_t dim   = ca->dim[level];
-  ca_size_t shift = ca->shift[level];
-  int8_t roll = ca->roll[level];
+  ca_size_t st = w->stride[level];
+  ca_shift_seg_t *seg;
   ca_size_t i;
+  int k;
 
-  if ( level == ca->ndim - 1 ) {
-    if ( ( ! shift ) || roll ) {
-      for (i=0; i<dim; i++) {
-        idx0[level] = i;
-        memcpy(ca_ptr_at_index(ca->parent, idx0), ptr, ca->bytes);
-      }
+  for (k=0; k<w->nseg[level]; k++) {
+    seg = &w->seg[level][k];
+    if ( seg->src < 0 ) {
+      continue;
     }
-    else {
-      if ( shift > 0 ) {
-        shift = ( shift >= dim ) ? dim : shift;
-
-        for (i=0; i<shift; i++) {
-          ; /* do nothing */
-        }
-
-        if ( shift < dim ) {
-          for (i=0; i<dim-shift; i++) {
-            idx0[level] = i;
-            memcpy(ca_ptr_at_index(ca->parent, idx0), ptr, ca->bytes);
-          }
-        }
-      }
-      else {
-        shift = ( -shift >= dim ) ? -dim : shift;
-
-        if ( -shift < dim ) {
-          for (i=0; i<dim+shift; i++) {
-            idx0[level] = -shift+i;
-            memcpy(ca_ptr_at_index(ca->parent, idx0), ptr, ca->bytes);
-          }
-        }
-
-        for (i=0; i<-shift; i++) {
-          ; /* do nothing */
-        }
-      }
-    }
-  }
-  else {
-    if ( ( ! shift ) || roll ) {
-      for (i=0; i<dim; i++) {
-        idx0[level] = i;
-        ca_shift_fill_loop(ca, ptr, level+1, idx0);
-      }
+    else if ( level == w->ndim - 1 ) {
+      ca_shift_memfill(q + st*seg->src, v, w->bytes, st/w->bytes*seg->len);
     }
     else {
-      if ( shift > 0 ) {
-        shift = ( shift >= dim ) ? dim : shift;
-
-        for (i=0; i<shift; i++) {
-          ; /* do nothing */
-        }
-
-        if ( shift < dim ) {
-          for (i=0; i<dim-shift; i++) {
-            idx0[level] = i;
-            ca_shift_fill_loop(ca, ptr, level+1, idx0);
-          }
-        }
-      }
-      else {
-        shift = ( -shift >= dim ) ? -dim : shift;
-
-        if ( -shift < dim ) {
-          for (i=0; i<dim+shift; i++) {
-            idx0[level] = -shift+i;
-            ca_shift_fill_loop(ca, ptr, level+1, idx0);
-          }
-        }
-
-        for (i=0; i<-shift; i++) {
-          ; /* do nothing */
-        }
+      for (i=0; i<seg->len; i++) {
+        ca_shift_fill_loop(w, level+1, v, q + st*(seg->src+i));
       }
     }
   }
 }
 
+static void
+ca_shift_attach (CAShift *ca)
+{
+  ca_shift_plan_t w;
+  ca_shift_plan_setup(&w, ca->ndim, ca->dim, ca->bytes,
+                      ca->shift, ca->roll, ca->fill);
+  if ( w.ndim > 0 ) {
+    ca_shift_attach_loop(&w, (int8_t) 0, ca->ptr, ca->parent->ptr);
+  }
+}
+
+static void
+ca_shift_sync (CAShift *ca)
+{
+  ca_shift_plan_t w;
+  ca_shift_plan_setup(&w, ca->ndim, ca->dim, ca->bytes,
+                      ca->shift, ca->roll, ca->fill);
+  if ( w.ndim > 0 ) {
+    ca_shift_sync_loop(&w, (int8_t) 0, ca->ptr, ca->parent->ptr);
+  }
+}
+
 static void
 ca_shift_fill (CAShift *ca, char *ptr)
 {
-  ca_size_t idx0[CA_RANK_MAX];
-  ca_shift_fill_loop(ca, ptr, (int16_t) 0, idx0);
+  ca_shift_plan_t w;
+  ca_shift_plan_setup(&w, ca->ndim, ca->dim, ca->bytes,
+                      ca->shift, ca->roll, ca->fill);
+  if ( w.ndim > 0 ) {
+    ca_shift_fill_loop(&w, (int8_t) 0, ptr, ca->parent->ptr);
+  }
 }
 
 /* ------------------------------------------------------------------- */
@@ -939,6 +753,102 @@ rb_ca_shift (int argc, VALUE *argv, VALUE self)
   return obj;
 }
 
+/* rolls the row-major buffer ptr in place, dimension by dimension. Along
+   each dimension the blocks are rotated by one memmove of the longer part
+   and memcpy of the shorter part through a temporary buffer */
+
+static void
+ca_shift_roll_inplace (char *ptr, ca_size_t bytes, int8_t ndim, ca_size_t *dim,
+                       ca_size_t *shift)
+{
+  ca_size_t blk[CA_RANK_MAX];
+  ca_size_t outer, d, s, t, o, len;
+  char *tmp, *base;
+  int8_t i;
+
+  for (i=0; i<ndim; i++) {
+    if ( dim[i] == 0 ) {
+      return;
+    }
+  }
+
+  len = bytes;
+  for (i=ndim-1; i>=0; i--) {
+    blk[i] = len;
+    len *= dim[i];
+  }
+
+  outer = 1;
+  for (i=0; i<ndim; outer *= dim[i], i++) {
+    d = dim[i];
+    s = shift[i];
+    s = ( s >= 0 ) ? s % d : d - ((-s) % d);
+    if ( s == 0 || s == d ) {
+      continue;
+    }
+    t   = ( s <= d - s ) ? s : d - s;
+    tmp = malloc_with_check(t * blk[i]);
+    for (o=0; o<outer; o++) {
+      base = ptr + o * d * blk[i];
+      if ( s <= d - s ) {        /* the last s blocks go to the front */
+        memcpy(tmp, base + (d-s)*blk[i], s*blk[i]);
+        memmove(base + s*blk[i], base, (d-s)*blk[i]);
+        memcpy(base, tmp, s*blk[i]);
+      }
+      else {                     /* the first d-s blocks go to the back */
+        memcpy(tmp, base, (d-s)*blk[i]);
+        memmove(base, base + (d-s)*blk[i], s*blk[i]);
+        memcpy(base + s*blk[i], tmp, (d-s)*blk[i]);
+      }
+    }
+    free(tmp);
+  }
+}
+
+/* @overload roll! (*shift)
+
+(Ordering, Modification)
+Rolls the elements of <code>self</code> in place by the given shifts
+along the dimensions. Same as <code>self[] = self.rolled(*shift)</code>,
+but entity arrays are rolled in their buffer without creating the
+virtual array.
+*/
+
+static VALUE
+rb_ca_roll_bang (int argc, VALUE *argv, VALUE self)
+{
+  CArray *ca;
+  ca_size_t shift[CA_RANK_MAX];
+  int8_t i;
+
+  rb_ca_modify(self);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_is_entity(ca) ) {
+    rb_ca_store_all(self, rb_funcall2(self, rb_intern("rolled"), argc, argv));
+    return self;
+  }
+
+  if ( argc != ca->ndim ) {
+    rb_raise(rb_eArgError, "# of arguments mismatch with ndim");
+  }
+
+  for (i=0; i<ca->ndim; i++) {
+    shift[i] = NUM2SIZE(argv[i]);
+  }
+
+  ca_shift_roll_inplace(ca->ptr, ca->bytes, ca->ndim, ca->dim, shift);
+
+  ca_update_mask(ca);
+  if ( ca->mask ) {
+    ca_shift_roll_inplace(ca->mask->ptr, ca->mask->bytes,
+                          ca->ndim, ca->dim, shift);
+  }
+
+  return self;
+}
+
 /* ------------------------------------------------------------------- */
 
 static VALUE
@@ -974,6 +884,7 @@ Init_ca_obj_shift ()
   rb_define_const(rb_cObject, "CA_OBJ_SHIFT", INT2NUM(CA_OBJ_SHIFT));
 
   rb_define_method(rb_cCArray, "shifted", rb_ca_shift, -1);
+  rb_define_method(rb_cCArray, "roll!", rb_ca_roll_bang, -1);
 
   rb_define_alloc_func(rb_cCAShift, rb_ca_shift_s_allocate);
   rb_define_method(rb_cCAShift, "initialize_copy",
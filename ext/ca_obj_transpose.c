@@ -28,7 +28,7 @@ typedef struct {
   ca_size_t   step;
 } CATrans;
 
-static int8_t CA_OBJ_TRANSPOSE;
+int8_t CA_OBJ_TRANSPOSE;
 
 const rb_data_type_t catrans_data_type = {
     .parent = &cavirtual_data_type,
@@ -139,6 +139,28 @@ ca_trans_new (CArray *parent, ca_size_t *imap)
   return ca;
 }
 
+/* the i-th dimension is the imap[i]-th dimension of the parent */
+
+int
+ca_trans_strided_view (void *ap, CAStrided *sv)
+{
+  CATrans *ca = (CATrans *) ap;
+  CAStrided p;
+  int8_t i;
+
+  if ( ! ca_strided_view(ca->parent, &p) ) {
+    return 0;
+  }
+
+  *sv = p;
+  for (i=0; i<ca->ndim; i++) {
+    sv->dim[i]    = p.dim[ca->imap[i]];
+    sv->stride[i] = p.stride[ca->imap[i]];
+  }
+
+  return 1;
+}
+
 static void
 free_ca_trans (void *ap)
 {
@@ -326,166 +348,48 @@ ca_operation_function_t ca_trans_func = {
 
 /* ------------------------------------------------------------------- */
 
+/* sets the strided views of the parent (in the order of the transposed
+   dimensions) and of the buffer ptr, for ca_strided_copy() */
+
 static void
-ca_trans_attach_loop (CATrans *ca, int8_t level, ca_size_t *idx, ca_size_t *idx0)
+ca_trans_copy_views (CATrans *ca, char *ptr, CAStrided *sp, CAStrided *sc)
 {
-  ca_size_t step = ca->step;
-  ca_size_t dim = ca->dim[level];
-  ca_size_t *imap = ca->imap;
-  ca_size_t i;
+  CArray *parent = ca->parent;
+  CAStrided p;
+  int8_t i;
 
-  if ( level == ca->ndim - 1 ) {
-    idx[level] = 0;
-    idx0[imap[level]] = 0;
-    switch ( ca->bytes ) {
-    case 1:
-      {
-        int8_t *p = ca_ptr_at_index(ca, idx);
-        int8_t *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          *p++ = *q;
-          q += step;
-        }
-      }
-      break;
-    case 2:
-      {
-        int16_t *p = ca_ptr_at_index(ca, idx);
-        int16_t *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          *p++ = *q;
-          q += step;
-        }
-      }
-      break;
-    case 4:
-      {
-        int32_t *p = ca_ptr_at_index(ca, idx);
-        int32_t *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          *p++ = *q;
-          q += step;
-        }
-      }
-      break;
-    case 8:
-      {
-        float64_t *p = ca_ptr_at_index(ca, idx);
-        float64_t *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          *p++ = *q;
-          q += step;
-        }
-      }
-      break;
-    default:
-      {
-        char *p = ca_ptr_at_index(ca, idx);
-        char *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          memcpy(p, q, ca->bytes);
-          p += ca->bytes;
-          q += ca->bytes*step;
-        }
-      }
-    }
-  }
-  else {
-    for (i=0; i<dim; i++) {
-      idx[level]  = i;
-      idx0[imap[level]] = i;
-      ca_trans_attach_loop(ca, level+1, idx, idx0);
-    }
+  p.bytes = ca->bytes;
+  ca_strided_set_contiguous(&p, parent->ndim, parent->dim);
+
+  sp->root  = parent;
+  sp->ptr   = parent->ptr;
+  sp->bytes = ca->bytes;
+  sp->ndim  = ca->ndim;
+  for (i=0; i<ca->ndim; i++) {
+    sp->dim[i]    = p.dim[ca->imap[i]];
+    sp->stride[i] = p.stride[ca->imap[i]];
   }
-}
 
-static void
-ca_trans_attach (CATrans *ca)
-{
-  ca_size_t idx[CA_RANK_MAX];
-  ca_size_t idx0[CA_RANK_MAX];
-  ca_trans_attach_loop(ca, 0, idx, idx0);
+  sc->root  = (CArray *) ca;
+  sc->ptr   = ptr;
+  sc->bytes = ca->bytes;
+  ca_strided_set_contiguous(sc, ca->ndim, ca->dim);
 }
 
 static void
-ca_trans_sync_loop (CATrans *ca, int8_t level, ca_size_t *idx, ca_size_t *idx0)
+ca_trans_attach (CATrans *ca)
 {
-  ca_size_t step = ca->step;
-  ca_size_t dim = ca->dim[level];
-  ca_size_t *imap = ca->imap;
-  ca_size_t i;
-
-  if ( level == ca->ndim - 1 ) {
-    idx[level] = 0;
-    idx0[imap[level]] = 0;
-    switch ( ca->bytes ) {
-    case 1:
-      {
-        int8_t *p = ca_ptr_at_index(ca, idx);
-        int8_t *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          *q = *p++;
-          q += step;
-        }
-      }
-      break;
-    case 2:
-      {
-        int16_t *p = ca_ptr_at_index(ca, idx);
-        int16_t *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          *q = *p++;
-          q += step;
-        }
-      }
-      break;
-    case 4:
-      {
-        int32_t *p = ca_ptr_at_index(ca, idx);
-        int32_t *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          *q = *p++;
-          q += step;
-        }
-      }
-      break;
-    case 8:
-      {
-        float64_t *p = ca_ptr_at_index(ca, idx);
-        float64_t *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          *q = *p++;
-          q += step;
-        }
-      }
-      break;
-    default:
-      {
-        char *p = ca_ptr_at_index(ca, idx);
-        char *q = ca_ptr_at_index(ca->parent, idx0);
-        for (i=0; i<dim; i++) {
-          memcpy(q, p, ca->bytes);
-          p += ca->bytes;
-          q += ca->bytes * step;
-        }
-      }
-    }
-  }
-  else {
-    for (i=0; i<dim; i++) {
-      idx[level] = i;
-      idx0[imap[level]] = i;
-      ca_trans_sync_loop(ca, level+1, idx, idx0);
-    }
-  }
+  CAStrided sp, sc;
+  ca_trans_copy_views(ca, ca->ptr, &sp, &sc);
+  ca_strided_copy(&sc, &sp, ! ca_is_object_type(ca));
 }
 
 static void
 ca_trans_sync (CATrans *ca)
 {
-  ca_size_t idx[CA_RANK_MAX];
-  ca_size_t idx0[CA_RANK_MAX];
-  ca_trans_sync_loop(ca, 0, idx, idx0);
+  CAStrided sp, sc;
+  ca_trans_copy_views(ca, ca->ptr, &sp, &sc);
+  ca_strided_copy(&sp, &sc, ! ca_is_object_type(ca));
 }
 
 /*
@@ -524,9 +428,29 @@ rb_ca_trans_new (VALUE cary, ca_size_t *imap)
 {
   volatile VALUE obj;
   CArray *parent;
-  CATrans *ca;
+  CATrans *ca, *cp;
+  ca_size_t map[CA_RANK_MAX];
+  int8_t i;
   rb_check_carray_object(cary);
   TypedData_Get_Struct(cary, CArray,&carray_data_type, parent);
+
+  /* the transpose of a transpose is folded into a transpose of the
+     grandparent (on the C structure only, as rb_ca_block_new() does) */
+  if ( parent->obj_type == CA_OBJ_TRANSPOSE && ! ca_is_attached(parent) &&
+       ! ca_is_readonly(parent) && ! ca_is_value_array(parent) ) {
+    cp = (CATrans *) parent;
+    for (i=0; i<cp->ndim; i++) {
+      if ( imap[i] < 0 || imap[i] >= cp->ndim ) {
+        break;
+      }
+      map[i] = cp->imap[imap[i]];
+    }
+    if ( i == cp->ndim ) {
+      parent = cp->parent;
+      imap   = map;
+    }
+  }
+
   ca = ca_trans_new(parent, imap);
   obj = ca_wrap_struct(ca);
   rb_ca_set_parent(obj, cary);
@@ -570,6 +494,60 @@ rb_ca_trans (int argc, VALUE *argv, VALUE self)
   return obj;
 }
 
+/* stores the elements of the transposed view into its entity parent */
+
+static void
+ca_trans_store_to_parent (CATrans *ca)
+{
+  CAStrided sp, sc;
+  char *buf;
+
+  buf = malloc_with_check(ca_length(ca));
+  ca_trans_copy_views(ca, buf, &sp, &sc);
+  ca_strided_copy(&sc, &sp, ! ca_is_object_type(ca));
+  memcpy(ca->parent->ptr, buf, ca_length(ca));
+  free(buf);
+}
+
+/* @overload transpose! (*imap)
+
+(Transformation, Modification)
+Stores the elements of <code>self.transposed(*imap)</code> into
+<code>self</code> in place. The shape of <code>self</code> is not changed.
+*/
+
+static VALUE
+rb_ca_trans_bang (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE obj;
+  CArray *ca;
+  CATrans *ct;
+
+  rb_ca_modify(self);
+
+  obj = rb_ca_trans(argc, argv, self);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_is_entity(ca) ) {
+    rb_ca_store_all(self, obj);
+    return self;
+  }
+
+  if ( ca->elements == 0 ) {
+    return self;
+  }
+
+  TypedData_Get_Struct(obj, CATrans, &catrans_data_type, ct);
+
+  ca_trans_store_to_parent(ct);
+  if ( ct->mask ) {
+    ca_trans_store_to_parent((CATrans *) ct->mask);
+  }
+
+  return self;
+}
+
 static VALUE
 rb_ca_trans_s_allocate (VALUE klass)
 {
@@ -603,6 +581,7 @@ Init_ca_obj_transpose ()
   rb_define_const(rb_cObject, "CA_OBJ_TRANSPOSE", INT2NUM(CA_OBJ_TRANSPOSE));
 
   rb_define_method(rb_cCArray, "transposed", rb_ca_trans, -1);
+  rb_define_method(rb_cCArray, "transpose!", rb_ca_trans_bang, -1);
 
   rb_define_alloc_func(rb_cCATrans, rb_ca_trans_s_allocate);
   rb_define_method(rb_cCATrans, "initialize_copy",
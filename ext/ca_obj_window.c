@@ -364,131 +364,140 @@ ca_operation_function_t ca_window_func = {
 
 /* ------------------------------------------------------------------- */
 
-#define proc_window_attach_get(type) \
-  if ( fill ) { \
-    type *p, *v; \
-    idx[level] = 0; \
-    p = ca_ptr_at_index((CArray*)cb, idx); \
-    v = (type*)cb->fill; \
-    for (i=0; i<count; i++, p++) { \
-      *p = *v; \
-    } \
-  } \
-  else { \
-    CArray *parent = cb->parent; \
-    ca_size_t start  = cb->start[level]; \
-    ca_size_t size0  = cb->size0[level]; \
-    type *p, *q, *v;                   \
-    idx[level]  = 0; \
-    p = (type*)ca_ptr_at_index((CArray*)cb, idx); \
-    v = (type*)cb->fill; \
-    i = 0; \
-    while ( start+i<0 && i<count ) { \
-      k = start + i; \
-      k = ca_bounds_normalize_index(cb->bounds, size0, k); \
-      if ( k < 0 || k >= size0 ) { \
-        *p = *v; \
-      } \
-      else { \
-        idx0[level] = k; \
-        *p = *(type*) ca_ptr_at_index(parent, idx0); \
-      } \
-      i++; p++; \
-    } \
-    idx0[level] = start+i; \
-    q = (type*)ca_ptr_at_index(parent, idx0);\
-    while ( start+i<size0 && i < count ) { \
-      *p = *q; \
-      i++, p++, q++; \
-    } \
-    while ( i < count ) { \
-      k = start + i; \
-      k = ca_bounds_normalize_index(cb->bounds, size0, k); \
-      if ( k < 0 || k >= size0 ) { \
-        *p = *v; \
-      } \
-      else { \
-        idx0[level] = k; \
-        *p = *(type*) ca_ptr_at_index(parent, idx0); \
-      } \
-      i++, p++; \
-    } \
+/*
+  The window is walked dimension by dimension. For each dimension the
+  in-range span [lo, hi) of the window index (0 <= start+i < size0) is
+  precomputed, and only the indices outside of it go through
+  ca_bounds_normalize_index(). The interior span of the last dimension is
+  copied by one memcpy. The trailing dimensions covering the parent
+  entirely (start = 0, count = size0) are merged into the element, so that
+  a window sliding along the leading dimensions copies whole blocks.
+*/
+
+typedef struct {
+  int8_t    ndim;    /* dimensions after merging the trailing full spans */
+  int8_t    bounds;
+  ca_size_t bytes;
+  char     *fill;
+  ca_size_t start[CA_RANK_MAX];
+  ca_size_t count[CA_RANK_MAX];
+  ca_size_t size0[CA_RANK_MAX];
+  ca_size_t lo[CA_RANK_MAX];       /* interior span [lo, hi) */
+  ca_size_t hi[CA_RANK_MAX];
+  ca_size_t cstride[CA_RANK_MAX];  /* strides of window (bytes) */
+  ca_size_t pstride[CA_RANK_MAX];  /* strides of parent (bytes) */
+} ca_window_plan_t;
+
+static void
+ca_window_plan_setup (CAWindow *cb, ca_window_plan_t *w)
+{
+  ca_size_t cs, ps, lo, hi;
+  int8_t i, n;
+
+  n = cb->ndim;
+  while ( n > 1 && cb->start[n-1] == 0 && cb->count[n-1] == cb->size0[n-1] ) {
+    n--;
+  }
+
+  cs = cb->bytes;
+  for (i=cb->ndim-1; i>=n; i--) {
+    cs *= cb->count[i];
+  }
+  ps = cs;
+
+  w->ndim   = n;
+  w->bounds = cb->bounds;
+  w->bytes  = cb->bytes;
+  w->fill   = cb->fill;
+
+  for (i=n-1; i>=0; i--) {
+    lo = - cb->start[i];
+    lo = ( lo < 0 ) ? 0 : ( lo > cb->count[i] ) ? cb->count[i] : lo;
+    hi = cb->size0[i] - cb->start[i];
+    hi = ( hi < lo ) ? lo : ( hi > cb->count[i] ) ? cb->count[i] : hi;
+    w->start[i]   = cb->start[i];
+    w->count[i]   = cb->count[i];
+    w->size0[i]   = cb->size0[i];
+    w->lo[i]      = lo;
+    w->hi[i]      = hi;
+    w->cstride[i] = cs;
+    w->pstride[i] = ps;
+    cs *= cb->count[i];
+    ps *= cb->size0[i];
   }
+}
+
+/* returns the parent index for the window index i, or -1 for fill */
+
+static ca_size_t
+ca_window_plan_index (ca_window_plan_t *w, int8_t level, ca_size_t i)
+{
+  ca_size_t k = w->start[level] + i;
+  if ( i < w->lo[level] || i >= w->hi[level] ) {
+    k = ca_bounds_normalize_index(w->bounds, w->size0[level], k);
+    if ( k < 0 || k >= w->size0[level] ) {
+      return -1;
+    }
+  }
+  return k;
+}
+
+/* fills n elements of the given bytes at p with the value v */
 
 static void
-ca_window_attach_loop (CAWindow *cb, int8_t level,
-                                ca_size_t *idx, ca_size_t *idx0, int fill)
+ca_window_memfill (char *p, char *v, ca_size_t bytes, ca_size_t n)
 {
-  ca_size_t count = cb->count[level];
+  ca_size_t len = bytes * n, done, m;
+  if ( n <= 0 ) {
+    return;
+  }
+  if ( bytes == 1 ) {
+    memset(p, *(uint8_t *)v, n);
+    return;
+  }
+  memcpy(p, v, bytes);
+  done = bytes;
+  while ( done < len ) {
+    m = ( len - done < done ) ? len - done : done;
+    memcpy(p + done, p, m);
+    done += m;
+  }
+}
+
+static void
+ca_window_attach_loop (ca_window_plan_t *w, int8_t level, char *p, char *q)
+{
+  ca_size_t count = w->count[level];
+  ca_size_t lo    = w->lo[level];
+  ca_size_t hi    = w->hi[level];
+  ca_size_t cs    = w->cstride[level];
+  ca_size_t ps    = w->pstride[level];
   ca_size_t i, k;
 
-  if ( level == cb->ndim - 1 ) {
-    switch ( cb->data_type ) {
-    case CA_BOOLEAN:
-    case CA_INT8:   proc_window_attach_get(int8_t); break;
-    case CA_UINT8:  proc_window_attach_get(uint8_t); break;
-    case CA_INT16:  proc_window_attach_get(int16_t); break;
-    case CA_UINT16: proc_window_attach_get(uint16_t); break;
-    case CA_INT32:  proc_window_attach_get(int32_t); break;
-    case CA_UINT32:  proc_window_attach_get(uint32_t); break;
-    case CA_INT64:   proc_window_attach_get(int64_t); break;
-    case CA_UINT64:  proc_window_attach_get(uint64_t); break;
-    case CA_FLOAT32: proc_window_attach_get(float32_t); break;
-    case CA_FLOAT64: proc_window_attach_get(float64_t); break;
-    case CA_FLOAT128: proc_window_attach_get(float128_t); break;
-#ifdef HAVE_COMPLEX_H
-    case CA_CMPLX64:  proc_window_attach_get(cmplx64_t); break;
-    case CA_CMPLX128: proc_window_attach_get(cmplx128_t); break;
-    case CA_CMPLX256: proc_window_attach_get(cmplx256_t); break;
-#endif
-    default:
-      if ( fill ) {
-        for (i=0; i<count; i++) {
-          idx[level] = i;
-          memcpy(ca_ptr_at_index((CArray*)cb, idx), cb->fill, cb->bytes);
-        }
+  if ( level == w->ndim - 1 ) {
+    for (i=0; i<count; i++) {
+      if ( i == lo && hi > lo ) {
+        memcpy(p + cs*lo, q + ps*(w->start[level]+lo), cs*(hi-lo));
+        i = hi - 1;
+        continue;
+      }
+      k = ca_window_plan_index(w, level, i);
+      if ( k < 0 ) {
+        ca_window_memfill(p + cs*i, w->fill, w->bytes, cs/w->bytes);
       }
       else {
-        ca_size_t start = cb->start[level];
-        ca_size_t size0 = cb->size0[level];
-        for (i=0; i<count; i++) {
-          idx[level]  = i;
-          k = start + i;
-          if ( k < 0 || k >= size0 ) {
-            k = ca_bounds_normalize_index(cb->bounds, size0, k);
-            if ( k < 0 || k >= size0 ) {
-              memcpy(ca_ptr_at_index((CArray*)cb, idx), cb->fill, cb->bytes);
-              continue;
-            }
-          }
-          idx0[level] = k;
-          memcpy(ca_ptr_at_index((CArray*)cb, idx), ca_ptr_at_index(cb->parent, idx0), cb->bytes);
-        }
+        memcpy(p + cs*i, q + ps*k, cs);
       }
     }
   }
   else {
-    if ( fill ) {
-      for (i=0; i<count; i++) {
-        idx[level] = i;
-        ca_window_attach_loop(cb, level+1, idx, idx0, 1);
+    for (i=0; i<count; i++) {
+      k = ca_window_plan_index(w, level, i);
+      if ( k < 0 ) {
+        ca_window_memfill(p + cs*i, w->fill, w->bytes, cs/w->bytes);
       }
-    }
-    else {
-      ca_size_t start = cb->start[level];
-      ca_size_t size0 = cb->size0[level];
-      for (i=0; i<count; i++) {
-        idx[level]  = i;
-        k = start + i;
-        if ( k < 0 || k >= size0 ) {
-          k = ca_bounds_normalize_index(cb->bounds, size0, k);
-          if ( k < 0 || k >= size0 ) {
-            ca_window_attach_loop(cb, level+1, idx, idx0, 1); /* fill */
-            continue;
-          }
-        }
-        idx0[level] = k;
-        ca_window_attach_loop(cb, level+1, idx, idx0, 0); /* not-fill */
+      else {
+        ca_window_attach_loop(w, level+1, p + cs*i, q + ps*k);
       }
     }
   }
@@ -497,105 +506,40 @@ ca_window_attach_loop (CAWindow *cb, int8_t level,
 void
 ca_window_attach (CAWindow *cb)
 {
-  ca_size_t idx[CA_RANK_MAX];
-  ca_size_t idx0[CA_RANK_MAX];
-  ca_window_attach_loop(cb, (int8_t) 0, idx, idx0, 0);
+  ca_window_plan_t w;
+  ca_window_plan_setup(cb, &w);
+  ca_window_attach_loop(&w, (int8_t) 0, cb->ptr, cb->parent->ptr);
 }
 
-#define proc_window_sync_set(type) \
-  { \
-    CArray *parent = cb->parent; \
-    type *p, *q; \
-    idx[level]  = 0; \
-    p = (type*)ca_ptr_at_index((CArray*)cb, idx); \
-    i = 0; \
-    while ( start+i<0 && i<count ) { \
-      k = start + i; \
-      k = ca_bounds_normalize_index(cb->bounds, size0, k); \
-      if ( k < 0 || k >= size0 ) { \
-        ; \
-      } \
-      else { \
-       idx0[level] = k; \
-        *(type *)ca_ptr_at_index(parent, idx0) = *p; \
-      } \
-      i++; p++;                         \
-    }\
-    idx0[level] = start + i; \
-    q = (type*)ca_ptr_at_index(parent, idx0);\
-    while ( start+i < size0 && i<count ) { \
-      *q = *p; \
-      i++; p++; q++;                            \
-    } \
-    while ( i<count ) { \
-      k = start + i; \
-      k = ca_bounds_normalize_index(cb->bounds, size0, k); \
-      if ( k < 0 || k >= size0 ) { \
-        ; \
-      } \
-      else { \
-        idx0[level] = k; \
-        *(type*)ca_ptr_at_index(parent, idx0) = *p; \
-      } \
-      i++; p++; \
-    } \
-  }
-
 static void
-ca_window_sync_loop (CAWindow *cb, int8_t level,
-                                ca_size_t *idx, ca_size_t *idx0)
+ca_window_sync_loop (ca_window_plan_t *w, int8_t level, char *p, char *q)
 {
-  ca_size_t count = cb->count[level];
-  ca_size_t start = cb->start[level];
-  ca_size_t size0 = cb->size0[level];
+  ca_size_t count = w->count[level];
+  ca_size_t lo    = w->lo[level];
+  ca_size_t hi    = w->hi[level];
+  ca_size_t cs    = w->cstride[level];
+  ca_size_t ps    = w->pstride[level];
   ca_size_t i, k;
 
-  if ( level == cb->ndim - 1 ) {
-    switch ( cb->data_type ) {
-    case CA_BOOLEAN:
-    case CA_INT8:   proc_window_sync_set(int8_t); break;
-    case CA_UINT8:  proc_window_sync_set(uint8_t); break;
-    case CA_INT16:  proc_window_sync_set(int16_t); break;
-    case CA_UINT16: proc_window_sync_set(uint16_t); break;
-    case CA_INT32:  proc_window_sync_set(int32_t); break;
-    case CA_UINT32:  proc_window_sync_set(uint32_t); break;
-    case CA_INT64:   proc_window_sync_set(int64_t); break;
-    case CA_UINT64:  proc_window_sync_set(uint64_t); break;
-    case CA_FLOAT32: proc_window_sync_set(float32_t); break;
-    case CA_FLOAT64: proc_window_sync_set(float64_t); break;
-    case CA_FLOAT128: proc_window_sync_set(float128_t); break;
-#ifdef HAVE_COMPLEX_H
-    case CA_CMPLX64:  proc_window_sync_set(cmplx64_t); break;
-    case CA_CMPLX128: proc_window_sync_set(cmplx128_t); break;
-    case CA_CMPLX256: proc_window_sync_set(cmplx256_t); break;
-#endif
-    default:
-      for (i=0; i<count; i++) {
-        idx[level]  = i;
-        k = start + i;
-        if ( k < 0 || k >= size0 ) {
-          k = ca_bounds_normalize_index(cb->bounds, size0, k);
-          if ( k < 0 || k >= size0 ) {
-            continue;
-          }
-        }
-        idx0[level] = k;
-        memcpy(ca_ptr_at_index(cb->parent, idx0), ca_ptr_at_index((CArray*)cb, idx), cb->bytes);
+  if ( level == w->ndim - 1 ) {
+    for (i=0; i<count; i++) {
+      if ( i == lo && hi > lo ) {
+        memcpy(q + ps*(w->start[level]+lo), p + cs*lo, cs*(hi-lo));
+        i = hi - 1;
+        continue;
+      }
+      k = ca_window_plan_index(w, level, i);
+      if ( k >= 0 ) {
+        memcpy(q + ps*k, p + cs*i, cs);
       }
     }
   }
   else {
     for (i=0; i<count; i++) {
-      idx[level]  = i;
-      k = start + i;
-      if ( k < 0 || k >= size0 ) {
-        k = ca_bounds_normalize_index(cb->bounds, size0, k);
-        if ( k < 0 || k >= size0 ) {
-          continue;
-        }
+      k = ca_window_plan_index(w, level, i);
+      if ( k >= 0 ) {
+        ca_window_sync_loop(w, level+1, p + cs*i, q + ps*k);
       }
-      idx0[level] = k;
-      ca_window_sync_loop(cb, level+1, idx, idx0);
     }
   }
 }
@@ -603,111 +547,50 @@ ca_window_sync_loop (CAWindow *cb, int8_t level,
 void
 ca_window_sync (CAWindow *cb)
 {
-  ca_size_t idx[CA_RANK_MAX];
-  ca_size_t idx0[CA_RANK_MAX];
-  ca_window_sync_loop(cb, (int8_t) 0, idx, idx0);
+  ca_window_plan_t w;
+  ca_window_plan_setup(cb, &w);
+  ca_window_sync_loop(&w, (int8_t) 0, cb->ptr, cb->parent->ptr);
 }
 
-#define proc_window_fill_set(type) \
-  { \
-    CArray *parent = cb->parent; \
-    type *q; \
-    i = 0; \
-    while ( start+i<0 && i<count ) { \
-      k = start + i; \
-      k = ca_bounds_normalize_index(cb->bounds, size0, k); \
-      if ( k < 0 || k >= size0 ) { \
-        ; \
-      } \
-      else { \
-       idx0[level] = k; \
-        *(type *)ca_ptr_at_index(parent, idx0) = *ptr; \
-      } \
-      i++; \
-    }\
-    idx0[level] = start + i; \
-    q = (type*)ca_ptr_at_index(parent, idx0);\
-    while ( start+i < size0 && i<count ) { \
-      *q = *ptr; \
-      i++; q++;                         \
-    } \
-    while ( i<count ) { \
-      k = start + i; \
-      k = ca_bounds_normalize_index(cb->bounds, size0, k); \
-      if ( k < 0 || k >= size0 ) { \
-        ; \
-      } \
-      else { \
-        idx0[level] = k; \
-        *(type*)ca_ptr_at_index(parent, idx0) = *ptr; \
-      } \
-      i++; \
-    } \
-  }
-
 static void
-ca_window_fill_loop (CAWindow *cb, char *ptr,
-                    int8_t level, ca_size_t *idx0)
+ca_window_fill_loop (ca_window_plan_t *w, int8_t level, char *v, char *q)
 {
-  ca_size_t count = cb->count[level];
-  ca_size_t start = cb->start[level];
-  ca_size_t size0 = cb->size0[level];
+  ca_size_t count = w->count[level];
+  ca_size_t lo    = w->lo[level];
+  ca_size_t hi    = w->hi[level];
+  ca_size_t ps    = w->pstride[level];
   ca_size_t i, k;
 
-  if ( level == cb->ndim - 1 ) {
-    switch ( cb->data_type ) {
-    case CA_BOOLEAN:
-    case CA_INT8:   proc_window_fill_set(int8_t); break;
-    case CA_UINT8:  proc_window_fill_set(uint8_t); break;
-    case CA_INT16:  proc_window_fill_set(int16_t); break;
-    case CA_UINT16: proc_window_fill_set(uint16_t); break;
-    case CA_INT32:  proc_window_fill_set(int32_t); break;
-    case CA_UINT32:  proc_window_fill_set(uint32_t); break;
-    case CA_INT64:   proc_window_fill_set(int64_t); break;
-    case CA_UINT64:  proc_window_fill_set(uint64_t); break;
-    case CA_FLOAT32: proc_window_fill_set(float32_t); break;
-    case CA_FLOAT64: proc_window_fill_set(float64_t); break;
-    case CA_FLOAT128: proc_window_fill_set(float128_t); break;
-#ifdef HAVE_COMPLEX_H
-    case CA_CMPLX64:  proc_window_fill_set(cmplx64_t); break;
-    case CA_CMPLX128: proc_window_fill_set(cmplx128_t); break;
-    case CA_CMPLX256: proc_window_fill_set(cmplx256_t); break;
-#endif
-    default:
-      for (i=0; i<count; i++) {
-        k = start + i;
-        if ( k < 0 || k >= size0 ) {
-          k = ca_bounds_normalize_index(cb->bounds, size0, k);
-          if ( k < 0 || k >= size0 ) {
-            continue;
-          }
-        }
-        idx0[level] = k;
-        memcpy(ca_ptr_at_index(cb->parent, idx0), ptr, cb->bytes);
+  if ( level == w->ndim - 1 ) {
+    for (i=0; i<count; i++) {
+      if ( i == lo && hi > lo ) {
+        ca_window_memfill(q + ps*(w->start[level]+lo), v, w->bytes,
+                          ps/w->bytes*(hi-lo));
+        i = hi - 1;
+        continue;
+      }
+      k = ca_window_plan_index(w, level, i);
+      if ( k >= 0 ) {
+        ca_window_memfill(q + ps*k, v, w->bytes, ps/w->bytes);
       }
     }
   }
   else {
     for (i=0; i<count; i++) {
-      k = start + i;
-      if ( k < 0 || k >= size0 ) {
-        k = ca_bounds_normalize_index(cb->bounds, size0, k);
-        if ( k < 0 || k >= size0 ) {
-          continue;
-        }
+      k = ca_window_plan_index(w, level, i);
+      if ( k >= 0 ) {
+        ca_window_fill_loop(w, level+1, v, q + ps*k);
       }
-      idx0[level] = k;
-      ca_window_fill_loop(cb, ptr, level+1, idx0);
     }
   }
-
 }
 
 void
 ca_window_fill (CAWindow *cb, char *ptr)
 {
-  ca_size_t idx0[CA_RANK_MAX];
-  ca_window_fill_loop(cb, ptr, (int8_t) 0, idx0);
+  ca_window_plan_t w;
+  ca_window_plan_setup(cb, &w);
+  ca_window_fill_loop(&w, (int8_t) 0, ptr, cb->parent->ptr);
 }
 
 /* ------------------------------------------------------------------- */
@@ -184,6 +184,32 @@ typedef int8_t boolean8_t;
 
 #include <stddef.h>
 
+/* CA_PRAGMA_SIMD marks a loop without loop-carried dependency for vectorizing.
+   It is enabled only when the compiler accepts -fopenmp-simd (see extconf.rb) */
+
+#ifdef HAVE_OPENMP_SIMD
+#  define CA_PRAGMA_SIMD _Pragma("omp simd")
+#else
+#  define CA_PRAGMA_SIMD
+#endif
+
+/* The generated kernels are also compiled for the ISA levels below, and the
+   best level for the CPU is selected at runtime (see carray_simd.c).
+   HAVE_CA_SIMD_DISPATCH is defined when the compiler accepts the target
+   attributes and __builtin_cpu_supports() (see extconf.rb) */
+
+#define CA_SIMD_NONE      0
+#define CA_SIMD_SSE42     1
+#define CA_SIMD_AVX2      2
+#define CA_SIMD_AVX512    3
+#define CA_SIMD_NLEVEL    4
+
+#ifdef HAVE_CA_SIMD_DISPATCH
+#  define CA_TARGET_SSE42   __attribute__((target("sse4.2")))
+#  define CA_TARGET_AVX2    __attribute__((target("avx2")))
+#  define CA_TARGET_AVX512  __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+#endif
+
 #define CA_ALIGN_VOIDP    offsetof(struct { char c; void   *x; }, x)
 #define CA_ALIGN_INT8     offsetof(struct { char c; int8_t  x; }, x)
 #define CA_ALIGN_INT16    offsetof(struct { char c; int16_t x; }, x)
@@ -211,6 +237,9 @@ typedef int8_t boolean8_t;
 #define CA_FLAG_SHARE_INDEX     16
 #define CA_FLAG_NOT_DATA_CLASS  32
 #define CA_FLAG_CYCLE_CHECK     64
+#define CA_FLAG_MASK_CLEAN     128  /* mask array known to have no masked element */
+#define CA_FLAG_STRIDED_ATTACH 256  /* attached through the strided view of the root */
+#define CA_FLAG_MASK_PACKED    512  /* mask created by overlay is bit-packed */
 
 enum {
   CA_LITTLE_ENDIAN = 0,
@@ -346,7 +375,8 @@ struct _CArray {
   ca_size_t  *dim;
   char     *ptr;
   CArray   *mask;
-};                         /* 28 + 4*ndim (bytes) */
+  uint64_t *mask_bits;     /* packed mask (see carray_bitmask.c) */
+};           /* 8 + 2*sizeof(ca_size_t) + 4*sizeof(void*) (bytes) */
 
 typedef CArray CAWrap;
 
@@ -816,6 +846,9 @@ typedef struct {
 
 /* -------------------------------------------------------------------- */
 
+/* kernels with the mask as boolean8 array (1 byte per element). The 
+   operators no longer call them; kept for the extension libraries. */
+
 typedef void (*ca_monop_func_t)(ca_size_t n, boolean8_t *m, 
                                 char *ptr1, ca_size_t i1, 
                                 char *ptr2, ca_size_t i2);
@@ -831,27 +864,68 @@ typedef void (*ca_bincmp_func_t)(ca_size_t n, boolean8_t *m,
                                  char *ptr2, ca_size_t b2, ca_size_t i2, 
                                  char *ptr3, ca_size_t b3, ca_size_t i3);
 
-VALUE rb_ca_call_monop (VALUE self, ca_monop_func_t func[]);
-VALUE rb_ca_call_monop_bang (VALUE self, ca_monop_func_t func[]);
-VALUE rb_ca_call_binop (VALUE self, VALUE other, ca_binop_func_t func[]);
-VALUE rb_ca_call_binop_bang (VALUE self, VALUE other, ca_binop_func_t func[]);
-VALUE rb_ca_call_moncmp (VALUE self, ca_moncmp_func_t func[]);
-VALUE rb_ca_call_bincmp (VALUE self, VALUE other, ca_bincmp_func_t func[]);
-void  ca_monop_not_implement(ca_size_t n, boolean8_t *m, 
+/* kernels with the mask as packed words (bit i of m[i/64] for element i, 
+   see carray_bitmask.c), called by rb_ca_call_monop etc. */
+
+typedef void (*ca_monop_bits_func_t)(ca_size_t n, uint64_t *m, 
+                                     char *ptr1, ca_size_t i1, 
+                                     char *ptr2, ca_size_t i2);
+typedef void (*ca_binop_bits_func_t)(ca_size_t n, uint64_t *m, 
+                                     char *ptr1, ca_size_t i1, 
+                                     char *ptr2, ca_size_t i2, 
+                                     char *ptr3, ca_size_t i3);
+typedef void (*ca_moncmp_bits_func_t)(ca_size_t n, uint64_t *m, 
+                                      char *ptr1, ca_size_t i1, 
+                                      boolean8_t *ptr2, ca_size_t i2);
+typedef void (*ca_bincmp_bits_func_t)(ca_size_t n, uint64_t *m, 
+                                      char *ptr1, ca_size_t b1, ca_size_t i1, 
+                                      char *ptr2, ca_size_t b2, ca_size_t i2, 
+                                      char *ptr3, ca_size_t b3, ca_size_t i3);
+
+VALUE rb_ca_call_monop (VALUE self, ca_monop_bits_func_t func[]);
+VALUE rb_ca_call_monop_bang (VALUE self, ca_monop_bits_func_t func[]);
+VALUE rb_ca_call_binop (VALUE self, VALUE other, ca_binop_bits_func_t func[]);
+VALUE rb_ca_call_binop_bang (VALUE self, VALUE other, ca_binop_bits_func_t func[]);
+VALUE rb_ca_call_moncmp (VALUE self, ca_moncmp_bits_func_t func[]);
+VALUE rb_ca_call_bincmp (VALUE self, VALUE other, ca_bincmp_bits_func_t func[]);
+VALUE rb_ca_pop_out (int *argc, VALUE **argv);
+CArray *ca_check_out (VALUE out, int8_t data_type, ca_size_t elements);
+VALUE rb_ca_call_monop_to (VALUE self, VALUE out, ca_monop_bits_func_t func[]);
+VALUE rb_ca_call_binop_to (VALUE self, VALUE other, VALUE out, ca_binop_bits_func_t func[]);
+VALUE rb_ca_call_moncmp_to (VALUE self, VALUE out, ca_moncmp_bits_func_t func[]);
+VALUE rb_ca_call_bincmp_to (VALUE self, VALUE other, VALUE out, ca_bincmp_bits_func_t func[]);
+void  ca_monop_not_implement(ca_size_t n, uint64_t *m, 
                                 char *ptr1, ca_size_t i1, 
                                 char *ptr2, ca_size_t i2) __attribute__((noreturn));
-void  ca_binop_not_implement(ca_size_t n, boolean8_t *m, 
+void  ca_binop_not_implement(ca_size_t n, uint64_t *m, 
                                 char *ptr1, ca_size_t i1, 
                                 char *ptr2, ca_size_t i2, 
                                 char *ptr3, ca_size_t i3) __attribute__((noreturn));
-void  ca_moncmp_not_implement(ca_size_t n, boolean8_t *m, 
+void  ca_moncmp_not_implement(ca_size_t n, uint64_t *m, 
                                  char *ptr1, ca_size_t i1, 
                                  boolean8_t *ptr2, ca_size_t i2) __attribute__((noreturn));
-void  ca_bincmp_not_implement(ca_size_t n, boolean8_t *m, 
+void  ca_bincmp_not_implement(ca_size_t n, uint64_t *m, 
                                  char *ptr1, ca_size_t b1, ca_size_t i1, 
                                  char *ptr2, ca_size_t b2, ca_size_t i2, 
                                  char *ptr3, ca_size_t b3, ca_size_t i3) __attribute__((noreturn));
 VALUE ca_math_call (VALUE mod, VALUE arg, ID id);
+VALUE ca_math_call_with_options (VALUE mod, int argc, VALUE *argv, ID id);
+
+/* tables of generated kernels looked up by method name (carray_math.c) */
+
+typedef struct {
+  const char           *name;        /* method name */
+  ca_monop_bits_func_t *func;
+  int                   float_only;  /* integer array is converted to float64 */
+} ca_monop_entry_t;
+
+typedef struct {
+  const char           *name;
+  ca_binop_bits_func_t *func;
+} ca_binop_entry_t;
+
+extern ca_monop_entry_t ca_monop_entries[];
+extern ca_binop_entry_t ca_binop_entries[];
 
 /* -------------------------------------------------------------------- */
 
@@ -967,6 +1041,232 @@ CAReduce *ca_reduce_new (CArray *carray, ca_size_t count, ca_size_t offset);
 
 VALUE   rb_dim_iter_new (VALUE vca, CAIndexInfo *info);
 
+/* --- carray_parallel.c --- */
+
+typedef void (*ca_parallel_func_t)(ca_size_t start, ca_size_t end, void *arg);
+typedef void (*ca_parallel_reduce_func_t)(int chunk, 
+                                          ca_size_t start, ca_size_t end,
+                                          void *arg);
+
+#define CA_PARALLEL_ZERODIV 1
+#define CA_PARALLEL_THREADS_MAX 256
+
+void    ca_parallel_for (ca_size_t n, int nogvl, ca_parallel_func_t func, void *arg);
+int     ca_parallel_reduce (ca_size_t n, int nogvl,
+                            ca_parallel_reduce_func_t func, void *arg);
+int     ca_parallel_set_error (int flag);
+
+/* --- carray_sort.c --- */
+
+int     ca_sort_values (int8_t data_type, void *ptr, ca_size_t n);
+int     ca_sort_index (int8_t data_type, void *ptr, ca_size_t *idx, ca_size_t n);
+void    ca_sort_index_fixlen (void *ptr, ca_size_t bytes, 
+                              ca_size_t *idx, ca_size_t n);
+
+/* --- carray_hash.c --- */
+
+ca_size_t ca_hash_factorize (CArray *ca, boolean8_t *m, ca_size_t *code, 
+                             ca_size_t **first);
+ca_size_t ca_hash_lookup (CArray *ca, boolean8_t *m, CArray *cq, 
+                          boolean8_t *mq, ca_size_t *code);
+VALUE     rb_ca_uniq_codes (VALUE self, int sorted, ca_size_t *code, 
+                            ca_size_t *count);
+
+/* --- bit-packed mask (carray_bitmask.c) --- */
+
+/* The mask of 64 elements is packed into a word (bit i of word j is the
+   mask of the element 64*j+i). The generated kernels take the mask as
+   the packed words, run a block without tests if the word is zero, skip
+   it if all ones, and otherwise visit the unmasked elements by the
+   trailing zero count. The entity array (CA_OBJ_ARRAY, CA_OBJ_ARRAY_WRAP)
+   can hold its mask as the packed words (mask_bits) instead of the mask
+   array. It is expanded into the mask array by ca_create_mask(), so that
+   the code reading ca->mask after ca_update_mask() or ca_attach() sees
+   the mask array as before. */
+
+#define CA_MASK_WORD_BITS 64
+
+#define ca_mask_nwords(n) \
+  ( ( (n) + CA_MASK_WORD_BITS - 1 ) / CA_MASK_WORD_BITS )
+
+#define ca_mask_word_fill(len) \
+  ( ( (len) >= CA_MASK_WORD_BITS ) ? ~ (uint64_t) 0 \
+                                   : ( ( (uint64_t) 1 << (len) ) - 1 ) )
+
+#define ca_mask_packable(ca) \
+  ( (ca)->obj_type == CA_OBJ_ARRAY || (ca)->obj_type == CA_OBJ_ARRAY_WRAP )
+
+#define ca_mask_is_packed(ca) \
+  ( ca_mask_packable(ca) && ((CArray *) (ca))->mask_bits )
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define ca_ctz64(x)       __builtin_ctzll((unsigned long long) (x))
+#  define ca_popcount64(x)  __builtin_popcountll((unsigned long long) (x))
+#else
+static inline int
+ca_ctz64 (uint64_t x)
+{
+  int i = 0;
+  while ( ! ( x & 1 ) ) {
+    x >>= 1;
+    i++;
+  }
+  return i;
+}
+
+static inline int
+ca_popcount64 (uint64_t x)
+{
+  x = x - ( ( x >> 1 ) & 0x5555555555555555ULL );
+  x = ( x & 0x3333333333333333ULL ) + ( ( x >> 2 ) & 0x3333333333333333ULL );
+  x = ( x + ( x >> 4 ) ) & 0x0f0f0f0f0f0f0f0fULL;
+  return (int) ( ( x * 0x0101010101010101ULL ) >> 56 );
+}
+#endif
+
+/* packs 8 bytes of mask (non-zero is masked) into the lower 8 bits */
+
+static inline uint64_t
+ca_mask_byte8 (const boolean8_t *m)
+{
+#ifdef WORDS_BIGENDIAN
+  uint64_t w = 0;
+  int i;
+  for (i=0; i<8; i++) {
+    w |= (uint64_t) ( m[i] != 0 ) << i;
+  }
+  return w;
+#else
+  uint64_t v;
+  memcpy(&v, m, 8);
+  v |= v >> 4;
+  v |= v >> 2;
+  v |= v >> 1;
+  return ( ( v & 0x0101010101010101ULL ) * 0x0102040810204080ULL ) >> 56;
+#endif
+}
+
+/* packs len (<= 64) bytes of mask into a word */
+
+static inline uint64_t
+ca_mask_word (const boolean8_t *m, ca_size_t len)
+{
+  uint64_t v[8], w = 0;
+  ca_size_t i;
+  if ( len == CA_MASK_WORD_BITS ) {
+    memcpy(v, m, 64);
+    if ( ! ( v[0] | v[1] | v[2] | v[3] | v[4] | v[5] | v[6] | v[7] ) ) {
+      return 0;
+    }
+    for (i=0; i<8; i++) {
+      w |= ca_mask_byte8(m + 8*i) << (8*i);
+    }
+    return w;
+  }
+  for (i=0; i<len; i++) {
+    if ( m[i] ) {
+      w |= (uint64_t) 1 << i;
+    }
+  }
+  return w;
+}
+
+void      ca_mask_pack (const boolean8_t *m, ca_size_t n, uint64_t *bits);
+void      ca_mask_pack_block (const boolean8_t *m, ca_size_t n, uint64_t *bits);
+void      ca_mask_unpack (const uint64_t *bits, ca_size_t n, boolean8_t *m);
+ca_size_t ca_mask_count (const boolean8_t *m, ca_size_t n);
+ca_size_t ca_mask_bits_count (const uint64_t *bits, ca_size_t n);
+void      ca_mask_prefer_packed (void *ap);
+void      ca_setup_mask_bits (void *ap, const uint64_t *bits);
+int       ca_mask_bits_overlay (void *ap, ca_size_t elements, int n, CArray **slist);
+void      ca_kernel_attach (void *ap);
+void      ca_kernel_sync (void *ap);
+void      ca_kernel_detach (void *ap);
+
+/* --- pairwise summation (carray_stat_proc.rb, carray_stat.c) --- */
+
+#define CA_PSUM_BLOCK 128
+#define CA_PSUM_DEPTH 64
+
+/* sums up buf[0...n] into s with 8 partial sums */
+
+#define ca_psum_block(atype, buf, n, s)                          \
+  {                                                              \
+    atype r_[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };                    \
+    int j_;                                                      \
+    for (j_=0; j_+8<=(n); j_+=8) {                               \
+      r_[0] += (buf)[j_];   r_[1] += (buf)[j_+1];                \
+      r_[2] += (buf)[j_+2]; r_[3] += (buf)[j_+3];                \
+      r_[4] += (buf)[j_+4]; r_[5] += (buf)[j_+5];                \
+      r_[6] += (buf)[j_+6]; r_[7] += (buf)[j_+7];                \
+    }                                                            \
+    (s) = ((r_[0] + r_[1]) + (r_[2] + r_[3])) +                  \
+          ((r_[4] + r_[5]) + (r_[6] + r_[7]));                   \
+    for (; j_<(n); j_++) {                                       \
+      (s) += (buf)[j_];                                          \
+    }                                                            \
+  }
+
+/* pushes the block sum s into the stack of partial sums, in which the
+   partial sums of the same number of blocks are added pairwise */
+
+#define ca_psum_push(stack, top, nblock, s)                      \
+  {                                                              \
+    ca_size_t k_;                                                \
+    for (k_=(nblock); k_ & 1; k_ >>= 1) {                        \
+      (s) = (stack)[--(top)] + (s);                              \
+    }                                                            \
+    (stack)[(top)++] = (s);                                      \
+    (nblock)++;                                                  \
+  }
+
+/* adds the partial sums left in the stack into s */
+
+#define ca_psum_finish(stack, top, s)                            \
+  {                                                              \
+    while ( (top) > 0 ) {                                        \
+      (s) = (stack)[--(top)] + (s);                              \
+    }                                                            \
+  }
+
+/* --- carray_simd.c --- */
+
+extern int ca_simd_level;
+
+void    ca_math_simd_setup (int level);      /* carray_math.c */
+void    ca_cast_simd_setup (int level);      /* carray_cast_func.c */
+
+/* --- strided view (carray_strided.c) --- */
+
+/* A strided view locates the elements of an array in the buffer of the
+   entity array at the root of its parent chain by per-dimension byte
+   strides. Entity arrays, and CABlock, CARefer (same bytes) and
+   CATranspose over them can be viewed this way. The operators run the
+   kernels on the strided views directly, without attaching (copying)
+   the virtual arrays. */
+
+typedef struct {
+  CArray   *root;                   /* entity array owning the buffer */
+  char     *ptr;                    /* address of the first element */
+  ca_size_t bytes;
+  int8_t    ndim;
+  ca_size_t dim[CA_RANK_MAX];
+  ca_size_t stride[CA_RANK_MAX];    /* in bytes */
+} CAStrided;
+
+int     ca_strided_view (void *ap, CAStrided *sv);
+void    ca_strided_set_contiguous (CAStrided *sv, int8_t ndim, ca_size_t *dim);
+int     ca_strided_is_contiguous (CAStrided *sv);
+void    ca_strided_copy (CAStrided *dst, CAStrided *src, int nogvl);
+int     ca_trans_strided_view (void *ap, CAStrided *sv); /* ca_obj_transpose.c */
+
+int     ca_strided_attach (void *ap);
+int     ca_strided_sync (void *ap);
+int     ca_strided_detach (void *ap);
+int     ca_strided_copy_data (void *ap, char *ptr);
+int     ca_strided_sync_data (void *ap, char *ptr);
+int     ca_strided_fill_data (void *ap, char *val);
+
 /* -------------------------------------------------------------------- */
 
 /* API : defining new array */
@@ -1079,9 +1379,11 @@ extern VALUE CA_UNDEF;
 extern VALUE CA_NIL;
 
 boolean8_t *ca_mask_ptr (void *ap);
+boolean8_t *ca_mask_ptr_any (void *ap);
 int     ca_has_mask (void *ap);
 int     ca_is_any_masked (void *ap);
 int     ca_is_all_masked (void *ap);
+void    ca_mask_touch (void *ap);
 void    ca_update_mask (void *ap);
 void    ca_create_mask (void *ap);
 void    ca_clear_mask (void *ap);
@@ -1139,7 +1441,7 @@ void    ca_parse_range_without_check (VALUE arg, ca_size_t size,
                         ca_size_t *offset, ca_size_t *count, ca_size_t *step);
 
 int     ca_equal (void *ap, void *bp);
-void    ca_zerodiv(void)  __attribute__((noreturn));
+void    ca_zerodiv(void);
 int32_t ca_rand (double rmax);
 ca_size_t ca_bounds_normalize_index (int8_t bounds, ca_size_t size0, ca_size_t k);
 
@@ -1380,6 +1682,23 @@ VALUE   ca_call_cfunc_7 (void (*func)(void*,void*,void*,void*,void*,void*,void*)
                          VALUE rcx5, 
                          VALUE rcx6);
 
+/* same as ca_call_cfunc_N, but the loop runs on the worker pool without
+   GVL, so func must not call the Ruby API (carray_call_cfunc.c) */
+VALUE   ca_call_cfunc_1_nogvl (void (*func)(void*),
+                               const char *fsync, VALUE rcx0);
+VALUE   ca_call_cfunc_2_nogvl (void (*func)(void*,void*),
+                               const char *fsync, VALUE rcx0, VALUE rcx1);
+VALUE   ca_call_cfunc_3_nogvl (void (*func)(void*,void*,void*),
+                               const char *fsync, VALUE rcx0, VALUE rcx1, VALUE rcx2);
+VALUE   ca_call_cfunc_4_nogvl (void (*func)(void*,void*,void*,void*),
+                               const char *fsync, VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3);
+VALUE   ca_call_cfunc_5_nogvl (void (*func)(void*,void*,void*,void*,void*),
+                               const char *fsync, VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4);
+VALUE   ca_call_cfunc_6_nogvl (void (*func)(void*,void*,void*,void*,void*,void*),
+                               const char *fsync, VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4, VALUE rcx5);
+VALUE   ca_call_cfunc_7_nogvl (void (*func)(void*,void*,void*,void*,void*,void*,void*),
+                               const char *fsync, VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4, VALUE rcx5, VALUE rcx6);
+
 VALUE   ca_call_cfunc_1_1 (int8_t dty, 
                            int8_t dtx, 
                            void (*mathfunc)(void*,void*), VALUE rx);
@@ -1390,6 +1709,18 @@ VALUE   ca_call_cfunc_1_2 (int8_t dty,
                            void (*mathfunc)(void*,void*,void*), 
                            volatile VALUE rx1, volatile VALUE rx2);
 
+VALUE   ca_call_cfunc_1_1_to (int8_t dty, 
+                              int8_t dtx, 
+                              void (*mathfunc)(void*,void*), VALUE rx,
+                              VALUE ry);
+
+VALUE   ca_call_cfunc_1_2_to (int8_t dty, 
+                              int8_t dtx1, 
+                              int8_t dtx2, 
+                              void (*mathfunc)(void*,void*,void*), 
+                              volatile VALUE rx1, volatile VALUE rx2,
+                              VALUE ry);
+
 VALUE   ca_call_cfunc_1_3 (int8_t dty, 
                            int8_t dtx1, 
                            int8_t dtx2, 
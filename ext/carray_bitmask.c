@@ -0,0 +1,431 @@
+/* ---------------------------------------------------------------------------
+
+  carray_bitmask.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  Bit-packed representation of the mask (1 bit per element). The kernels
+  generated by mkmath.rb take the mask as the packed words. The entity
+  array (CA_OBJ_ARRAY, CA_OBJ_ARRAY_WRAP) holds its mask as the packed
+  words (ca->mask_bits) instead of the boolean8 mask array when
+  CArray.packed_mask is set:
+
+  + the result of the operators (carray_operator.c, carray_lazy.c) and
+    the copy (ca_copy, clone, dup) of the array with the packed mask get
+    the packed mask by ca_copy_mask_overlay_n().
+  + CArray#mask_bits= stores the words as they are.
+  + ca_is_any_masked(), ca_is_all_masked(), ca_count_masked() and the
+    operators read the words without expanding them.
+  + ca_create_mask() (and so ca_update_mask(), ca_attach(), CArray#mask,
+    CArray#[] ...) expands the words into the mask array, and the array
+    keeps the mask array afterwards.
+
+  The mask array once created is never packed, because the mask objects
+  (CArray#mask) and the masks of the virtual arrays refer to it.
+*/
+
+#include "carray.h"
+
+static int ca_packed_mask = 0;
+
+typedef struct {
+  const boolean8_t *m;
+  uint64_t         *bits;
+  ca_size_t         n;
+  int               overlay;
+} ca_mask_pack_arg_t;
+
+static void
+ca_mask_pack_body (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_mask_pack_arg_t *a = (ca_mask_pack_arg_t *) arg;
+  ca_size_t j, k0;
+  uint64_t w;
+  for (j=start; j<end; j++) {
+    k0 = j * CA_MASK_WORD_BITS;
+    w  = ca_mask_word(a->m + k0,
+                    ( a->n - k0 < CA_MASK_WORD_BITS ) ? a->n - k0
+                                                      : CA_MASK_WORD_BITS);
+    a->bits[j] = ( a->overlay ) ? a->bits[j] | w : w;
+  }
+}
+
+/* packs n bytes of mask m into ca_mask_nwords(n) words */
+
+void
+ca_mask_pack (const boolean8_t *m, ca_size_t n, uint64_t *bits)
+{
+  ca_mask_pack_arg_t arg;
+  arg.m       = m;
+  arg.bits    = bits;
+  arg.n       = n;
+  arg.overlay = 0;
+  ca_parallel_for(ca_mask_nwords(n), 1, ca_mask_pack_body, &arg);
+}
+
+/* same as ca_mask_pack() without the worker pool (for the kernel chunks) */
+
+void
+ca_mask_pack_block (const boolean8_t *m, ca_size_t n, uint64_t *bits)
+{
+  ca_mask_pack_arg_t arg;
+  arg.m       = m;
+  arg.bits    = bits;
+  arg.n       = n;
+  arg.overlay = 0;
+  ca_mask_pack_body(0, ca_mask_nwords(n), &arg);
+}
+
+/* ORs n bytes of mask m into the words */
+
+static void
+ca_mask_pack_or (const boolean8_t *m, ca_size_t n, uint64_t *bits)
+{
+  ca_mask_pack_arg_t arg;
+  arg.m       = m;
+  arg.bits    = bits;
+  arg.n       = n;
+  arg.overlay = 1;
+  ca_parallel_for(ca_mask_nwords(n), 1, ca_mask_pack_body, &arg);
+}
+
+/* unpacks the words into n bytes of mask m */
+
+void
+ca_mask_unpack (const uint64_t *bits, ca_size_t n, boolean8_t *m)
+{
+  ca_size_t i, j, len;
+  uint64_t w;
+  for (j=0; j<ca_mask_nwords(n); j++) {
+    w   = bits[j];
+    len = ( n - j*CA_MASK_WORD_BITS < CA_MASK_WORD_BITS ) ?
+          n - j*CA_MASK_WORD_BITS : CA_MASK_WORD_BITS;
+    if ( w == 0 ) {
+      memset(m, 0, len);
+    }
+    else {
+      for (i=0; i<len; i++) {
+        m[i] = (boolean8_t) ( ( w >> i ) & 1 );
+      }
+    }
+    m += len;
+  }
+}
+
+/* returns the number of the masked elements in n bytes of mask m */
+
+ca_size_t
+ca_mask_count (const boolean8_t *m, ca_size_t n)
+{
+  ca_size_t count = 0, k0;
+  for (k0=0; k0<n; k0+=CA_MASK_WORD_BITS) {
+    count += ca_popcount64(ca_mask_word(m + k0,
+                    ( n - k0 < CA_MASK_WORD_BITS ) ? n - k0
+                                                   : CA_MASK_WORD_BITS));
+  }
+  return count;
+}
+
+/* returns the number of the masked elements in the words for n elements */
+
+ca_size_t
+ca_mask_bits_count (const uint64_t *bits, ca_size_t n)
+{
+  ca_size_t count = 0, j;
+  for (j=0; j<ca_mask_nwords(n); j++) {
+    count += ca_popcount64(bits[j]);
+  }
+  return count;
+}
+
+/* lets the mask of ca (an entity array without mask array) be created
+   as the packed words by ca_copy_mask_overlay_n() if CArray.packed_mask
+   is set */
+
+void
+ca_mask_prefer_packed (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  if ( ca_packed_mask && ca_mask_packable(ca) && ! ca->mask ) {
+    ca_set_flag(ca, CA_FLAG_MASK_PACKED);
+  }
+}
+
+static void
+ca_mask_bits_allocate (CArray *ca)
+{
+  ca_size_t nw = ca_mask_nwords(ca->elements);
+  if ( ! ca->mask_bits ) {
+    ca->mask_bits = malloc_with_check(nw * sizeof(uint64_t));
+    memset(ca->mask_bits, 0, nw * sizeof(uint64_t));
+  }
+  ca_set_flag(ca, CA_FLAG_MASK_PACKED);
+}
+
+/* sets the packed mask of ca (an entity array without mask array) to
+   the words for ca->elements */
+
+void
+ca_setup_mask_bits (void *ap, const uint64_t *bits)
+{
+  CArray *ca = (CArray *) ap;
+  ca_size_t nw = ca_mask_nwords(ca->elements);
+
+  if ( ( ! ca_mask_packable(ca) ) || ca->mask ) {
+    rb_raise(rb_eRuntimeError, "[BUG] array can not have packed mask");
+  }
+
+  ca_mask_bits_allocate(ca);
+  if ( nw > 0 ) {
+    memcpy(ca->mask_bits, bits, nw * sizeof(uint64_t));
+    ca->mask_bits[nw-1] &=
+      ca_mask_word_fill(ca->elements - (nw-1) * CA_MASK_WORD_BITS);
+  }
+}
+
+/* ca_copy_mask_overlay_n() for ca with the packed mask (or to be packed).
+   Returns 0 if the mask of ca is expanded on the way by a source which is
+   a virtual array of ca, and the overlay should be done on the mask array. */
+
+int
+ca_mask_bits_overlay (void *ap, ca_size_t elements, int n, CArray **slist)
+{
+  CArray *ca = (CArray *) ap;
+  CArray *cs;
+  uint64_t *bits;
+  ca_size_t nw, j;
+  int i;
+
+  ca_mask_bits_allocate(ca);
+
+  nw = ca_mask_nwords(elements);
+
+  for (i=0; i<n; i++) {
+    cs = slist[i];
+    if ( ( ! cs ) || cs == ca ) {
+      continue;
+    }
+    if ( ca_mask_is_packed(cs) ) {
+      bits = ca->mask_bits;
+      for (j=0; j<nw; j++) {
+        bits[j] |= cs->mask_bits[j] &
+          ca_mask_word_fill(elements - j * CA_MASK_WORD_BITS);
+      }
+      continue;
+    }
+    ca_update_mask(cs);
+    if ( ! ca->mask_bits ) {
+      return 0;
+    }
+    if ( ( ! cs->mask ) || ca_test_flag(cs->mask, CA_FLAG_MASK_CLEAN) ) {
+      continue;
+    }
+    bits = ca->mask_bits;
+    ca_attach(cs->mask);
+    if ( ca_is_scalar(cs) ) {
+      if ( *(boolean8_t *) cs->mask->ptr ) {
+        for (j=0; j<nw; j++) {
+          bits[j] |= ca_mask_word_fill(elements - j * CA_MASK_WORD_BITS);
+        }
+      }
+    }
+    else {
+      ca_mask_pack_or((boolean8_t *) cs->mask->ptr, elements, bits);
+    }
+    ca_detach(cs->mask);
+  }
+
+  return 1;
+}
+
+/*
+  ca_attach(), ca_sync() and ca_detach() for the operands given to the
+  kernels. They do nothing for the entity array with the packed mask,
+  for which ca_attach() etc. would only expand the mask.
+*/
+
+void
+ca_kernel_attach (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  if ( ! ca_mask_is_packed(ca) ) {
+    ca_attach(ca);
+  }
+}
+
+void
+ca_kernel_sync (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  if ( ! ca_mask_is_packed(ca) ) {
+    ca_sync(ca);
+  }
+}
+
+void
+ca_kernel_detach (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  if ( ! ca_mask_is_packed(ca) ) {
+    ca_detach(ca);
+  }
+}
+
+/* @overload packed_mask
+
+(Masking, Configuration)
+Returns true if the masks of the new arrays created by the operators
+are held as the packed words (1 bit per element) instead of the boolean8
+mask array. The default is false. See CArray.packed_mask=.
+*/
+
+static VALUE
+rb_ca_s_packed_mask (VALUE klass)
+{
+  return ( ca_packed_mask ) ? Qtrue : Qfalse;
+}
+
+/* @overload packed_mask= (flag)
+
+(Masking, Configuration)
+Sets whether the masks of the results of the operators and of the
+copies of the arrays with the packed mask (to_ca, clone, dup) and the
+masks given by CArray#mask_bits= are held as the packed words. The
+operators, CArray#any_masked?, CArray#all_masked? and
+CArray#count_masked read the packed words as they are. The other methods
+(CArray#mask, CArray#[] etc.) expand them into the mask array, which the
+array keeps afterwards. CArray#mask and CArray#mask= behave as before.
+*/
+
+static VALUE
+rb_ca_s_set_packed_mask (VALUE klass, VALUE rflag)
+{
+  ca_packed_mask = RTEST(rflag) ? 1 : 0;
+  return rflag;
+}
+
+/* @overload mask_packed?
+
+(Masking, Inquiry)
+Returns true if the mask of <code>self</code> is held as the packed
+words (see CArray.packed_mask=).
+*/
+
+static VALUE
+rb_ca_is_mask_packed (VALUE self)
+{
+  CArray *ca;
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  return ( ca_mask_is_packed(ca) ) ? Qtrue : Qfalse;
+}
+
+/* @overload mask_bits
+
+(Masking, Conversion)
+Returns the mask state of <code>self</code> packed into an uint64 array
+of (elements+63)/64 words (bit i of the word j is the mask of the element
+at the address 64*j+i). Returns 0 if <code>self</code> has no mask array
+(same as CArray#mask).
+*/
+
+static VALUE
+rb_ca_mask_bits (VALUE self)
+{
+  volatile VALUE out;
+  CArray *ca, *co;
+  ca_size_t nw;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  nw = ca_mask_nwords(ca->elements);
+
+  if ( ca_mask_is_packed(ca) ) {
+    out = rb_carray_new(CA_UINT64, 1, &nw, 0, NULL);
+    TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+    memcpy(co->ptr, ca->mask_bits, nw * sizeof(uint64_t));
+    return out;
+  }
+
+  ca_update_mask(ca);
+  if ( ! ca->mask ) {
+    return INT2NUM(0);
+  }
+
+  out = rb_carray_new(CA_UINT64, 1, &nw, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  ca_attach(ca);
+  ca_mask_pack((boolean8_t *) ca->mask->ptr, ca->elements,
+               (uint64_t *) co->ptr);
+  ca_detach(ca);
+
+  return out;
+}
+
+/* @overload mask_bits= (bits)
+
+(Masking, Modification)
+Sets the mask state of <code>self</code> from the packed words
+given by CArray#mask_bits. The words are stored as the packed mask
+if CArray.packed_mask is set and <code>self</code> is an entity array
+without the mask array.
+*/
+
+static VALUE
+rb_ca_set_mask_bits (VALUE self, VALUE rbits)
+{
+  volatile VALUE rb, rmask;
+  CArray *ca, *cb, *cm;
+
+  rb_ca_modify(self);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  rb = rb_ca_wrap_readonly(rbits, INT2NUM(CA_UINT64));
+  TypedData_Get_Struct(rb, CArray, &carray_data_type, cb);
+
+  if ( cb->elements != ca_mask_nwords(ca->elements) ) {
+    rb_raise(rb_eArgError,
+             "number of words (%lld) should be %lld for %lld elements",
+             (long long) cb->elements,
+             (long long) ca_mask_nwords(ca->elements),
+             (long long) ca->elements);
+  }
+
+  ca_mask_prefer_packed(ca);
+  if ( ca_mask_is_packed(ca) ||
+       ( ( ! ca->mask ) && ca_test_flag(ca, CA_FLAG_MASK_PACKED) ) ) {
+    ca_attach(cb);
+    ca_setup_mask_bits(ca, (uint64_t *) cb->ptr);
+    ca_detach(cb);
+    return rbits;
+  }
+
+  rmask = rb_carray_new(CA_BOOLEAN, ca->ndim, ca->dim, 0, NULL);
+  TypedData_Get_Struct(rmask, CArray, &carray_data_type, cm);
+
+  ca_attach(cb);
+  ca_mask_unpack((uint64_t *) cb->ptr, cm->elements, (boolean8_t *) cm->ptr);
+  ca_detach(cb);
+
+  rb_ca_set_mask(self, rmask);
+
+  return rbits;
+}
+
+void
+Init_carray_bitmask ()
+{
+  rb_define_singleton_method(rb_cCArray, "packed_mask",
+                             rb_ca_s_packed_mask, 0);
+  rb_define_singleton_method(rb_cCArray, "packed_mask=",
+                             rb_ca_s_set_packed_mask, 1);
+  rb_define_method(rb_cCArray, "mask_packed?", rb_ca_is_mask_packed, 0);
+  rb_define_method(rb_cCArray, "mask_bits",  rb_ca_mask_bits, 0);
+  rb_define_method(rb_cCArray, "mask_bits=", rb_ca_set_mask_bits, 1);
+}
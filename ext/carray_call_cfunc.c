@@ -10,8 +10,71 @@
 
 #include "carray.h"
 
-VALUE
-ca_call_cfunc_1 (void (*func)(void *p0), const char *fsync,
+/* 
+  ca_call_cfunc_N() calls the element function serially with GVL held,
+  so that the function may use the Ruby API (e.g. rb_raise).
+  ca_call_cfunc_N_nogvl() is for pure C element functions, and the loop
+  is processed by the worker pool without GVL (see carray_parallel.c).
+*/
+
+typedef void (*ca_cfunc1_t)(void*);
+typedef void (*ca_cfunc2_t)(void*,void*);
+typedef void (*ca_cfunc3_t)(void*,void*,void*);
+typedef void (*ca_cfunc4_t)(void*,void*,void*,void*);
+typedef void (*ca_cfunc5_t)(void*,void*,void*,void*,void*);
+typedef void (*ca_cfunc6_t)(void*,void*,void*,void*,void*,void*);
+typedef void (*ca_cfunc7_t)(void*,void*,void*,void*,void*,void*,void*);
+
+typedef struct {
+  int         nargs;
+  void       *func;
+  boolean8_t *m;
+  char      **q;
+  ca_size_t  *s;
+} ca_cfunc_loop_t;
+
+static void
+ca_cfunc_loop_chunk (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_cfunc_loop_t *c = (ca_cfunc_loop_t *) arg;
+  char *p[7];
+  ca_size_t k;
+  int i;
+
+#define proc_cfunc_loop(call) \
+  for (k=start; k<end; k++) { \
+    if ( c->m && c->m[k] ) { \
+      continue; \
+    } \
+    for (i=0; i<c->nargs; i++) { \
+      p[i] = c->q[i] + k*c->s[i]; \
+    } \
+    call; \
+  }
+
+  switch ( c->nargs ) {
+  case 1: proc_cfunc_loop(((ca_cfunc1_t)c->func)(p[0])); break;
+  case 2: proc_cfunc_loop(((ca_cfunc2_t)c->func)(p[0],p[1])); break;
+  case 3: proc_cfunc_loop(((ca_cfunc3_t)c->func)(p[0],p[1],p[2])); break;
+  case 4: proc_cfunc_loop(((ca_cfunc4_t)c->func)(p[0],p[1],p[2],p[3])); break;
+  case 5: proc_cfunc_loop(((ca_cfunc5_t)c->func)(p[0],p[1],p[2],p[3],p[4])); break;
+  case 6: proc_cfunc_loop(((ca_cfunc6_t)c->func)(p[0],p[1],p[2],p[3],p[4],p[5])); break;
+  case 7: proc_cfunc_loop(((ca_cfunc7_t)c->func)(p[0],p[1],p[2],p[3],p[4],p[5],p[6])); break;
+  }
+
+#undef proc_cfunc_loop
+}
+
+static void
+ca_call_cfunc_loop (int nargs, void *func, boolean8_t *m, ca_size_t n, 
+                    char **q, ca_size_t *s, int nogvl)
+{
+  ca_cfunc_loop_t c = { nargs, func, m, q, s };
+  ca_parallel_for(n, nogvl, ca_cfunc_loop_chunk, &c);
+}
+
+static VALUE
+ca_call_cfunc_1_run (int nogvl, void (*func)(void *p0), const char *fsync,
                           VALUE rcx0)
 {
   CArray *cx0;
@@ -27,18 +90,14 @@ ca_call_cfunc_1 (void (*func)(void *p0), const char *fsync,
   ca_attach(cx0);
 
   {
-    char      *p0;
     char      *q0;
     ca_size_t    s0;
-    ca_size_t    k;
     n = ca_set_iterator(1, cx0, &q0, &s0);
     s0 *= cx0->bytes;
-    #ifdef _OPENMP
-    #pragma omp parallel for private(p0)
-    #endif
-    for (k=0; k<n; k++) {
-      p0 = q0 + k*s0;
-      func(p0);
+    {
+      char      *q[] = { q0 };
+      ca_size_t  s[] = { s0 };
+      ca_call_cfunc_loop(1, (void *) func, NULL, n, q, s, nogvl);
     }
   }
 
@@ -48,13 +107,27 @@ ca_call_cfunc_1 (void (*func)(void *p0), const char *fsync,
   return rcx0;
 }
 
+VALUE
+ca_call_cfunc_1 (void (*func)(void *p0), const char *fsync,
+                          VALUE rcx0)
+{
+  return ca_call_cfunc_1_run(0, func, fsync, rcx0);
+}
 
 VALUE
-ca_call_cfunc_2 (void (*func)(void *p0, void *p1), const char *fsync,
+ca_call_cfunc_1_nogvl (void (*func)(void *p0), const char *fsync,
+                          VALUE rcx0)
+{
+  return ca_call_cfunc_1_run(1, func, fsync, rcx0);
+}
+
+
+static VALUE
+ca_call_cfunc_2_run (int nogvl, void (*func)(void *p0, void *p1), const char *fsync,
                           VALUE rcx0, VALUE rcx1)
 {
   CArray *cx0, *cx1;
-  boolean8_t *m0 = NULL, *m;
+  boolean8_t *m0 = NULL;
   ca_size_t n;
 
   if ( strlen(fsync) != 2 ) {
@@ -72,44 +145,24 @@ ca_call_cfunc_2 (void (*func)(void *p0, void *p1), const char *fsync,
     int i = 0;
     if ( fsync[0] == '0' ) cx[i++] = cx0;
     if ( fsync[1] == '0' ) cx[i++] = cx1;
-    m = m0 = ca_allocate_mask_iterator_n(i, cx);
+    m0 = ca_allocate_mask_iterator_n(i, cx);
     if ( fsync[0] == '1' ) ca_copy_mask_overwrite_n(cx0, cx0->elements, i, cx);
     if ( fsync[1] == '1' ) ca_copy_mask_overwrite_n(cx1, cx1->elements, i, cx);
   }
 
   {
-    char      *p0, *p1;
     char      *q0, *q1;
     ca_size_t    s0,  s1;
-    ca_size_t    k;
 
     n = ca_set_iterator(2, cx0, &q0, &s0,
                            cx1, &q1, &s1);
     s0 *= cx0->bytes;
     s1 *= cx1->bytes;
 
-    if ( m0 ) {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1)
-      #endif
-      for (k=0; k<n; k++) {
-        m = m0 + k;
-        if ( ! *m ) { 
-          p0 = q0 + k*s0; 
-          p1 = q1 + k*s1;
-          func(p0, p1);        
-        }
-      }
-    }
-    else {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1)
-      #endif
-      for (k=0; k<n; k++) {
-        p0 = q0 + k*s0; 
-        p1 = q1 + k*s1;
-        func(p0, p1);        
-      }
+    {
+      char      *q[] = { q0, q1 };
+      ca_size_t  s[] = { s0, s1 };
+      ca_call_cfunc_loop(2, (void *) func, m0, n, q, s, nogvl);
     }
   }
   if ( fsync[0] == '1' ) ca_sync(cx0);
@@ -122,11 +175,25 @@ ca_call_cfunc_2 (void (*func)(void *p0, void *p1), const char *fsync,
 }
 
 VALUE
-ca_call_cfunc_3 (void (*func)(void *p0, void *p1, void *p2), const char *fsync,
+ca_call_cfunc_2 (void (*func)(void *p0, void *p1), const char *fsync,
+                          VALUE rcx0, VALUE rcx1)
+{
+  return ca_call_cfunc_2_run(0, func, fsync, rcx0, rcx1);
+}
+
+VALUE
+ca_call_cfunc_2_nogvl (void (*func)(void *p0, void *p1), const char *fsync,
+                          VALUE rcx0, VALUE rcx1)
+{
+  return ca_call_cfunc_2_run(1, func, fsync, rcx0, rcx1);
+}
+
+static VALUE
+ca_call_cfunc_3_run (int nogvl, void (*func)(void *p0, void *p1, void *p2), const char *fsync,
                           VALUE rcx0, VALUE rcx1, VALUE rcx2)
 {
   CArray *cx0, *cx1, *cx2;
-  boolean8_t *m0 = NULL, *m;
+  boolean8_t *m0 = NULL;
   ca_size_t n;
 
   if ( strlen(fsync) != 3 ) {
@@ -146,17 +213,15 @@ ca_call_cfunc_3 (void (*func)(void *p0, void *p1, void *p2), const char *fsync,
     if ( fsync[0] == '0' ) cx[i++] = cx0;
     if ( fsync[1] == '0' ) cx[i++] = cx1;
     if ( fsync[2] == '0' ) cx[i++] = cx2;
-    m = m0 = ca_allocate_mask_iterator_n(i, cx);
+    m0 = ca_allocate_mask_iterator_n(i, cx);
     if ( fsync[0] == '1' ) ca_copy_mask_overwrite_n(cx0, cx0->elements, i, cx);
     if ( fsync[1] == '1' ) ca_copy_mask_overwrite_n(cx1, cx1->elements, i, cx);
     if ( fsync[2] == '1' ) ca_copy_mask_overwrite_n(cx2, cx2->elements, i, cx);
   }
 
   {
-    char      *p0, *p1, *p2;
     char      *q0, *q1, *q2;
     ca_size_t    s0,  s1,  s2;
-    ca_size_t    k;
 
     n = ca_set_iterator(3, cx0, &q0, &s0,
                            cx1, &q1, &s1,
@@ -165,30 +230,10 @@ ca_call_cfunc_3 (void (*func)(void *p0, void *p1, void *p2), const char *fsync,
     s1 *= cx1->bytes;
     s2 *= cx2->bytes;
 
-    if ( m0 ) {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2)
-      #endif
-      for (k=0; k<n; k++) {
-        m = m0 + k;
-        if ( ! *m ) { 
-          p0 = q0 + k*s0; 
-          p1 = q1 + k*s1;
-          p2 = q2 + k*s2;
-          func(p0, p1, p2);      
-        }
-      }
-    }
-    else {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2)
-      #endif
-      for (k=0; k<n; k++) {
-        p0 = q0 + k*s0; 
-        p1 = q1 + k*s1;
-        p2 = q2 + k*s2;
-        func(p0, p1, p2);      
-      }
+    {
+      char      *q[] = { q0, q1, q2 };
+      ca_size_t  s[] = { s0, s1, s2 };
+      ca_call_cfunc_loop(3, (void *) func, m0, n, q, s, nogvl);
     }
   }
   if ( fsync[0] == '1' ) ca_sync(cx0);
@@ -202,11 +247,25 @@ ca_call_cfunc_3 (void (*func)(void *p0, void *p1, void *p2), const char *fsync,
 }
 
 VALUE
-ca_call_cfunc_4 (void (*func)(void *p0, void *p1, void *p2, void *p3), const char *fsync,
+ca_call_cfunc_3 (void (*func)(void *p0, void *p1, void *p2), const char *fsync,
+                          VALUE rcx0, VALUE rcx1, VALUE rcx2)
+{
+  return ca_call_cfunc_3_run(0, func, fsync, rcx0, rcx1, rcx2);
+}
+
+VALUE
+ca_call_cfunc_3_nogvl (void (*func)(void *p0, void *p1, void *p2), const char *fsync,
+                          VALUE rcx0, VALUE rcx1, VALUE rcx2)
+{
+  return ca_call_cfunc_3_run(1, func, fsync, rcx0, rcx1, rcx2);
+}
+
+static VALUE
+ca_call_cfunc_4_run (int nogvl, void (*func)(void *p0, void *p1, void *p2, void *p3), const char *fsync,
                                             VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3)
 {
   CArray *cx0, *cx1, *cx2, *cx3;
-  boolean8_t *m0 = NULL, *m;
+  boolean8_t *m0 = NULL;
   ca_size_t n;
 
   if ( strlen(fsync) != 4 ) {
@@ -228,7 +287,7 @@ ca_call_cfunc_4 (void (*func)(void *p0, void *p1, void *p2, void *p3), const cha
     if ( fsync[1] == '0' ) cx[i++] = cx1;
     if ( fsync[2] == '0' ) cx[i++] = cx2;
     if ( fsync[3] == '0' ) cx[i++] = cx3;
-    m = m0 = ca_allocate_mask_iterator_n(i, cx);
+    m0 = ca_allocate_mask_iterator_n(i, cx);
     if ( fsync[0] == '1' ) ca_copy_mask_overwrite_n(cx0, cx0->elements, i, cx);
     if ( fsync[1] == '1' ) ca_copy_mask_overwrite_n(cx1, cx1->elements, i, cx);
     if ( fsync[2] == '1' ) ca_copy_mask_overwrite_n(cx2, cx2->elements, i, cx);
@@ -236,10 +295,8 @@ ca_call_cfunc_4 (void (*func)(void *p0, void *p1, void *p2, void *p3), const cha
   }
 
   {
-    char      *p0, *p1, *p2, *p3;
     char      *q0, *q1, *q2, *q3;
     ca_size_t    s0,  s1,  s2,  s3;
-    ca_size_t    k;
 
     n = ca_set_iterator(4, cx0, &q0, &s0,
                            cx1, &q1, &s1,
@@ -251,32 +308,10 @@ ca_call_cfunc_4 (void (*func)(void *p0, void *p1, void *p2, void *p3), const cha
     s2 *= cx2->bytes;
     s3 *= cx3->bytes;
 
-    if ( m0 ) {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2,p3)
-      #endif
-      for (k=0; k<n; k++) {
-        m = m0 + k;
-        if ( ! *m ) { 
-          p0 = q0 + k*s0; 
-          p1 = q1 + k*s1;
-          p2 = q2 + k*s2;
-          p3 = q3 + k*s3;
-          func(p0, p1, p2, p3);      
-        }
-      }
-    }
-    else {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2,p3)
-      #endif
-      for (k=0; k<n; k++) {
-        p0 = q0 + k*s0; 
-        p1 = q1 + k*s1;
-        p2 = q2 + k*s2;
-        p3 = q3 + k*s3;
-        func(p0, p1, p2, p3);      
-      }
+    {
+      char      *q[] = { q0, q1, q2, q3 };
+      ca_size_t  s[] = { s0, s1, s2, s3 };
+      ca_call_cfunc_loop(4, (void *) func, m0, n, q, s, nogvl);
     }
   }
   if ( fsync[0] == '1' ) ca_sync(cx0);
@@ -291,11 +326,25 @@ ca_call_cfunc_4 (void (*func)(void *p0, void *p1, void *p2, void *p3), const cha
 }
 
 VALUE
-ca_call_cfunc_5 (void (*func)(void*,void*,void*,void*,void*), const char *fsync,
+ca_call_cfunc_4 (void (*func)(void *p0, void *p1, void *p2, void *p3), const char *fsync,
+                                            VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3)
+{
+  return ca_call_cfunc_4_run(0, func, fsync, rcx0, rcx1, rcx2, rcx3);
+}
+
+VALUE
+ca_call_cfunc_4_nogvl (void (*func)(void *p0, void *p1, void *p2, void *p3), const char *fsync,
+                                            VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3)
+{
+  return ca_call_cfunc_4_run(1, func, fsync, rcx0, rcx1, rcx2, rcx3);
+}
+
+static VALUE
+ca_call_cfunc_5_run (int nogvl, void (*func)(void*,void*,void*,void*,void*), const char *fsync,
                                             VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4)
 {
   CArray *cx0, *cx1, *cx2, *cx3, *cx4;
-  boolean8_t *m0 = NULL, *m;
+  boolean8_t *m0 = NULL;
   ca_size_t n;
 
   if ( strlen(fsync) != 5 ) {
@@ -319,7 +368,7 @@ ca_call_cfunc_5 (void (*func)(void*,void*,void*,void*,void*), const char *fsync,
     if ( fsync[2] == '0' ) cx[i++] = cx2;
     if ( fsync[3] == '0' ) cx[i++] = cx3;
     if ( fsync[4] == '0' ) cx[i++] = cx4;
-    m = m0 = ca_allocate_mask_iterator_n(i, cx);
+    m0 = ca_allocate_mask_iterator_n(i, cx);
     if ( fsync[0] == '1' ) ca_copy_mask_overwrite_n(cx0, cx0->elements, i, cx);
     if ( fsync[1] == '1' ) ca_copy_mask_overwrite_n(cx1, cx1->elements, i, cx);
     if ( fsync[2] == '1' ) ca_copy_mask_overwrite_n(cx2, cx2->elements, i, cx);
@@ -328,10 +377,8 @@ ca_call_cfunc_5 (void (*func)(void*,void*,void*,void*,void*), const char *fsync,
   }
 
   {
-    char      *p0, *p1, *p2, *p3, *p4;
     char      *q0, *q1, *q2, *q3, *q4;
     ca_size_t    s0,  s1,  s2,  s3,  s4;
-    ca_size_t    k;
 
     n = ca_set_iterator(5, cx0, &q0, &s0,
                            cx1, &q1, &s1,
@@ -345,34 +392,10 @@ ca_call_cfunc_5 (void (*func)(void*,void*,void*,void*,void*), const char *fsync,
     s3 *= cx3->bytes;
     s4 *= cx4->bytes;
 
-    if ( m0 ) {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2,p3,p4)
-      #endif
-      for (k=0; k<n; k++) {
-        m = m0 + k;
-        if ( ! *m ) { 
-          p0 = q0 + k*s0; 
-          p1 = q1 + k*s1;
-          p2 = q2 + k*s2;
-          p3 = q3 + k*s3;
-          p4 = q4 + k*s4;
-          func(p0, p1, p2, p3, p4);      
-        }
-      }
-    }
-    else {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2,p3,p4)
-      #endif
-      for (k=0; k<n; k++) {
-        p0 = q0 + k*s0; 
-        p1 = q1 + k*s1;
-        p2 = q2 + k*s2;
-        p3 = q3 + k*s3;
-        p4 = q4 + k*s4;
-        func(p0, p1, p2, p3, p4);      
-      }
+    {
+      char      *q[] = { q0, q1, q2, q3, q4 };
+      ca_size_t  s[] = { s0, s1, s2, s3, s4 };
+      ca_call_cfunc_loop(5, (void *) func, m0, n, q, s, nogvl);
     }
   }
   if ( fsync[0] == '1' ) ca_sync(cx0);
@@ -388,11 +411,25 @@ ca_call_cfunc_5 (void (*func)(void*,void*,void*,void*,void*), const char *fsync,
 }
 
 VALUE
-ca_call_cfunc_6 (void (*func)(void*,void*,void*,void*,void*,void*), const char *fsync,
+ca_call_cfunc_5 (void (*func)(void*,void*,void*,void*,void*), const char *fsync,
+                                            VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4)
+{
+  return ca_call_cfunc_5_run(0, func, fsync, rcx0, rcx1, rcx2, rcx3, rcx4);
+}
+
+VALUE
+ca_call_cfunc_5_nogvl (void (*func)(void*,void*,void*,void*,void*), const char *fsync,
+                                            VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4)
+{
+  return ca_call_cfunc_5_run(1, func, fsync, rcx0, rcx1, rcx2, rcx3, rcx4);
+}
+
+static VALUE
+ca_call_cfunc_6_run (int nogvl, void (*func)(void*,void*,void*,void*,void*,void*), const char *fsync,
                                             VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4, VALUE rcx5)
 {
   CArray *cx0, *cx1, *cx2, *cx3, *cx4, *cx5;
-  boolean8_t *m0 = NULL, *m;
+  boolean8_t *m0 = NULL;
   ca_size_t n;
 
   if ( strlen(fsync) != 6 ) {
@@ -418,7 +455,7 @@ ca_call_cfunc_6 (void (*func)(void*,void*,void*,void*,void*,void*), const char *
     if ( fsync[3] == '0' ) cx[i++] = cx3;
     if ( fsync[4] == '0' ) cx[i++] = cx4;
     if ( fsync[5] == '0' ) cx[i++] = cx5;
-    m = m0 = ca_allocate_mask_iterator_n(i, cx);
+    m0 = ca_allocate_mask_iterator_n(i, cx);
     if ( fsync[0] == '1' ) ca_copy_mask_overwrite_n(cx0, cx0->elements, i, cx);
     if ( fsync[1] == '1' ) ca_copy_mask_overwrite_n(cx1, cx1->elements, i, cx);
     if ( fsync[2] == '1' ) ca_copy_mask_overwrite_n(cx2, cx2->elements, i, cx);
@@ -428,10 +465,8 @@ ca_call_cfunc_6 (void (*func)(void*,void*,void*,void*,void*,void*), const char *
   }
 
   {
-    char      *p0, *p1, *p2, *p3, *p4, *p5;
     char      *q0, *q1, *q2, *q3, *q4, *q5;
     ca_size_t    s0,  s1,  s2,  s3,  s4,  s5;
-    ca_size_t    k;
 
     n = ca_set_iterator(6, cx0, &q0, &s0,
                            cx1, &q1, &s1,
@@ -447,36 +482,10 @@ ca_call_cfunc_6 (void (*func)(void*,void*,void*,void*,void*,void*), const char *
     s4 *= cx4->bytes;
     s5 *= cx5->bytes;
 
-    if ( m0 ) {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2,p3,p4,p5)
-      #endif
-      for (k=0; k<n; k++) {
-        m = m0 + k;
-        if ( ! *m ) { 
-          p0 = q0 + k*s0; 
-          p1 = q1 + k*s1;
-          p2 = q2 + k*s2;
-          p3 = q3 + k*s3;
-          p4 = q4 + k*s4;
-          p5 = q5 + k*s5;
-          func(p0, p1, p2, p3, p4, p5);      
-        }
-      }
-    }
-    else {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2,p3,p4,p5)
-      #endif
-      for (k=0; k<n; k++) {
-        p0 = q0 + k*s0; 
-        p1 = q1 + k*s1;
-        p2 = q2 + k*s2;
-        p3 = q3 + k*s3;
-        p4 = q4 + k*s4;
-        p5 = q5 + k*s5;
-        func(p0, p1, p2, p3, p4, p5);      
-      }
+    {
+      char      *q[] = { q0, q1, q2, q3, q4, q5 };
+      ca_size_t  s[] = { s0, s1, s2, s3, s4, s5 };
+      ca_call_cfunc_loop(6, (void *) func, m0, n, q, s, nogvl);
     }
   }
   if ( fsync[0] == '1' ) ca_sync(cx0);
@@ -493,11 +502,25 @@ ca_call_cfunc_6 (void (*func)(void*,void*,void*,void*,void*,void*), const char *
 }
 
 VALUE
-ca_call_cfunc_7 (void (*func)(void*,void*,void*,void*,void*,void*,void*), const char *fsync,
+ca_call_cfunc_6 (void (*func)(void*,void*,void*,void*,void*,void*), const char *fsync,
+                                            VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4, VALUE rcx5)
+{
+  return ca_call_cfunc_6_run(0, func, fsync, rcx0, rcx1, rcx2, rcx3, rcx4, rcx5);
+}
+
+VALUE
+ca_call_cfunc_6_nogvl (void (*func)(void*,void*,void*,void*,void*,void*), const char *fsync,
+                                            VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4, VALUE rcx5)
+{
+  return ca_call_cfunc_6_run(1, func, fsync, rcx0, rcx1, rcx2, rcx3, rcx4, rcx5);
+}
+
+static VALUE
+ca_call_cfunc_7_run (int nogvl, void (*func)(void*,void*,void*,void*,void*,void*,void*), const char *fsync,
                                             VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4, VALUE rcx5, VALUE rcx6)
 {
   CArray *cx0, *cx1, *cx2, *cx3, *cx4, *cx5, *cx6;
-  boolean8_t *m0 = NULL, *m;
+  boolean8_t *m0 = NULL;
   ca_size_t n;
 
   if ( strlen(fsync) != 7 ) {
@@ -525,7 +548,7 @@ ca_call_cfunc_7 (void (*func)(void*,void*,void*,void*,void*,void*,void*), const
     if ( fsync[4] == '0' ) cx[i++] = cx4;
     if ( fsync[5] == '0' ) cx[i++] = cx5;
     if ( fsync[6] == '0' ) cx[i++] = cx6;
-    m = m0 = ca_allocate_mask_iterator_n(i, cx);
+    m0 = ca_allocate_mask_iterator_n(i, cx);
     if ( fsync[0] == '1' ) ca_copy_mask_overwrite_n(cx0, cx0->elements, i, cx);
     if ( fsync[1] == '1' ) ca_copy_mask_overwrite_n(cx1, cx1->elements, i, cx);
     if ( fsync[2] == '1' ) ca_copy_mask_overwrite_n(cx2, cx2->elements, i, cx);
@@ -536,10 +559,8 @@ ca_call_cfunc_7 (void (*func)(void*,void*,void*,void*,void*,void*,void*), const
   }
 
   {
-    char      *p0, *p1, *p2, *p3, *p4, *p5, *p6;
     char      *q0, *q1, *q2, *q3, *q4, *q5, *q6;
     ca_size_t    s0,  s1,  s2,  s3,  s4,  s5,  s6;
-    ca_size_t    k;
 
     n = ca_set_iterator(7, cx0, &q0, &s0,
                            cx1, &q1, &s1,
@@ -557,38 +578,10 @@ ca_call_cfunc_7 (void (*func)(void*,void*,void*,void*,void*,void*,void*), const
     s5 *= cx5->bytes;
     s6 *= cx6->bytes;
 
-    if ( m0 ) {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2,p3,p4,p5,p6)
-      #endif
-      for (k=0; k<n; k++) {
-        m = m0 + k;
-        if ( ! *m ) { 
-          p0 = q0 + k*s0; 
-          p1 = q1 + k*s1;
-          p2 = q2 + k*s2;
-          p3 = q3 + k*s3;
-          p4 = q4 + k*s4;
-          p5 = q5 + k*s5;
-          p6 = q6 + k*s6;
-          func(p0, p1, p2, p3, p4, p5, p6);      
-        }
-      }
-    }
-    else {
-      #ifdef _OPENMP
-      #pragma omp parallel for private(p0,p1,p2,p3,p4,p5,p6)
-      #endif
-      for (k=0; k<n; k++) {
-        p0 = q0 + k*s0; 
-        p1 = q1 + k*s1;
-        p2 = q2 + k*s2;
-        p3 = q3 + k*s3;
-        p4 = q4 + k*s4;
-        p5 = q5 + k*s5;
-        p6 = q6 + k*s6;
-        func(p0, p1, p2, p3, p4, p5, p6);      
-      }
+    {
+      char      *q[] = { q0, q1, q2, q3, q4, q5, q6 };
+      ca_size_t  s[] = { s0, s1, s2, s3, s4, s5, s6 };
+      ca_call_cfunc_loop(7, (void *) func, m0, n, q, s, nogvl);
     }
 
   }
@@ -606,6 +599,20 @@ ca_call_cfunc_7 (void (*func)(void*,void*,void*,void*,void*,void*,void*), const
   return rcx0;
 }
 
+VALUE
+ca_call_cfunc_7 (void (*func)(void*,void*,void*,void*,void*,void*,void*), const char *fsync,
+                                            VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4, VALUE rcx5, VALUE rcx6)
+{
+  return ca_call_cfunc_7_run(0, func, fsync, rcx0, rcx1, rcx2, rcx3, rcx4, rcx5, rcx6);
+}
+
+VALUE
+ca_call_cfunc_7_nogvl (void (*func)(void*,void*,void*,void*,void*,void*,void*), const char *fsync,
+                                            VALUE rcx0, VALUE rcx1, VALUE rcx2, VALUE rcx3, VALUE rcx4, VALUE rcx5, VALUE rcx6)
+{
+  return ca_call_cfunc_7_run(1, func, fsync, rcx0, rcx1, rcx2, rcx3, rcx4, rcx5, rcx6);
+}
+
 /* -------------------------------------------------------------------- */
 
 VALUE
@@ -657,6 +664,40 @@ ca_call_cfunc_1_2 (int8_t dty,
   }
 }
 
+/* stores the results of ca_call_cfunc_1_1 and ca_call_cfunc_1_2 into the
+   existing array ry (out: option), and returns ry */
+
+VALUE
+ca_call_cfunc_1_1_to (int8_t dty, int8_t dtx, 
+                      void (*mathfunc)(void*,void*), VALUE rx, VALUE ry) 
+{ 
+  CArray *cx;
+  rx = rb_ca_wrap_readonly(rx, INT2NUM(dtx)); 
+  TypedData_Get_Struct(rx, CArray, &carray_data_type, cx);
+  ca_check_out(ry, dty, cx->elements);
+  ca_call_cfunc_2(mathfunc, "10", ry, rx); 
+  return ry;
+}
+
+VALUE
+ca_call_cfunc_1_2_to (int8_t dty, 
+                      int8_t dtx1, 
+                      int8_t dtx2, 
+                      void (*mathfunc)(void*,void*,void*), 
+                      volatile VALUE rx1, 
+                      volatile VALUE rx2,
+                      VALUE ry) 
+{ 
+  CArray *cx1, *cx2;
+  rx1 = rb_ca_wrap_readonly(rx1, INT2NUM(dtx1)); 
+  rx2 = rb_ca_wrap_readonly(rx2, INT2NUM(dtx2)); 
+  TypedData_Get_Struct(rx1, CArray, &carray_data_type, cx1);
+  TypedData_Get_Struct(rx2, CArray, &carray_data_type, cx2);
+  ca_check_out(ry, dty, 
+               ( ca_is_scalar(cx1) ) ? cx2->elements : cx1->elements);
+  ca_call_cfunc_3(mathfunc, "100", ry, rx1, rx2); 
+  return ry;
+}
 
 VALUE
 ca_call_cfunc_1_3 (int8_t dty, 
@@ -136,6 +136,26 @@ OBJECT = [
 ]
 
 CA_CAST_TABLE = {}
+
+#
+# The casts between the types in SIMD_TYPES are also emitted in the ISA
+# variants (see SIMD_VARIANTS in mkmath.rb), and ca_cast_simd_setup()
+# copies the variants of the selected level into ca_cast_func_table
+#
+
+SIMD_VARIANTS = [
+  ["sse42",  "CA_TARGET_SSE42"],
+  ["avx2",   "CA_TARGET_AVX2"],
+  ["avx512", "CA_TARGET_AVX512"],
+]
+
+SIMD_TYPES = [
+  CA_BOOLEAN, CA_INT8, CA_UINT8, CA_INT16, CA_UINT16, CA_INT32, CA_UINT32,
+  CA_INT64, CA_UINT64, CA_FLOAT32, CA_FLOAT64, CA_CMPLX64, CA_CMPLX128
+]
+
+SIMD_DEFS    = []
+CA_CAST_SIMD = []
 data_type.each do |type1|
   CA_CAST_TABLE[type1] = Hash.new("ca_cast_not_implemented")
 end
@@ -321,43 +341,37 @@ puts
     ctype1 = ctype[type1]
     ctype2 = ctype[type2]
     CA_CAST_TABLE[type1][type2] = "ca_cast_#{ctype1}_#{ctype2}"
-    puts <<-END_DEF  .gsub(/^ {6}/, '')
-      static void
-      ca_cast_#{ctype1}_#{ctype2}(ca_size_t n, CArray *a1, void *ptr1, CArray *a2, void *ptr2, boolean8_t *m)
+    kernel = lambda { |suffix, target| <<-END_DEF  .gsub(/^ {6}/, '') }
+      static #{target}void
+      ca_cast_#{ctype1}_#{ctype2}#{suffix}(ca_size_t n, CArray *a1, void *ptr1, CArray *a2, void *ptr2, boolean8_t *m)
       {
          #{ctype1} *q1 = ptr1;
-         #{ctype1} *p1 = q1;
          #{ctype2} *q2 = ptr2;
-         #{ctype2} *p2 = q2;
          ca_size_t k;
          if ( m ) {
-           boolean8_t *pm = m;
-           #ifdef _OPENMP
-           #pragma omp parallel for private(pm,p1,p2)
-           #endif
            for (k=0; k<n; k++) {
-             pm = m + k;
-             if ( ! *pm ) { 
-               p1 = q1 + k;
-               p2 = q2 + k;
-               *p2 = (#{ctype2}) *p1;
+             if ( ! m[k] ) { 
+               q2[k] = (#{ctype2}) q1[k];
              }
            }
          }
          else {
-           #ifdef _OPENMP
-           #pragma omp parallel for private(p1,p2)
-           #endif
+           CA_PRAGMA_SIMD
            for (k=0; k<n; k++) {
-             p1 = q1 + k;
-             p2 = q2 + k;
-             *p2 = (#{ctype2}) *p1;
+             q2[k] = (#{ctype2}) q1[k];
            }
          }
          return;
       }
     END_DEF
+    puts kernel.call("", "")
     puts
+    if SIMD_TYPES.include?(type1) and SIMD_TYPES.include?(type2)
+      CA_CAST_SIMD << [type1, type2]
+      SIMD_VARIANTS.each do |suffix, target|
+        SIMD_DEFS << kernel.call("_#{suffix}", "#{target} ") << "\n"
+      end
+    end
   end
 end
 
@@ -494,3 +508,38 @@ puts "};"
 
 puts
 
+
+puts "/* ------------------ ca_cast_simd_setup ------------------------ */"
+puts
+puts "#ifdef HAVE_CA_SIMD_DISPATCH"
+puts
+puts SIMD_DEFS.join
+puts "static struct {"
+puts "  int8_t type1;"
+puts "  int8_t type2;"
+puts "  ca_cast_func_t func[CA_SIMD_NLEVEL];"
+puts "} ca_cast_simd_table[] = {"
+CA_CAST_SIMD.each do |type1, type2|
+  base = CA_CAST_TABLE[type1][type2]
+  list = [base] + SIMD_VARIANTS.map { |suffix, target| "#{base}_#{suffix}" }
+  puts "  { #{type1}, #{type2}, { #{list.join(", ")} } },"
+end
+puts "};"
+puts
+puts "#endif"
+puts
+
+puts %{
+void
+ca_cast_simd_setup (int level)
+{
+#ifdef HAVE_CA_SIMD_DISPATCH
+  int n = (int) (sizeof(ca_cast_simd_table)/sizeof(ca_cast_simd_table[0]));
+  int i;
+  for (i=0; i<n; i++) {
+    ca_cast_func_table[ca_cast_simd_table[i].type1][ca_cast_simd_table[i].type2] =
+                                             ca_cast_simd_table[i].func[level];
+  }
+#endif
+}
+}
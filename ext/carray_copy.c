@@ -33,6 +33,13 @@ ca_copy (void *ap)
     ca_copy_data(ca, co->ptr);
   }
 
+  if ( ca_mask_is_packed(ca) ) {         /* keeps the mask packed */
+    if ( ca_is_any_masked(ca) ) {
+      ca_setup_mask_bits(co, ca->mask_bits);
+    }
+    return co;
+  }
+
   ca_update_mask(ca);
   if ( ca->mask ) {
     ca_copy_mask(co, ca);
@@ -716,7 +716,10 @@ ca_attach (void *ap)
     }
 
     if ( ! ca->ptr ) {
-      ca_func[ca->obj_type].attach(ap);
+      /* the chain of views is attached from the root in one pass */
+      if ( ! ca_strided_attach(ca) ) {
+        ca_func[ca->obj_type].attach(ap);
+      }
     }
   }
   else {                      /* entity array */
@@ -741,7 +744,9 @@ ca_update (void *ap)
   if ( ca_is_virtual(ca) ) {  /* virtual array */
 
     if ( ca->ptr ) {
-      ca_func[ca->obj_type].copy_data(ca, ca->ptr);
+      if ( ! ca_strided_copy_data(ca, ca->ptr) ) {
+        ca_func[ca->obj_type].copy_data(ca, ca->ptr);
+      }
     }
     else {
       rb_raise(rb_eRuntimeError, 
@@ -775,12 +780,15 @@ ca_sync (void *ap)
              "can not modify read-only array");
   }
 
+  ca_mask_touch(ca);
   ca_update_mask(ca);
   ca_sync(ca->mask);
 
   if ( ca_is_virtual(ca) ) {  /* virtual array */
     if ( ! CAVIRTUAL(ca)->nosync ) { /* FIXME : */
-      ca_func[ca->obj_type].sync(ap);
+      if ( ! ca_strided_sync(ca) ) {
+        ca_func[ca->obj_type].sync(ap);
+      }
     }
   }
   else {                      /* enitity array */
@@ -807,7 +815,9 @@ ca_detach (void *ap)
 
   if ( ca_is_virtual(ca) ) {  /* virtual array */
     if ( CAVIRTUAL(ca)->attach == 1 ) {
-      ca_func[ca->obj_type].detach(ap);
+      if ( ! ca_strided_detach(ca) ) {
+        ca_func[ca->obj_type].detach(ap);
+      }
     }
     CAVIRTUAL(ca)->attach -= 1;
   }
@@ -883,6 +893,9 @@ void
 ca_copy_data (void *ap, char *ptr)
 {
   CArray *ca = (CArray *) ap;
+  if ( ca_strided_copy_data(ca, ptr) ) {
+    return;
+  }
   ca_func[ca->obj_type].copy_data(ap, ptr); /* delegate */
 }
 
@@ -898,11 +911,13 @@ ca_sync_data (void *ap, char *ptr)
              "can not sync data to read-only array");
   }
 
+  ca_mask_touch(ca);
+
   if ( ca_is_virtual(ca) ) {  /* virtual array */
     if ( CAVIRTUAL(ca)->nosync ) { /* ca is to be attached */
       ca_func[CA_OBJ_ARRAY].sync_data(ap, ptr);
     }
-    else {
+    else if ( ! ca_strided_sync_data(ca, ptr) ) {
       ca_func[ca->obj_type].sync_data(ap, ptr);
     }
   }
@@ -928,7 +943,7 @@ ca_fill_data (void *ap, void *aptr)
     if ( ca_is_attached(ca) ) { /* ca is to be attached */
       ca_func[CA_OBJ_ARRAY].fill_data(ap, ptr);
     }
-    else {
+    else if ( ! ca_strided_fill_data(ca, ptr) ) {
       ca_func[ca->obj_type].fill_data(ap, ptr);
     }
   }
@@ -960,6 +975,8 @@ ca_fill (void *ap, void *aptr)
     rb_raise(rb_eRuntimeError, "can't fill read-only carray");
   }
 
+  ca_mask_touch(ca);
+
   ca_fill_data(ap, ptr);
 }
 
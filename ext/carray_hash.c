@@ -0,0 +1,544 @@
+/* ---------------------------------------------------------------------------
+
+  carray_hash.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  ca_hash_factorize() assigns a code (0, 1, 2, ...) to each distinct value
+  of the array in the order of the first occurrence, using an open
+  addressing hash table (linear probing) specialized for each data type.
+  The table stores only the codes, the key of a code is referred through
+  the address of its first occurrence.
+
+  The float values are compared by "==", so that 0.0 and -0.0 are same,
+  and all NaNs are regarded as one value. The fixlen values are compared
+  as byte strings, and the objects by #hash and #eql?.
+*/
+
+#include "carray.h"
+#include <math.h>
+
+#define CA_HASH_INITIAL 256
+
+typedef struct {
+  ca_size_t *slot;     /* code at each slot (-1 for the empty slot) */
+  ca_size_t  size;     /* number of slots (power of 2) */
+  ca_size_t *first;    /* address of the first occurrence of each code */
+  ca_size_t  count;    /* number of codes */
+} ca_hash_t;
+
+static inline uint64_t
+ca_hash_mix (uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+static inline uint64_t
+ca_hash_float (double x)
+{
+  union { double d; uint64_t u; } v;
+  if ( isnan(x) ) {
+    return 0x7ff8000000000000ULL;
+  }
+  v.d = ( x == 0.0 ) ? 0.0 : x;
+  return ca_hash_mix(v.u);
+}
+
+static inline uint64_t
+ca_hash_bytes (const unsigned char *p, ca_size_t bytes)
+{
+  uint64_t h = 0xcbf29ce484222325ULL;       /* FNV-1a */
+  ca_size_t i;
+  for (i=0; i<bytes; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ULL;
+  }
+  return ca_hash_mix(h);
+}
+
+static void
+ca_hash_reset_slot (ca_hash_t *h)
+{
+  ca_size_t j;
+  h->slot = malloc_with_check(sizeof(ca_size_t)*h->size);
+  for (j=0; j<h->size; j++) {
+    h->slot[j] = -1;
+  }
+}
+
+static void
+ca_hash_init (ca_hash_t *h)
+{
+  h->size  = CA_HASH_INITIAL;
+  h->first = malloc_with_check(sizeof(ca_size_t)*(h->size/2));
+  h->count = 0;
+  ca_hash_reset_slot(h);
+}
+
+/* doubles the table (the caller rehashes the codes 0...count) */
+
+static void
+ca_hash_expand (ca_hash_t *h)
+{
+  free(h->slot);
+  h->size *= 2;
+  h->first = xrealloc(h->first, sizeof(ca_size_t)*(h->size/2));
+  ca_hash_reset_slot(h);
+}
+
+/* inserts the code c into the table by the hash value hv
+   (used for rehashing, the code should not be in the table) */
+
+static inline void
+ca_hash_insert (ca_hash_t *h, uint64_t hv, ca_size_t c)
+{
+  ca_size_t j = (ca_size_t) (hv & (uint64_t) (h->size - 1));
+  while ( h->slot[j] >= 0 ) {
+    j = (j + 1) & (h->size - 1);
+  }
+  h->slot[j] = c;
+}
+
+/* HASH(p, i) gives the hash value of the i-th element of p, 
+   EQUAL(p, i, q, j) tests the i-th element of p and the j-th element of q. 
+   The variable bytes is visible to these macros. */
+
+#define proc_factorize(name, type, HASH, EQUAL)                         \
+static void                                                             \
+ca_factorize_ ## name (CArray *ca, boolean8_t *m,                       \
+                       ca_size_t *code, ca_hash_t *h)                   \
+{                                                                       \
+  type *p = (type *) ca->ptr;                                           \
+  ca_size_t bytes = ca->bytes;                                          \
+  ca_size_t i, j, c, k;                                                 \
+  (void) bytes;                                                         \
+  for (i=0; i<ca->elements; i++) {                                      \
+    if ( m && m[i] ) {                                                  \
+      code[i] = -1;                                                     \
+      continue;                                                         \
+    }                                                                   \
+    j = (ca_size_t) (HASH(p, i) & (uint64_t) (h->size - 1));            \
+    while ( ( c = h->slot[j] ) >= 0 ) {                                 \
+      if ( EQUAL(p, h->first[c], p, i) ) {                              \
+        break;                                                          \
+      }                                                                 \
+      j = (j + 1) & (h->size - 1);                                      \
+    }                                                                   \
+    if ( c < 0 ) {                                                      \
+      c = h->count++;                                                   \
+      h->first[c] = i;                                                  \
+      h->slot[j] = c;                                                   \
+      if ( h->count * 2 >= h->size ) {                                  \
+        ca_hash_expand(h);                                              \
+        for (k=0; k<h->count; k++) {                                    \
+          ca_hash_insert(h, HASH(p, h->first[k]), k);                   \
+        }                                                               \
+      }                                                                 \
+    }                                                                   \
+    code[i] = c;                                                        \
+  }                                                                     \
+}                                                                       \
+                                                                        \
+static void                                                             \
+ca_lookup_ ## name (CArray *cb, ca_hash_t *h,                           \
+                    CArray *ca, boolean8_t *m, ca_size_t *code)         \
+{                                                                       \
+  type *p = (type *) cb->ptr;                                           \
+  type *q = (type *) ca->ptr;                                           \
+  ca_size_t bytes = ca->bytes;                                          \
+  ca_size_t i, j, c;                                                    \
+  (void) bytes;                                                         \
+  for (i=0; i<ca->elements; i++) {                                      \
+    if ( m && m[i] ) {                                                  \
+      code[i] = -1;                                                     \
+      continue;                                                         \
+    }                                                                   \
+    j = (ca_size_t) (HASH(q, i) & (uint64_t) (h->size - 1));            \
+    while ( ( c = h->slot[j] ) >= 0 ) {                                 \
+      if ( EQUAL(p, h->first[c], q, i) ) {                              \
+        break;                                                          \
+      }                                                                 \
+      j = (j + 1) & (h->size - 1);                                      \
+    }                                                                   \
+    code[i] = c;                                                        \
+  }                                                                     \
+}
+
+#define ca_feq(a, b)  ( (a) == (b) || ( isnan(a) && isnan(b) ) )
+
+#define hash_int(p, i)            ca_hash_mix((uint64_t) p[i])
+#define equal_int(p, i, q, j)     ( p[i] == q[j] )
+
+#define hash_float(p, i)          ca_hash_float((double) p[i])
+#define equal_float(p, i, q, j)   ca_feq(p[i], q[j])
+
+#define hash_cmplx(p, i) \
+  ( ca_hash_float((double) creal(p[i])) * 31 + \
+    ca_hash_float((double) cimag(p[i])) )
+#define equal_cmplx(p, i, q, j) \
+  ( ca_feq(creal(p[i]), creal(q[j])) && ca_feq(cimag(p[i]), cimag(q[j])) )
+
+#define hash_fixlen(p, i) \
+  ca_hash_bytes((unsigned char *) p + (i)*bytes, bytes)
+#define equal_fixlen(p, i, q, j) \
+  ( ! memcmp((char *) p + (i)*bytes, (char *) q + (j)*bytes, bytes) )
+
+#define hash_object(p, i)         ((uint64_t) NUM2LONG(rb_hash(p[i])))
+#define equal_object(p, i, q, j)  rb_eql(p[i], q[j])
+
+proc_factorize(fixlen,     char,        hash_fixlen, equal_fixlen)
+proc_factorize(boolean8_t, boolean8_t,  hash_int,    equal_int)
+proc_factorize(int8_t,     int8_t,      hash_int,    equal_int)
+proc_factorize(uint8_t,    uint8_t,     hash_int,    equal_int)
+proc_factorize(int16_t,    int16_t,     hash_int,    equal_int)
+proc_factorize(uint16_t,   uint16_t,    hash_int,    equal_int)
+proc_factorize(int32_t,    int32_t,     hash_int,    equal_int)
+proc_factorize(uint32_t,   uint32_t,    hash_int,    equal_int)
+proc_factorize(int64_t,    int64_t,     hash_int,    equal_int)
+proc_factorize(uint64_t,   uint64_t,    hash_int,    equal_int)
+proc_factorize(float32_t,  float32_t,   hash_float,  equal_float)
+proc_factorize(float64_t,  float64_t,   hash_float,  equal_float)
+proc_factorize(float128_t, float128_t,  hash_float,  equal_float)
+#ifdef HAVE_COMPLEX_H
+proc_factorize(cmplx64_t,  cmplx64_t,   hash_cmplx,  equal_cmplx)
+proc_factorize(cmplx128_t, cmplx128_t,  hash_cmplx,  equal_cmplx)
+proc_factorize(cmplx256_t, cmplx256_t,  hash_cmplx,  equal_cmplx)
+#endif
+proc_factorize(VALUE,      VALUE,       hash_object, equal_object)
+
+typedef void (*ca_factorize_func_t)(CArray *, boolean8_t *,
+                                    ca_size_t *, ca_hash_t *);
+
+typedef void (*ca_lookup_func_t)(CArray *, ca_hash_t *,
+                                 CArray *, boolean8_t *, ca_size_t *);
+
+#ifdef HAVE_COMPLEX_H
+#define ca_hash_table(name)                                            \
+static name ## _func_t                                                 \
+name ## _func[CA_NTYPE] = {                                            \
+  name ## _fixlen,     name ## _boolean8_t,                            \
+  name ## _int8_t,     name ## _uint8_t,                               \
+  name ## _int16_t,    name ## _uint16_t,                              \
+  name ## _int32_t,    name ## _uint32_t,                              \
+  name ## _int64_t,    name ## _uint64_t,                              \
+  name ## _float32_t,  name ## _float64_t,  name ## _float128_t,       \
+  name ## _cmplx64_t,  name ## _cmplx128_t, name ## _cmplx256_t,       \
+  name ## _VALUE,                                                      \
+};
+#else
+#define ca_hash_table(name)                                            \
+static name ## _func_t                                                 \
+name ## _func[CA_NTYPE] = {                                            \
+  name ## _fixlen,     name ## _boolean8_t,                            \
+  name ## _int8_t,     name ## _uint8_t,                               \
+  name ## _int16_t,    name ## _uint16_t,                              \
+  name ## _int32_t,    name ## _uint32_t,                              \
+  name ## _int64_t,    name ## _uint64_t,                              \
+  name ## _float32_t,  name ## _float64_t,  name ## _float128_t,       \
+  NULL,                NULL,                NULL,                      \
+  name ## _VALUE,                                                      \
+};
+#endif
+
+ca_hash_table(ca_factorize)
+ca_hash_table(ca_lookup)
+
+/* builds the table of ca (and looks up the elements of cq if given).
+   The object arrays are processed under rb_ensure(), because #hash and 
+   #eql? may raise an exception. */
+
+struct ca_hash_arg {
+  CArray     *ca;
+  boolean8_t *m;
+  ca_size_t  *code;
+  CArray     *cq;
+  boolean8_t *mq;
+  ca_size_t  *qcode;
+  ca_hash_t  *h;
+  int         done;
+};
+
+static VALUE
+ca_hash_body (VALUE varg)
+{
+  struct ca_hash_arg *arg = (struct ca_hash_arg *) varg;
+  int8_t data_type = arg->ca->data_type;
+  ca_factorize_func[data_type](arg->ca, arg->m, arg->code, arg->h);
+  if ( arg->cq ) {
+    ca_lookup_func[data_type](arg->ca, arg->h, arg->cq, arg->mq, arg->qcode);
+  }
+  arg->done = 1;
+  return Qnil;
+}
+
+static VALUE
+ca_hash_ensure (VALUE varg)
+{
+  struct ca_hash_arg *arg = (struct ca_hash_arg *) varg;
+  if ( ! arg->done ) {
+    free(arg->h->slot);
+    free(arg->h->first);
+  }
+  return Qnil;
+}
+
+static void
+ca_hash_run (struct ca_hash_arg *arg)
+{
+  if ( ! ca_factorize_func[arg->ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "can't hash the array of data_type %s",
+             ca_type_name[arg->ca->data_type]);
+  }
+  ca_hash_init(arg->h);
+  arg->done = 0;
+  if ( arg->ca->data_type == CA_OBJECT ) {
+    rb_ensure(ca_hash_body, (VALUE) arg, ca_hash_ensure, (VALUE) arg);
+  }
+  else {
+    ca_hash_body((VALUE) arg);
+  }
+  free(arg->h->slot);
+}
+
+/* stores the codes of the elements of ca (attached) into code[0...elements]
+   (-1 for the elements masked by m, which may be NULL), returns the number
+   of the distinct values. The addresses of the first occurrences are
+   returned by *first, which should be freed by the caller. */
+
+ca_size_t
+ca_hash_factorize (CArray *ca, boolean8_t *m, ca_size_t *code,
+                   ca_size_t **first)
+{
+  ca_hash_t h;
+  struct ca_hash_arg arg = { ca, m, code, NULL, NULL, NULL, &h, 0 };
+  ca_hash_run(&arg);
+  *first = h.first;
+  return h.count;
+}
+
+/* stores into code[0...cq->elements] the code of each element of cq in the 
+   factorization of ca (see ca_hash_factorize), or -1 for the elements not 
+   found in ca or masked by mq. The arrays should be attached, and have 
+   the same data type and bytes. Returns the number of the codes. */
+
+ca_size_t
+ca_hash_lookup (CArray *ca, boolean8_t *m, CArray *cq, boolean8_t *mq,
+                ca_size_t *code)
+{
+  volatile VALUE rtmp;
+  CArray *ct;
+  ca_hash_t h;
+  struct ca_hash_arg arg = { ca, m, NULL, cq, mq, code, &h, 0 };
+  rtmp = rb_carray_new(CA_SIZE, 1, &ca->elements, 0, NULL);
+  TypedData_Get_Struct(rtmp, CArray, &carray_data_type, ct);
+  arg.code = (ca_size_t *) ct->ptr;
+  ca_hash_run(&arg);
+  free(h.first);
+  return h.count;
+}
+
+/* ------------------------------------------------------------------- */
+
+/* returns the array of the distinct values of self in the order of the 
+   first occurrence (or in ascending order if sorted is true), and stores 
+   into code[0...elements] the position of each element in the array 
+   (-1 for the masked elements). The number of the distinct values is 
+   returned by *count. */
+
+VALUE
+rb_ca_uniq_codes (VALUE self, int sorted, ca_size_t *code, ca_size_t *count)
+{
+  volatile VALUE out, raddr;
+  CArray *ca, *co, *ci;
+  boolean8_t *m;
+  ca_size_t *first, *addr, *rank;
+  ca_size_t n, i;
+  char *tmp;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( sorted && ca_is_complex_type(ca) ) {
+    rb_raise(rb_eCADataTypeError,
+             "can't sort the distinct values of data_type %s",
+             ca_type_name[ca->data_type]);
+  }
+
+  ca_attach(ca);
+  m = ( ca->mask ) ? (boolean8_t *) ca->mask->ptr : NULL;
+  n = ca_hash_factorize(ca, m, code, &first);
+
+  out = rb_carray_new(ca->data_type, 1, &n, ca->bytes, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  for (i=0; i<n; i++) {
+    memcpy(co->ptr + i*co->bytes, ca->ptr + first[i]*ca->bytes, co->bytes);
+  }
+
+  free(first);
+  ca_detach(ca);
+
+  rb_ca_data_type_inherit(out, self);
+
+  if ( sorted && n > 1 ) {
+    raddr = rb_funcall(rb_mCA, rb_intern("sort_addr"), 1, out);
+    TypedData_Get_Struct(raddr, CArray, &carray_data_type, ci);
+    addr = (ca_size_t *) ci->ptr;
+    tmp  = malloc_with_check(co->bytes*n);
+    rank = malloc_with_check(sizeof(ca_size_t)*n);
+    memcpy(tmp, co->ptr, co->bytes*n);
+    for (i=0; i<n; i++) {
+      memcpy(co->ptr + i*co->bytes, tmp + addr[i]*co->bytes, co->bytes);
+      rank[addr[i]] = i;
+    }
+    for (i=0; i<ca->elements; i++) {
+      if ( code[i] >= 0 ) {
+        code[i] = rank[code[i]];
+      }
+    }
+    free(tmp);
+    free(rank);
+  }
+
+  *count = n;
+  return out;
+}
+
+static int
+rb_ca_uniq_sorted_option (int *argc, VALUE **argv)
+{
+  volatile VALUE ropt, rsorted = Qnil;
+  ropt = rb_pop_options(argc, argv);
+  rb_scan_options(ropt, "sorted", &rsorted);
+  rb_check_arity(*argc, 0, 0);
+  return RTEST(rsorted);
+}
+
+/* @overload uniq (sorted: false)
+
+Returns the 1-D array of the distinct values of the elements in the order
+of their first occurrence (in ascending order if sorted: true is given).
+The masked elements are ignored. The float values 0.0 and -0.0 are
+regarded as same, and all NaNs are regarded as one value.
+*/
+
+static VALUE
+rb_ca_uniq (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE rcode;
+  CArray *ca, *cc;
+  ca_size_t n;
+  int sorted = rb_ca_uniq_sorted_option(&argc, &argv);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  rcode = rb_carray_new(CA_SIZE, 1, &ca->elements, 0, NULL);
+  TypedData_Get_Struct(rcode, CArray, &carray_data_type, cc);
+
+  return rb_ca_uniq_codes(self, sorted, (ca_size_t *) cc->ptr, &n);
+}
+
+/* @overload uniq_counts (sorted: false)
+
+Returns the pair of the distinct values (see #uniq) and the number of
+their occurrences.
+
+    a = CA_INT([3, 1, 3, 2, 1, 3])
+    a.uniq_counts                  # => [<3, 1, 2>, <3, 2, 1>]
+    a.uniq_counts(sorted: true)    # => [<1, 2, 3>, <2, 1, 3>]
+*/
+
+static VALUE
+rb_ca_uniq_counts (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE out, rcnt, rcode;
+  CArray *ca, *cc;
+  ca_size_t *code, *cnt;
+  ca_size_t n, i;
+  int sorted = rb_ca_uniq_sorted_option(&argc, &argv);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  rcode = rb_carray_new(CA_SIZE, 1, &ca->elements, 0, NULL);
+  TypedData_Get_Struct(rcode, CArray, &carray_data_type, cc);
+  code = (ca_size_t *) cc->ptr;
+
+  out = rb_ca_uniq_codes(self, sorted, code, &n);
+
+  rcnt = rb_carray_new(CA_SIZE, 1, &n, 0, NULL);
+  TypedData_Get_Struct(rcnt, CArray, &carray_data_type, cc);
+  cnt = (ca_size_t *) cc->ptr;
+  memset(cnt, 0, sizeof(ca_size_t)*n);
+  for (i=0; i<ca->elements; i++) {
+    if ( code[i] >= 0 ) {
+      cnt[code[i]] += 1;
+    }
+  }
+
+  return rb_assoc_new(out, rcnt);
+}
+
+/* @overload uniq_inverse (sorted: false)
+
+Returns the pair of the distinct values (see #uniq) and the array of
+the same shape as self which holds the index of each element in the
+distinct values, so that values[inverse] reconstructs self. The inverse
+is masked at the masked elements.
+
+    a = CA_INT([3, 1, 3, 2])
+    v, inv = a.uniq_inverse        # => [<3, 1, 2>, <0, 1, 0, 2>]
+    v[inv]                         # => <3, 1, 3, 2>
+*/
+
+static VALUE
+rb_ca_uniq_inverse (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE out, rinv;
+  CArray *ca, *ci;
+  ca_size_t *code;
+  boolean8_t *mi;
+  ca_size_t n, i;
+  int sorted = rb_ca_uniq_sorted_option(&argc, &argv);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  rinv = rb_carray_new(CA_SIZE, ca->ndim, ca->dim, 0, NULL);
+  TypedData_Get_Struct(rinv, CArray, &carray_data_type, ci);
+  code = (ca_size_t *) ci->ptr;
+
+  out = rb_ca_uniq_codes(self, sorted, code, &n);
+
+  for (i=0; i<ci->elements; i++) {
+    if ( code[i] < 0 ) {
+      break;
+    }
+  }
+  if ( i < ci->elements ) {
+    ca_create_mask(ci);
+    mi = (boolean8_t *) ci->mask->ptr;
+    for (; i<ci->elements; i++) {
+      if ( code[i] < 0 ) {
+        mi[i] = 1;
+        code[i] = 0;
+      }
+    }
+  }
+
+  return rb_assoc_new(out, rinv);
+}
+
+void
+Init_carray_hash ()
+{
+  rb_define_method(rb_cCArray, "uniq", rb_ca_uniq, -1);
+  rb_define_method(rb_cCArray, "uniq_counts", rb_ca_uniq_counts, -1);
+  rb_define_method(rb_cCArray, "uniq_inverse", rb_ca_uniq_inverse, -1);
+}
@@ -0,0 +1,661 @@
+/* ---------------------------------------------------------------------------
+
+  carray_lazy.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  CALazy records the chain of elementwise operations (monop, binop) as an
+  expression tree instead of evaluating each operation immediately.
+  CALazy#evaluate walks the tree chunk by chunk, using the kernels generated
+  by carray_math.rb (ca_monop_*, ca_binop_*) on buffers of CA_LAZY_CHUNK
+  elements, so that no full-size temporary array is created except the
+  output.
+*/
+
+#include "carray.h"
+
+#define CA_LAZY_CHUNK 4096
+
+enum {
+  CA_LAZY_LEAF,
+  CA_LAZY_CAST,
+  CA_LAZY_MONOP,
+  CA_LAZY_BINOP,
+};
+
+typedef struct {
+  int8_t                kind;
+  int8_t                data_type;
+  int8_t                is_scalar;
+  ca_monop_bits_func_t *monop;
+  ca_binop_bits_func_t *binop;
+  VALUE                 arg1;  /* CArray object for leaf, CALazy object for others */
+  VALUE                 arg2;
+} CALazyNode;
+
+static VALUE rb_cCALazy;
+
+static void
+ca_lazy_mark (void *ptr)
+{
+  CALazyNode *node = (CALazyNode *) ptr;
+  rb_gc_mark(node->arg1);
+  rb_gc_mark(node->arg2);
+}
+
+static const rb_data_type_t calazy_data_type = {
+    .wrap_struct_name = "CALazy",
+    .function = {
+        .dmark = ca_lazy_mark,
+        .dfree = RUBY_TYPED_DEFAULT_FREE,
+        .dsize = NULL,
+        .dcompact = NULL
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE
+rb_lazy_s_allocate (VALUE klass)
+{
+  CALazyNode *node;
+  VALUE obj;
+  obj = TypedData_Make_Struct(klass, CALazyNode, &calazy_data_type, node);
+  node->arg1 = Qnil;
+  node->arg2 = Qnil;
+  return obj;
+}
+
+static VALUE
+ca_lazy_node_new (int8_t kind, int8_t data_type, int8_t is_scalar,
+                  VALUE arg1, VALUE arg2)
+{
+  volatile VALUE obj;
+  CALazyNode *node;
+  obj = rb_lazy_s_allocate(rb_cCALazy);
+  TypedData_Get_Struct(obj, CALazyNode, &calazy_data_type, node);
+  node->kind      = kind;
+  node->data_type = data_type;
+  node->is_scalar = is_scalar;
+  node->arg1      = arg1;
+  node->arg2      = arg2;
+  return obj;
+}
+
+static CALazyNode *
+ca_lazy_get (VALUE obj)
+{
+  CALazyNode *node;
+  TypedData_Get_Struct(obj, CALazyNode, &calazy_data_type, node);
+  return node;
+}
+
+static VALUE
+ca_lazy_leaf_new (VALUE carray)
+{
+  CArray *ca;
+
+  rb_check_carray_object(carray);
+  TypedData_Get_Struct(carray, CArray, &carray_data_type, ca);
+
+  if ( ca_is_fixlen_type(ca) || ca_is_object_type(ca) ) {
+    rb_raise(rb_eCADataTypeError,
+             "lazy evaluation is not supported for data type '%s'",
+             ca_type_name[ca->data_type]);
+  }
+  if ( ca->obj_type == CA_OBJ_UNBOUND_REPEAT ) {
+    rb_raise(rb_eRuntimeError,
+             "lazy evaluation is not supported for unbound repeat array");
+  }
+
+  return ca_lazy_node_new(CA_LAZY_LEAF, ca->data_type, ca_is_scalar(ca),
+                          carray, Qnil);
+}
+
+/* inserts cast node if the data type of node differs from data_type */
+
+static VALUE
+ca_lazy_cast (VALUE obj, int8_t data_type)
+{
+  CALazyNode *node = ca_lazy_get(obj);
+  if ( node->data_type == data_type ) {
+    return obj;
+  }
+  return ca_lazy_node_new(CA_LAZY_CAST, data_type, node->is_scalar, obj, Qnil);
+}
+
+/* creates the representative object for determining the data type
+   of operation with the same rule as rb_ca_call_binop() */
+
+static VALUE
+ca_lazy_representative (CALazyNode *node)
+{
+  ca_size_t dim = 1;
+  if ( node->is_scalar ) {
+    return rb_cscalar_new(node->data_type, 0, NULL);
+  }
+  else {
+    return rb_carray_new(node->data_type, 1, &dim, 0, NULL);
+  }
+}
+
+/* @overload initialize (carray)
+
+Creates the leaf node of lazy evaluation refering the given array.
+Usually created by CArray#lazy.
+*/
+
+static VALUE
+rb_lazy_initialize (VALUE self, VALUE carray)
+{
+  volatile VALUE leaf;
+  CALazyNode *node, *src;
+  node = ca_lazy_get(self);
+  leaf = ca_lazy_leaf_new(carray);
+  src  = ca_lazy_get(leaf);
+  *node = *src;
+  return self;
+}
+
+/* @overload data_type
+
+Returns the data type of the result of evaluation.
+*/
+
+static VALUE
+rb_lazy_data_type (VALUE self)
+{
+  return INT2NUM(ca_lazy_get(self)->data_type);
+}
+
+static ca_monop_entry_t *
+ca_lazy_find_monop (VALUE rname)
+{
+  ca_monop_entry_t *e;
+  const char *name = StringValueCStr(rname);
+  for (e=ca_monop_entries; e->name; e++) {
+    if ( ! strcmp(e->name, name) ) {
+      return e;
+    }
+  }
+  rb_raise(rb_eArgError, "unknown monop '%s'", name);
+}
+
+static ca_binop_entry_t *
+ca_lazy_find_binop (VALUE rname)
+{
+  ca_binop_entry_t *e;
+  const char *name = StringValueCStr(rname);
+  for (e=ca_binop_entries; e->name; e++) {
+    if ( ! strcmp(e->name, name) ) {
+      return e;
+    }
+  }
+  rb_raise(rb_eArgError, "unknown binop '%s'", name);
+}
+
+/* @overload monop (name)
+
+(internal) Appends the monop named +name+ to the expression.
+*/
+
+static VALUE
+rb_lazy_monop (VALUE self, VALUE rname)
+{
+  volatile VALUE obj, arg;
+  CALazyNode *node = ca_lazy_get(self), *out;
+  ca_monop_entry_t *e;
+  int8_t data_type = node->data_type;
+
+  if ( SYMBOL_P(rname) ) {
+    rname = rb_sym2str(rname);
+  }
+  e = ca_lazy_find_monop(rname);
+
+  if ( e->float_only &&
+       data_type >= CA_INT8 && data_type <= CA_UINT64 ) {
+    data_type = CA_FLOAT64;
+  }
+
+  if ( e->func[data_type] == (ca_monop_bits_func_t) ca_monop_not_implement ) {
+    rb_raise(rb_eCADataTypeError,
+             "invalid data type '%s' for monop '%s' (not implemented)",
+             ca_type_name[data_type], e->name);
+  }
+
+  arg = ca_lazy_cast(self, data_type);
+  obj = ca_lazy_node_new(CA_LAZY_MONOP, data_type, node->is_scalar, arg, Qnil);
+  out = ca_lazy_get(obj);
+  out->monop = e->func;
+
+  return obj;
+}
+
+/* @overload binop (name, other)
+
+(internal) Appends the binop named +name+ with +other+ to the expression.
+*/
+
+static VALUE
+rb_lazy_binop (VALUE self, VALUE rname, VALUE other)
+{
+  volatile VALUE obj, lhs, rhs, rs, ro;
+  CALazyNode *node1 = ca_lazy_get(self), *node2, *out;
+  ca_binop_entry_t *e;
+  CArray *cs, *co;
+  int8_t data_type;
+
+  if ( SYMBOL_P(rname) ) {
+    rname = rb_sym2str(rname);
+  }
+  e = ca_lazy_find_binop(rname);
+
+  if ( rb_obj_is_kind_of(other, rb_cCALazy) ) {
+    rhs = other;
+  }
+  else if ( rb_obj_is_carray(other) ) {
+    rhs = ca_lazy_leaf_new(other);
+  }
+  else {
+    rhs = Qnil;
+  }
+
+  /* determine data_type as rb_ca_call_binop() does */
+
+  rs = ca_lazy_representative(node1);
+  ro = NIL_P(rhs) ? other : ca_lazy_representative(ca_lazy_get(rhs));
+  rb_ca_cast_self_or_other(&rs, &ro);
+
+  TypedData_Get_Struct(rs, CArray, &carray_data_type, cs);
+  TypedData_Get_Struct(ro, CArray, &carray_data_type, co);
+
+  if ( cs->data_type != co->data_type ) {
+    rb_raise(rb_eCADataTypeError,
+             "can't determine data type for lazy binop ('%s' and '%s')",
+             ca_type_name[cs->data_type], ca_type_name[co->data_type]);
+  }
+
+  data_type = cs->data_type;
+
+  if ( NIL_P(rhs) ) {         /* other is converted to scalar */
+    rhs = ca_lazy_leaf_new(ro);
+  }
+
+  if ( e->func[data_type] == (ca_binop_bits_func_t) ca_binop_not_implement ) {
+    rb_raise(rb_eCADataTypeError,
+             "invalid data type '%s' for binop '%s' (not implemented)",
+             ca_type_name[data_type], e->name);
+  }
+
+  node2 = ca_lazy_get(rhs);
+  lhs = ca_lazy_cast(self, data_type);
+  rhs = ca_lazy_cast(rhs, data_type);
+  obj = ca_lazy_node_new(CA_LAZY_BINOP, data_type,
+                         node1->is_scalar && node2->is_scalar, lhs, rhs);
+  out = ca_lazy_get(obj);
+  out->binop = e->func;
+
+  return obj;
+}
+
+/* @overload coerce (other)
+
+(internal) Converts +other+ to CALazy object.
+*/
+
+static VALUE
+rb_lazy_coerce (VALUE self, VALUE other)
+{
+  volatile VALUE rs, ro;
+  if ( rb_obj_is_carray(other) ) {
+    return rb_assoc_new(ca_lazy_leaf_new(other), self);
+  }
+  else {
+    rs = ca_lazy_representative(ca_lazy_get(self));
+    ro = other;
+    rb_ca_cast_self_or_other(&ro, &rs);
+    return rb_assoc_new(ca_lazy_leaf_new(ro), self);
+  }
+}
+
+/* ------------------------------------------------------------------- */
+
+typedef struct {
+  CALazyNode *node;
+  CArray     *ca;       /* leaf array */
+  CArray      type;     /* dummy for data type information used in casting */
+  char       *buf;      /* chunk buffer */
+  char       *ptr;      /* pointer to the data for current chunk */
+  ca_size_t   step;     /* 0 for scalar, 1 for array */
+  int         c1, c2;   /* indices of child items */
+} ca_lazy_item_t;
+
+typedef struct {
+  int             nitem;
+  int             nleaf;
+  ca_lazy_item_t *items;
+  CArray        **leaves;
+  int             nattach;  /* number of the attached leaves */
+  VALUE           self;
+  VALUE           out;
+  CArray         *co;
+} ca_lazy_eval_t;
+
+static int
+ca_lazy_count (VALUE obj)
+{
+  CALazyNode *node = ca_lazy_get(obj);
+  switch ( node->kind ) {
+  case CA_LAZY_LEAF:
+    return 1;
+  case CA_LAZY_CAST:
+  case CA_LAZY_MONOP:
+    return 1 + ca_lazy_count(node->arg1);
+  default:
+    return 1 + ca_lazy_count(node->arg1) + ca_lazy_count(node->arg2);
+  }
+}
+
+/* stores the nodes in post-order, returns the index of obj */
+
+static int
+ca_lazy_flatten (VALUE obj, ca_lazy_eval_t *ev)
+{
+  CALazyNode *node = ca_lazy_get(obj);
+  ca_lazy_item_t *item;
+  int c1 = -1, c2 = -1, i;
+
+  if ( node->kind != CA_LAZY_LEAF ) {
+    c1 = ca_lazy_flatten(node->arg1, ev);
+  }
+  if ( node->kind == CA_LAZY_BINOP ) {
+    c2 = ca_lazy_flatten(node->arg2, ev);
+  }
+
+  i = ev->nitem++;
+  item = &ev->items[i];
+  item->node = node;
+  item->ca   = NULL;
+  item->buf  = NULL;
+  item->ptr  = NULL;
+  item->step = node->is_scalar ? 0 : 1;
+  item->c1   = c1;
+  item->c2   = c2;
+  item->type.data_type = node->data_type;
+  item->type.bytes     = ca_sizeof[node->data_type];
+
+  if ( node->kind == CA_LAZY_LEAF ) {
+    TypedData_Get_Struct(node->arg1, CArray, &carray_data_type, item->ca);
+    ev->leaves[ev->nleaf++] = item->ca;
+  }
+
+  return i;
+}
+
+static void
+ca_lazy_eval_chunks (ca_lazy_eval_t *ev)
+{
+  CArray *co = ev->co;
+  ca_lazy_item_t *item, *root = &ev->items[ev->nitem-1], *c1, *c2;
+  boolean8_t *m0, *m;
+  uint64_t *mw0, *mw;
+  boolean8_t mbuf[CA_LAZY_CHUNK];
+  uint64_t wbuf[CA_LAZY_CHUNK / CA_MASK_WORD_BITS];
+  char *outp;
+  ca_size_t bytes = co->bytes;
+  ca_size_t off, len, k;
+  int i, has_cast = 0;
+
+  /* the kernels take the mask as the packed words, the casts as bytes */
+  ca_mask_prefer_packed(co);
+  ca_copy_mask_overlay_n(co, co->elements, ev->nleaf, ev->leaves);
+  m0  = NULL;
+  mw0 = NULL;
+  if ( ca_mask_is_packed(co) ) {
+    mw0 = ( ca_is_any_masked(co) ) ? co->mask_bits : NULL;
+  }
+  else {
+    m0 = ca_mask_ptr_any(co);
+  }
+
+  for (i=0; i<ev->nitem-1; i++) {
+    item = &ev->items[i];
+    if ( item->node->kind != CA_LAZY_LEAF ) {
+      item->buf = malloc_with_check(CA_LAZY_CHUNK * item->type.bytes);
+    }
+  }
+
+  for (i=0; i<ev->nitem; i++) {
+    if ( ev->items[i].node->kind == CA_LAZY_CAST ) {
+      has_cast = 1;
+    }
+  }
+
+  for (off=0; off<co->elements; off+=CA_LAZY_CHUNK) {
+
+    len  = co->elements - off;
+    if ( len > CA_LAZY_CHUNK ) {
+      len = CA_LAZY_CHUNK;
+    }
+    m    = NULL;
+    mw   = NULL;
+    if ( mw0 ) {
+      mw = mw0 + off / CA_MASK_WORD_BITS;
+      if ( has_cast ) {
+        ca_mask_unpack(mw, len, mbuf);
+        m = mbuf;
+      }
+    }
+    else if ( m0 ) {
+      m = m0 + off;
+      ca_mask_pack_block(m, len, wbuf);
+      mw = wbuf;
+    }
+    outp = co->ptr + off * bytes;
+
+    for (i=0; i<ev->nitem; i++) {
+      item = &ev->items[i];
+      c1 = ( item->c1 >= 0 ) ? &ev->items[item->c1] : NULL;
+      c2 = ( item->c2 >= 0 ) ? &ev->items[item->c2] : NULL;
+      item->ptr = ( item == root ) ? outp : item->buf;
+      switch ( item->node->kind ) {
+      case CA_LAZY_LEAF:
+        item->ptr = item->ca->ptr + item->step * off * item->ca->bytes;
+        break;
+      case CA_LAZY_CAST:
+        if ( c1->step ) {
+          ca_cast_block_with_mask(len, &c1->type, c1->ptr,
+                                       &item->type, item->ptr, m);
+        }
+        else {
+          ca_cast_block(1, &c1->type, c1->ptr, &item->type, item->ptr);
+        }
+        break;
+      case CA_LAZY_MONOP:
+        item->node->monop[item->type.data_type](len, mw,
+                                                c1->ptr, c1->step,
+                                                item->ptr, 1);
+        item->step = 1;
+        break;
+      case CA_LAZY_BINOP:
+        item->node->binop[item->type.data_type](len, mw,
+                                                c1->ptr, c1->step,
+                                                c2->ptr, c2->step,
+                                                item->ptr, 1);
+        item->step = 1;
+        break;
+      }
+    }
+
+    /* the root is leaf or the result is scalar stepped */
+    if ( root->ptr != outp ) {
+      if ( root->step ) {
+        memcpy(outp, root->ptr, len * bytes);
+      }
+      else {
+        memcpy(outp, root->ptr, bytes);
+      }
+    }
+    if ( ! root->step ) {
+      for (k=1; k<len; k++) {
+        memcpy(outp + k * bytes, outp, bytes);
+      }
+    }
+  }
+}
+
+/* every step which may raise is done here, so that ca_lazy_eval_ensure
+   can release whatever has been acquired so far */
+
+static VALUE
+ca_lazy_eval_body (VALUE arg)
+{
+  ca_lazy_eval_t *ev = (ca_lazy_eval_t *) arg;
+  CALazyNode *root = ca_lazy_get(ev->self);
+  CArray *ref = NULL, *ca;
+  int n, i;
+
+  n = ca_lazy_count(ev->self);
+
+  ev->items  = malloc_with_check(sizeof(ca_lazy_item_t) * n);
+  ev->leaves = malloc_with_check(sizeof(CArray *) * n);
+
+  ca_lazy_flatten(ev->self, ev);
+
+  /* check the number of elements */
+  for (i=0; i<ev->nleaf; i++) {
+    ca = ev->leaves[i];
+    if ( ca_is_scalar(ca) ) {
+      continue;
+    }
+    if ( ! ref ) {
+      ref = ca;
+    }
+    else if ( ca->elements != ref->elements ) {
+      rb_raise(rb_eRuntimeError, "elements mismatch (%ld <-> %ld)",
+               (long) ref->elements, (long) ca->elements);
+    }
+  }
+
+  if ( ref ) {
+    ev->out = rb_carray_new(root->data_type, ref->ndim, ref->dim, 0, NULL);
+  }
+  else {
+    ev->out = rb_cscalar_new(root->data_type, 0, NULL);
+  }
+  TypedData_Get_Struct(ev->out, CArray, &carray_data_type, ev->co);
+
+  for (i=0; i<ev->nleaf; i++) {
+    ca_kernel_attach(ev->leaves[i]);
+    ev->nattach++;
+  }
+
+  ca_lazy_eval_chunks(ev);
+
+  return Qnil;
+}
+
+static VALUE
+ca_lazy_eval_ensure (VALUE arg)
+{
+  ca_lazy_eval_t *ev = (ca_lazy_eval_t *) arg;
+  int i;
+  for (i=0; i<ev->nitem; i++) {
+    free(ev->items[i].buf);
+  }
+  for (i=0; i<ev->nattach; i++) {
+    ca_kernel_detach(ev->leaves[i]);
+  }
+  free(ev->items);
+  free(ev->leaves);
+  return Qnil;
+}
+
+/* @overload evaluate
+
+Evaluates the expression in a single pass over the chunks of the operands
+and returns the result as a new CArray object. Alias to_ca.
+*/
+
+static VALUE
+rb_lazy_evaluate (VALUE self)
+{
+  volatile VALUE out;
+  ca_lazy_eval_t ev;
+
+  ev.nitem   = 0;
+  ev.nleaf   = 0;
+  ev.nattach = 0;
+  ev.items   = NULL;
+  ev.leaves  = NULL;
+  ev.self    = self;
+  ev.out     = Qnil;
+  ev.co      = NULL;
+
+  rb_ensure(ca_lazy_eval_body, (VALUE) &ev, ca_lazy_eval_ensure, (VALUE) &ev);
+
+  out = ev.out;
+  return out;
+}
+
+/* yard:
+  class CArray
+    # Returns CALazy object which records the following elementwise
+    # operations without evaluating them. The operations are evaluated
+    # by CALazy#evaluate (or #to_ca) at once.
+    def lazy
+    end
+  end
+*/
+
+static VALUE
+rb_ca_lazy (VALUE self)
+{
+  return ca_lazy_leaf_new(self);
+}
+
+static VALUE
+rb_lazy_monop_names (VALUE klass)
+{
+  volatile VALUE list = rb_ary_new();
+  ca_monop_entry_t *e;
+  for (e=ca_monop_entries; e->name; e++) {
+    rb_ary_push(list, rb_str_new2(e->name));
+  }
+  return list;
+}
+
+static VALUE
+rb_lazy_binop_names (VALUE klass)
+{
+  volatile VALUE list = rb_ary_new();
+  ca_binop_entry_t *e;
+  for (e=ca_binop_entries; e->name; e++) {
+    rb_ary_push(list, rb_str_new2(e->name));
+  }
+  return list;
+}
+
+void
+Init_carray_lazy ()
+{
+  rb_cCALazy = rb_define_class("CALazy", rb_cObject);
+  rb_define_alloc_func(rb_cCALazy, rb_lazy_s_allocate);
+
+  rb_define_singleton_method(rb_cCALazy, "monop_names", rb_lazy_monop_names, 0);
+  rb_define_singleton_method(rb_cCALazy, "binop_names", rb_lazy_binop_names, 0);
+
+  rb_define_method(rb_cCALazy, "initialize", rb_lazy_initialize, 1);
+  rb_define_method(rb_cCALazy, "data_type", rb_lazy_data_type, 0);
+  rb_define_method(rb_cCALazy, "monop", rb_lazy_monop, 1);
+  rb_define_method(rb_cCALazy, "binop", rb_lazy_binop, 2);
+  rb_define_method(rb_cCALazy, "coerce", rb_lazy_coerce, 1);
+  rb_define_method(rb_cCALazy, "evaluate", rb_lazy_evaluate, 0);
+  rb_define_method(rb_cCALazy, "to_ca", rb_lazy_evaluate, 0);
+
+  rb_define_method(rb_cCArray, "lazy", rb_ca_lazy, 0);
+}
@@ -28,6 +28,10 @@ ca_has_mask (void *ap)
   if ( ca->mask ) {                /* mask array already created */
     return 1;
   }
+  else if ( ca_mask_is_packed(ca) ) { /* packed mask, expanded here */
+    ca_create_mask(ca);
+    return 1;
+  }
   else if ( ca_is_value_array(ca) ) {
     return 0;                     /* array itself is returned by CArray#value */
   }
@@ -53,30 +57,89 @@ ca_has_mask (void *ap)
   }
 }
 
+/*
+  The mask array of an entity array carries CA_FLAG_MASK_CLEAN when it is
+  known (by the last scan) to have no masked element, so that the repeated
+  queries and the kernels (see ca_mask_ptr_any) can skip the mask without
+  scanning it again. The flag is cleared by ca_mask_touch() which is called
+  for the array to be modified and all of its parents (rb_ca_modify,
+  ca_sync, ca_sync_data, ca_fill, ca_copy_mask_overlay_n). It is set only
+  for the entity arrays whose mask array is also entity, because the mask
+  of a virtual array is a temporary copy of the parent's mask.
+*/
+
+#define ca_mask_cacheable(ca) \
+  ( ca_is_entity(ca) && (ca)->mask && ca_is_entity((ca)->mask) )
+
+void
+ca_mask_touch (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  while ( ca ) {
+    ca_unset_flag(ca, CA_FLAG_MASK_CLEAN);
+    if ( ca->mask ) {
+      ca_unset_flag(ca->mask, CA_FLAG_MASK_CLEAN);
+    }
+    ca = ( ca_is_virtual(ca) ) ? CAVIRTUAL(ca)->parent : NULL;
+  }
+}
+
 int
 ca_is_any_masked (void *ap)
 {
   CArray *ca = (CArray *) ap;
   boolean8_t *m;
-  ca_size_t i;
+  ca_size_t k0;
   int flag = 0;
 
+  if ( ca_mask_is_packed(ca) ) {
+    for (k0=0; k0<ca_mask_nwords(ca->elements); k0++) {
+      if ( ca->mask_bits[k0] ) {
+        return 1;
+      }
+    }
+    return 0;
+  }
+
   ca_update_mask(ca);
   if ( ca->mask ) {
+    if ( ca_test_flag(ca->mask, CA_FLAG_MASK_CLEAN) ) {
+      return 0;
+    }
     ca_attach(ca->mask);
     m = (boolean8_t *) ca->mask->ptr;
-    for (i=0; i<ca->elements; i++) {
-      if ( *m++ ) {
+    for (k0=0; k0<ca->elements; k0+=CA_MASK_WORD_BITS) {
+      if ( ca_mask_word(m + k0, ( ca->elements - k0 < CA_MASK_WORD_BITS ) ?
+                                ca->elements - k0 : CA_MASK_WORD_BITS) ) {
         flag = 1;
         break;
       }
     }
     ca_detach(ca->mask);
+    if ( ( ! flag ) && ca_mask_cacheable(ca) ) {
+      ca_set_flag(ca->mask, CA_FLAG_MASK_CLEAN);
+    }
   }
 
   return flag;
 }
 
+/* mask pointer, NULL if no element is masked (ca should be attached,
+   the packed mask is expanded) */
+
+boolean8_t *
+ca_mask_ptr_any (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  if ( ca_mask_is_packed(ca) ) {
+    ca_update_mask(ca);
+  }
+  if ( ca->mask && ca_is_any_masked(ca) ) {
+    return (boolean8_t *) ca->mask->ptr;
+  }
+  return NULL;
+}
+
 int
 ca_is_all_masked (void *ap)
 {
@@ -85,8 +148,20 @@ ca_is_all_masked (void *ap)
   ca_size_t i;
   int flag;
 
+  if ( ca_mask_is_packed(ca) ) {
+    for (i=0; i<ca_mask_nwords(ca->elements); i++) {
+      if ( ca->mask_bits[i] != ca_mask_word_fill(ca->elements - i * CA_MASK_WORD_BITS) ) {
+        return 0;
+      }
+    }
+    return 1;
+  }
+
   ca_update_mask(ca);
   if ( ca->mask ) {
+    if ( ca_test_flag(ca->mask, CA_FLAG_MASK_CLEAN) ) {
+      return ( ca->elements == 0 );
+    }
     flag = 1;
     ca_attach(ca->mask);
     m = (boolean8_t *) ca->mask->ptr;
@@ -192,8 +267,10 @@ ca_copy_mask_overlay_n (void *ap, ca_size_t elements, int n, CArray **slist)
   int i, some_has_mask = 0;
   ca_size_t j;
 
+  /* nothing to overlay if no element of the sources is masked
+     (the mask of ca is not created in this case) */
   for (i=0; i<n; i++) {
-    if ( slist[i] && ca_has_mask(slist[i]) ) {
+    if ( slist[i] && ca_is_any_masked(slist[i]) ) {
       some_has_mask = 1;
       break;
     }
@@ -201,23 +278,43 @@ ca_copy_mask_overlay_n (void *ap, ca_size_t elements, int n, CArray **slist)
 
   if ( some_has_mask ) {
 
-    ca_update_mask(ca);
-    if ( ! ca->mask ) {
-      ca_create_mask(ca);
-    }
+    ca_mask_touch(ca);
 
     if ( elements > ca->elements ) {
       elements = ca->elements;
     }
 
+    /* the packed mask (see carray_bitmask.c) */
+    if ( ca_mask_is_packed(ca) ||
+         ( ( ! ca->mask ) && ca_test_flag(ca, CA_FLAG_MASK_PACKED) ) ) {
+      if ( ca_mask_bits_overlay(ca, elements, n, slist) ) {
+        return;
+      }
+    }
+
+    ca_update_mask(ca);
+    if ( ! ca->mask ) {
+      ca_create_mask(ca);
+    }
+
     ca_attach(ca->mask);
     for (i=0; i<n; i++) {
       cs = slist[i];
       if ( ! cs ) {
         continue;
       }
+      if ( ca_mask_is_packed(cs) ) {
+        ma = (boolean8_t *) ca->mask->ptr;
+        for (j=0; j<elements; j++) {
+          if ( ( cs->mask_bits[j / CA_MASK_WORD_BITS]
+                 >> ( j % CA_MASK_WORD_BITS ) ) & 1 ) {
+            ma[j] = 1;
+          }
+        }
+        continue;
+      }
       ca_update_mask(cs);
-      if ( ! cs->mask ) {
+      if ( ( ! cs->mask ) || ca_test_flag(cs->mask, CA_FLAG_MASK_CLEAN) ) {
         continue;
       }
       ca_attach(cs->mask);
@@ -319,20 +416,24 @@ ca_size_t
 ca_count_masked (void *ap)
 {
   CArray *ca = (CArray *) ap;
-  boolean8_t *m;
-  ca_size_t i, count = 0;
+  ca_size_t count = 0;
+
+  if ( ca_mask_is_packed(ca) ) {
+    return ca_mask_bits_count(ca->mask_bits, ca->elements);
+  }
 
   ca_update_mask(ca);
 
   if ( ca->mask ) {
-    ca_attach(ca->mask);
-    m = (boolean8_t *) ca->mask->ptr;
-    for (i=0; i<ca->elements; i++) {
-      if ( *m++ ) {
-        count++;
-      }
+    if ( ca_test_flag(ca->mask, CA_FLAG_MASK_CLEAN) ) {
+      return 0;
     }
+    ca_attach(ca->mask);
+    count = ca_mask_count((boolean8_t *) ca->mask->ptr, ca->elements);
     ca_detach(ca->mask);
+    if ( count == 0 && ca_mask_cacheable(ca) ) {
+      ca_set_flag(ca->mask, CA_FLAG_MASK_CLEAN);
+    }
   }
 
   return count;
@@ -573,6 +674,9 @@ rb_ca_has_mask (VALUE self)
 {
   CArray *ca;
   TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  if ( ca_mask_is_packed(ca) ) {
+    return Qtrue;
+  }
   return ( ca_has_mask(ca) ) ? Qtrue : Qfalse;
 }
 
@@ -840,9 +944,7 @@ VALUE
 rb_ca_count_masked (VALUE self)
 {
   CArray *ca;
-  printf("hello\n");
   TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
-  printf("world\n");
   return SIZE2NUM(ca_count_masked(ca));
 }
 
@@ -1165,5 +1267,10 @@ Init_carray_mask ()
 /*  def count_masked (*axis); end */
 /*  def count_not_masked (*axis); end */
 
+  /* the counts without axis (the packed mask is not expanded) */
+  rb_define_method(rb_cCArray, "__count_masked__", rb_ca_count_masked, 0);
+  rb_define_method(rb_cCArray, "__count_not_masked__",
+                                               rb_ca_count_not_masked, 0);
+
 }
 
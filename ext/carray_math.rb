@@ -71,7 +71,8 @@ alias_op("-@", "neg")
 alias_op("~", "bit_neg")
 
 monop("abs_i", "abs_i",
-      INT_TYPES   => "(#2) = abs(#1);",
+      SINT_TYPES  => "(#2) = ( (#1) < 0 ) ? -(#1) : (#1);",
+      UINT_TYPES  => "(#2) = (#1);",
       FLOAT_TYPES => "(#2) = fabs((float64_t)#1);",
       CMPLX_TYPES => HAVE_COMPLEX ? "(#2) = cabs((cmplx128_t)#1);" : nil,
       OBJ_TYPES   => '(#2) = rb_funcall((#1), rb_intern("abs"), 0);')
@@ -143,7 +144,7 @@ monfunc("round", "round",
       FLOAT_TYPES => %{(#2) = ((#1)>0.0) ? floor((#1)+0.5) : ((#1)<0.0) ? ceil((#1)-0.5) : 0.0; },
       OBJ_TYPES   => '(#2) = rb_funcall((#1), rb_intern("round"), 0);')
 monfunc("rcp", "rcp",
-      INT_TYPES => "if ((#1)==0) {ca_zerodiv();}; (#2) = 1/(#1);",
+      INT_TYPES => "if ((#1)==0) {ca_zerodiv(); (#2) = 0;} else {(#2) = 1/(#1);}",
       FLOAT_TYPES => "(#2) = 1/(#1);",
       CMPLX_TYPES => HAVE_COMPLEX ? "(#2) = 1/(#1);" : nil,
       OBJ_TYPES => '(#2) = rb_funcall(INT2NUM(1), id_slash, 1, (#1));')
@@ -254,7 +255,7 @@ binop("*", "mul",
       OBJ_TYPES => '(#3) = rb_funcall((#1), id_star, 1, (#2));')
 
 binop("/", "div",
-      INT_TYPES => "if ((#2)==0) {ca_zerodiv();}; (#3) = (#1) / (#2);",
+      INT_TYPES => "if ((#2)==0) {ca_zerodiv(); (#3) = 0;} else {(#3) = (#1) / (#2);}",
       FLOAT_TYPES => "(#3) = (#1) / (#2);",
       CMPLX_TYPES => HAVE_COMPLEX ? "(#3) = (#1) / (#2);" : nil,
       OBJ_TYPES => '(#3) = rb_funcall((#1), id_slash, 1, (#2));')
@@ -263,18 +264,18 @@ binop("quo_i", "quo_i",
       OBJ_TYPES => '(#3) = rb_funcall((#1), rb_intern("quo"), 1, (#2));')
 
 binop("rcp_mul", "rcp_mul",
-      INT_TYPES => "if ((#1)==0) {ca_zerodiv();}; (#3) = (#2) / (#1);",
+      INT_TYPES => "if ((#1)==0) {ca_zerodiv(); (#3) = 0;} else {(#3) = (#2) / (#1);}",
       FLOAT_TYPES => "(#3) = (#2) / (#1);",
       CMPLX_TYPES => HAVE_COMPLEX ? "(#3) = (#2) / (#1);" : nil,
       OBJ_TYPES => '(#3) = rb_funcall((#2), id_slash, 1, (#1));')
 
 binop("%", "mod",
-      INT_TYPES => "if ((#2)==0) {ca_zerodiv();}; (#3) = (#1) % (#2);",
+      INT_TYPES => "if ((#2)==0) {ca_zerodiv(); (#3) = 0;} else {(#3) = (#1) % (#2);}",
       FLOAT_TYPES => "(#3) = fmod(#1, #2);",
       OBJ_TYPES => '(#3) = rb_funcall((#1), id_percent, 1, (#2));')
 
 binop("reminder", "reminder",
-      INT_TYPES => "if ((#2)==0) {ca_zerodiv();}; (#3) = (#1) % (#2);",
+      INT_TYPES => "if ((#2)==0) {ca_zerodiv(); (#3) = 0;} else {(#3) = (#1) % (#2);}",
       FLOAT_TYPES => "(#3) = remainder(#1, #2);",
       OBJ_TYPES => '(#3) = rb_funcall((#1), id_percent, 1, (#2));')
 
@@ -537,7 +538,7 @@ op_powi_## type (type x, int32_t p) \
   } \
   if (p<0) { \
     type den = op_powi_## type(x, -p); \
-    if (den==0) ca_zerodiv(); \
+    if (den==0) { ca_zerodiv(); return 0; } \
     return 1/den; \
   }\
   while (p) { \
@@ -230,10 +230,16 @@ mathfunc_atan2 (void *p0, void *p1, void *p2)
 }
 
 static VALUE 
-rb_camath_atan2 (VALUE mod, VALUE rx1, VALUE rx2)
+rb_camath_atan2 (int argc, VALUE *argv, VALUE mod)
 {
-  return ca_call_cfunc_1_2(CA_DOUBLE, CA_DOUBLE, CA_DOUBLE, 
-                             mathfunc_atan2, rx1, rx2);
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 2, 2);
+  if ( NIL_P(rout) ) {
+    return ca_call_cfunc_1_2(CA_DOUBLE, CA_DOUBLE, CA_DOUBLE, 
+                             mathfunc_atan2, argv[0], argv[1]);
+  }
+  return ca_call_cfunc_1_2_to(CA_DOUBLE, CA_DOUBLE, CA_DOUBLE, 
+                              mathfunc_atan2, argv[0], argv[1], rout);
 }
 
 /* ----------------------------------------------------------------------- */
@@ -249,10 +255,16 @@ mathfunc_hypot (void *p0, void *p1, void *p2)
 }
 
 static VALUE 
-rb_camath_hypot (VALUE mod, VALUE rx1, VALUE rx2)
+rb_camath_hypot (int argc, VALUE *argv, VALUE mod)
 {
-  return ca_call_cfunc_1_2(CA_DOUBLE, CA_DOUBLE, CA_DOUBLE, 
-                             mathfunc_hypot, rx1, rx2);
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 2, 2);
+  if ( NIL_P(rout) ) {
+    return ca_call_cfunc_1_2(CA_DOUBLE, CA_DOUBLE, CA_DOUBLE, 
+                             mathfunc_hypot, argv[0], argv[1]);
+  }
+  return ca_call_cfunc_1_2_to(CA_DOUBLE, CA_DOUBLE, CA_DOUBLE, 
+                              mathfunc_hypot, argv[0], argv[1], rout);
 }
 
 /* ----------------------------------------------------------------------- */
@@ -268,9 +280,15 @@ mathfunc_lgamma (void *p0, void *p1)
 }
 
 static VALUE
-rb_camath_lgamma (VALUE mod, VALUE rx1)
+rb_camath_lgamma (int argc, VALUE *argv, VALUE mod)
 {
-  return ca_call_cfunc_1_1(CA_DOUBLE, CA_DOUBLE, mathfunc_lgamma, rx1);
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 1, 1);
+  if ( NIL_P(rout) ) {
+    return ca_call_cfunc_1_1(CA_DOUBLE, CA_DOUBLE, mathfunc_lgamma, argv[0]);
+  }
+  return ca_call_cfunc_1_1_to(CA_DOUBLE, CA_DOUBLE, mathfunc_lgamma, 
+                              argv[0], rout);
 }
 
 /* ----------------------------------------------------------------------- */
@@ -286,9 +304,15 @@ mathfunc_expm1 (void *p0, void *p1)
 }
 
 static VALUE
-rb_camath_expm1 (VALUE mod, VALUE rx1)
+rb_camath_expm1 (int argc, VALUE *argv, VALUE mod)
 {
-  return ca_call_cfunc_1_1(CA_DOUBLE, CA_DOUBLE, mathfunc_expm1, rx1);
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 1, 1);
+  if ( NIL_P(rout) ) {
+    return ca_call_cfunc_1_1(CA_DOUBLE, CA_DOUBLE, mathfunc_expm1, argv[0]);
+  }
+  return ca_call_cfunc_1_1_to(CA_DOUBLE, CA_DOUBLE, mathfunc_expm1, 
+                              argv[0], rout);
 }
 
 void
@@ -306,11 +330,11 @@ Init_carray_mathfunc ()
   rb_define_module_function(rb_mCAMath, "spherical_to_xyz", rb_camath_sph_to_xyz, 3);
   rb_define_module_function(rb_mCAMath, "xyz_to_spherical", rb_camath_xyz_to_sph, 3);
 
-  rb_define_module_function(rb_mCAMath, "atan2", rb_camath_atan2, 2);
-  rb_define_module_function(rb_mCAMath, "hypot", rb_camath_hypot, 2);
+  rb_define_module_function(rb_mCAMath, "atan2", rb_camath_atan2, -1);
+  rb_define_module_function(rb_mCAMath, "hypot", rb_camath_hypot, -1);
 
-  rb_define_module_function(rb_mCAMath, "lgamma",  rb_camath_lgamma, 1);
-  rb_define_module_function(rb_mCAMath, "expm1",   rb_camath_expm1, 1);
+  rb_define_module_function(rb_mCAMath, "lgamma",  rb_camath_lgamma, -1);
+  rb_define_module_function(rb_mCAMath, "expm1",   rb_camath_expm1, -1);
 
   rb_define_method(rb_cNumeric, "deg_360", rb_num_deg_360, 0);
   rb_define_method(rb_cNumeric, "deg_180", rb_num_deg_180, 0);
@@ -14,43 +14,529 @@
 
 VALUE rb_mCAMath;
 
-extern ca_binop_func_t ca_binop_mul[CA_NTYPE];
-extern ca_binop_func_t ca_binop_add[CA_NTYPE];
+extern ca_binop_bits_func_t ca_binop_mul[CA_NTYPE];
+extern ca_binop_bits_func_t ca_binop_add[CA_NTYPE];
 
 void
 ca_zerodiv ()
 {
-  #ifdef _OPENMP
-  #pragma omp master
-  #endif
+  /* in the parallel region, the error is raised after the region finishes */
+  if ( ca_parallel_set_error(CA_PARALLEL_ZERODIV) ) {
+    return;
+  }
   rb_raise(rb_eZeroDivError, "divided by 0");
 }
 
+/*
+  The kernels are called chunk by chunk through ca_parallel_for(), which
+  releases GVL and uses the worker pool for large arrays. The kernels for
+  CA_OBJECT call Ruby API, so they are always called with GVL.
+
+  The kernels take the mask as the packed words. The packed mask of the
+  result array (see carray_bitmask.c) is given as it is, and the mask
+  array is packed block by block on the stack.
+*/
+
+enum {
+  CA_KERNEL_MONOP,
+  CA_KERNEL_BINOP,
+  CA_KERNEL_MONCMP,
+  CA_KERNEL_BINCMP,
+};
+
+#define CA_KERNEL_MASK_BLOCK 4096
+
+typedef struct {
+  int         kind;
+  void       *func;
+  boolean8_t *m;        /* mask array */
+  uint64_t   *mw;       /* packed mask */
+  char       *ptr[3];
+  ca_size_t   bytes[3];
+  ca_size_t   step[3];
+} ca_kernel_call_t;
+
+static void
+ca_kernel_call_block (ca_kernel_call_t *c, ca_size_t start, ca_size_t n,
+                      uint64_t *m)
+{
+  char *p[3];
+  int i;
+
+  for (i=0; i<3; i++) {
+    p[i] = ( c->ptr[i] ) ? c->ptr[i] + start * c->step[i] * c->bytes[i] : NULL;
+  }
+
+  switch ( c->kind ) {
+  case CA_KERNEL_MONOP:
+    ((ca_monop_bits_func_t) c->func)(n, m, p[0], c->step[0], p[1], c->step[1]);
+    break;
+  case CA_KERNEL_BINOP:
+    ((ca_binop_bits_func_t) c->func)(n, m, p[0], c->step[0], p[1], c->step[1],
+                                      p[2], c->step[2]);
+    break;
+  case CA_KERNEL_MONCMP:
+    ((ca_moncmp_bits_func_t) c->func)(n, m, p[0], c->step[0],
+                                 (boolean8_t *) p[1], c->step[1]);
+    break;
+  case CA_KERNEL_BINCMP:
+    ((ca_bincmp_bits_func_t) c->func)(n, m, p[0], c->bytes[0], c->step[0],
+                                       p[1], c->bytes[1], c->step[1],
+                                       p[2], c->bytes[2], c->step[2]);
+    break;
+  }
+}
+
+static void
+ca_kernel_call_chunk (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_kernel_call_t *c = (ca_kernel_call_t *) arg;
+  uint64_t buf[CA_KERNEL_MASK_BLOCK / CA_MASK_WORD_BITS];
+  ca_size_t k = start, len, r;
+
+  if ( c->mw ) {
+    /* the head of the chunk up to the word boundary by the shifted word */
+    r = start % CA_MASK_WORD_BITS;
+    if ( r && k < end ) {
+      len = CA_MASK_WORD_BITS - r;
+      if ( len > end - k ) {
+        len = end - k;
+      }
+      buf[0] = c->mw[k / CA_MASK_WORD_BITS] >> r;
+      ca_kernel_call_block(c, k, len, buf);
+      k += len;
+    }
+    if ( k < end ) {
+      ca_kernel_call_block(c, k, end - k, c->mw + k / CA_MASK_WORD_BITS);
+    }
+  }
+  else if ( c->m ) {
+    for (; k<end; k+=len) {
+      len = end - k;
+      if ( len > CA_KERNEL_MASK_BLOCK ) {
+        len = CA_KERNEL_MASK_BLOCK;
+      }
+      ca_mask_pack_block(c->m + k, len, buf);
+      ca_kernel_call_block(c, k, len, buf);
+    }
+  }
+  else {
+    ca_kernel_call_block(c, start, end - start, NULL);
+  }
+}
+
+static void
+ca_kernel_call (ca_kernel_call_t *c, int8_t data_type, ca_size_t n, int implemented)
+{
+  /* "not_implement" kernels raise error, and scalar operations are 
+     not worth to be divided */
+  int nogvl = implemented && ( data_type != CA_OBJECT ) && 
+              ( c->step[0] || c->step[1] || c->step[2] );
+  ca_parallel_for(n, nogvl, ca_kernel_call_chunk, c);
+}
+
+/* sets the mask of cm (the array for the result) given to the kernels */
+
+static void
+ca_kernel_call_mask (ca_kernel_call_t *c, CArray *cm)
+{
+  if ( ca_mask_is_packed(cm) ) {
+    c->mw = ( ca_is_any_masked(cm) ) ? cm->mask_bits : NULL;
+  }
+  else {
+    c->m  = ca_mask_ptr_any(cm);
+  }
+}
+
+static void
+ca_exec_monop (ca_monop_bits_func_t func[], int8_t data_type, ca_size_t n, CArray *cm,
+               char *ptr1, ca_size_t b1, ca_size_t i1,
+               char *ptr2, ca_size_t b2, ca_size_t i2)
+{
+  ca_kernel_call_t c = { CA_KERNEL_MONOP, (void *) func[data_type], NULL, NULL,
+                         { ptr1, ptr2, NULL }, { b1, b2, 0 }, { i1, i2, 0 } };
+  ca_kernel_call_mask(&c, cm);
+  ca_kernel_call(&c, data_type, n,
+                 func[data_type] != ca_monop_not_implement);
+}
+
+static void
+ca_exec_binop (ca_binop_bits_func_t func[], int8_t data_type, ca_size_t n, CArray *cm,
+               char *ptr1, ca_size_t b1, ca_size_t i1,
+               char *ptr2, ca_size_t b2, ca_size_t i2,
+               char *ptr3, ca_size_t b3, ca_size_t i3)
+{
+  ca_kernel_call_t c = { CA_KERNEL_BINOP, (void *) func[data_type], NULL, NULL,
+                         { ptr1, ptr2, ptr3 }, { b1, b2, b3 }, { i1, i2, i3 } };
+  ca_kernel_call_mask(&c, cm);
+  ca_kernel_call(&c, data_type, n,
+                 func[data_type] != ca_binop_not_implement);
+}
+
+static void
+ca_exec_moncmp (ca_moncmp_bits_func_t func[], int8_t data_type, ca_size_t n, CArray *cm,
+                char *ptr1, ca_size_t b1, ca_size_t i1,
+                char *ptr2, ca_size_t b2, ca_size_t i2)
+{
+  ca_kernel_call_t c = { CA_KERNEL_MONCMP, (void *) func[data_type], NULL, NULL,
+                         { ptr1, ptr2, NULL }, { b1, b2, 0 }, { i1, i2, 0 } };
+  ca_kernel_call_mask(&c, cm);
+  ca_kernel_call(&c, data_type, n,
+                 func[data_type] != ca_moncmp_not_implement);
+}
+
+static void
+ca_exec_bincmp (ca_bincmp_bits_func_t func[], int8_t data_type, ca_size_t n, CArray *cm,
+                char *ptr1, ca_size_t b1, ca_size_t i1,
+                char *ptr2, ca_size_t b2, ca_size_t i2,
+                char *ptr3, ca_size_t b3, ca_size_t i3)
+{
+  ca_kernel_call_t c = { CA_KERNEL_BINCMP, (void *) func[data_type], NULL, NULL,
+                         { ptr1, ptr2, ptr3 }, { b1, b2, b3 }, { i1, i2, i3 } };
+  ca_kernel_call_mask(&c, cm);
+  ca_kernel_call(&c, data_type, n,
+                 func[data_type] != ca_bincmp_not_implement);
+}
+
+/*
+  When the operands are strided views (see carray_strided.c) without
+  masked elements, the kernels are called on the buffers of the entity
+  arrays row by row (the last dimension is the inner loop), instead of
+  attaching the virtual operands and synchronizing the result. The range
+  of elements given by ca_parallel_for() is walked through the rows.
+*/
+
+typedef struct {
+  ca_kernel_call_t c;                 /* ptr[] and step[] are set per row */
+  int8_t    ndim;
+  ca_size_t dim[CA_RANK_MAX];
+  ca_size_t stride[3][CA_RANK_MAX];   /* in bytes */
+} ca_strided_call_t;
+
+static void
+ca_strided_call_chunk (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_strided_call_t *s = (ca_strided_call_t *) arg;
+  ca_kernel_call_t c = s->c;
+  int8_t last = s->ndim - 1;
+  ca_size_t idx[CA_RANK_MAX];
+  ca_size_t k, q, len;
+  char *p;
+  int i, l;
+
+  q = start;
+  for (l=last; l>=0; l--) {
+    idx[l] = q % s->dim[l];
+    q /= s->dim[l];
+  }
+
+  k = start;
+  while ( k < end ) {
+    len = s->dim[last] - idx[last];
+    if ( len > end - k ) {
+      len = end - k;
+    }
+    for (i=0; i<3; i++) {
+      if ( s->c.ptr[i] ) {
+        p = s->c.ptr[i];
+        for (l=0; l<=last; l++) {
+          p += idx[l] * s->stride[i][l];
+        }
+        c.ptr[i] = p;
+      }
+    }
+    ca_kernel_call_chunk(0, len, &c);
+    k += len;
+    idx[last] = 0;
+    for (l=last-1; l>=0; l--) {
+      if ( ++idx[l] < s->dim[l] ) {
+        break;
+      }
+      idx[l] = 0;
+    }
+  }
+}
+
+/*
+  Sets up the strided call for the operands cs[0...n] (the last one is
+  the output). cs[n-1] == NULL stands for a new array for the output,
+  which is created after the setup. The strides of the dimensions
+  contiguous in all the operands are merged to make the rows longer.
+*/
+
+static int
+ca_strided_setup (ca_strided_call_t *s, int n, CArray **cs)
+{
+  CAStrided sv[3];
+  ca_size_t lo[3], hi[3];
+  int is_scalar[3];
+  int i, j, l, lead = -1, virtual = 0;
+  int8_t nd;
+
+  for (i=0; i<n; i++) {
+    is_scalar[i] = ( cs[i] && cs[i]->obj_type == CA_OBJ_SCALAR );
+    if ( ! cs[i] ) {
+      continue;
+    }
+    if ( is_scalar[i] ) {
+      if ( i == n - 1 || ca_is_any_masked(cs[i]) ) {
+        return 0;
+      }
+      continue;
+    }
+    if ( ! ca_strided_view(cs[i], &sv[i]) ) {
+      return 0;
+    }
+    if ( ca_is_any_masked(sv[i].root) ) {
+      return 0;
+    }
+    if ( ! ca_is_entity(cs[i]) ) {
+      virtual = 1;
+    }
+    if ( lead < 0 ) {
+      lead = i;
+    }
+  }
+
+  /* entity arrays are already operated on their buffers */
+  if ( ! virtual ) {
+    return 0;
+  }
+
+  s->ndim = sv[lead].ndim;
+  memcpy(s->dim, sv[lead].dim, s->ndim * sizeof(ca_size_t));
+
+  for (i=0; i<n; i++) {
+    if ( ! cs[i] ) {                    /* new array for the output */
+      sv[i].ptr   = NULL;
+      sv[i].bytes = s->c.bytes[i];
+      ca_strided_set_contiguous(&sv[i], s->ndim, s->dim);
+    }
+    else if ( is_scalar[i] ) {
+      sv[i].ptr = cs[i]->ptr;
+      for (l=0; l<s->ndim; l++) {
+        sv[i].stride[l] = 0;
+      }
+      continue;
+    }
+    else if ( cs[i]->elements != cs[lead]->elements ) {
+      return 0;
+    }
+    else if ( sv[i].ndim != s->ndim ||
+              memcmp(sv[i].dim, s->dim, s->ndim * sizeof(ca_size_t)) ) {
+      /* the different shape is allowed only for the contiguous operand */
+      if ( ! ca_strided_is_contiguous(&sv[i]) ) {
+        return 0;
+      }
+      ca_strided_set_contiguous(&sv[i], s->ndim, s->dim);
+    }
+  }
+
+  /* the output must not overlap the inputs, except for the same view */
+  if ( cs[n-1] ) {
+    for (i=0; i<n; i++) {
+      lo[i] = hi[i] = 0;
+      if ( cs[i] && ! is_scalar[i] ) {
+        for (l=0; l<s->ndim; l++) {
+          if ( sv[i].stride[l] < 0 ) {
+            lo[i] += ( s->dim[l] - 1 ) * sv[i].stride[l];
+          }
+          else {
+            hi[i] += ( s->dim[l] - 1 ) * sv[i].stride[l];
+          }
+        }
+        hi[i] += sv[i].bytes;
+      }
+    }
+    for (i=0; i<n-1; i++) {
+      if ( ! cs[i] || is_scalar[i] || sv[i].root != sv[n-1].root ) {
+        continue;
+      }
+      if ( sv[i].ptr == sv[n-1].ptr &&
+           ! memcmp(sv[i].stride, sv[n-1].stride, s->ndim * sizeof(ca_size_t)) ) {
+        continue;
+      }
+      if ( sv[i].ptr + lo[i] < sv[n-1].ptr + hi[n-1] &&
+           sv[n-1].ptr + lo[n-1] < sv[i].ptr + hi[i] ) {
+        return 0;
+      }
+    }
+  }
+
+  /* merges the contiguous dimensions and drops the dimensions of size 1 */
+  nd = 0;
+  for (l=0; l<s->ndim; l++) {
+    if ( s->dim[l] == 1 ) {
+      continue;
+    }
+    if ( nd > 0 ) {
+      for (j=0; j<n; j++) {
+        if ( sv[j].stride[nd-1] != sv[j].stride[l] * s->dim[l] ) {
+          break;
+        }
+      }
+      if ( j == n ) {
+        s->dim[nd-1] *= s->dim[l];
+        for (j=0; j<n; j++) {
+          sv[j].stride[nd-1] = sv[j].stride[l];
+        }
+        continue;
+      }
+    }
+    s->dim[nd] = s->dim[l];
+    for (j=0; j<n; j++) {
+      sv[j].stride[nd] = sv[j].stride[l];
+    }
+    nd++;
+  }
+  if ( nd == 0 ) {
+    s->dim[0] = 1;
+    for (j=0; j<n; j++) {
+      sv[j].stride[0] = 0;
+    }
+    nd = 1;
+  }
+  s->ndim = nd;
+
+  for (i=0; i<n; i++) {
+    s->c.ptr[i]  = sv[i].ptr;
+    s->c.step[i] = sv[i].stride[nd-1] / s->c.bytes[i];
+    memcpy(s->stride[i], sv[i].stride, nd * sizeof(ca_size_t));
+  }
+
+  return 1;
+}
+
+static void
+ca_strided_call (ca_strided_call_t *s, int8_t data_type, int implemented)
+{
+  ca_size_t elements = 1;
+  int nogvl = implemented && ( data_type != CA_OBJECT );
+  int8_t l;
+  for (l=0; l<s->ndim; l++) {
+    elements *= s->dim[l];
+  }
+  if ( elements > 0 ) {
+    ca_parallel_for(elements, nogvl, ca_strided_call_chunk, s);
+  }
+}
+
+/* ca2 = ca1.op, ca1.op! (ca2 == ca1) */
+
+static int
+ca_strided_monop (ca_monop_bits_func_t func[], CArray *ca1, CArray *ca2)
+{
+  ca_strided_call_t s;
+  CArray *cs[2] = { ca1, ca2 };
+  int8_t data_type = ca1->data_type;
+  ca_kernel_call_t c = { CA_KERNEL_MONOP, (void *) func[data_type], NULL, NULL,
+                         { NULL, NULL, NULL }, { ca1->bytes, ca2->bytes, 0 },
+                         { 0, 0, 0 } };
+  s.c = c;
+  if ( ! ca_strided_setup(&s, 2, cs) ) {
+    return 0;
+  }
+  ca_strided_call(&s, data_type, func[data_type] != ca_monop_not_implement);
+  return 1;
+}
+
+/* ca3 = ca1.op(ca2) (ca3 == NULL, returned in *out), ca1.op!(ca2) (ca3 == ca1) */
+
+static int
+ca_strided_binop (ca_binop_bits_func_t func[], CArray *ca1, CArray *ca2,
+                  CArray *ca3, CArray **out)
+{
+  ca_strided_call_t s;
+  CArray *cs[3] = { ca1, ca2, ca3 };
+  CArray *lead = ( ca1->obj_type == CA_OBJ_SCALAR ) ? ca2 : ca1;
+  int8_t data_type = ca1->data_type;
+  ca_kernel_call_t c = { CA_KERNEL_BINOP, (void *) func[data_type], NULL, NULL,
+                         { NULL, NULL, NULL },
+                         { ca1->bytes, ca2->bytes, lead->bytes },
+                         { 0, 0, 0 } };
+  s.c = c;
+  if ( ! ca_strided_setup(&s, 3, cs) ) {
+    return 0;
+  }
+  if ( ! ca3 ) {
+    *out = ca_template(lead);
+    s.c.ptr[2] = (*out)->ptr;
+  }
+  ca_strided_call(&s, data_type, func[data_type] != ca_binop_not_implement);
+  return 1;
+}
+
+/* ca2 = ca1.op */
+
+static int
+ca_strided_moncmp (ca_moncmp_bits_func_t func[], CArray *ca1, CArray *ca2)
+{
+  ca_strided_call_t s;
+  CArray *cs[2] = { ca1, ca2 };
+  int8_t data_type = ca1->data_type;
+  ca_kernel_call_t c = { CA_KERNEL_MONCMP, (void *) func[data_type], NULL, NULL,
+                         { NULL, NULL, NULL }, { ca1->bytes, ca2->bytes, 0 },
+                         { 0, 0, 0 } };
+  s.c = c;
+  if ( ! ca_strided_setup(&s, 2, cs) ) {
+    return 0;
+  }
+  ca_strided_call(&s, data_type, func[data_type] != ca_moncmp_not_implement);
+  return 1;
+}
+
+/* ca3 = ca1.op(ca2) (returned in *out) */
+
+static int
+ca_strided_bincmp (ca_bincmp_bits_func_t func[], CArray *ca1, CArray *ca2,
+                   CArray **out)
+{
+  ca_strided_call_t s;
+  CArray *cs[3] = { ca1, ca2, NULL };
+  CArray *lead = ( ca1->obj_type == CA_OBJ_SCALAR ) ? ca2 : ca1;
+  int8_t data_type = ca1->data_type;
+  ca_kernel_call_t c = { CA_KERNEL_BINCMP, (void *) func[data_type], NULL, NULL,
+                         { NULL, NULL, NULL }, { ca1->bytes, ca2->bytes, 1 },
+                         { 0, 0, 0 } };
+  s.c = c;
+  if ( ! ca_strided_setup(&s, 3, cs) ) {
+    return 0;
+  }
+  *out = carray_new(CA_BOOLEAN, lead->ndim, lead->dim, 0, NULL);
+  s.c.ptr[2] = (*out)->ptr;
+  ca_strided_call(&s, data_type, func[data_type] != ca_bincmp_not_implement);
+  return 1;
+}
+
 VALUE
-rb_ca_call_monop (VALUE self, ca_monop_func_t func[])
+rb_ca_call_monop (VALUE self, ca_monop_bits_func_t func[])
 {
   volatile VALUE out;
   CArray *ca1, *ca2;   /* ca2 = ca1.op */
 
   TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
 
-  if ( ca_has_mask(ca1) ) {
+  if ( ca_is_any_masked(ca1) ) {
     ca2 = ca_template_safe(ca1);              
   }
   else {
     ca2 = ca_template(ca1);        
   }
 
-  ca2 = ca_template(ca1);
   out = ca_wrap_struct(ca2);
 
-  ca_attach(ca1);
+  if ( ca_strided_monop(func, ca1, ca2) ) {
+    return out;
+  }
+
+  ca_kernel_attach(ca1);
+  ca_mask_prefer_packed(ca2);
   ca_copy_mask_overlay(ca2, ca2->elements, 1, ca1);
-  func[ca1->data_type](ca1->elements,
-                       ( ca2->mask ) ? (boolean8_t *)ca2->mask->ptr : NULL,
-                       ca1->ptr, 1,
-                       ca2->ptr, 1);
-  ca_detach(ca1);
+  ca_exec_monop(func, ca1->data_type, ca1->elements,
+                ca2,
+                ca1->ptr, ca1->bytes, 1,
+                ca2->ptr, ca2->bytes, 1);
+  ca_kernel_detach(ca1);
 
   /* unresolved unbound repeat array generates unbound repeat array again */
   if ( ca1->obj_type == CA_OBJ_UNBOUND_REPEAT ) {
@@ -62,7 +548,7 @@ rb_ca_call_monop (VALUE self, ca_monop_func_t func[])
 }
 
 VALUE
-rb_ca_call_monop_bang (VALUE self, ca_monop_func_t func[])
+rb_ca_call_monop_bang (VALUE self, ca_monop_bits_func_t func[])
 {
   CArray *ca1;         /* ca1.op! */
 
@@ -70,13 +556,18 @@ rb_ca_call_monop_bang (VALUE self, ca_monop_func_t func[])
 
   TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
 
-  ca_attach(ca1);
-  func[ca1->data_type](ca1->elements,
-                       ( ca1->mask ) ? (boolean8_t *)ca1->mask->ptr : NULL,
-                       ca1->ptr, 1,
-                       ca1->ptr, 1);
-  ca_sync(ca1);
-  ca_detach(ca1);
+  /* the strided view is operated in place without copy in and out */
+  if ( ca_strided_monop(func, ca1, ca1) ) {
+    return self;
+  }
+
+  ca_kernel_attach(ca1);
+  ca_exec_monop(func, ca1->data_type, ca1->elements,
+                ca1,
+                ca1->ptr, ca1->bytes, 1,
+                ca1->ptr, ca1->bytes, 1);
+  ca_kernel_sync(ca1);
+  ca_kernel_detach(ca1);
 
   return self;
 }
@@ -106,7 +597,7 @@ rb_ca_binop_pass_to_other (VALUE self, VALUE other, ID method)
 
 VALUE
 rb_ca_call_binop (volatile VALUE self, volatile VALUE other,
-                                         ca_binop_func_t func[])
+                                         ca_binop_bits_func_t func[])
 {
   volatile VALUE out;
   CArray *ca1, *ca2, *ca3; /* ca3 = ca1.op(ca2) */
@@ -117,12 +608,18 @@ rb_ca_call_binop (volatile VALUE self, volatile VALUE other,
   TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
   TypedData_Get_Struct(other, CArray, &carray_data_type, ca2);
 
-  ca_attach_n(2, ca1, ca2);
+  /* strided views without masked elements are operated without attaching */
+  if ( ca_strided_binop(func, ca1, ca2, NULL, &ca3) ) {
+    return ca_wrap_struct(ca3);
+  }
+
+  ca_kernel_attach(ca1);
+  ca_kernel_attach(ca2);
 
   /* main operation */
   if ( rb_obj_is_cscalar(self) ) {
     if ( rb_obj_is_cscalar(other) ) { /* scalar vs scalar */
-      if ( ca_has_mask(ca1) || ca_has_mask(ca2) ) {
+      if ( ca_is_any_masked(ca1) || ca_is_any_masked(ca2) ) {
         ca3 = ca_template_safe(ca1);              
       }
       else {
@@ -130,15 +627,16 @@ rb_ca_call_binop (volatile VALUE self, volatile VALUE other,
       }
       out = ca_wrap_struct(ca3);
 
+      ca_mask_prefer_packed(ca3);
       ca_copy_mask_overlay(ca3, ca3->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca3->mask ) ? (boolean8_t *) ca3->mask->ptr : NULL,
-                           ca1->ptr, 0,
-                           ca2->ptr, 0,
-                           ca3->ptr, 0);
+      ca_exec_binop(func, ca1->data_type, ca1->elements,
+                    ca3,
+                    ca1->ptr, ca1->bytes, 0,
+                    ca2->ptr, ca2->bytes, 0,
+                    ca3->ptr, ca3->bytes, 0);
     }
     else {                                         /* scalar vs array */
-      if ( ca_has_mask(ca1) || ca_has_mask(ca2) ) {
+      if ( ca_is_any_masked(ca1) || ca_is_any_masked(ca2) ) {
         ca3 = ca_template_safe(ca2);              
       }
       else {
@@ -146,17 +644,18 @@ rb_ca_call_binop (volatile VALUE self, volatile VALUE other,
       }
       out = ca_wrap_struct(ca3);
 
+      ca_mask_prefer_packed(ca3);
       ca_copy_mask_overlay(ca3, ca3->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca2->elements, 
-                           ( ca3->mask ) ? (boolean8_t *) ca3->mask->ptr : NULL,
-                           ca1->ptr, 0,
-                           ca2->ptr, 1,
-                           ca3->ptr, 1);
+      ca_exec_binop(func, ca1->data_type, ca2->elements,
+                    ca3,
+                    ca1->ptr, ca1->bytes, 0,
+                    ca2->ptr, ca2->bytes, 1,
+                    ca3->ptr, ca3->bytes, 1);
     }
   }
   else {                                           /* array vs scalar */
     if ( rb_obj_is_cscalar(other) ) {
-      if ( ca_has_mask(ca1) || ca_has_mask(ca2) ) {
+      if ( ca_is_any_masked(ca1) || ca_is_any_masked(ca2) ) {
         ca3 = ca_template_safe(ca1);              
       }
       else {
@@ -164,19 +663,20 @@ rb_ca_call_binop (volatile VALUE self, volatile VALUE other,
       }
       out = ca_wrap_struct(ca3);
 
+      ca_mask_prefer_packed(ca3);
       ca_copy_mask_overlay(ca3, ca3->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca3->mask ) ? (boolean8_t *) ca3->mask->ptr : NULL,
-                           ca1->ptr, 1,
-                           ca2->ptr, 0,
-                           ca3->ptr, 1);
+      ca_exec_binop(func, ca1->data_type, ca1->elements,
+                    ca3,
+                    ca1->ptr, ca1->bytes, 1,
+                    ca2->ptr, ca2->bytes, 0,
+                    ca3->ptr, ca3->bytes, 1);
     }
     else {                                         /* array vs array */
       if ( ca1->elements != ca2->elements ) {
         rb_raise(rb_eRuntimeError, "elements mismatch (%lld <-> %lld)",
                                    (ca_size_t) ca1->elements, (ca_size_t) ca2->elements);
       }
-      if ( ca_has_mask(ca1) || ca_has_mask(ca2) ) {
+      if ( ca_is_any_masked(ca1) || ca_is_any_masked(ca2) ) {
         ca3 = ca_template_safe(ca1);              
       }
       else {
@@ -184,16 +684,18 @@ rb_ca_call_binop (volatile VALUE self, volatile VALUE other,
       }
       out = ca_wrap_struct(ca3);
 
+      ca_mask_prefer_packed(ca3);
       ca_copy_mask_overlay(ca3, ca3->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca3->mask ) ? (boolean8_t *) ca3->mask->ptr : NULL,
-                           ca1->ptr, 1,
-                           ca2->ptr, 1,
-                           ca3->ptr, 1);
+      ca_exec_binop(func, ca1->data_type, ca1->elements,
+                    ca3,
+                    ca1->ptr, ca1->bytes, 1,
+                    ca2->ptr, ca2->bytes, 1,
+                    ca3->ptr, ca3->bytes, 1);
     }
   }
 
-  ca_detach_n(2, ca1, ca2);
+  ca_kernel_detach(ca1);
+  ca_kernel_detach(ca2);
 
   /* unresolved unbound repeat array generates unbound repeat array again */
   if ( ca1->obj_type == CA_OBJ_UNBOUND_REPEAT ) {
@@ -211,7 +713,7 @@ rb_ca_call_binop (volatile VALUE self, volatile VALUE other,
 }
 
 VALUE
-rb_ca_call_binop_bang (VALUE self, VALUE other, ca_binop_func_t func[])
+rb_ca_call_binop_bang (VALUE self, VALUE other, ca_binop_bits_func_t func[])
 {
   CArray *ca1, *ca2;   /* ca1.op!(ca2) */
 
@@ -223,17 +725,23 @@ rb_ca_call_binop_bang (VALUE self, VALUE other, ca_binop_func_t func[])
   TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
   TypedData_Get_Struct(other, CArray, &carray_data_type, ca2);
 
-  ca_attach_n(2, ca1, ca2);
+  /* the strided view is operated in place without copy in and out */
+  if ( ca_strided_binop(func, ca1, ca2, ca1, NULL) ) {
+    return self;
+  }
+
+  ca_kernel_attach(ca1);
+  ca_kernel_attach(ca2);
 
   /* main operation */
   if ( rb_obj_is_cscalar(self) ) {
     if ( rb_obj_is_cscalar(other) ) { /* scalar vs scalar */
       ca_copy_mask_overlay(ca1, ca1->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca1->mask ) ? (boolean8_t *) ca1->mask->ptr : NULL,
-                           ca1->ptr, 0,
-                           ca2->ptr, 0,
-                           ca1->ptr, 0);
+      ca_exec_binop(func, ca1->data_type, ca1->elements,
+                    ca1,
+                    ca1->ptr, ca1->bytes, 0,
+                    ca2->ptr, ca2->bytes, 0,
+                    ca1->ptr, ca1->bytes, 0);
     }
     else {                                         /* scalar vs array */
       if ( ca1->elements != ca2->elements ) {
@@ -242,21 +750,21 @@ rb_ca_call_binop_bang (VALUE self, VALUE other, ca_binop_func_t func[])
       }
 
       ca_copy_mask_overlay(ca1, ca1->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca1->mask ) ? (boolean8_t *) ca1->mask->ptr : NULL,
-                           ca1->ptr, 0,
-                           ca2->ptr, 0,
-                           ca1->ptr, 0);
+      ca_exec_binop(func, ca1->data_type, ca1->elements,
+                    ca1,
+                    ca1->ptr, ca1->bytes, 0,
+                    ca2->ptr, ca2->bytes, 0,
+                    ca1->ptr, ca1->bytes, 0);
     }
   }
   else {
     if ( rb_obj_is_cscalar(other) ) { /* array vs scalar */
       ca_copy_mask_overlay(ca1, ca1->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca1->mask ) ? (boolean8_t *) ca1->mask->ptr : NULL,
-                           ca1->ptr, 1,
-                           ca2->ptr, 0,
-                           ca1->ptr, 1);
+      ca_exec_binop(func, ca1->data_type, ca1->elements,
+                    ca1,
+                    ca1->ptr, ca1->bytes, 1,
+                    ca2->ptr, ca2->bytes, 0,
+                    ca1->ptr, ca1->bytes, 1);
     }
     else {                                          /* array vs array */
       if ( ca1->elements != ca2->elements ) {
@@ -265,23 +773,24 @@ rb_ca_call_binop_bang (VALUE self, VALUE other, ca_binop_func_t func[])
       }
 
       ca_copy_mask_overlay(ca1, ca1->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca1->mask ) ? (boolean8_t *) ca1->mask->ptr : NULL,
-                           ca1->ptr, 1,
-                           ca2->ptr, 1,
-                           ca1->ptr, 1);
+      ca_exec_binop(func, ca1->data_type, ca1->elements,
+                    ca1,
+                    ca1->ptr, ca1->bytes, 1,
+                    ca2->ptr, ca2->bytes, 1,
+                    ca1->ptr, ca1->bytes, 1);
     }
 
   }
 
-  ca_sync(ca1);
-  ca_detach_n(2, ca1, ca2);
+  ca_kernel_sync(ca1);
+  ca_kernel_detach(ca1);
+  ca_kernel_detach(ca2);
 
   return self;
 }
 
 VALUE
-rb_ca_call_moncmp (VALUE self, ca_moncmp_func_t func[])
+rb_ca_call_moncmp (VALUE self, ca_moncmp_bits_func_t func[])
 {
   volatile VALUE out;
   CArray *ca1, *ca2;    /* ca2 = ca1.op */
@@ -297,13 +806,18 @@ rb_ca_call_moncmp (VALUE self, ca_moncmp_func_t func[])
 
   TypedData_Get_Struct(out, CArray, &carray_data_type, ca2);
 
-  ca_attach(ca1);
+  if ( ca_strided_moncmp(func, ca1, ca2) ) {
+    return out;
+  }
+
+  ca_kernel_attach(ca1);
+  ca_mask_prefer_packed(ca2);
   ca_copy_mask_overlay(ca2, ca2->elements, 1, ca1);
-  func[ca1->data_type](ca1->elements, 
-                       ( ca2->mask ) ? (boolean8_t *) ca2->mask->ptr : NULL,
-                       ca1->ptr, 1,
-                       (boolean8_t *) ca2->ptr, 1);
-  ca_detach(ca1);
+  ca_exec_moncmp(func, ca1->data_type, ca1->elements,
+                 ca2,
+                 ca1->ptr, ca1->bytes, 1,
+                 ca2->ptr, ca2->bytes, 1);
+  ca_kernel_detach(ca1);
 
   /* unresolved unbound repeat array generates unbound repeat array again */
   if ( ca1->obj_type == CA_OBJ_UNBOUND_REPEAT ) {
@@ -315,22 +829,22 @@ rb_ca_call_moncmp (VALUE self, ca_moncmp_func_t func[])
 }
 
 
-extern ca_monop_func_t ca_bincmp_eq[CA_NTYPE];
-extern ca_monop_func_t ca_bincmp_ne[CA_NTYPE];
+extern ca_monop_bits_func_t ca_bincmp_eq[CA_NTYPE];
+extern ca_monop_bits_func_t ca_bincmp_ne[CA_NTYPE];
 
 VALUE
 rb_ca_call_bincmp (volatile VALUE self, volatile VALUE other,
-                                    ca_bincmp_func_t func[])
+                                    ca_bincmp_bits_func_t func[])
 {
   volatile VALUE out = Qnil;
   CArray *ca1, *ca2, *ca3;  /* ca3 = ca1.op(ca2) */
 
   /* check for comparison with CA_UNDEF */
   if ( other == CA_UNDEF ) {
-    if ( (ca_bincmp_func_t) func == (ca_bincmp_func_t) ca_bincmp_eq ) {  /* a.eq(UNDEF) -> a.is_masked */
+    if ( (ca_bincmp_bits_func_t) func == (ca_bincmp_bits_func_t) ca_bincmp_eq ) {  /* a.eq(UNDEF) -> a.is_masked */
       return rb_ca_is_masked(self);
     }
-    else if ( (ca_bincmp_func_t) func == (ca_bincmp_func_t) ca_bincmp_ne ) { /* a.ne(UNDEF) -> a.is_not_masked */
+    else if ( (ca_bincmp_bits_func_t) func == (ca_bincmp_bits_func_t) ca_bincmp_ne ) { /* a.ne(UNDEF) -> a.is_not_masked */
       return rb_ca_is_not_masked(self);
     }
     else {
@@ -344,7 +858,12 @@ rb_ca_call_bincmp (volatile VALUE self, volatile VALUE other,
   TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
   TypedData_Get_Struct(other, CArray, &carray_data_type, ca2);
 
-  ca_attach_n(2, ca1, ca2);
+  if ( ca_strided_bincmp(func, ca1, ca2, &ca3) ) {
+    return ca_wrap_struct(ca3);
+  }
+
+  ca_kernel_attach(ca1);
+  ca_kernel_attach(ca2);
 
   /* main operation */
   if ( rb_obj_is_cscalar(self) ) {
@@ -352,23 +871,25 @@ rb_ca_call_bincmp (volatile VALUE self, volatile VALUE other,
       out = rb_cscalar_new(CA_BOOLEAN, 0, NULL);
       TypedData_Get_Struct(out, CArray, &carray_data_type, ca3);
 
+      ca_mask_prefer_packed(ca3);
       ca_copy_mask_overlay(ca3, ca3->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca3->mask ) ? (boolean8_t *) ca3->mask->ptr : NULL,
-                           ca1->ptr, ca1->bytes, 0,
-                           ca2->ptr, ca2->bytes, 0,
-                           ca3->ptr, ca3->bytes, 0);
+      ca_exec_bincmp(func, ca1->data_type, ca1->elements,
+                     ca3,
+                     ca1->ptr, ca1->bytes, 0,
+                     ca2->ptr, ca2->bytes, 0,
+                     ca3->ptr, ca3->bytes, 0);
     }
     else {                                          /* scalar vs array */
       out = rb_carray_new(CA_BOOLEAN, ca2->ndim, ca2->dim, 0, NULL);
       TypedData_Get_Struct(out, CArray, &carray_data_type, ca3);
 
+      ca_mask_prefer_packed(ca3);
       ca_copy_mask_overlay(ca3, ca3->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca2->elements, 
-                           ( ca3->mask ) ? (boolean8_t *) ca3->mask->ptr : NULL,
-                           ca1->ptr, ca1->bytes, 0,
-                           ca2->ptr, ca2->bytes, 1,
-                           ca3->ptr, ca3->bytes, 1);
+      ca_exec_bincmp(func, ca1->data_type, ca2->elements,
+                     ca3,
+                     ca1->ptr, ca1->bytes, 0,
+                     ca2->ptr, ca2->bytes, 1,
+                     ca3->ptr, ca3->bytes, 1);
     }
   }
   else {
@@ -376,12 +897,13 @@ rb_ca_call_bincmp (volatile VALUE self, volatile VALUE other,
       out = rb_carray_new(CA_BOOLEAN, ca1->ndim, ca1->dim, 0, NULL);
       TypedData_Get_Struct(out, CArray, &carray_data_type, ca3);
 
+      ca_mask_prefer_packed(ca3);
       ca_copy_mask_overlay(ca3, ca3->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca3->mask ) ? (boolean8_t *) ca3->mask->ptr : NULL,
-                           ca1->ptr, ca1->bytes, 1,
-                           ca2->ptr, ca2->bytes, 0,
-                           ca3->ptr, ca3->bytes, 1);
+      ca_exec_bincmp(func, ca1->data_type, ca1->elements,
+                     ca3,
+                     ca1->ptr, ca1->bytes, 1,
+                     ca2->ptr, ca2->bytes, 0,
+                     ca3->ptr, ca3->bytes, 1);
     }
     else {                                          /* array vs array */
       if ( ca1->elements != ca2->elements ) {
@@ -391,16 +913,18 @@ rb_ca_call_bincmp (volatile VALUE self, volatile VALUE other,
       out = rb_carray_new(CA_BOOLEAN, ca1->ndim, ca1->dim, 0, NULL);
       TypedData_Get_Struct(out, CArray, &carray_data_type, ca3);
 
+      ca_mask_prefer_packed(ca3);
       ca_copy_mask_overlay(ca3, ca3->elements, 2, ca1, ca2);
-      func[ca1->data_type](ca1->elements, 
-                           ( ca3->mask ) ? (boolean8_t *) ca3->mask->ptr : NULL,
-                           ca1->ptr, ca1->bytes, 1,
-                           ca2->ptr, ca2->bytes, 1,
-                           ca3->ptr, ca3->bytes, 1);
+      ca_exec_bincmp(func, ca1->data_type, ca1->elements,
+                     ca3,
+                     ca1->ptr, ca1->bytes, 1,
+                     ca2->ptr, ca2->bytes, 1,
+                     ca3->ptr, ca3->bytes, 1);
     }
   }
 
-  ca_detach_n(2, ca1, ca2);
+  ca_kernel_detach(ca1);
+  ca_kernel_detach(ca2);
 
   /* unresolved unbound repeat array generates unbound repeat array again */
   if ( ca1->obj_type == CA_OBJ_UNBOUND_REPEAT ) {
@@ -411,8 +935,235 @@ rb_ca_call_bincmp (volatile VALUE self, volatile VALUE other,
   return out;
 }
 
+/* ------------------------------------------------------------------- */
+
+/*
+  The following functions store the result of the operation into the
+  existing array "out" (given by "out:" option) instead of creating a new
+  array. "out" should have the same number of elements and the same data
+  type as the result, and can be a virtual array. The mask of "out" is
+  overwritten by the overlay of the operands' masks.
+*/
+
+VALUE
+rb_ca_pop_out (int *argc, VALUE **argv)
+{
+  volatile VALUE ropt, rout = Qnil;
+  ropt = rb_pop_options(argc, argv);
+  rb_scan_options(ropt, "out", &rout);
+  return rout;
+}
+
+CArray *
+ca_check_out (VALUE out, int8_t data_type, ca_size_t elements)
+{
+  CArray *co;
+
+  rb_check_carray_object(out);
+  rb_ca_modify(out);
+
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  if ( co->data_type != data_type ) {
+    rb_raise(rb_eCADataTypeError,
+             "data type mismatch of out ('%s' for '%s')",
+             ca_type_name[co->data_type], ca_type_name[data_type]);
+  }
+  if ( co->elements != elements ) {
+    rb_raise(rb_eRuntimeError, "elements mismatch of out (%lld for %lld)",
+             (ca_size_t) co->elements, (ca_size_t) elements);
+  }
+
+  return co;
+}
+
+static void
+ca_check_out_operand (CArray *ca)
+{
+  if ( ca->obj_type == CA_OBJ_UNBOUND_REPEAT ) {
+    rb_raise(rb_eRuntimeError,
+             "can't store the result for unbound repeat array into out");
+  }
+}
+
+static void
+ca_overwrite_out_mask (CArray *co, int n, CArray **slist)
+{
+  boolean8_t zero = 0;
+  int i;
+
+  /* the mask of out is cleared unless out is one of the operands */
+  for (i=0; i<n; i++) {
+    if ( slist[i] == co ) {
+      break;
+    }
+  }
+  if ( i == n ) {
+    ca_update_mask(co);
+    if ( co->mask ) {
+      ca_fill(co->mask, &zero);
+    }
+  }
+
+  ca_copy_mask_overlay_n(co, co->elements, n, slist);
+}
+
+VALUE
+rb_ca_call_monop_to (VALUE self, VALUE out, ca_monop_bits_func_t func[])
+{
+  CArray *ca1, *co;   /* co = ca1.op */
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
+
+  ca_check_out_operand(ca1);
+  co = ca_check_out(out, ca1->data_type, ca1->elements);
+
+  ca_attach(ca1);
+  ca_overwrite_out_mask(co, 1, &ca1);
+  ca_attach(co);
+  ca_exec_monop(func, ca1->data_type, ca1->elements,
+                co,
+                ca1->ptr, ca1->bytes, 1,
+                co->ptr, co->bytes, 1);
+  ca_sync(co);
+  ca_detach(co);
+  ca_detach(ca1);
+
+  return out;
+}
+
+VALUE
+rb_ca_call_binop_to (volatile VALUE self, volatile VALUE other, VALUE out,
+                                         ca_binop_bits_func_t func[])
+{
+  CArray *ca1, *ca2, *co; /* co = ca1.op(ca2) */
+  CArray *slist[2];
+  ca_size_t elements, i1, i2;
+
+  if ( ! rb_ca_test_castable(other) ) {
+    rb_raise(rb_eArgError, "out can't be used with the operand of %s",
+             rb_obj_classname(other));
+  }
+
+  /* do implicit casting and resolving unbound repeat array */
+  rb_ca_cast_self_or_other(&self, &other);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
+  TypedData_Get_Struct(other, CArray, &carray_data_type, ca2);
+
+  ca_check_out_operand(ca1);
+  ca_check_out_operand(ca2);
+
+  i1 = rb_obj_is_cscalar(self)  ? 0 : 1;
+  i2 = rb_obj_is_cscalar(other) ? 0 : 1;
+
+  if ( i1 && i2 && ca1->elements != ca2->elements ) {
+    rb_raise(rb_eRuntimeError, "elements mismatch (%lld <-> %lld)",
+                               (ca_size_t) ca1->elements, (ca_size_t) ca2->elements);
+  }
+
+  elements = ( i1 ) ? ca1->elements : ca2->elements;
+  co = ca_check_out(out, ca1->data_type, elements);
+
+  ca_attach_n(2, ca1, ca2);
+  slist[0] = ca1;
+  slist[1] = ca2;
+  ca_overwrite_out_mask(co, 2, slist);
+  ca_attach(co);
+  ca_exec_binop(func, ca1->data_type, elements,
+                co,
+                ca1->ptr, ca1->bytes, i1,
+                ca2->ptr, ca2->bytes, i2,
+                co->ptr, co->bytes, 1);
+  ca_sync(co);
+  ca_detach(co);
+  ca_detach_n(2, ca1, ca2);
+
+  return out;
+}
+
+VALUE
+rb_ca_call_moncmp_to (VALUE self, VALUE out, ca_moncmp_bits_func_t func[])
+{
+  CArray *ca1, *co;    /* co = ca1.op */
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
+
+  ca_check_out_operand(ca1);
+  co = ca_check_out(out, CA_BOOLEAN, ca1->elements);
+
+  ca_attach(ca1);
+  ca_overwrite_out_mask(co, 1, &ca1);
+  ca_attach(co);
+  ca_exec_moncmp(func, ca1->data_type, ca1->elements,
+                 co,
+                 ca1->ptr, ca1->bytes, 1,
+                 co->ptr, co->bytes, 1);
+  ca_sync(co);
+  ca_detach(co);
+  ca_detach(ca1);
+
+  return out;
+}
+
+VALUE
+rb_ca_call_bincmp_to (volatile VALUE self, volatile VALUE other, VALUE out,
+                                    ca_bincmp_bits_func_t func[])
+{
+  CArray *ca1, *ca2, *co;  /* co = ca1.op(ca2) */
+  CArray *slist[2];
+  ca_size_t elements, i1, i2;
+
+  /* comparison with CA_UNDEF (is_masked, is_not_masked) */
+  if ( other == CA_UNDEF ) {
+    rb_ca_store_all(out, rb_ca_call_bincmp(self, other, func));
+    return out;
+  }
+
+  if ( ! rb_ca_test_castable(other) ) {
+    rb_raise(rb_eArgError, "out can't be used with the operand of %s",
+             rb_obj_classname(other));
+  }
+
+  /* do implicit casting and resolving unbound repeat array */
+  rb_ca_cast_self_or_other(&self, &other);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca1);
+  TypedData_Get_Struct(other, CArray, &carray_data_type, ca2);
+
+  ca_check_out_operand(ca1);
+  ca_check_out_operand(ca2);
+
+  i1 = rb_obj_is_cscalar(self)  ? 0 : 1;
+  i2 = rb_obj_is_cscalar(other) ? 0 : 1;
+
+  if ( i1 && i2 && ca1->elements != ca2->elements ) {
+    rb_raise(rb_eRuntimeError, "elements mismatch in bincmp (%lld <-> %lld)",
+                               (ca_size_t) ca1->elements, (ca_size_t) ca2->elements);
+  }
+
+  elements = ( i1 ) ? ca1->elements : ca2->elements;
+  co = ca_check_out(out, CA_BOOLEAN, elements);
+
+  ca_attach_n(2, ca1, ca2);
+  slist[0] = ca1;
+  slist[1] = ca2;
+  ca_overwrite_out_mask(co, 2, slist);
+  ca_attach(co);
+  ca_exec_bincmp(func, ca1->data_type, elements,
+                 co,
+                 ca1->ptr, ca1->bytes, i1,
+                 ca2->ptr, ca2->bytes, i2,
+                 co->ptr, co->bytes, 1);
+  ca_sync(co);
+  ca_detach(co);
+  ca_detach_n(2, ca1, ca2);
+
+  return out;
+}
+
 void
-ca_monop_not_implement(ca_size_t n, boolean8_t *m, 
+ca_monop_not_implement(ca_size_t n, uint64_t *m, 
                                 char *ptr1, ca_size_t i1, 
                                 char *ptr2, ca_size_t i2)
 {
@@ -421,7 +1172,7 @@ ca_monop_not_implement(ca_size_t n, boolean8_t *m,
 }
 
 void
-ca_binop_not_implement(ca_size_t n, boolean8_t *m, 
+ca_binop_not_implement(ca_size_t n, uint64_t *m, 
                                 char *ptr1, ca_size_t i1, 
                                 char *ptr2, ca_size_t i2, 
                                 char *ptr3, ca_size_t i3)
@@ -431,7 +1182,7 @@ ca_binop_not_implement(ca_size_t n, boolean8_t *m,
 }
 
 void
-ca_moncmp_not_implement(ca_size_t n, boolean8_t *m, 
+ca_moncmp_not_implement(ca_size_t n, uint64_t *m, 
                                  char *ptr1, ca_size_t i1, 
                                  boolean8_t *ptr2, ca_size_t i2)
 {
@@ -440,7 +1191,7 @@ ca_moncmp_not_implement(ca_size_t n, boolean8_t *m,
 }
 
 void
-ca_bincmp_not_implement (ca_size_t n, boolean8_t *m, 
+ca_bincmp_not_implement (ca_size_t n, uint64_t *m, 
                                  char *ptr1, ca_size_t b1, ca_size_t i1, 
                                  char *ptr2, ca_size_t b2, ca_size_t i2, 
                                  char *ptr3, ca_size_t b3, ca_size_t i3)
@@ -478,6 +1229,27 @@ ca_math_call (VALUE mod, VALUE arg, ID id)
   }
 }
 
+/* CAMath functions accepting "out:" option, CAMath.sin(x, out: y) */
+
+VALUE
+ca_math_call_with_options (VALUE mod, int argc, VALUE *argv, ID id)
+{
+  volatile VALUE ropt;
+
+  ropt = rb_pop_options(&argc, &argv);
+  rb_check_arity(argc, 1, 1);
+
+  if ( NIL_P(ropt) ) {
+    return ca_math_call(mod, argv[0], id);
+  }
+  else if ( rb_obj_is_carray(argv[0]) ) {
+    return rb_funcall(argv[0], id, 1, ropt);
+  }
+  else {
+    rb_raise(rb_eArgError, "option is available only for CArray argument");
+  }
+}
+
 /* @overload coerece (other)
 
 [TBD]
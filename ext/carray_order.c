@@ -376,7 +376,8 @@ ca_qsort_cmp[CA_NTYPE] = {
 
 /* @overload sort!
 
-Sorts <i>ca</i>'s elements in place.
+Sorts <i>ca</i>'s elements in place. The integer and float types are 
+sorted by radix sort (see carray_sort.c), NaN is placed at the end.
 */
 
 static VALUE
@@ -412,7 +413,7 @@ rb_ca_sort_bang (VALUE self)
     ca->ptr = ca_ptr;
     free(cmp_ptr);
   }
-  else {
+  else if ( ! ca_sort_values(ca->data_type, ca->ptr, ca->elements) ) {
     qsort(ca->ptr, ca->elements, ca->bytes, ca_qsort_cmp[ca->data_type]);
   }
   ca_sync(ca);
@@ -0,0 +1,380 @@
+/* ---------------------------------------------------------------------------
+
+  carray_parallel.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  ca_parallel_for() runs a loop body over the range [0, n) on the internal
+  worker pool. The range is split into the chunks of at least
+  ca_parallel_threshold elements, so small arrays are processed on the
+  calling thread without any synchronization.
+
+  When "nogvl" is true and n is not smaller than the threshold, the loop
+  runs under rb_thread_call_without_gvl(), so the loop body must not call
+  any Ruby API. Errors in the body are reported by ca_parallel_set_error()
+  and raised after the parallel region finishes.
+*/
+
+#include "carray.h"
+#include <stdlib.h>
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+#include <ruby/thread.h>
+#endif
+
+#if defined(HAVE_PTHREAD_H)
+#include <pthread.h>
+#include <signal.h>
+#define CA_HAVE_THREAD_POOL 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CA_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define CA_THREAD_LOCAL __declspec(thread)
+#else
+#define CA_THREAD_LOCAL _Thread_local
+#endif
+
+#define CA_PARALLEL_THRESHOLD     65536
+
+static int       ca_parallel_threads   = 1;
+static ca_size_t ca_parallel_threshold = CA_PARALLEL_THRESHOLD;
+
+typedef struct {
+  ca_parallel_func_t func;
+  ca_parallel_reduce_func_t rfunc;
+  void              *arg;
+  ca_size_t          n;
+  int                nchunk;
+  int                next;     /* index of next chunk to be processed */
+  int                done;     /* number of processed chunks */
+  volatile int       status;   /* error flags (CA_PARALLEL_*) */
+} ca_parallel_job_t;
+
+/* error status of the parallel region which the current thread works for */
+static CA_THREAD_LOCAL volatile int *ca_parallel_status = NULL;
+
+int
+ca_parallel_set_error (int flag)
+{
+  if ( ca_parallel_status ) {
+    *ca_parallel_status |= flag;
+    return 1;
+  }
+  return 0;
+}
+
+static void
+ca_parallel_run_chunk (ca_parallel_job_t *job, int i)
+{
+  volatile int *save = ca_parallel_status;
+  ca_size_t start = (ca_size_t) ((double) job->n * i / job->nchunk);
+  ca_size_t end   = (ca_size_t) ((double) job->n * (i+1) / job->nchunk);
+  ca_parallel_status = &job->status;
+  if ( job->rfunc ) {
+    job->rfunc(i, start, end, job->arg);
+  }
+  else {
+    job->func(start, end, job->arg);
+  }
+  ca_parallel_status = save;
+}
+
+/* ------------------------------------------------------------------- */
+
+#ifdef CA_HAVE_THREAD_POOL
+
+static pthread_mutex_t pool_busy = PTHREAD_MUTEX_INITIALIZER; /* one job at a time */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER; /* guards the job */
+static pthread_cond_t  pool_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  pool_done = PTHREAD_COND_INITIALIZER;
+static ca_parallel_job_t *pool_job = NULL;
+static unsigned long      pool_generation = 0;
+static int                pool_nworker = 0;
+
+/* processes the chunks of the job until no chunk is left
+   (called with pool_lock held) */
+
+static void
+ca_parallel_work (ca_parallel_job_t *job)
+{
+  int i;
+  while ( job->next < job->nchunk ) {
+    i = job->next++;
+    pthread_mutex_unlock(&pool_lock);
+    ca_parallel_run_chunk(job, i);
+    pthread_mutex_lock(&pool_lock);
+    job->done += 1;
+    if ( job->done == job->nchunk ) {
+      pthread_cond_broadcast(&pool_done);
+    }
+  }
+}
+
+static void *
+ca_parallel_worker (void *arg)
+{
+  unsigned long seen = 0;
+  sigset_t set;
+
+  /* signals should be handled by ruby threads */
+  sigfillset(&set);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+  pthread_mutex_lock(&pool_lock);
+  for (;;) {
+    while ( pool_generation == seen ) {
+      pthread_cond_wait(&pool_wake, &pool_lock);
+    }
+    seen = pool_generation;
+    if ( pool_job ) {
+      ca_parallel_work(pool_job);
+    }
+  }
+  return NULL;
+}
+
+/* creates the workers up to nworker (called with pool_busy held) */
+
+static void
+ca_parallel_spawn (int nworker)
+{
+  pthread_attr_t attr;
+  pthread_t th;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  while ( pool_nworker < nworker ) {
+    if ( pthread_create(&th, &attr, ca_parallel_worker, NULL) ) {
+      break;
+    }
+    pool_nworker++;
+  }
+  pthread_attr_destroy(&attr);
+}
+
+static void
+ca_parallel_atfork_child (void)
+{
+  /* the workers do not exist in the child process */
+  pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t  c = PTHREAD_COND_INITIALIZER;
+  pool_busy = m;
+  pool_lock = m;
+  pool_wake = c;
+  pool_done = c;
+  pool_job  = NULL;
+  pool_nworker = 0;
+}
+
+#endif
+
+static void *
+ca_parallel_region (void *arg)
+{
+  ca_parallel_job_t *job = (ca_parallel_job_t *) arg;
+  int i;
+
+#ifdef CA_HAVE_THREAD_POOL
+  if ( job->nchunk > 1 && pthread_mutex_trylock(&pool_busy) == 0 ) {
+    ca_parallel_spawn(job->nchunk - 1);
+    pthread_mutex_lock(&pool_lock);
+    pool_job = job;
+    pool_generation++;
+    pthread_cond_broadcast(&pool_wake);
+    ca_parallel_work(job);
+    while ( job->done < job->nchunk ) {
+      pthread_cond_wait(&pool_done, &pool_lock);
+    }
+    pool_job = NULL;
+    pthread_mutex_unlock(&pool_lock);
+    pthread_mutex_unlock(&pool_busy);
+    return NULL;
+  }
+#endif
+
+  /* single chunk, or the pool is used by another thread */
+  for (i=0; i<job->nchunk; i++) {
+    ca_parallel_run_chunk(job, i);
+  }
+
+  return NULL;
+}
+
+/* runs the chunks of the job, returns the number of chunks */
+
+static int
+ca_parallel_run (ca_size_t n, int nogvl,
+                 ca_parallel_func_t func, ca_parallel_reduce_func_t rfunc,
+                 void *arg)
+{
+  ca_parallel_job_t job;
+  ca_size_t nchunk;
+
+  if ( n <= 0 ) {
+    return 0;
+  }
+
+  if ( ! nogvl || n < ca_parallel_threshold ) {
+    nchunk = 1;
+  }
+  else {
+    nchunk = n / ca_parallel_threshold;
+    if ( nchunk > ca_parallel_threads ) {
+      nchunk = ca_parallel_threads;
+    }
+  }
+
+  job.func   = func;
+  job.rfunc  = rfunc;
+  job.arg    = arg;
+  job.n      = n;
+  job.nchunk = (int) nchunk;
+  job.next   = 0;
+  job.done   = 0;
+  job.status = 0;
+
+  if ( nchunk == 1 ) {
+    if ( rfunc ) {
+      rfunc(0, 0, n, arg);
+    }
+    else {
+      func(0, n, arg);
+    }
+    return 1;
+  }
+
+#ifdef HAVE_RB_THREAD_CALL_WITHOUT_GVL
+  rb_thread_call_without_gvl(ca_parallel_region, &job, NULL, NULL);
+#else
+  ca_parallel_region(&job);
+#endif
+
+  if ( job.status & CA_PARALLEL_ZERODIV ) {
+    rb_raise(rb_eZeroDivError, "divided by 0");
+  }
+
+  return job.nchunk;
+}
+
+void
+ca_parallel_for (ca_size_t n, int nogvl, ca_parallel_func_t func, void *arg)
+{
+  ca_parallel_run(n, nogvl, func, NULL, arg);
+}
+
+/* calls func(i, start, end, arg) for the chunks i = 0...nchunk, 
+   returns nchunk (at most CA_PARALLEL_THREADS_MAX) */
+
+int
+ca_parallel_reduce (ca_size_t n, int nogvl, 
+                    ca_parallel_reduce_func_t func, void *arg)
+{
+  return ca_parallel_run(n, nogvl, NULL, func, arg);
+}
+
+/* ------------------------------------------------------------------- */
+
+/* @overload num_threads
+
+Returns the number of threads used for the operations on large arrays.
+The default value is taken from the environment variable
+CARRAY_NUM_THREADS or the number of processors.
+*/
+
+static VALUE
+rb_ca_s_num_threads (VALUE klass)
+{
+  return INT2NUM(ca_parallel_threads);
+}
+
+/* @overload num_threads= (num)
+
+Sets the number of threads used for the operations on large arrays.
+*/
+
+static VALUE
+rb_ca_s_set_num_threads (VALUE klass, VALUE rnum)
+{
+  int num = NUM2INT(rnum);
+  if ( num < 1 || num > CA_PARALLEL_THREADS_MAX ) {
+    rb_raise(rb_eArgError, "number of threads should be in 1..%i",
+             CA_PARALLEL_THREADS_MAX);
+  }
+  ca_parallel_threads = num;
+  return rnum;
+}
+
+/* @overload parallel_threshold
+
+Returns the minimum number of elements processed by a thread.
+The operations on the arrays smaller than this value run on the calling
+thread without releasing GVL.
+*/
+
+static VALUE
+rb_ca_s_parallel_threshold (VALUE klass)
+{
+  return SIZE2NUM(ca_parallel_threshold);
+}
+
+/* @overload parallel_threshold= (num)
+
+Sets the minimum number of elements processed by a thread.
+*/
+
+static VALUE
+rb_ca_s_set_parallel_threshold (VALUE klass, VALUE rnum)
+{
+  ca_size_t num = NUM2SIZE(rnum);
+  if ( num < 1 ) {
+    rb_raise(rb_eArgError, "threshold should be positive");
+  }
+  ca_parallel_threshold = num;
+  return rnum;
+}
+
+void
+Init_carray_parallel ()
+{
+  const char *env = getenv("CARRAY_NUM_THREADS");
+  long num = 1;
+
+  if ( env ) {
+    num = strtol(env, NULL, 10);
+  }
+#if defined(CA_HAVE_THREAD_POOL) && defined(_SC_NPROCESSORS_ONLN)
+  else {
+    num = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+#endif
+  if ( num < 1 ) {
+    num = 1;
+  }
+  if ( num > CA_PARALLEL_THREADS_MAX ) {
+    num = CA_PARALLEL_THREADS_MAX;
+  }
+  ca_parallel_threads = (int) num;
+
+#ifdef CA_HAVE_THREAD_POOL
+  pthread_atfork(NULL, NULL, ca_parallel_atfork_child);
+#endif
+
+  rb_define_singleton_method(rb_cCArray, "num_threads",
+                             rb_ca_s_num_threads, 0);
+  rb_define_singleton_method(rb_cCArray, "num_threads=",
+                             rb_ca_s_set_num_threads, 1);
+  rb_define_singleton_method(rb_cCArray, "parallel_threshold",
+                             rb_ca_s_parallel_threshold, 0);
+  rb_define_singleton_method(rb_cCArray, "parallel_threshold=",
+                             rb_ca_s_set_parallel_threshold, 1);
+}
@@ -0,0 +1,531 @@
+/* ---------------------------------------------------------------------------
+
+  carray_set.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  Set operations on the values of arrays (isin, intersect1d, union1d and
+  setdiff1d). The membership of the elements is tested by one of the two
+  strategies,
+
+    hash  : the table of the other array (ca_hash_lookup in carray_hash.c)
+            is probed by each element.
+    merge : the other array is sorted and made unique, the elements are
+            sorted by their addresses (ca_sort_index), and both are merged.
+
+  The merge is used for the integer and float types when the other array
+  has more than CA_SET_HASH_MAX elements, because the probes to a table
+  larger than the cache are slower than the radix sorts. The sorted unique
+  values are made by the radix sort for the arrays larger than
+  CA_SET_SORT_MIN, otherwise by the hash table of CArray#uniq.
+
+  The values are compared by "==" (0.0 and -0.0 are same, and all NaNs
+  are regarded as one value), and the masked elements are ignored.
+*/
+
+#include "carray.h"
+#include <math.h>
+
+#define CA_SET_HASH_MAX  (1 << 21)
+#define CA_SET_SORT_MIN  (1 << 16)
+
+#define lt_int(a, b)   ( (a) < (b) )
+#define eq_int(a, b)   ( (a) == (b) )
+#define lt_flt(a, b)   ( (a) < (b) || ( isnan(b) && ! isnan(a) ) )
+#define eq_flt(a, b)   ( (a) == (b) || ( isnan(a) && isnan(b) ) )
+
+/* removes the duplicates from the sorted values p[0...n],
+   returns the number of the values left */
+
+#define proc_set_unique(type, EQ)                                       \
+static ca_size_t                                                        \
+ca_set_unique_ ## type (void *ptr, ca_size_t n)                         \
+{                                                                       \
+  type *p = (type *) ptr;                                               \
+  ca_size_t i, k;                                                       \
+  if ( n <= 0 ) {                                                       \
+    return 0;                                                           \
+  }                                                                     \
+  for (i=1, k=1; i<n; i++) {                                            \
+    if ( ! EQ(p[i], p[k-1]) ) {                                         \
+      p[k++] = p[i];                                                    \
+    }                                                                   \
+  }                                                                     \
+  return k;                                                             \
+}
+
+/* sets out[idx[i]] to 1 if the element pa[idx[i]] is found in pb[0...nb],
+   where idx[0...na] is sorted by pa and pb is sorted and unique */
+
+#define proc_set_merge(type, LT, EQ)                                    \
+static void                                                             \
+ca_set_merge_ ## type (void *ptra, ca_size_t *idx, ca_size_t na,        \
+                       void *ptrb, ca_size_t nb, boolean8_t *out)       \
+{                                                                       \
+  type *pa = (type *) ptra;                                             \
+  type *pb = (type *) ptrb;                                             \
+  type v;                                                               \
+  ca_size_t i, j = 0;                                                   \
+  for (i=0; i<na; i++) {                                                \
+    v = pa[idx[i]];                                                     \
+    while ( j < nb && LT(pb[j], v) ) {                                  \
+      j++;                                                              \
+    }                                                                   \
+    if ( j >= nb ) {                                                    \
+      break;                                                            \
+    }                                                                   \
+    out[idx[i]] = EQ(pb[j], v) ? 1 : 0;                                 \
+  }                                                                     \
+}
+
+#define proc_set(type, LT, EQ)                                          \
+  proc_set_unique(type, EQ)                                             \
+  proc_set_merge(type, LT, EQ)
+
+proc_set(boolean8_t, lt_int, eq_int)
+proc_set(int8_t,     lt_int, eq_int)
+proc_set(uint8_t,    lt_int, eq_int)
+proc_set(int16_t,    lt_int, eq_int)
+proc_set(uint16_t,   lt_int, eq_int)
+proc_set(int32_t,    lt_int, eq_int)
+proc_set(uint32_t,   lt_int, eq_int)
+proc_set(int64_t,    lt_int, eq_int)
+proc_set(uint64_t,   lt_int, eq_int)
+proc_set(float32_t,  lt_flt, eq_flt)
+proc_set(float64_t,  lt_flt, eq_flt)
+proc_set(float128_t, lt_flt, eq_flt)
+
+typedef ca_size_t (*ca_set_unique_func_t)(void *, ca_size_t);
+typedef void (*ca_set_merge_func_t)(void *, ca_size_t *, ca_size_t,
+                                    void *, ca_size_t, boolean8_t *);
+
+#define ca_set_table(name)                                             \
+static ca_set_ ## name ## _func_t                                      \
+ca_set_ ## name ## _func[CA_NTYPE] = {                                 \
+  NULL,                                                                \
+  ca_set_ ## name ## _boolean8_t,                                      \
+  ca_set_ ## name ## _int8_t,                                          \
+  ca_set_ ## name ## _uint8_t,                                         \
+  ca_set_ ## name ## _int16_t,                                         \
+  ca_set_ ## name ## _uint16_t,                                        \
+  ca_set_ ## name ## _int32_t,                                         \
+  ca_set_ ## name ## _uint32_t,                                        \
+  ca_set_ ## name ## _int64_t,                                         \
+  ca_set_ ## name ## _uint64_t,                                        \
+  ca_set_ ## name ## _float32_t,                                       \
+  ca_set_ ## name ## _float64_t,                                       \
+  ca_set_ ## name ## _float128_t,                                      \
+  NULL,                                                                \
+  NULL,                                                                \
+  NULL,                                                                \
+  NULL,                                                                \
+};
+
+ca_set_table(unique)
+ca_set_table(merge)
+
+/* ------------------------------------------------------------------- */
+
+/* guesses the data type of the values of other (not CArray) as the
+   implicit casting of the operators does for a number */
+
+static int8_t
+ca_set_guess_type (VALUE other)
+{
+  volatile VALUE list;
+  int is_int = 1, is_num = 1;
+  long i;
+  if ( TYPE(other) == T_ARRAY ) {
+    list = rb_funcall(other, rb_intern("flatten"), 0);
+  }
+  else {
+    list = rb_ary_new3(1, other);
+  }
+  for (i=0; i<RARRAY_LEN(list); i++) {
+    switch ( TYPE(rb_ary_entry(list, i)) ) {
+    case T_FIXNUM:
+    case T_BIGNUM:
+      break;
+    case T_FLOAT:
+      is_int = 0;
+      break;
+    default:
+      is_int = is_num = 0;
+      break;
+    }
+  }
+  return ( is_int ) ? CA_INT64 : ( is_num ) ? CA_FLOAT64 : CA_OBJECT;
+}
+
+/* returns other as an array of its own data type (guessed from the values
+   for Array or Numeric), or of the data type of self for the other values */
+
+static VALUE
+rb_ca_set_values (VALUE self, VALUE other)
+{
+  volatile VALUE obj;
+  CArray *ca, *cb;
+  int8_t data_type;
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  if ( rb_obj_is_carray(other) ) {
+    TypedData_Get_Struct(other, CArray, &carray_data_type, cb);
+    if ( ( cb->data_type == CA_FIXLEN || ca->data_type == CA_FIXLEN ) &&
+         ! ( cb->data_type == ca->data_type && cb->bytes == ca->bytes ) ) {
+      rb_raise(rb_eCADataTypeError,
+               "data type mismatch between %s[%lld] and %s[%lld]",
+               ca_type_name[ca->data_type], (long long) ca->bytes,
+               ca_type_name[cb->data_type], (long long) cb->bytes);
+    }
+    return other;
+  }
+  data_type = ca_set_guess_type(other);
+  if ( data_type == CA_OBJECT ) {
+    data_type = ca->data_type;
+  }
+  obj = rb_ca_wrap_readonly(other, INT2NUM(data_type));
+  if ( ! rb_obj_is_carray(obj) ) {
+    rb_raise(rb_eTypeError, "can't convert %s to CArray",
+             rb_obj_classname(other));
+  }
+  return obj;
+}
+
+/* returns other (see rb_ca_set_values) as an array of the data type of
+   self. A value which does not survive the conversion to the data type
+   of self and back (3.5 or 256 for an int32 or uint8 self) can't be equal
+   to any element of self, so such values are dropped and *lost is set.
+   Then the result is the 1-D array of the valid values left. */
+
+static VALUE
+rb_ca_set_other (VALUE self, VALUE other, int *lost)
+{
+  volatile VALUE obj, back, rok;
+  CArray *ca, *cb, *co, *ck, *cx;
+  boolean8_t *ok, *m;
+  ca_size_t i, n;
+
+  *lost = 0;
+
+  other = rb_ca_set_values(self, other);
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  TypedData_Get_Struct(other, CArray, &carray_data_type, cb);
+  if ( cb->data_type == ca->data_type && cb->bytes == ca->bytes ) {
+    return other;
+  }
+
+  obj = rb_ca_wrap_readonly(other, INT2NUM(ca->data_type));
+  if ( ca->data_type == CA_OBJECT || cb->data_type == CA_OBJECT ) {
+    return obj;
+  }
+
+  /* the values which survive the round trip (NaN survives as NaN) */
+  back = rb_ca_wrap_readonly(obj, INT2NUM(cb->data_type));
+  rok  = rb_funcall(back, rb_intern("eq"), 1, other);
+  if ( ca_is_float_type(ca) ) {
+    rok = rb_funcall(rok, rb_intern("|"), 1,
+                     rb_funcall(back, rb_intern("ne"), 1, back));
+  }
+
+  TypedData_Get_Struct(rok, CArray, &carray_data_type, ck);
+  ca_attach(ck);
+  ok = (boolean8_t *) ck->ptr;
+  m  = ( ck->mask ) ? (boolean8_t *) ck->mask->ptr : NULL;
+  for (i=0, n=0; i<ck->elements; i++) {
+    if ( ! ( m && m[i] ) ) {
+      if ( ok[i] ) {
+        n++;
+      }
+      else {
+        *lost = 1;
+      }
+    }
+  }
+  if ( ! *lost ) {
+    ca_detach(ck);
+    return obj;
+  }
+
+  TypedData_Get_Struct(obj, CArray, &carray_data_type, cx);
+  other = rb_carray_new(ca->data_type, 1, &n, ca->bytes, NULL);
+  TypedData_Get_Struct(other, CArray, &carray_data_type, co);
+  ca_attach(cx);
+  for (i=0, n=0; i<ck->elements; i++) {
+    if ( ok[i] && ! ( m && m[i] ) ) {
+      memcpy(co->ptr + (n++)*co->bytes, cx->ptr + i*cx->bytes, co->bytes);
+    }
+  }
+  ca_detach(cx);
+  ca_detach(ck);
+
+  return other;
+}
+
+/* copies the valid elements of ca (attached) into ptr,
+   returns the number of the elements copied */
+
+static ca_size_t
+ca_set_copy_valid (CArray *ca, char *ptr)
+{
+  boolean8_t *m = ( ca->mask ) ? (boolean8_t *) ca->mask->ptr : NULL;
+  ca_size_t i, n;
+  if ( ! m ) {
+    memcpy(ptr, ca->ptr, ca->bytes*ca->elements);
+    return ca->elements;
+  }
+  for (i=0, n=0; i<ca->elements; i++) {
+    if ( ! m[i] ) {
+      memcpy(ptr + (n++)*ca->bytes, ca->ptr + i*ca->bytes, ca->bytes);
+    }
+  }
+  return n;
+}
+
+/* returns the 1-D array of the sorted unique values of the valid elements
+   of self (and of other if given, which has the same data type) */
+
+static VALUE
+rb_ca_set_sorted_unique (VALUE self, VALUE other)
+{
+  volatile VALUE out, rtmp, rcode;
+  CArray *ca, *cb = NULL, *ct, *co;
+  ca_size_t n, nb = 0;
+  int8_t data_type;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  if ( ! NIL_P(other) ) {
+    TypedData_Get_Struct(other, CArray, &carray_data_type, cb);
+    nb = cb->elements;
+  }
+  data_type = ca->data_type;
+
+  /* the valid elements of self and other */
+
+  n = ca->elements + nb;
+  rtmp = rb_carray_new(data_type, 1, &n, ca->bytes, NULL);
+  TypedData_Get_Struct(rtmp, CArray, &carray_data_type, ct);
+
+  ca_attach(ca);
+  n = ca_set_copy_valid(ca, ct->ptr);
+  ca_detach(ca);
+  if ( cb ) {
+    ca_attach(cb);
+    n += ca_set_copy_valid(cb, ct->ptr + n*ct->bytes);
+    ca_detach(cb);
+  }
+
+  if ( ca_set_unique_func[data_type] && n > CA_SET_SORT_MIN ) {
+    ca_sort_values(data_type, ct->ptr, n);
+    n = ca_set_unique_func[data_type](ct->ptr, n);
+    out = rb_carray_new(data_type, 1, &n, ct->bytes, NULL);
+    TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+    memcpy(co->ptr, ct->ptr, ct->bytes*n);
+  }
+  else {
+    if ( n < ct->elements ) {
+      rtmp = rb_carray_new(data_type, 1, &n, ct->bytes, NULL);
+      TypedData_Get_Struct(rtmp, CArray, &carray_data_type, co);
+      memcpy(co->ptr, ct->ptr, ct->bytes*n);
+    }
+    rcode = rb_carray_new(CA_SIZE, 1, &n, 0, NULL);
+    TypedData_Get_Struct(rcode, CArray, &carray_data_type, co);
+    out = rb_ca_uniq_codes(rtmp, 1, (ca_size_t *) co->ptr, &n);
+  }
+
+  rb_ca_data_type_inherit(out, self);
+  return out;
+}
+
+/* sets out[i] to 1 for the elements of ca found in cb, and to 0 for
+   the others (including the masked elements) */
+
+static void
+ca_set_isin (CArray *ca, CArray *cb, boolean8_t *out)
+{
+  boolean8_t *ma, *mb;
+  ca_size_t *code;
+  ca_size_t i;
+
+  memset(out, 0, ca->elements);
+
+  ca_attach_n(2, ca, cb);
+  ma = ( ca->mask ) ? (boolean8_t *) ca->mask->ptr : NULL;
+  mb = ( cb->mask ) ? (boolean8_t *) cb->mask->ptr : NULL;
+
+  if ( ca_set_merge_func[ca->data_type] && cb->elements > CA_SET_HASH_MAX ) {
+    ca_size_t *idx, na, nb;
+    char *vb;
+    idx = malloc_with_check(sizeof(ca_size_t)*(ca->elements+1));
+    vb  = malloc_with_check(cb->bytes*(cb->elements+1));
+    for (i=0, na=0; i<ca->elements; i++) {
+      if ( ! ( ma && ma[i] ) ) {
+        idx[na++] = i;
+      }
+    }
+    nb = ca_set_copy_valid(cb, vb);
+    ca_sort_values(cb->data_type, vb, nb);
+    nb = ca_set_unique_func[cb->data_type](vb, nb);
+    ca_sort_index(ca->data_type, ca->ptr, idx, na);
+    ca_set_merge_func[ca->data_type](ca->ptr, idx, na, vb, nb, out);
+    free(idx);
+    free(vb);
+  }
+  else {
+    volatile VALUE rcode;
+    CArray *cc;
+    rcode = rb_carray_new(CA_SIZE, 1, &ca->elements, 0, NULL);
+    TypedData_Get_Struct(rcode, CArray, &carray_data_type, cc);
+    code = (ca_size_t *) cc->ptr;
+    ca_hash_lookup(cb, mb, ca, ma, code);
+    for (i=0; i<ca->elements; i++) {
+      out[i] = ( code[i] >= 0 );
+    }
+  }
+
+  ca_detach_n(2, ca, cb);
+}
+
+/* @overload isin (other)
+
+Returns the boolean array of the same shape as self, which is 1 for the
+elements found in the values of other (CArray or Array). The values of
+other are converted to the data type of self, and the values changed by
+the conversion (e.g. 3.5 or 256 for an int32 or uint8 self) are never
+found. The result is masked at the masked elements of self,
+and the masked elements of other are ignored. The membership is tested by
+the hash table of other, or by the merge of the sorted arrays for large
+integer and float arrays.
+
+    a = CA_INT([1, 5, 2, 7, 5])
+    a.isin([5, 7])           # => <0, 1, 0, 1, 1>
+*/
+
+static VALUE
+rb_ca_isin (VALUE self, VALUE other)
+{
+  volatile VALUE rb, out;
+  CArray *ca, *cb, *co;
+  int lost;
+
+  rb = rb_ca_set_other(self, other, &lost);
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  TypedData_Get_Struct(rb, CArray, &carray_data_type, cb);
+
+  out = rb_carray_new(CA_BOOLEAN, ca->ndim, ca->dim, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  ca_set_isin(ca, cb, (boolean8_t *) co->ptr);
+
+  if ( ca_has_mask(ca) ) {
+    ca_copy_mask_overlay(co, co->elements, 1, ca);
+  }
+
+  return out;
+}
+
+/* returns the elements of the sorted unique values of self which are
+   found (or not found if negate is true) in other */
+
+static VALUE
+rb_ca_set_select (VALUE self, VALUE other, int negate)
+{
+  volatile VALUE rb, ru, rflag, out;
+  CArray *cb, *cu, *cf, *co;
+  boolean8_t *f;
+  ca_size_t i, n;
+  int lost;
+
+  rb = rb_ca_set_other(self, other, &lost);
+  TypedData_Get_Struct(rb, CArray, &carray_data_type, cb);
+
+  ru = rb_ca_set_sorted_unique(self, Qnil);
+  TypedData_Get_Struct(ru, CArray, &carray_data_type, cu);
+
+  rflag = rb_carray_new(CA_BOOLEAN, 1, &cu->elements, 0, NULL);
+  TypedData_Get_Struct(rflag, CArray, &carray_data_type, cf);
+  f = (boolean8_t *) cf->ptr;
+
+  ca_set_isin(cu, cb, f);
+
+  for (i=0, n=0; i<cu->elements; i++) {
+    if ( f[i] != negate ) {
+      n++;
+    }
+  }
+
+  out = rb_carray_new(cu->data_type, 1, &n, cu->bytes, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+  for (i=0, n=0; i<cu->elements; i++) {
+    if ( f[i] != negate ) {
+      memcpy(co->ptr + (n++)*co->bytes, cu->ptr + i*cu->bytes, co->bytes);
+    }
+  }
+
+  rb_ca_data_type_inherit(out, self);
+  return out;
+}
+
+/* @overload intersect1d (other)
+
+Returns the sorted unique values found in both of self and other
+(the masked elements are ignored).
+
+    CA_INT([3, 1, 2, 3]).intersect1d(CA_INT([3, 4, 1]))   # => <1, 3>
+*/
+
+static VALUE
+rb_ca_intersect1d (VALUE self, VALUE other)
+{
+  return rb_ca_set_select(self, other, 0);
+}
+
+/* @overload setdiff1d (other)
+
+Returns the sorted unique values of self which are not found in other
+(the masked elements are ignored).
+
+    CA_INT([3, 1, 2, 3]).setdiff1d(CA_INT([3, 4, 1]))     # => <2>
+*/
+
+static VALUE
+rb_ca_setdiff1d (VALUE self, VALUE other)
+{
+  return rb_ca_set_select(self, other, 1);
+}
+
+/* @overload union1d (other)
+
+Returns the sorted unique values found in self or other
+(the masked elements are ignored). The result has the data type of self,
+or the common data type of the operators if some values of other are
+changed by the conversion to the data type of self.
+
+    CA_INT([3, 1, 2, 3]).union1d(CA_INT([3, 4, 1]))       # => <1, 2, 3, 4>
+*/
+
+static VALUE
+rb_ca_union1d (VALUE self, VALUE other)
+{
+  volatile VALUE ra = self, rb;
+  int lost;
+  rb = rb_ca_set_other(self, other, &lost);
+  if ( lost ) {
+    /* unites in the common data type of the operators */
+    rb = rb_ca_set_values(self, other);
+    rb_ca_cast_self_or_other(&ra, &rb);
+  }
+  return rb_ca_set_sorted_unique(ra, rb);
+}
+
+void
+Init_carray_set ()
+{
+  rb_define_method(rb_cCArray, "isin", rb_ca_isin, 1);
+  rb_define_method(rb_cCArray, "intersect1d", rb_ca_intersect1d, 1);
+  rb_define_method(rb_cCArray, "setdiff1d", rb_ca_setdiff1d, 1);
+  rb_define_method(rb_cCArray, "union1d", rb_ca_union1d, 1);
+}
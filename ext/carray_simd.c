@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------------
+
+  carray_simd.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  The kernels generated from carray_math.rb and carray_cast_func.rb are
+  compiled for several ISA levels (see SIMD_VARIANTS in mkmath.rb). At the
+  initialization, the highest level supported by the CPU is detected by
+  CPUID (__builtin_cpu_supports) and the kernels of the level are copied
+  into the kernel tables, so that a binary built once runs with the best
+  kernels on every host.
+
+  The environment variable CARRAY_SIMD_LEVEL limits the level selected
+  at the initialization (e.g. CARRAY_SIMD_LEVEL=avx2).
+*/
+
+#include "carray.h"
+#include <stdlib.h>
+
+int ca_simd_level = CA_SIMD_NONE;
+
+static int ca_simd_level_max = CA_SIMD_NONE;
+
+static const char *ca_simd_level_name[CA_SIMD_NLEVEL] = {
+  "none",
+  "sse4.2",
+  "avx2",
+  "avx512",
+};
+
+static int
+ca_simd_detect ()
+{
+#ifdef HAVE_CA_SIMD_DISPATCH
+  __builtin_cpu_init();
+  if ( __builtin_cpu_supports("avx512f") &&
+       __builtin_cpu_supports("avx512bw") &&
+       __builtin_cpu_supports("avx512dq") &&
+       __builtin_cpu_supports("avx512vl") ) {
+    return CA_SIMD_AVX512;
+  }
+  if ( __builtin_cpu_supports("avx2") ) {
+    return CA_SIMD_AVX2;
+  }
+  if ( __builtin_cpu_supports("sse4.2") ) {
+    return CA_SIMD_SSE42;
+  }
+#endif
+  return CA_SIMD_NONE;
+}
+
+static void
+ca_simd_select (int level)
+{
+  ca_math_simd_setup(level);
+  ca_cast_simd_setup(level);
+  ca_simd_level = level;
+}
+
+static int
+ca_simd_level_from_name (const char *name)
+{
+  int level;
+  for (level=0; level<CA_SIMD_NLEVEL; level++) {
+    if ( ! strcmp(name, ca_simd_level_name[level]) ) {
+      return level;
+    }
+  }
+  return -1;
+}
+
+/* @overload simd_level
+
+Returns the name of the ISA level of the kernels currently used for the
+operators, math functions and casts ("none", "sse4.2", "avx2" or "avx512").
+"none" means the kernels built with the default compiler options.
+*/
+
+static VALUE
+rb_ca_s_simd_level (VALUE klass)
+{
+  return rb_str_new2(ca_simd_level_name[ca_simd_level]);
+}
+
+/* @overload simd_levels
+
+Returns the names of the ISA levels supported by the CPU.
+*/
+
+static VALUE
+rb_ca_s_simd_levels (VALUE klass)
+{
+  volatile VALUE list = rb_ary_new();
+  int level;
+  for (level=0; level<=ca_simd_level_max; level++) {
+    rb_ary_push(list, rb_str_new2(ca_simd_level_name[level]));
+  }
+  return list;
+}
+
+/* @overload simd_level= (name)
+
+Switches the ISA level of the kernels. The level should be one of
+CArray.simd_levels.
+*/
+
+static VALUE
+rb_ca_s_set_simd_level (VALUE klass, VALUE rname)
+{
+  volatile VALUE rstr;
+  int level;
+  if ( SYMBOL_P(rname) ) {
+    rstr = rb_sym2str(rname);
+  }
+  else {
+    rstr = rname;
+  }
+  level = ca_simd_level_from_name(StringValueCStr(rstr));
+  if ( level < 0 ) {
+    rb_raise(rb_eArgError, "unknown simd level '%s'", StringValueCStr(rstr));
+  }
+  if ( level > ca_simd_level_max ) {
+    rb_raise(rb_eArgError, "simd level '%s' is not supported by this CPU",
+             StringValueCStr(rstr));
+  }
+  ca_simd_select(level);
+  return rname;
+}
+
+void
+Init_carray_simd ()
+{
+  const char *env = getenv("CARRAY_SIMD_LEVEL");
+  int level;
+
+  ca_simd_level_max = ca_simd_detect();
+
+  level = ca_simd_level_max;
+  if ( env ) {
+    int limit = ca_simd_level_from_name(env);
+    if ( limit >= 0 && limit < level ) {
+      level = limit;
+    }
+  }
+  ca_simd_select(level);
+
+  rb_define_singleton_method(rb_cCArray, "simd_level",
+                             rb_ca_s_simd_level, 0);
+  rb_define_singleton_method(rb_cCArray, "simd_level=",
+                             rb_ca_s_set_simd_level, 1);
+  rb_define_singleton_method(rb_cCArray, "simd_levels",
+                             rb_ca_s_simd_levels, 0);
+}
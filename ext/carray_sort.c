@@ -0,0 +1,782 @@
+/* ---------------------------------------------------------------------------
+
+  carray_sort.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  Type-specialized sort engine used by CArray#sort!, #sort and #sort_addr.
+
+  ca_sort_values() sorts the elements in place, and ca_sort_index() sorts
+  the list of addresses by the elements at the addresses (stable). The
+  integer and float types (up to 64 bits) are sorted by LSD radix sort
+  on the unsigned keys mapped from the elements in order. The bytes which
+  are same for all keys are skipped. NaN is placed after all numbers as
+  in the comparison functions of qsort in carray_order.c. The small arrays
+  and float128 are sorted by introsort with the inlined comparison.
+*/
+
+#include "carray.h"
+#include <math.h>
+
+/* the arrays smaller than this are sorted by introsort or insertion sort */
+
+#define CA_RADIX_THRESHOLD 256
+
+/* insertion sort is used for the ranges smaller than this in introsort */
+
+#define CA_INTRO_INSERTION 16
+
+#define lt_c(x, y)    ( (x) < (y) )
+#define lt_nan(x, y)  ( (x) < (y) || ( isnan(y) && ! isnan(x) ) )
+
+/* ----------------------------------------------------------------- */
+/*  introsort                                                        */
+/* ----------------------------------------------------------------- */
+
+#define proc_introsort(type, lt)                                        \
+static void                                                             \
+ca_heapsort_##type (type *a, ca_size_t n)                               \
+{                                                                       \
+  ca_size_t i, j, k;                                                    \
+  type t;                                                               \
+  for (i=n/2; i-- > 0; ) {                                              \
+    for (j=i; (k=2*j+1) < n; j=k) {                                     \
+      if ( k+1 < n && lt(a[k], a[k+1]) ) {                              \
+        k++;                                                            \
+      }                                                                 \
+      if ( ! lt(a[j], a[k]) ) {                                         \
+        break;                                                          \
+      }                                                                 \
+      t = a[j]; a[j] = a[k]; a[k] = t;                                  \
+    }                                                                   \
+  }                                                                     \
+  for (i=n-1; i>0; i--) {                                               \
+    t = a[0]; a[0] = a[i]; a[i] = t;                                    \
+    for (j=0; (k=2*j+1) < i; j=k) {                                     \
+      if ( k+1 < i && lt(a[k], a[k+1]) ) {                              \
+        k++;                                                            \
+      }                                                                 \
+      if ( ! lt(a[j], a[k]) ) {                                         \
+        break;                                                          \
+      }                                                                 \
+      t = a[j]; a[j] = a[k]; a[k] = t;                                  \
+    }                                                                   \
+  }                                                                     \
+}                                                                       \
+                                                                        \
+static void                                                             \
+ca_introsort_loop_##type (type *a, ca_size_t lo, ca_size_t hi,          \
+                          int depth)                                    \
+{                                                                       \
+  ca_size_t i, j, mid;                                                  \
+  type t, pivot;                                                        \
+  while ( hi - lo > CA_INTRO_INSERTION ) {                              \
+    if ( depth-- == 0 ) {                                               \
+      ca_heapsort_##type(a + lo, hi - lo + 1);                          \
+      return;                                                           \
+    }                                                                   \
+    mid = lo + (hi - lo)/2;                                             \
+    if ( lt(a[mid], a[lo]) ) { t = a[mid]; a[mid] = a[lo]; a[lo] = t; } \
+    if ( lt(a[hi], a[lo]) )  { t = a[hi];  a[hi]  = a[lo]; a[lo] = t; } \
+    if ( lt(a[hi], a[mid]) ) { t = a[hi];  a[hi] = a[mid]; a[mid] = t; }\
+    pivot = a[mid];                                                     \
+    i = lo;                                                             \
+    j = hi;                                                             \
+    while ( i <= j ) {                                                  \
+      while ( lt(a[i], pivot) ) {                                       \
+        i++;                                                            \
+      }                                                                 \
+      while ( lt(pivot, a[j]) ) {                                       \
+        j--;                                                            \
+      }                                                                 \
+      if ( i <= j ) {                                                   \
+        t = a[i]; a[i] = a[j]; a[j] = t;                                \
+        i++;                                                            \
+        j--;                                                            \
+      }                                                                 \
+    }                                                                   \
+    /* recurses into the smaller part */                                \
+    if ( j - lo < hi - i ) {                                            \
+      if ( lo < j ) {                                                   \
+        ca_introsort_loop_##type(a, lo, j, depth);                      \
+      }                                                                 \
+      lo = i;                                                           \
+    }                                                                   \
+    else {                                                              \
+      if ( i < hi ) {                                                   \
+        ca_introsort_loop_##type(a, i, hi, depth);                      \
+      }                                                                 \
+      hi = j;                                                           \
+    }                                                                   \
+  }                                                                     \
+}                                                                       \
+                                                                        \
+static void                                                             \
+ca_introsort_##type (type *a, ca_size_t n)                              \
+{                                                                       \
+  ca_size_t i, j, m;                                                    \
+  int depth = 0;                                                        \
+  type t;                                                               \
+  if ( n < 2 ) {                                                        \
+    return;                                                             \
+  }                                                                     \
+  for (m=n; m > 1; m >>= 1) {                                           \
+    depth += 2;                                                         \
+  }                                                                     \
+  ca_introsort_loop_##type(a, 0, n-1, depth);                           \
+  /* finishes the short ranges left unsorted */                         \
+  for (i=1; i<n; i++) {                                                 \
+    t = a[i];                                                           \
+    for (j=i; j>0 && lt(t, a[j-1]); j--) {                              \
+      a[j] = a[j-1];                                                    \
+    }                                                                   \
+    a[j] = t;                                                           \
+  }                                                                     \
+}
+
+proc_introsort(boolean8_t, lt_c)
+proc_introsort(int8_t,     lt_c)
+proc_introsort(uint8_t,    lt_c)
+proc_introsort(int16_t,    lt_c)
+proc_introsort(uint16_t,   lt_c)
+proc_introsort(int32_t,    lt_c)
+proc_introsort(uint32_t,   lt_c)
+proc_introsort(int64_t,    lt_c)
+proc_introsort(uint64_t,   lt_c)
+proc_introsort(float32_t,  lt_nan)
+proc_introsort(float64_t,  lt_nan)
+proc_introsort(float128_t, lt_nan)
+
+/* ----------------------------------------------------------------- */
+/*  LSD radix sort of unsigned keys                                  */
+/* ----------------------------------------------------------------- */
+
+/*
+  ca_radix_sort_<utype>() sorts key[0...n] (with idx[0...n] if idx is not
+  NULL) using the buffers tkey and tidx of the same size. The keys are
+  sorted by the digits of CA_RADIX_BITS bits (3 passes for 32 bits keys,
+  6 passes for 64 bits keys), and the histograms of all digits are counted
+  in one pass. The result is placed in key (and idx). Returns 0 if the 
+  memory is not allocated. (The functions below do not call Ruby API, 
+  since they run on the worker pool without GVL.)
+*/
+
+#define CA_RADIX_BITS   11
+#define CA_RADIX_SIZE   (1 << CA_RADIX_BITS)
+#define CA_RADIX_MASK   (CA_RADIX_SIZE - 1)
+
+#define proc_radix_sort(utype)                                          \
+static int                                                              \
+ca_radix_sort_##utype (utype *key, utype *tkey,                         \
+                       ca_size_t *idx, ca_size_t *tidx, ca_size_t n)    \
+{                                                                       \
+  ca_size_t (*count)[CA_RADIX_SIZE];                                    \
+  utype *src = key, *dst = tkey, *tk;                                   \
+  ca_size_t *isrc = idx, *idst = tidx, *ti;                             \
+  ca_size_t i, pos, c;                                                  \
+  int ndigit = (int) (8*sizeof(utype) + CA_RADIX_BITS - 1)/CA_RADIX_BITS; \
+  int b, d, shift;                                                      \
+  if ( n <= 0 ) {                                                       \
+    return 1;                                                           \
+  }                                                                     \
+  count = (ca_size_t (*)[CA_RADIX_SIZE]) calloc(ndigit, sizeof(*count)); \
+  if ( ! count ) {                                                      \
+    return 0;                                                           \
+  }                                                                     \
+  for (i=0; i<n; i++) {                                                 \
+    utype k = key[i];                                                   \
+    for (b=0; b<ndigit; b++) {                                          \
+      count[b][(k >> (CA_RADIX_BITS*b)) & CA_RADIX_MASK]++;             \
+    }                                                                   \
+  }                                                                     \
+  for (b=0; b<ndigit; b++) {                                            \
+    shift = CA_RADIX_BITS*b;                                            \
+    /* all keys have the same digit */                                  \
+    if ( count[b][(src[0] >> shift) & CA_RADIX_MASK] == n ) {           \
+      continue;                                                         \
+    }                                                                   \
+    for (d=0, pos=0; d<CA_RADIX_SIZE; d++) {                            \
+      c = count[b][d];                                                  \
+      count[b][d] = pos;                                                \
+      pos += c;                                                         \
+    }                                                                   \
+    if ( isrc ) {                                                       \
+      for (i=0; i<n; i++) {                                             \
+        pos = count[b][(src[i] >> shift) & CA_RADIX_MASK]++;            \
+        dst[pos]  = src[i];                                             \
+        idst[pos] = isrc[i];                                            \
+      }                                                                 \
+      ti = isrc; isrc = idst; idst = ti;                                \
+    }                                                                   \
+    else {                                                              \
+      for (i=0; i<n; i++) {                                             \
+        dst[count[b][(src[i] >> shift) & CA_RADIX_MASK]++] = src[i];    \
+      }                                                                 \
+    }                                                                   \
+    tk = src; src = dst; dst = tk;                                      \
+  }                                                                     \
+  if ( src != key ) {                                                   \
+    memcpy(key, src, sizeof(utype)*n);                                  \
+    if ( isrc ) {                                                       \
+      memcpy(idx, isrc, sizeof(ca_size_t)*n);                           \
+    }                                                                   \
+  }                                                                     \
+  free(count);                                                          \
+  return 1;                                                             \
+}
+
+proc_radix_sort(uint8_t)
+proc_radix_sort(uint16_t)
+proc_radix_sort(uint32_t)
+proc_radix_sort(uint64_t)
+
+/* ----------------------------------------------------------------- */
+/*  mapping of elements to the unsigned keys in order                */
+/* ----------------------------------------------------------------- */
+
+#define key_uint(utype, x)  ((utype)(x))
+#define key_int(utype, x)   ((utype)(x) ^ ((utype)1 << (8*sizeof(utype)-1)))
+#define unkey_uint(utype, k)  (k)
+#define unkey_int(utype, k)   ((k) ^ ((utype)1 << (8*sizeof(utype)-1)))
+
+/* the negative floats are reversed, the positive floats are shifted
+   above them */
+
+#define key_float(utype, u)                                             \
+  ( ( (u) >> (8*sizeof(utype)-1) ) ? ~(u)                               \
+                               : (u) | ((utype)1 << (8*sizeof(utype)-1)) )
+#define unkey_float(utype, k)                                           \
+  ( ( (k) >> (8*sizeof(utype)-1) ) ? (k) ^ ((utype)1 << (8*sizeof(utype)-1)) \
+                               : ~(k) )
+
+/* int and uint types, the key is made by the cast */
+
+#define proc_sort_int(type, utype, kind)                                \
+static int                                                              \
+ca_sort_values_##type (type *a, ca_size_t n)                            \
+{                                                                       \
+  utype *k = (utype *) a, *tmp;                                         \
+  ca_size_t i;                                                          \
+  int status;                                                           \
+  if ( n < CA_RADIX_THRESHOLD ) {                                       \
+    ca_introsort_##type(a, n);                                          \
+    return 1;                                                           \
+  }                                                                     \
+  tmp = malloc(sizeof(utype)*n);                                        \
+  if ( ! tmp ) {                                                        \
+    return 0;                                                           \
+  }                                                                     \
+  for (i=0; i<n; i++) {                                                 \
+    k[i] = key_##kind(utype, a[i]);                                     \
+  }                                                                     \
+  status = ca_radix_sort_##utype(k, tmp, NULL, NULL, n);                \
+  for (i=0; i<n; i++) {                                                 \
+    k[i] = unkey_##kind(utype, k[i]);                                   \
+  }                                                                     \
+  free(tmp);                                                            \
+  return status;                                                        \
+}                                                                       \
+                                                                        \
+static int                                                              \
+ca_sort_index_##type (type *a, ca_size_t *idx, ca_size_t n)             \
+{                                                                       \
+  utype *k, *tmp;                                                       \
+  ca_size_t *tidx;                                                      \
+  ca_size_t i;                                                          \
+  int status = 0;                                                       \
+  k    = malloc(sizeof(utype)*n);                                       \
+  tmp  = malloc(sizeof(utype)*n);                                       \
+  tidx = malloc(sizeof(ca_size_t)*n);                                   \
+  if ( k && tmp && tidx ) {                                             \
+    for (i=0; i<n; i++) {                                               \
+      k[i] = key_##kind(utype, a[idx[i]]);                              \
+    }                                                                   \
+    status = ca_radix_sort_##utype(k, tmp, idx, tidx, n);               \
+  }                                                                     \
+  free(k);                                                              \
+  free(tmp);                                                            \
+  free(tidx);                                                           \
+  return status;                                                        \
+}
+
+proc_sort_int(boolean8_t, uint8_t,  uint)
+proc_sort_int(int8_t,     uint8_t,  int)
+proc_sort_int(uint8_t,    uint8_t,  uint)
+proc_sort_int(int16_t,    uint16_t, int)
+proc_sort_int(uint16_t,   uint16_t, uint)
+proc_sort_int(int32_t,    uint32_t, int)
+proc_sort_int(uint32_t,   uint32_t, uint)
+proc_sort_int(int64_t,    uint64_t, int)
+proc_sort_int(uint64_t,   uint64_t, uint)
+
+/* float types, NaN is moved to the end (keeping the order) before the
+   radix sort of the other elements */
+
+#define proc_sort_float(type, utype)                                    \
+static int                                                              \
+ca_sort_values_##type (type *a, ca_size_t n)                            \
+{                                                                       \
+  utype *k = (utype *) a, *tmp, u;                                      \
+  type *nan;                                                            \
+  ca_size_t i, m, c;                                                    \
+  int status;                                                           \
+  if ( n < CA_RADIX_THRESHOLD ) {                                       \
+    ca_introsort_##type(a, n);                                          \
+    return 1;                                                           \
+  }                                                                     \
+  tmp = malloc(sizeof(utype)*n);                                        \
+  if ( ! tmp ) {                                                        \
+    return 0;                                                           \
+  }                                                                     \
+  nan = (type *) tmp;                                                   \
+  for (i=0, m=0, c=0; i<n; i++) {                                       \
+    if ( isnan(a[i]) ) {                                                \
+      nan[c++] = a[i];                                                  \
+    }                                                                   \
+    else {                                                              \
+      a[m++] = a[i];                                                    \
+    }                                                                   \
+  }                                                                     \
+  memcpy(a + m, nan, sizeof(type)*c);                                   \
+  for (i=0; i<m; i++) {                                                 \
+    memcpy(&u, &a[i], sizeof(utype));                                   \
+    k[i] = key_float(utype, u);                                         \
+  }                                                                     \
+  status = ca_radix_sort_##utype(k, tmp, NULL, NULL, m);                \
+  for (i=0; i<m; i++) {                                                 \
+    u = unkey_float(utype, k[i]);                                       \
+    memcpy(&a[i], &u, sizeof(utype));                                   \
+  }                                                                     \
+  free(tmp);                                                            \
+  return status;                                                        \
+}                                                                       \
+                                                                        \
+static int                                                              \
+ca_sort_index_##type (type *a, ca_size_t *idx, ca_size_t n)             \
+{                                                                       \
+  utype *k, *tmp, u;                                                    \
+  ca_size_t *tidx;                                                      \
+  ca_size_t i, m, c;                                                    \
+  int status = 0;                                                       \
+  k    = malloc(sizeof(utype)*n);                                       \
+  tmp  = malloc(sizeof(utype)*n);                                       \
+  tidx = malloc(sizeof(ca_size_t)*n);                                   \
+  if ( k && tmp && tidx ) {                                             \
+    for (i=0, m=0, c=0; i<n; i++) {                                     \
+      if ( isnan(a[idx[i]]) ) {                                         \
+        tidx[c++] = idx[i];                                             \
+      }                                                                 \
+      else {                                                            \
+        /* -0.0 is same as 0.0 for the stable sort */                   \
+        if ( a[idx[i]] == 0 ) {                                         \
+          u = 0;                                                        \
+        }                                                               \
+        else {                                                          \
+          memcpy(&u, &a[idx[i]], sizeof(utype));                        \
+        }                                                               \
+        k[m]     = key_float(utype, u);                                 \
+        idx[m++] = idx[i];                                              \
+      }                                                                 \
+    }                                                                   \
+    memcpy(idx + m, tidx, sizeof(ca_size_t)*c);                         \
+    status = ca_radix_sort_##utype(k, tmp, idx, tidx, m);               \
+  }                                                                     \
+  free(k);                                                              \
+  free(tmp);                                                            \
+  free(tidx);                                                           \
+  return status;                                                        \
+}
+
+proc_sort_float(float32_t, uint32_t)
+proc_sort_float(float64_t, uint64_t)
+
+static int
+ca_sort_values_float128_t (float128_t *a, ca_size_t n)
+{
+  ca_introsort_float128_t(a, n);
+  return 1;
+}
+
+/* ----------------------------------------------------------------- */
+/*  stable merge of two sorted runs                                  */
+/* ----------------------------------------------------------------- */
+
+/*
+  ca_merge_<name>() writes the output positions [s, e) of the merge of 
+  the runs src[ps...pm] and src[pm...pe] into dst[s...e]. The positions
+  in the runs are found by the binary search on the merge path (co-rank), 
+  so that the output of one merge is divided among the threads. The 
+  element of the first run is taken first for the same values (stable).
+*/
+
+#define key_val(type, base, x)  (x)
+#define key_idx(type, base, x)  (((type *)(base))[x])
+
+#define proc_merge(name, etype, type, lt, key)                          \
+static ca_size_t                                                        \
+ca_merge_corank_##name (void *base, etype *A, ca_size_t na,             \
+                        etype *B, ca_size_t nb, ca_size_t d)            \
+{                                                                       \
+  ca_size_t lo = ( d > nb ) ? d - nb : 0;                               \
+  ca_size_t hi = ( d < na ) ? d : na;                                   \
+  ca_size_t i;                                                          \
+  while ( lo < hi ) {                                                   \
+    i = lo + (hi - lo)/2;                                               \
+    /* A[i] is taken before B[d-i-1] */                                 \
+    if ( ! lt(key(type, base, B[d-i-1]), key(type, base, A[i])) ) {     \
+      lo = i + 1;                                                       \
+    }                                                                   \
+    else {                                                              \
+      hi = i;                                                           \
+    }                                                                   \
+  }                                                                     \
+  return lo;                                                            \
+}                                                                       \
+                                                                        \
+static void                                                             \
+ca_merge_##name (void *base, void *vsrc, void *vdst,                    \
+                 ca_size_t ps, ca_size_t pm, ca_size_t pe,              \
+                 ca_size_t s, ca_size_t e)                              \
+{                                                                       \
+  etype *A = (etype *) vsrc + ps, *B = (etype *) vsrc + pm;             \
+  etype *C = (etype *) vdst;                                            \
+  ca_size_t na = pm - ps, nb = pe - pm;                                 \
+  ca_size_t i, j, k, i1, j1;                                            \
+  i  = ca_merge_corank_##name(base, A, na, B, nb, s - ps);              \
+  j  = s - ps - i;                                                      \
+  i1 = ca_merge_corank_##name(base, A, na, B, nb, e - ps);              \
+  j1 = e - ps - i1;                                                     \
+  for (k=s; i<i1 && j<j1; k++) {                                        \
+    if ( lt(key(type, base, B[j]), key(type, base, A[i])) ) {           \
+      C[k] = B[j++];                                                    \
+    }                                                                   \
+    else {                                                              \
+      C[k] = A[i++];                                                    \
+    }                                                                   \
+  }                                                                     \
+  for (; i<i1; k++) {                                                   \
+    C[k] = A[i++];                                                      \
+  }                                                                     \
+  for (; j<j1; k++) {                                                   \
+    C[k] = B[j++];                                                      \
+  }                                                                     \
+}
+
+proc_merge(values_boolean8_t, boolean8_t, boolean8_t, lt_c,   key_val)
+proc_merge(values_int8_t,     int8_t,     int8_t,     lt_c,   key_val)
+proc_merge(values_uint8_t,    uint8_t,    uint8_t,    lt_c,   key_val)
+proc_merge(values_int16_t,    int16_t,    int16_t,    lt_c,   key_val)
+proc_merge(values_uint16_t,   uint16_t,   uint16_t,   lt_c,   key_val)
+proc_merge(values_int32_t,    int32_t,    int32_t,    lt_c,   key_val)
+proc_merge(values_uint32_t,   uint32_t,   uint32_t,   lt_c,   key_val)
+proc_merge(values_int64_t,    int64_t,    int64_t,    lt_c,   key_val)
+proc_merge(values_uint64_t,   uint64_t,   uint64_t,   lt_c,   key_val)
+proc_merge(values_float32_t,  float32_t,  float32_t,  lt_nan, key_val)
+proc_merge(values_float64_t,  float64_t,  float64_t,  lt_nan, key_val)
+proc_merge(values_float128_t, float128_t, float128_t, lt_nan, key_val)
+
+proc_merge(index_boolean8_t, ca_size_t, boolean8_t, lt_c,   key_idx)
+proc_merge(index_int8_t,     ca_size_t, int8_t,     lt_c,   key_idx)
+proc_merge(index_uint8_t,    ca_size_t, uint8_t,    lt_c,   key_idx)
+proc_merge(index_int16_t,    ca_size_t, int16_t,    lt_c,   key_idx)
+proc_merge(index_uint16_t,   ca_size_t, uint16_t,   lt_c,   key_idx)
+proc_merge(index_int32_t,    ca_size_t, int32_t,    lt_c,   key_idx)
+proc_merge(index_uint32_t,   ca_size_t, uint32_t,   lt_c,   key_idx)
+proc_merge(index_int64_t,    ca_size_t, int64_t,    lt_c,   key_idx)
+proc_merge(index_uint64_t,   ca_size_t, uint64_t,   lt_c,   key_idx)
+proc_merge(index_float32_t,  ca_size_t, float32_t,  lt_nan, key_idx)
+proc_merge(index_float64_t,  ca_size_t, float64_t,  lt_nan, key_idx)
+
+/* ----------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------- */
+
+typedef int  (*ca_sort_values_func_t)(void *a, ca_size_t n);
+typedef int  (*ca_sort_index_func_t)(void *a, ca_size_t *idx, ca_size_t n);
+typedef void (*ca_merge_func_t)(void *base, void *src, void *dst,
+                                ca_size_t ps, ca_size_t pm, ca_size_t pe,
+                                ca_size_t s, ca_size_t e);
+
+static ca_sort_values_func_t
+ca_sort_values_func[CA_NTYPE] = {
+  NULL,
+  (ca_sort_values_func_t) ca_sort_values_boolean8_t,
+  (ca_sort_values_func_t) ca_sort_values_int8_t,
+  (ca_sort_values_func_t) ca_sort_values_uint8_t,
+  (ca_sort_values_func_t) ca_sort_values_int16_t,
+  (ca_sort_values_func_t) ca_sort_values_uint16_t,
+  (ca_sort_values_func_t) ca_sort_values_int32_t,
+  (ca_sort_values_func_t) ca_sort_values_uint32_t,
+  (ca_sort_values_func_t) ca_sort_values_int64_t,
+  (ca_sort_values_func_t) ca_sort_values_uint64_t,
+  (ca_sort_values_func_t) ca_sort_values_float32_t,
+  (ca_sort_values_func_t) ca_sort_values_float64_t,
+  (ca_sort_values_func_t) ca_sort_values_float128_t,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static ca_sort_index_func_t
+ca_sort_index_func[CA_NTYPE] = {
+  NULL,
+  (ca_sort_index_func_t) ca_sort_index_boolean8_t,
+  (ca_sort_index_func_t) ca_sort_index_int8_t,
+  (ca_sort_index_func_t) ca_sort_index_uint8_t,
+  (ca_sort_index_func_t) ca_sort_index_int16_t,
+  (ca_sort_index_func_t) ca_sort_index_uint16_t,
+  (ca_sort_index_func_t) ca_sort_index_int32_t,
+  (ca_sort_index_func_t) ca_sort_index_uint32_t,
+  (ca_sort_index_func_t) ca_sort_index_int64_t,
+  (ca_sort_index_func_t) ca_sort_index_uint64_t,
+  (ca_sort_index_func_t) ca_sort_index_float32_t,
+  (ca_sort_index_func_t) ca_sort_index_float64_t,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static ca_merge_func_t
+ca_merge_values_func[CA_NTYPE] = {
+  NULL,
+  (ca_merge_func_t) ca_merge_values_boolean8_t,
+  (ca_merge_func_t) ca_merge_values_int8_t,
+  (ca_merge_func_t) ca_merge_values_uint8_t,
+  (ca_merge_func_t) ca_merge_values_int16_t,
+  (ca_merge_func_t) ca_merge_values_uint16_t,
+  (ca_merge_func_t) ca_merge_values_int32_t,
+  (ca_merge_func_t) ca_merge_values_uint32_t,
+  (ca_merge_func_t) ca_merge_values_int64_t,
+  (ca_merge_func_t) ca_merge_values_uint64_t,
+  (ca_merge_func_t) ca_merge_values_float32_t,
+  (ca_merge_func_t) ca_merge_values_float64_t,
+  (ca_merge_func_t) ca_merge_values_float128_t,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+static ca_merge_func_t
+ca_merge_index_func[CA_NTYPE] = {
+  NULL,
+  (ca_merge_func_t) ca_merge_index_boolean8_t,
+  (ca_merge_func_t) ca_merge_index_int8_t,
+  (ca_merge_func_t) ca_merge_index_uint8_t,
+  (ca_merge_func_t) ca_merge_index_int16_t,
+  (ca_merge_func_t) ca_merge_index_uint16_t,
+  (ca_merge_func_t) ca_merge_index_int32_t,
+  (ca_merge_func_t) ca_merge_index_uint32_t,
+  (ca_merge_func_t) ca_merge_index_int64_t,
+  (ca_merge_func_t) ca_merge_index_uint64_t,
+  (ca_merge_func_t) ca_merge_index_float32_t,
+  (ca_merge_func_t) ca_merge_index_float64_t,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+};
+
+/* ----------------------------------------------------------------- */
+/*  parallel sort                                                    */
+/* ----------------------------------------------------------------- */
+
+/*
+  The elements (or the addresses) are divided into the chunks of 
+  ca_parallel_reduce(), and the chunks are sorted on the worker pool 
+  without GVL. Then the sorted runs are merged pairwise in log2(nchunk) 
+  rounds, where each round is divided among the threads by the output 
+  positions (ca_parallel_for). The result is same as the serial sort
+  (the merge is stable).
+*/
+
+typedef struct {
+  int8_t     data_type;
+  char      *ptr;                /* elements */
+  ca_size_t *idx;                /* addresses (NULL for ca_sort_values) */
+  ca_size_t  bytes;              /* size of the sorted items */
+  volatile int nomem;
+  /* merge */
+  ca_merge_func_t merge;
+  char      *src, *dst;
+  ca_size_t  bnd[CA_PARALLEL_THREADS_MAX+1];   /* boundaries of the runs */
+  int        nrun;
+} ca_sort_job_t;
+
+static void
+ca_sort_chunk (int chunk, ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_sort_job_t *job = (ca_sort_job_t *) arg;
+  int status;
+  job->bnd[chunk]   = start;
+  job->bnd[chunk+1] = end;
+  if ( job->idx ) {
+    status = ( end - start > 1 ) ? 
+               ca_sort_index_func[job->data_type](job->ptr, job->idx + start, 
+                                                  end - start) : 1;
+  }
+  else {
+    status = ca_sort_values_func[job->data_type](job->ptr + start*job->bytes,
+                                                 end - start);
+  }
+  if ( ! status ) {
+    job->nomem = 1;
+  }
+}
+
+/* merges the output positions [start, end) of the current round */
+
+static void
+ca_sort_merge_range (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_sort_job_t *job = (ca_sort_job_t *) arg;
+  ca_size_t ps, pm, pe, s, e;
+  int r;
+  for (r=0; r<job->nrun; r+=2) {
+    ps = job->bnd[r];
+    pe = ( r+2 <= job->nrun ) ? job->bnd[r+2] : job->bnd[r+1];
+    if ( pe <= start || ps >= end ) {
+      continue;
+    }
+    s = ( start > ps ) ? start : ps;
+    e = ( end < pe ) ? end : pe;
+    if ( r+1 == job->nrun ) {      /* the last run without pair */
+      memcpy(job->dst + s*job->bytes, job->src + s*job->bytes, 
+             (e - s)*job->bytes);
+    }
+    else {
+      pm = job->bnd[r+1];
+      job->merge(job->ptr, job->src, job->dst, ps, pm, pe, s, e);
+    }
+  }
+}
+
+static void
+ca_sort_parallel (ca_sort_job_t *job, char *data, ca_size_t n)
+{
+  char *tmp, *t;
+  int r, nrun;
+
+  job->nomem = 0;
+  job->nrun  = ca_parallel_reduce(n, 1, ca_sort_chunk, job);
+  if ( job->nomem ) {
+    rb_raise(rb_eNoMemError, "failed to allocate memory for sort");
+  }
+  if ( job->nrun <= 1 ) {
+    return;
+  }
+
+  tmp = malloc_with_check(n * job->bytes);
+  job->src = data;
+  job->dst = tmp;
+  while ( job->nrun > 1 ) {
+    ca_parallel_for(n, 1, ca_sort_merge_range, job);
+    nrun = job->nrun;
+    for (r=0; r<nrun; r+=2) {
+      job->bnd[r/2] = job->bnd[r];
+    }
+    job->nrun = (nrun + 1)/2;
+    job->bnd[job->nrun] = n;
+    t = job->src; job->src = job->dst; job->dst = t;
+  }
+  if ( job->src != data ) {
+    memcpy(data, job->src, n * job->bytes);
+  }
+  free(tmp);
+}
+
+/* sorts ptr[0...n] of the data type in place, 
+   returns 0 if the data type is not supported */
+
+int
+ca_sort_values (int8_t data_type, void *ptr, ca_size_t n)
+{
+  ca_sort_job_t job;
+  if ( ! ca_sort_values_func[data_type] ) {
+    return 0;
+  }
+  if ( n > 1 ) {
+    job.data_type = data_type;
+    job.ptr       = (char *) ptr;
+    job.idx       = NULL;
+    job.bytes     = ca_sizeof[data_type];
+    job.merge     = ca_merge_values_func[data_type];
+    ca_sort_parallel(&job, (char *) ptr, n);
+  }
+  return 1;
+}
+
+/* reorders the addresses idx[0...n] by the elements ptr[idx[i]] in
+   ascending order (stable), returns 0 if the data type is not supported */
+
+int
+ca_sort_index (int8_t data_type, void *ptr, ca_size_t *idx, ca_size_t n)
+{
+  ca_sort_job_t job;
+  if ( ! ca_sort_index_func[data_type] ) {
+    return 0;
+  }
+  if ( n > 1 ) {
+    job.data_type = data_type;
+    job.ptr       = (char *) ptr;
+    job.idx       = idx;
+    job.bytes     = sizeof(ca_size_t);
+    job.merge     = ca_merge_index_func[data_type];
+    ca_sort_parallel(&job, (char *) idx, n);
+  }
+  return 1;
+}
+
+/* reorders the addresses idx[0...n] by the byte strings of the length 
+   bytes at ptr + idx[i]*bytes in memcmp order (stable). LSD radix sort 
+   on the bytes from the last one, the bytes same for all are skipped. */
+
+void
+ca_sort_index_fixlen (void *ptr, ca_size_t bytes, ca_size_t *idx, ca_size_t n)
+{
+  unsigned char *p = (unsigned char *) ptr;
+  unsigned char *kb;
+  ca_size_t count[256];
+  ca_size_t *src = idx, *dst, *tidx, *t;
+  ca_size_t i, b, pos, c;
+  int d;
+  if ( n < 2 ) {
+    return;
+  }
+  tidx = malloc_with_check(sizeof(ca_size_t)*n);
+  kb   = malloc_with_check(n);
+  dst  = tidx;
+  for (b=bytes-1; b>=0; b--) {
+    memset(count, 0, sizeof(count));
+    for (i=0; i<n; i++) {
+      kb[i] = p[src[i]*bytes + b];
+      count[kb[i]]++;
+    }
+    if ( count[kb[0]] == n ) {
+      continue;
+    }
+    for (d=0, pos=0; d<256; d++) {
+      c = count[d];
+      count[d] = pos;
+      pos += c;
+    }
+    for (i=0; i<n; i++) {
+      dst[count[kb[i]]++] = src[i];
+    }
+    t = src; src = dst; dst = t;
+  }
+  if ( src != idx ) {
+    memcpy(idx, src, sizeof(ca_size_t)*n);
+  }
+  free(tidx);
+  free(kb);
+}
@@ -97,79 +97,119 @@ ca_qsort_cmp[CA_NTYPE] = {
 
 /* ----------------------------------------------------------------- */
 
-struct cmp_base {
-  int      n;
-  CArray **ca;
-};
+/* element of the stable sort by the comparison function, 
+   the position in the current order is used for the same values */
 
 struct cmp_data {
-  ca_size_t  i;
-  struct cmp_base *base;
+  ca_size_t  pos;
+  ca_size_t  addr;
+  CArray    *ca;
 };
 
 static int
 qcmp_func (struct cmp_data *a, struct cmp_data *b)
 {
-  struct cmp_base *base = a->base;
-  int n = base->n;
-  CArray **ca = base->ca;
-  ca_size_t ia = a->i;
-  ca_size_t ib = b->i;
+  CArray *ca = a->ca;
   int result;
-  int i;
+  result = ca_qsort_cmp[ca->data_type](ca->ptr + a->addr*ca->bytes, 
+                                       ca->ptr + b->addr*ca->bytes);
+  if ( result ) {
+    return result;
+  }
+  return ( a->pos > b->pos ) ? 1 : -1; /* for stable sort */
+}
+
+/* reorders q[0...n] by the elements of ca (stable) */
+
+static void
+ca_sort_addr_pass (CArray *ca, ca_size_t *q, ca_size_t n)
+{
+  struct cmp_data *data;
+  ca_size_t i;
+
+  if ( ca_sort_index(ca->data_type, ca->ptr, q, n) ) {
+    return;
+  }
+
+  if ( ca->data_type == CA_FIXLEN ) {
+    ca_sort_index_fixlen(ca->ptr, ca->bytes, q, n);
+    return;
+  }
+
+  data = malloc_with_check(sizeof(struct cmp_data)*(n+1));
   for (i=0; i<n; i++) {
-    int8_t data_type = ca[i]->data_type;
-    char  *ptr = ca[i]->ptr;
-    boolean8_t  *m = ( ca[i]->mask ) ? (boolean8_t *) ca[i]->mask->ptr : NULL;
-    ca_size_t bytes = ca[i]->bytes;
-    if ( ( ! m ) || 
-         ( ( ! m[ia] ) && ( ! m[ib] ) ) ) {
-      if ( data_type == CA_FIXLEN ) {
-        result = ca_qsort_cmp[CA_FIXLEN](ptr + ia*bytes, 
-                                         ptr + ib*bytes, bytes);
+    data[i].pos  = i;
+    data[i].addr = q[i];
+    data[i].ca   = ca;
+  }
+  qsort(data, n, sizeof(struct cmp_data),
+        (int (*)(const void*,const void*)) qcmp_func);
+  for (i=0; i<n; i++) {
+    q[i] = data[i].addr;
+  }
+  free(data);
+}
+
+/* sorts the addresses q[0...elements] by the arrays ca[0...n] in 
+   lexicographic order (ca[0] is the primary key). The stable sort by
+   each array is applied from the last array to the first, so the order 
+   by the later arrays is kept for the same values. The masked elements 
+   are placed after the valid elements in each pass. */
+
+static void
+ca_sort_addr_lex (int n, CArray **ca, ca_size_t *q)
+{
+  ca_size_t elements = ca[0]->elements;
+  ca_size_t *t = NULL;
+  boolean8_t *m;
+  ca_size_t i, nv, nm;
+  int j;
+  for (i=0; i<elements; i++) {
+    q[i] = i;
+  }
+  for (j=n-1; j>=0; j--) {
+    m  = ( ca[j]->mask ) ? (boolean8_t *) ca[j]->mask->ptr : NULL;
+    nv = elements;
+    if ( m ) {
+      if ( ! t ) {
+        t = malloc_with_check(sizeof(ca_size_t)*(elements+1));
       }
-      else {
-        result = ca_qsort_cmp[data_type](ptr + ia*bytes, 
-                                         ptr + ib*bytes);
+      for (i=0, nv=0, nm=0; i<elements; i++) {
+        if ( m[q[i]] ) {
+          t[nm++] = q[i];
+        }
+        else {
+          q[nv++] = q[i];
+        }
       }
+      memcpy(q + nv, t, sizeof(ca_size_t)*nm);
     }
-    else if ( ( ! m[ia] ) && ( m[ib] ) ) {
-      result = -1;
-    }
-    else if ( ( m[ia] ) && ( ! m[ib] ) ) {
-      result = 1;
-    }
-    else {
-      result = 0;
-    }
-    if ( result ) {
-      return result;
-    }
+    ca_sort_addr_pass(ca[j], q, nv);
   }
-  return ( ia > ib ) ? 1 : -1; /* for stable sort */
+  free(t);
 }
 
 /* @overload sort_addr (*args)
 
-(Sort) Returns index table for index sort
+(Sort) Returns index table for index sort (stable)
 
      idx = CA.sort_addr(a, b, c)  ### priority a > b > c
      a[idx]
      b[idx]
      c[idx]
+
+The integer and float arrays are sorted by radix sort (in parallel 
+for the large arrays), and the fixlen arrays by radix sort on the bytes 
+(memcmp order).
 */
 
 static VALUE
 rb_ca_s_sort_addr (int argc, VALUE *argv, VALUE self)
 {
   volatile VALUE out;
-  CArray *co;
-  struct cmp_base *base;
-  struct cmp_data *data;
+  CArray **ca, *co;
   ca_size_t elements;
-  ca_size_t *q;
   int j;
-  ca_size_t i;
   
   if ( argc <= 0 ) {
     rb_raise(rb_eArgError, "no arg given");
@@ -185,49 +225,41 @@ rb_ca_s_sort_addr (int argc, VALUE *argv, VALUE self)
     }
   }
 
-  base = malloc_with_check(sizeof(struct cmp_base));
-  base->n = argc;
-  base->ca = malloc_with_check(sizeof(CArray *)*base->n);
+  out = rb_ca_template_with_type(argv[0], INT2NUM(CA_SIZE), INT2NUM(0));
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
 
+  ca = ALLOCA_N(CArray *, argc);
   for (j=0; j<argc; j++) {
-    CArray *ca;
-    TypedData_Get_Struct(argv[j], CArray, &carray_data_type, ca);
-    base->ca[j] = ca;
-    ca_attach(ca);
+    TypedData_Get_Struct(argv[j], CArray, &carray_data_type, ca[j]);
+    ca_attach(ca[j]);
   }
 
-  data = malloc_with_check(sizeof(struct cmp_data)*elements);
-  for (i=0; i<elements; i++) {
-    data[i].i = i;
-    data[i].base = base;
+  ca_sort_addr_lex(argc, ca, (ca_size_t *) co->ptr);
+
+  for (j=0; j<argc; j++) {
+    ca_detach(ca[j]);
   }
 
-#ifdef HAVE_MERGESORT
-  mergesort(data, elements, sizeof(struct cmp_data), 
-            (int (*)(const void*,const void*)) qcmp_func);
-#else
-  qsort(data, elements, sizeof(struct cmp_data),
-            (int (*)(const void*,const void*)) qcmp_func);
-#endif
+  return out;
+}
 
-  out = rb_ca_template_with_type(argv[0], INT2NUM(CA_SIZE), INT2NUM(0));
-  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
-  q = (ca_size_t *) co->ptr;
-  
-  for (i=0; i<elements; i++) {
-    *q = data[i].i;
-    q++;
-  }
+/* @overload lexsort (*keys)
 
-  for (j=0; j<argc; j++) {
-    ca_detach(base->ca[j]);
-  }
+(Sort) Returns the addresses which sort the elements of the arrays 
+in lexicographic order of keys (keys[0] is the primary key) as a stable 
+sort. The keys can be any mix of the integer, float and fixlen arrays 
+(and the object arrays compared by <=>). The masked elements are placed 
+after the valid elements for each key. Same as CA.sort_addr(*keys).
 
-  free(data);
-  free(base->ca);  
-  free(base);        
+     idx = CArray.lexsort(name, age)
+     name[idx]
+     age[idx]
+*/
 
-  return out;
+static VALUE
+rb_ca_s_lexsort (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_s_sort_addr(argc, argv, self);
 }
 
 /* @overload sort_addr (*args)
@@ -250,5 +282,6 @@ void
 Init_carray_sort_addr ()
 {
   rb_define_singleton_method(rb_mCA, "sort_addr", rb_ca_s_sort_addr, -1);
+  rb_define_singleton_method(rb_cCArray, "lexsort", rb_ca_s_lexsort, -1);
   rb_define_method(rb_cCArray, "sort_addr", rb_ca_sort_addr, -1);
 }
@@ -0,0 +1,711 @@
+/* ---------------------------------------------------------------------------
+
+  carray_sorted_index.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  CASortedIndex holds the sorted keys in the Eytzinger layout, i.e. the keys
+  are stored in the breadth-first order of the implicit binary search tree
+  (the children of the node k are 2k and 2k+1). The search goes down the
+  tree by
+
+      k = 2*k + ( e[k] < x )
+
+  without any branch depending on the keys, and the nodes four levels
+  below (16k...16k+15) are prefetched, so that the search is bound by the
+  latency of the memory only once per four levels. The position found is
+  converted to the index in the sorted keys by the table rank[].
+
+  The integer keys are kept as int64 and compared exactly (float64 can not
+  hold the integers above 2^53), the other keys are converted to float64.
+
+  The queries given by a CArray are processed in parallel on the worker
+  pool without GVL.
+*/
+
+#include "carray.h"
+#include <math.h>
+#include <float.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ca_prefetch(p)  __builtin_prefetch(p)
+#define ca_ffs64(x)     __builtin_ffsll((long long) (x))
+#else
+#define ca_prefetch(p)
+static int
+ca_ffs64 (uint64_t x)
+{
+  int i;
+  for (i=1; i<=64; i++, x>>=1) {
+    if ( x & 1 ) {
+      return i;
+    }
+  }
+  return 0;
+}
+#endif
+
+#define CA_SORTED_INDEX_ALIGN 64     /* bytes of cache line */
+
+typedef struct {
+  int8_t     data_type; /* CA_FLOAT64 or CA_INT64 */
+  ca_size_t  n;
+  void      *keys;      /* sorted keys [0...n] */
+  void      *eytz;      /* keys in Eytzinger order [1...n] */
+  void      *eytz_mem;  /* memory block of eytz (for alignment) */
+  ca_size_t *rank;      /* rank[k] is the index in keys of eytz[k],
+                           rank[0] = n */
+} CASortedIndex;
+
+/* both of the key types have 8 bytes */
+#define CA_SORTED_INDEX_KEY_BYTES 8
+
+static VALUE rb_cCASortedIndex;
+
+static void
+ca_sorted_index_free (void *ptr)
+{
+  CASortedIndex *si = (CASortedIndex *) ptr;
+  xfree(si->keys);
+  xfree(si->eytz_mem);
+  xfree(si->rank);
+  xfree(si);
+}
+
+static size_t
+ca_sorted_index_memsize (const void *ptr)
+{
+  const CASortedIndex *si = (const CASortedIndex *) ptr;
+  return sizeof(CASortedIndex) +
+         ( ( si->keys ) ? si->n * ( 2*CA_SORTED_INDEX_KEY_BYTES
+                                    + sizeof(ca_size_t) )
+                          + CA_SORTED_INDEX_ALIGN : 0 );
+}
+
+static const rb_data_type_t ca_sorted_index_data_type = {
+    .wrap_struct_name = "CASortedIndex",
+    .function = {
+        .dmark = NULL,
+        .dfree = ca_sorted_index_free,
+        .dsize = ca_sorted_index_memsize,
+        .dcompact = NULL
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE
+rb_sorted_index_s_allocate (VALUE klass)
+{
+  CASortedIndex *si;
+  return TypedData_Make_Struct(klass, CASortedIndex,
+                               &ca_sorted_index_data_type, si);
+}
+
+static CASortedIndex *
+ca_sorted_index_get (VALUE obj)
+{
+  CASortedIndex *si;
+  TypedData_Get_Struct(obj, CASortedIndex, &ca_sorted_index_data_type, si);
+  if ( ! si->keys ) {
+    rb_raise(rb_eRuntimeError, "CASortedIndex is not initialized");
+  }
+  return si;
+}
+
+/* fills the subtree of the node k by keys[i...], returns the next i */
+
+static ca_size_t
+ca_sorted_index_fill (CASortedIndex *si, ca_size_t i, ca_size_t k)
+{
+  if ( k <= si->n ) {
+    i = ca_sorted_index_fill(si, i, 2*k);
+    memcpy((char *) si->eytz + k * CA_SORTED_INDEX_KEY_BYTES,
+           (char *) si->keys + i * CA_SORTED_INDEX_KEY_BYTES,
+           CA_SORTED_INDEX_KEY_BYTES);
+    si->rank[k] = i;
+    i = ca_sorted_index_fill(si, i+1, 2*k+1);
+  }
+  return i;
+}
+
+/* returns the first index i with keys[i] >= x (or keys[i] > x if upper),
+   or n if no such key */
+
+#define proc_sorted_index_bound(name, type)                             \
+static inline ca_size_t                                                 \
+name (const CASortedIndex *si, type x, int upper)                       \
+{                                                                       \
+  const type *e = (const type *) si->eytz;                              \
+  ca_size_t n = si->n;                                                  \
+  uint64_t k = 1;                                                       \
+  if ( upper ) {                                                        \
+    while ( k <= (uint64_t) n ) {                                       \
+      ca_prefetch(e + 16*k);                                            \
+      k = 2*k + ( e[k] <= x );                                          \
+    }                                                                   \
+  }                                                                     \
+  else {                                                                \
+    while ( k <= (uint64_t) n ) {                                       \
+      ca_prefetch(e + 16*k);                                            \
+      k = 2*k + ( e[k] < x );                                           \
+    }                                                                   \
+  }                                                                     \
+  k >>= ca_ffs64(~k);                                                   \
+  return si->rank[k];                                                   \
+}
+
+proc_sorted_index_bound(ca_sorted_index_bound_f64, float64_t)
+proc_sorted_index_bound(ca_sorted_index_bound_i64, int64_t)
+
+/* bound of the float64 x (not NaN) in the int64 keys, by the integer
+   thresholds e < x <=> e < ceil(x) and e <= x <=> e <= floor(x) */
+
+static inline ca_size_t
+ca_sorted_index_bound_i64_f64 (const CASortedIndex *si, float64_t x,
+                               int upper)
+{
+  float64_t t = ( upper ) ? floor(x) : ceil(x);
+  if ( t >= 9223372036854775808.0 ) {
+    return si->n;
+  }
+  else if ( t < -9223372036854775808.0 ) {
+    return 0;
+  }
+  return ca_sorted_index_bound_i64(si, (int64_t) t, upper);
+}
+
+/* fractional index of x in the float64 keys by the linear interpolation,
+   the first index for the keys equal to x */
+
+static inline float64_t
+ca_sorted_index_section_f64 (const CASortedIndex *si, float64_t x)
+{
+  const float64_t *y = (const float64_t *) si->keys;
+  ca_size_t n = si->n;
+  ca_size_t x1;
+  float64_t y1, y2;
+  if ( isnan(x) ) {
+    return x;
+  }
+  if ( x <= y[0] ) {
+    if ( x == y[0] ) {
+      return 0.0;
+    }
+    x1 = 0;
+  }
+  else if ( x > y[n-1] ) {
+    x1 = n-2;
+  }
+  else {
+    x1 = ca_sorted_index_bound_f64(si, x, 0) - 1;  /* y[x1] < x <= y[x1+1] */
+  }
+  y1 = y[x1];
+  y2 = y[x1+1];
+  if ( fabs(y2-x)/fabs(y2) < DBL_EPSILON*100 ) {
+    return (float64_t) (x1 + 1);
+  }
+  else if ( fabs(y1-x)/fabs(y1) < DBL_EPSILON*100 ) {
+    return (float64_t) x1;
+  }
+  else {
+    return (x-y1)/(y2-y1) + (float64_t) x1;
+  }
+}
+
+/* a - b for the int64 values without overflow */
+
+static inline float64_t
+ca_sorted_index_diff_i64 (int64_t a, int64_t b)
+{
+  return ( a >= b ) ?   (float64_t) ( (uint64_t) a - (uint64_t) b )
+                    : - (float64_t) ( (uint64_t) b - (uint64_t) a );
+}
+
+/* fractional index of x in the int64 keys, where x is given by int64 xi
+   (or by float64 xf if is_float), the first index for the keys equal to x */
+
+static inline float64_t
+ca_sorted_index_section_i64 (const CASortedIndex *si, int64_t xi,
+                             float64_t xf, int is_float)
+{
+  const int64_t *y = (const int64_t *) si->keys;
+  ca_size_t n = si->n;
+  ca_size_t k, x1;
+  float64_t dx;
+  if ( is_float ) {
+    if ( isnan(xf) ) {
+      return xf;
+    }
+    k = ca_sorted_index_bound_i64_f64(si, xf, 0);
+    if ( k < n && xf == floor(xf) && (float64_t) y[k] == xf ) {
+      return (float64_t) k;
+    }
+  }
+  else {
+    k = ca_sorted_index_bound_i64(si, xi, 0);
+    if ( k < n && y[k] == xi ) {
+      return (float64_t) k;
+    }
+  }
+  x1 = ( k == 0 ) ? 0 : ( k == n ) ? n-2 : k-1;
+  dx = ( is_float ) ? xf - (float64_t) y[x1]
+                    : ca_sorted_index_diff_i64(xi, y[x1]);
+  return dx / ca_sorted_index_diff_i64(y[x1+1], y[x1]) + (float64_t) x1;
+}
+
+/* ------------------------------------------------------------------- */
+
+enum {
+  CA_SORTED_INDEX_LOWER,
+  CA_SORTED_INDEX_UPPER,
+  CA_SORTED_INDEX_FIND,
+  CA_SORTED_INDEX_SECTION,
+};
+
+typedef struct {
+  CASortedIndex *si;
+  int            op;
+  int8_t         data_type;  /* of px, CA_FLOAT64 or CA_INT64 */
+  void          *px;
+  boolean8_t    *mx;
+  void          *po;
+} ca_sorted_index_job_t;
+
+/* the queries on the float64 keys */
+
+static void
+ca_sorted_index_run_f64 (ca_size_t start, ca_size_t end,
+                         ca_sorted_index_job_t *job)
+{
+  const CASortedIndex *si = job->si;
+  float64_t *px = (float64_t *) job->px;
+  boolean8_t *mx = job->mx;
+  ca_size_t *pi = (ca_size_t *) job->po;
+  float64_t *pf = (float64_t *) job->po;
+  const float64_t *keys = (const float64_t *) si->keys;
+  ca_size_t i, k;
+  switch ( job->op ) {
+  case CA_SORTED_INDEX_LOWER:
+  case CA_SORTED_INDEX_UPPER:
+    for (i=start; i<end; i++) {
+      if ( mx && mx[i] ) {
+        pi[i] = 0;
+      }
+      else if ( isnan(px[i]) ) {
+        pi[i] = si->n;
+      }
+      else {
+        pi[i] = ca_sorted_index_bound_f64(si, px[i],
+                                          job->op == CA_SORTED_INDEX_UPPER);
+      }
+    }
+    break;
+  case CA_SORTED_INDEX_FIND:
+    for (i=start; i<end; i++) {
+      if ( mx && mx[i] ) {
+        pi[i] = -1;
+        continue;
+      }
+      k = ca_sorted_index_bound_f64(si, px[i], 0);
+      pi[i] = ( k < si->n && keys[k] == px[i] ) ? k : -1;
+    }
+    break;
+  case CA_SORTED_INDEX_SECTION:
+    for (i=start; i<end; i++) {
+      pf[i] = ( mx && mx[i] ) ? 0.0 : ca_sorted_index_section_f64(si, px[i]);
+    }
+    break;
+  }
+}
+
+/* the queries on the int64 keys, x is int64 or float64 */
+
+static void
+ca_sorted_index_run_i64 (ca_size_t start, ca_size_t end,
+                         ca_sorted_index_job_t *job)
+{
+  const CASortedIndex *si = job->si;
+  int is_float = ( job->data_type == CA_FLOAT64 );
+  int64_t *pxi = (int64_t *) job->px;
+  float64_t *pxf = (float64_t *) job->px;
+  boolean8_t *mx = job->mx;
+  ca_size_t *pi = (ca_size_t *) job->po;
+  float64_t *pf = (float64_t *) job->po;
+  const int64_t *keys = (const int64_t *) si->keys;
+  int upper = ( job->op == CA_SORTED_INDEX_UPPER );
+  ca_size_t i, k;
+  switch ( job->op ) {
+  case CA_SORTED_INDEX_LOWER:
+  case CA_SORTED_INDEX_UPPER:
+    for (i=start; i<end; i++) {
+      if ( mx && mx[i] ) {
+        pi[i] = 0;
+      }
+      else if ( ! is_float ) {
+        pi[i] = ca_sorted_index_bound_i64(si, pxi[i], upper);
+      }
+      else if ( isnan(pxf[i]) ) {
+        pi[i] = si->n;
+      }
+      else {
+        pi[i] = ca_sorted_index_bound_i64_f64(si, pxf[i], upper);
+      }
+    }
+    break;
+  case CA_SORTED_INDEX_FIND:
+    for (i=start; i<end; i++) {
+      if ( mx && mx[i] ) {
+        pi[i] = -1;
+      }
+      else if ( ! is_float ) {
+        k = ca_sorted_index_bound_i64(si, pxi[i], 0);
+        pi[i] = ( k < si->n && keys[k] == pxi[i] ) ? k : -1;
+      }
+      else if ( isnan(pxf[i]) ) {
+        pi[i] = -1;
+      }
+      else {
+        k = ca_sorted_index_bound_i64_f64(si, pxf[i], 0);
+        pi[i] = ( k < si->n && pxf[i] == floor(pxf[i]) &&
+                  (float64_t) keys[k] == pxf[i] ) ? k : -1;
+      }
+    }
+    break;
+  case CA_SORTED_INDEX_SECTION:
+    for (i=start; i<end; i++) {
+      pf[i] = ( mx && mx[i] ) ? 0.0 :
+              ca_sorted_index_section_i64(si,
+                                          ( is_float ) ? 0 : pxi[i],
+                                          ( is_float ) ? pxf[i] : 0.0,
+                                          is_float);
+    }
+    break;
+  }
+}
+
+static void
+ca_sorted_index_run (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_sorted_index_job_t *job = (ca_sorted_index_job_t *) arg;
+  if ( job->si->data_type == CA_INT64 ) {
+    ca_sorted_index_run_i64(start, end, job);
+  }
+  else {
+    ca_sorted_index_run_f64(start, end, job);
+  }
+}
+
+/* returns true if v is an Integer in the range of int64 */
+
+static int
+ca_sorted_index_int64_p (VALUE v)
+{
+  if ( FIXNUM_P(v) ) {
+    return 1;
+  }
+  return RB_TYPE_P(v, T_BIGNUM) && rb_absint_numwords(v, 63, NULL) <= 1;
+}
+
+/* returns the data type (CA_INT64 or CA_FLOAT64) to search the keys or
+   the queries v exactly, i.e. CA_INT64 for the integer type CArray (except
+   uint64 which does not fit in int64) or Integer (or Array of them) */
+
+static int8_t
+ca_sorted_index_key_type (VALUE v)
+{
+  CArray *ca;
+  long i;
+  if ( rb_obj_is_carray(v) ) {
+    TypedData_Get_Struct(v, CArray, &carray_data_type, ca);
+    if ( ca->data_type == CA_UINT64 ) {
+      volatile VALUE vmax;
+      if ( ca->elements == 0 ) {
+        return CA_INT64;
+      }
+      vmax = rb_funcall(v, rb_intern("max"), 0);
+      return ( ! NIL_P(vmax) && ca_sorted_index_int64_p(vmax) ) ?
+             CA_INT64 : CA_FLOAT64;
+    }
+    return ca_is_integer_type(ca) ? CA_INT64 : CA_FLOAT64;
+  }
+  else if ( RB_TYPE_P(v, T_ARRAY) ) {
+    for (i=0; i<RARRAY_LEN(v); i++) {
+      if ( ! ca_sorted_index_int64_p(RARRAY_AREF(v, i)) ) {
+        return CA_FLOAT64;
+      }
+    }
+    return CA_INT64;
+  }
+  else {
+    return ca_sorted_index_int64_p(v) ? CA_INT64 : CA_FLOAT64;
+  }
+}
+
+/* runs the query op for the elements of vx, returns a CArray of the shape
+   of vx (or a scalar value if vx is a number) */
+
+static VALUE
+rb_sorted_index_query (VALUE self, VALUE vx, int op)
+{
+  volatile VALUE rx, out;
+  CASortedIndex *si = ca_sorted_index_get(self);
+  ca_sorted_index_job_t job;
+  CArray *cx, *co;
+  boolean8_t *mo;
+  ca_size_t i;
+  int8_t data_type;
+
+  if ( op == CA_SORTED_INDEX_SECTION && si->n < 2 ) {
+    rb_raise(rb_eRuntimeError, "section needs two keys at least");
+  }
+
+  job.data_type = ( si->data_type == CA_INT64 ) ?
+                  ca_sorted_index_key_type(vx) : CA_FLOAT64;
+
+  rx = rb_ca_wrap_readonly(vx, INT2NUM(job.data_type));
+  TypedData_Get_Struct(rx, CArray, &carray_data_type, cx);
+
+  data_type = ( op == CA_SORTED_INDEX_SECTION ) ? CA_FLOAT64 : CA_SIZE;
+  out = rb_carray_new(data_type, cx->ndim, cx->dim, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  ca_attach(cx);
+
+  job.si = si;
+  job.op = op;
+  job.px = cx->ptr;
+  job.mx = ( cx->mask ) ? (boolean8_t *) cx->mask->ptr : NULL;
+  job.po = co->ptr;
+
+  ca_parallel_for(cx->elements, 1, ca_sorted_index_run, &job);
+
+  if ( job.mx ) {
+    ca_copy_mask_overlay(co, co->elements, 1, cx);
+  }
+
+  ca_detach(cx);
+
+  if ( op == CA_SORTED_INDEX_FIND ) {
+    ca_size_t *po = (ca_size_t *) co->ptr;
+    mo = NULL;
+    for (i=0; i<co->elements; i++) {
+      if ( po[i] < 0 ) {
+        if ( ! mo ) {
+          ca_create_mask(co);
+          mo = (boolean8_t *) co->mask->ptr;
+        }
+        mo[i] = 1;
+        po[i] = 0;
+      }
+    }
+  }
+
+  if ( rb_obj_is_kind_of(vx, rb_cNumeric) ) {
+    VALUE v = rb_ca_fetch_addr(out, 0);
+    return ( v == CA_UNDEF ) ? Qnil : v;
+  }
+
+  return out;
+}
+
+/* @overload initialize (keys)
+
+Creates the search index of the keys (CArray or Array sorted in ascending
+order, without NaN and masked elements). The integer keys are kept as
+int64 (uint64 keys should not exceed the range of int64) and searched
+exactly, the other keys are converted to float64.
+
+    si = CASortedIndex.new(CArray.float64(1000).seq!)
+    si.section(CA_DOUBLE([1.5, 998.25]))   # => <1.5, 998.25>
+*/
+
+static VALUE
+rb_sorted_index_initialize (VALUE self, VALUE rkeys)
+{
+  volatile VALUE rk;
+  CASortedIndex *si;
+  CArray *ck;
+  ca_size_t i, n;
+  int8_t data_type;
+  char *mem;
+
+  TypedData_Get_Struct(self, CASortedIndex, &ca_sorted_index_data_type, si);
+
+  data_type = ca_sorted_index_key_type(rkeys);
+  if ( data_type == CA_FLOAT64 && rb_obj_is_carray(rkeys) &&
+       RTEST(rb_ca_is_integer_type(rkeys)) ) {
+    rb_raise(rb_eArgError, "uint64 keys should not exceed the range of int64");
+  }
+
+  rk = rb_ca_wrap_readonly(rkeys, INT2NUM(data_type));
+  TypedData_Get_Struct(rk, CArray, &carray_data_type, ck);
+
+  ca_attach(ck);
+
+  if ( ca_is_any_masked(ck) ) {
+    ca_detach(ck);
+    rb_raise(rb_eArgError, "keys should not have any masked elements");
+  }
+
+  n = ck->elements;
+  for (i=0; i<n; i++) {
+    int bad;
+    if ( data_type == CA_INT64 ) {
+      int64_t *k = (int64_t *) ck->ptr;
+      bad = ( i > 0 && k[i] < k[i-1] );
+    }
+    else {
+      float64_t *k = (float64_t *) ck->ptr;
+      bad = isnan(k[i]) || ( i > 0 && k[i] < k[i-1] );
+    }
+    if ( bad ) {
+      ca_detach(ck);
+      rb_raise(rb_eArgError,
+               "keys should be sorted in ascending order without NaN");
+    }
+  }
+
+  if ( si->keys ) {
+    xfree(si->keys);
+    xfree(si->eytz_mem);
+    xfree(si->rank);
+    si->keys = NULL;
+  }
+
+  si->data_type = data_type;
+  si->n    = n;
+  si->rank = ALLOC_N(ca_size_t, n+1);
+  si->eytz_mem = mem = ALLOC_N(char,
+                       CA_SORTED_INDEX_KEY_BYTES*(n+1) + CA_SORTED_INDEX_ALIGN);
+  si->eytz = mem + CA_SORTED_INDEX_ALIGN -
+             ((uintptr_t) mem) % CA_SORTED_INDEX_ALIGN;
+  si->keys = ALLOC_N(char, CA_SORTED_INDEX_KEY_BYTES*(n+1));
+  memcpy(si->keys, ck->ptr, CA_SORTED_INDEX_KEY_BYTES*n);
+
+  ca_detach(ck);
+
+  si->rank[0] = n;
+  memset(si->eytz, 0, CA_SORTED_INDEX_KEY_BYTES);
+  ca_sorted_index_fill(si, 0, 1);
+
+  return self;
+}
+
+/* @overload size
+
+Returns the number of the keys.
+*/
+
+static VALUE
+rb_sorted_index_size (VALUE self)
+{
+  return SIZE2NUM(ca_sorted_index_get(self)->n);
+}
+
+/* @overload keys
+
+Returns the sorted keys as an int64 array (for the integer keys) or
+a float64 array.
+*/
+
+static VALUE
+rb_sorted_index_keys (VALUE self)
+{
+  volatile VALUE out;
+  CASortedIndex *si = ca_sorted_index_get(self);
+  CArray *co;
+  out = rb_carray_new(si->data_type, 1, &si->n, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+  memcpy(co->ptr, si->keys, CA_SORTED_INDEX_KEY_BYTES*si->n);
+  return out;
+}
+
+/* @overload lower_bound (x)
+
+Returns the index of the first key not less than x for each element of x
+(the number of the keys if not found). The result has the shape of x,
+or is an integer for a number x.
+*/
+
+static VALUE
+rb_sorted_index_lower_bound (VALUE self, VALUE vx)
+{
+  return rb_sorted_index_query(self, vx, CA_SORTED_INDEX_LOWER);
+}
+
+/* @overload upper_bound (x)
+
+Returns the index of the first key greater than x for each element of x
+(the number of the keys if not found).
+*/
+
+static VALUE
+rb_sorted_index_upper_bound (VALUE self, VALUE vx)
+{
+  return rb_sorted_index_query(self, vx, CA_SORTED_INDEX_UPPER);
+}
+
+/* @overload bsearch (x)
+
+Returns the index of the key equal to x for each element of x, which is
+masked (or nil for a number x) if not found. Same as CArray#bsearch on the
+keys, except that the first index (lower_bound) is always returned for
+the duplicated keys, where CArray#bsearch may return any of them.
+*/
+
+static VALUE
+rb_sorted_index_bsearch (VALUE self, VALUE vx)
+{
+  return rb_sorted_index_query(self, vx, CA_SORTED_INDEX_FIND);
+}
+
+/* @overload section (x)
+
+Returns the fractional index of x in the keys by linear interpolation
+(extrapolated outside the keys) for each element of x. Same as
+CArray#section on the keys, except that the first index (lower_bound) is
+always returned for x equal to the duplicated keys, where CArray#section
+may return another one of them.
+*/
+
+static VALUE
+rb_sorted_index_section (VALUE self, VALUE vx)
+{
+  return rb_sorted_index_query(self, vx, CA_SORTED_INDEX_SECTION);
+}
+
+/* @overload sorted_index
+
+Returns CASortedIndex of self (which should be sorted in ascending order)
+for the repeated lookups by bsearch, section, lower_bound and upper_bound.
+*/
+
+static VALUE
+rb_ca_sorted_index (VALUE self)
+{
+  return rb_class_new_instance(1, &self, rb_cCASortedIndex);
+}
+
+void
+Init_carray_sorted_index ()
+{
+  rb_cCASortedIndex = rb_define_class("CASortedIndex", rb_cObject);
+  rb_define_alloc_func(rb_cCASortedIndex, rb_sorted_index_s_allocate);
+  rb_define_method(rb_cCASortedIndex, "initialize",
+                   rb_sorted_index_initialize, 1);
+  rb_define_method(rb_cCASortedIndex, "size", rb_sorted_index_size, 0);
+  rb_define_method(rb_cCASortedIndex, "keys", rb_sorted_index_keys, 0);
+  rb_define_method(rb_cCASortedIndex, "lower_bound",
+                   rb_sorted_index_lower_bound, 1);
+  rb_define_method(rb_cCASortedIndex, "upper_bound",
+                   rb_sorted_index_upper_bound, 1);
+  rb_define_method(rb_cCASortedIndex, "bsearch", rb_sorted_index_bsearch, 1);
+  rb_define_method(rb_cCASortedIndex, "section", rb_sorted_index_section, 1);
+
+  rb_define_method(rb_cCArray, "sorted_index", rb_ca_sorted_index, 0);
+}
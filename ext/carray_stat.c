@@ -23,7 +23,7 @@
   { \
     type *ptr = (type *) ca->ptr; \
     type *q   = (type *) co->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     boolean8_t *n = NULL; \
     type fval = ( ! NIL_P(rfval) ) ? (type) from(rfval) : (type)(0.0); \
     type min  = *ptr; \
@@ -131,7 +131,7 @@ rb_ca_cummin (int argc, VALUE *argv, VALUE self)
   { \
     type *ptr = (type *) ca->ptr; \
     type *q   = (type *) co->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     boolean8_t *n = NULL; \
     type fval = ( ! NIL_P(rfval) ) ? (type) from(rfval) : (type)(0.0); \
     type max  = *ptr; \
@@ -239,7 +239,7 @@ rb_ca_cummax (int argc, VALUE *argv, VALUE self)
   { \
     type *ptr = (type *) ca->ptr; \
     atype *q   = (atype *) co->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     boolean8_t *n = NULL; \
     atype fval = ( ! NIL_P(rfval) ) ? (type) from(rfval) : (atype)(0.0); \
     atype prod  = (atype)(1.0); \
@@ -336,46 +336,141 @@ rb_ca_cumprod (int argc, VALUE *argv, VALUE self)
 
 /* ----------------------------------------------------------------- */
 
-#define proc_wsum(type, atype, conv, to) \
-  { \
-    type *p1 = (type*)ca->ptr; \
-    type *p2; \
-    ca_size_t  s2; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
-    atype sum  = 0.0; \
-    ca_size_t count = 0; \
-    ca_size_t i; \
-    ca_set_iterator(1, cw, &p2, &s2); \
-    if ( m ) { \
-      count = 0; \
-      for (i=ca->elements; i; i--, p1++, p2+=s2) { \
-        if ( ! *m++ ) { \
-          sum += (atype)conv(*p1) * (atype)conv(*p2); \
-        } \
-        else { \
-          count++; \
-        } \
-      } \
-    } \
-    else { \
-      for (i=ca->elements; i; i--, p1++, p2+=s2) { \
-        sum += (atype)conv(*p1) * (atype)conv(*p2); \
+/*
+  The weighted sum is computed by the pairwise summation (see ca_psum_block()
+  in carray.h). For the real types, the elements are divided into the chunks
+  of ca_parallel_reduce() and the partial sums are added in the order of the
+  chunks, so the result does not depend on the scheduling of the threads.
+*/
+
+#define proc_wsum_block(type, atype, conv) \
+static atype \
+ca_wsum_block_##type (ca_size_t n, boolean8_t *m, \
+                      void *ptr1, void *ptr2, ca_size_t s2, ca_size_t *count) \
+{ \
+  type *p1 = (type *) ptr1; \
+  type *p2 = (type *) ptr2; \
+  atype buf[CA_PSUM_BLOCK]; \
+  atype stack[CA_PSUM_DEPTH]; \
+  atype s; \
+  ca_size_t nblock = 0, cnt = 0; \
+  ca_size_t i; \
+  int nb = 0, top = 0, k; \
+  if ( ( ! m ) && s2 == 1 ) { \
+    for (i=0; i<n; i+=nb) { \
+      nb = ( n - i < CA_PSUM_BLOCK ) ? (int)(n - i) : CA_PSUM_BLOCK; \
+      for (k=0; k<nb; k++) { \
+        buf[k] = (atype)conv(p1[i+k]) * (atype)conv(p2[i+k]); \
       } \
+      ca_psum_block(atype, buf, nb, s); \
+      ca_psum_push(stack, top, nblock, s); \
     } \
-    if ( ( ! NIL_P(rmin_count) ) && count > min_count )     {   \
-      out = ( NIL_P(rfval) ) ? CA_UNDEF : rfval;\
+    n = 0; \
+    nb = 0; \
+  } \
+  for (i=0; i<n; i++, p1++, p2+=s2) { \
+    if ( m && m[i] ) { \
+      cnt++; \
     } \
     else { \
-      out = to(sum); \
+      buf[nb++] = (atype)conv(*p1) * (atype)conv(*p2); \
+      if ( nb == CA_PSUM_BLOCK ) { \
+        ca_psum_block(atype, buf, nb, s); \
+        ca_psum_push(stack, top, nblock, s); \
+        nb = 0; \
+      } \
     } \
+  } \
+  ca_psum_block(atype, buf, nb, s); \
+  ca_psum_finish(stack, top, s); \
+  *count = cnt; \
+  return s; \
+}
+
+proc_wsum_block(int8_t,     double, )
+proc_wsum_block(uint8_t,    double, )
+proc_wsum_block(int16_t,    double, )
+proc_wsum_block(uint16_t,   double, )
+proc_wsum_block(int32_t,    double, )
+proc_wsum_block(uint32_t,   double, )
+proc_wsum_block(int64_t,    double, )
+proc_wsum_block(uint64_t,   double, )
+proc_wsum_block(float32_t,  double, )
+proc_wsum_block(float64_t,  double, )
+proc_wsum_block(float128_t, double, )
+#ifdef HAVE_COMPLEX_H
+proc_wsum_block(cmplx64_t,  cmplx128_t, )
+proc_wsum_block(cmplx128_t, cmplx128_t, )
+proc_wsum_block(cmplx256_t, cmplx128_t, )
+#endif
+proc_wsum_block(VALUE,      double, NUM2DBL)
+
+typedef double (*ca_wsum_block_t)(ca_size_t n, boolean8_t *m,
+                                  void *ptr1, void *ptr2, ca_size_t s2,
+                                  ca_size_t *count);
+
+typedef struct {
+  ca_wsum_block_t block;
+  boolean8_t     *m;
+  char           *p1;
+  char           *p2;
+  ca_size_t       s2;
+  ca_size_t       bytes;
+  double          sum[CA_PARALLEL_THREADS_MAX];
+  ca_size_t       count[CA_PARALLEL_THREADS_MAX];
+} ca_wsum_t;
+
+static void
+ca_wsum_chunk (int i, ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_wsum_t *w = (ca_wsum_t *) arg;
+  w->sum[i] = w->block(end - start, ( w->m ) ? w->m + start : NULL,
+                       w->p1 + start * w->bytes,
+                       w->p2 + start * w->s2 * w->bytes, w->s2,
+                       &w->count[i]);
+}
+
+static double
+ca_wsum_parallel (CArray *ca, ca_wsum_block_t block, boolean8_t *m,
+                  char *p2, ca_size_t s2, ca_size_t *count)
+{
+  ca_wsum_t w;
+  int n, i, k;
+  w.block = block;
+  w.m     = m;
+  w.p1    = ca->ptr;
+  w.p2    = p2;
+  w.s2    = s2;
+  w.bytes = ca->bytes;
+  n = ca_parallel_reduce(ca->elements, 1, ca_wsum_chunk, &w);
+  for (k=1; k<n; k*=2) {
+    for (i=0; i+k<n; i+=2*k) {
+      w.sum[i]   += w.sum[i+k];
+      w.count[i] += w.count[i+k];
+    }
   }
+  *count = w.count[0];
+  return w.sum[0];
+}
+
+#define proc_wsum(type) \
+  sum = ca_wsum_parallel(ca, ca_wsum_block_##type, m, p2, s2, &count);
+
+#define proc_wsum_cmplx(type) \
+  csum = ca_wsum_block_##type(ca->elements, m, ca->ptr, p2, s2, &count);
 
 static VALUE
 rb_ca_wsum (int argc, VALUE *argv, VALUE self)
 {
   volatile VALUE out, weight = argv[0], rmin_count = Qnil, rfval = Qnil, tmp;
   CArray *ca, *cw;
-  ca_size_t min_count;
+  ca_size_t min_count, count = 0, s2;
+  boolean8_t *m;
+  char *p2;
+  double sum = 0.0;
+#ifdef HAVE_COMPLEX_H
+  cmplx128_t csum = 0.0;
+#endif
 
   if ( argc > 1 ) {
     rb_scan_args(argc, argv, "12", (VALUE *) &weight, (VALUE *) &rmin_count, (VALUE *) &rfval);
@@ -405,30 +500,49 @@ rb_ca_wsum (int argc, VALUE *argv, VALUE self)
 
   ca_attach_n(2, ca, cw);
 
+  m = ca_mask_ptr_any(ca);
+  ca_set_iterator(1, cw, &p2, &s2);
+
   switch ( ca->data_type ) {
   case CA_BOOLEAN:
-  case CA_INT8:     proc_wsum(int8_t, double,,rb_float_new);       break;
-  case CA_UINT8:    proc_wsum(uint8_t,double,,rb_float_new);     break;
-  case CA_INT16:    proc_wsum(int16_t,double,,rb_float_new);      break;
-  case CA_UINT16:   proc_wsum(uint16_t,double,,rb_float_new);    break;
-  case CA_INT32:    proc_wsum(int32_t,double,,rb_float_new);      break;
-  case CA_UINT32:   proc_wsum(uint32_t,double,,rb_float_new);    break;
-  case CA_INT64:    proc_wsum(int64_t,double,,rb_float_new);      break;
-  case CA_UINT64:   proc_wsum(uint64_t,double,,rb_float_new);    break;
-  case CA_FLOAT32:  proc_wsum(float32_t,double,,rb_float_new);    break;
-  case CA_FLOAT64:  proc_wsum(float64_t,double,,rb_float_new);    break;
-  case CA_FLOAT128: proc_wsum(float128_t,double,,rb_float_new);   break;
+  case CA_INT8:     proc_wsum(int8_t);     break;
+  case CA_UINT8:    proc_wsum(uint8_t);    break;
+  case CA_INT16:    proc_wsum(int16_t);    break;
+  case CA_UINT16:   proc_wsum(uint16_t);   break;
+  case CA_INT32:    proc_wsum(int32_t);    break;
+  case CA_UINT32:   proc_wsum(uint32_t);   break;
+  case CA_INT64:    proc_wsum(int64_t);    break;
+  case CA_UINT64:   proc_wsum(uint64_t);   break;
+  case CA_FLOAT32:  proc_wsum(float32_t);  break;
+  case CA_FLOAT64:  proc_wsum(float64_t);  break;
+  case CA_FLOAT128: proc_wsum(float128_t); break;
 #ifdef HAVE_COMPLEX_H
-  case CA_CMPLX64:  proc_wsum(cmplx64_t,cmplx128_t,,rb_ccomplex_new); break;
-  case CA_CMPLX128: proc_wsum(cmplx128_t,cmplx128_t,,rb_ccomplex_new); break;
-  case CA_CMPLX256: proc_wsum(cmplx256_t,cmplx128_t,,rb_ccomplex_new); break;
+  case CA_CMPLX64:  proc_wsum_cmplx(cmplx64_t);  break;
+  case CA_CMPLX128: proc_wsum_cmplx(cmplx128_t); break;
+  case CA_CMPLX256: proc_wsum_cmplx(cmplx256_t); break;
 #endif
-  case CA_OBJECT:   proc_wsum(VALUE,double,NUM2DBL,rb_float_new); break;
-  default: rb_raise(rb_eRuntimeError, "invalid data type");
+  case CA_OBJECT:   
+    sum = ca_wsum_block_VALUE(ca->elements, m, ca->ptr, p2, s2, &count); 
+    break;
+  default: 
+    ca_detach_n(2, ca, cw);
+    rb_raise(rb_eRuntimeError, "invalid data type");
   }
 
   ca_detach_n(2, ca, cw);
 
+  if ( ( ! NIL_P(rmin_count) ) && count > min_count ) {
+    out = ( NIL_P(rfval) ) ? CA_UNDEF : rfval;
+  }
+#ifdef HAVE_COMPLEX_H
+  else if ( ca_is_complex_type(ca) ) {
+    out = rb_ccomplex_new(csum);
+  }
+#endif
+  else {
+    out = rb_float_new(sum);
+  }
+
   return out;
 }
 
@@ -440,7 +554,7 @@ rb_ca_wsum (int argc, VALUE *argv, VALUE self)
     type *p2; \
     ca_size_t  s2; \
     atype *q   = (atype *) co->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     boolean8_t *n = NULL; \
     atype fval = ( ! NIL_P(rfval) ) ? (type) from(rfval) : (atype)(0.0); \
     atype sum  = 0.0; \
@@ -551,7 +665,7 @@ rb_ca_cumwsum (int argc, VALUE *argv, VALUE self)
     type *p1 = (type*)ca->ptr; \
     type *p2 = (type*)cw->ptr; \
     ca_size_t   s2; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     atype sum = 0.0; \
     atype den = 0.0; \
     atype ave; \
@@ -651,7 +765,7 @@ rb_ca_wmean (int argc, VALUE *argv, VALUE self)
 #define proc_variancep(type,from) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     double sum  = 0.0; \
     double sum2 = 0.0; \
     double del, var, ave; \
@@ -682,7 +796,7 @@ rb_ca_wmean (int argc, VALUE *argv, VALUE self)
     } \
     ave = sum / ((double) nvalid); \
     ptr = (type *) ca->ptr; \
-    m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    m = ca_mask_ptr_any(ca); \
     if ( m ) { \
       for (i=ca->elements; i; i--, ptr++) { \
         if ( ! *m++ ) { \
@@ -754,7 +868,7 @@ rb_ca_variancep (int argc, VALUE *argv, VALUE self)
 #define proc_variance(type,from) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     double sum  = 0.0; \
     double sum2 = 0.0; \
     double del, var, ave; \
@@ -785,7 +899,7 @@ rb_ca_variancep (int argc, VALUE *argv, VALUE self)
     } \
     ave = sum / ((double) nvalid); \
     ptr = (type *) ca->ptr; \
-    m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    m = ca_mask_ptr_any(ca); \
     if ( m ) { \
       for (i=ca->elements; i; i--, ptr++) { \
         if ( ! *m++ ) { \
@@ -885,7 +999,7 @@ rb_ca_count_true (int argc, VALUE *argv, VALUE self)
 
   {
     boolean8_t *ptr = (boolean8_t *) ca->ptr;
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL;
+    boolean8_t *m = ca_mask_ptr_any(ca);
     ca_size_t count = 0;
     ca_size_t value_count = 0;
     ca_size_t i;
@@ -954,7 +1068,7 @@ rb_ca_count_false (int argc, VALUE *argv, VALUE self)
 
   {
     boolean8_t *ptr = (boolean8_t *) ca->ptr;
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL;
+    boolean8_t *m = ca_mask_ptr_any(ca);
     ca_size_t count = 0;
     ca_size_t value_count = 0;
     ca_size_t i;
@@ -995,7 +1109,7 @@ rb_ca_count_false (int argc, VALUE *argv, VALUE self)
 #define proc_count_equal(type,from) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     ca_size_t count = 0; \
     ca_size_t value_count = 0; \
@@ -1030,7 +1144,7 @@ rb_ca_count_false (int argc, VALUE *argv, VALUE self)
 #define proc_count_equal_data() \
   { \
     char *ptr = ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     char *val = ALLOCA_N(char, ca->bytes); \
     ca_size_t count = 0; \
     ca_size_t value_count = 0; \
@@ -1066,7 +1180,7 @@ rb_ca_count_false (int argc, VALUE *argv, VALUE self)
 #define proc_count_equal_object() \
   { \
     VALUE *ptr = (VALUE *)ca->ptr;                                 \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     VALUE val = value; \
     ca_size_t count = 0; \
     ca_size_t value_count = 0; \
@@ -1157,7 +1271,7 @@ rb_ca_count_equal (int argc, VALUE *argv, VALUE self)
 #define proc_count_equiv(type,from,nabs) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     double rtol = fabs(NUM2DBL(reps)); \
     double vabs = nabs(val); \
@@ -1250,7 +1364,7 @@ rb_ca_count_equiv (int argc, VALUE *argv, VALUE self)
 #define proc_count_close(type,from,nabs) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     double atol = fabs(NUM2DBL(aeps)); \
     ca_size_t count = 0; \
@@ -1341,7 +1455,7 @@ rb_ca_count_close (int argc, VALUE *argv, VALUE self)
 #define proc_all_equal(type,from) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     ca_size_t i; \
     if ( m ) { \
@@ -1365,7 +1479,7 @@ rb_ca_count_close (int argc, VALUE *argv, VALUE self)
 #define proc_all_equal_object() \
   { \
     VALUE *ptr = (VALUE *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     VALUE val  = value; \
     ca_size_t i; \
     if ( m ) { \
@@ -1389,7 +1503,7 @@ rb_ca_count_close (int argc, VALUE *argv, VALUE self)
 #define proc_all_equal_data() \
   { \
     char *ptr = ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     char *val = ALLOCA_N(char, ca->bytes); \
     ca_size_t i; \
     rb_ca_obj2ptr(self, value, val); \
@@ -1457,7 +1571,7 @@ rb_ca_all_equal_p (int argc, VALUE *argv, VALUE self)
 #define proc_all_equiv(type,from,nabs) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     double rtol = fabs(NUM2DBL(reps)); \
     double vabs = nabs(val); \
@@ -1528,7 +1642,7 @@ rb_ca_all_equiv_p (int argc, VALUE *argv, VALUE self)
 #define proc_all_close(type,from,nabs) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     double atol = fabs(NUM2DBL(aeps)); \
     ca_size_t i; \
@@ -1596,7 +1710,7 @@ rb_ca_all_close_p (int argc, VALUE *argv, VALUE self)
 #define proc_any_equal(type,from) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     ca_size_t i; \
     if ( m ) { \
@@ -1620,7 +1734,7 @@ rb_ca_all_close_p (int argc, VALUE *argv, VALUE self)
 #define proc_any_equal_object() \
   { \
     VALUE *ptr = (VALUE *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     VALUE val  = value; \
     ca_size_t i; \
     if ( m ) { \
@@ -1644,7 +1758,7 @@ rb_ca_all_close_p (int argc, VALUE *argv, VALUE self)
 #define proc_any_equal_data() \
   { \
     char *ptr = ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     char *val = ALLOCA_N(char, ca->bytes); \
     ca_size_t i; \
     rb_ca_obj2ptr(self, value, val); \
@@ -1710,7 +1824,7 @@ rb_ca_any_equal_p (int argc, VALUE *argv, VALUE self)
 #define proc_any_equiv(type,from,nabs) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     double rtol = fabs(NUM2DBL(reps)); \
     double vabs = nabs(val); \
@@ -1781,7 +1895,7 @@ rb_ca_any_equiv_p (int argc, VALUE *argv, VALUE self)
 #define proc_any_close(type,from,nabs) \
   { \
     type *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     type val  = (type) from(value); \
     double atol = fabs(NUM2DBL(aeps)); \
     ca_size_t i; \
@@ -1867,7 +1981,7 @@ rb_ca_none_close_p (int argc, VALUE *argv, VALUE self)
 #define proc_histogram(type, from) \
   { \
     type  *ptr = (type *) ca->ptr; \
-    boolean8_t *m = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m = ca_mask_ptr_any(ca); \
     double min  = NUM2DBL(vmin); \
     double max  = NUM2DBL(vmax); \
     double diff = (max - min)/icls; \
@@ -1961,7 +2075,7 @@ rb_ca_histogram (int argc, VALUE *argv, VALUE self)
 #define proc_grade(type, from)                             \
   {                                                          \
     ca_size_t *dst = (ca_size_t *) sa->ptr;                      \
-    boolean8_t *m   = (ca->mask) ? (boolean8_t*) ca->mask->ptr : NULL; \
+    boolean8_t *m   = ca_mask_ptr_any(ca); \
     boolean8_t *dm  = (sa->mask) ? (boolean8_t*) sa->mask->ptr : NULL; \
     type   *ptr = (type *) ca->ptr;                          \
     double min  = NUM2DBL(vmin);                             \
@@ -306,6 +306,85 @@ typedef struct {
 
 typedef void (*ca_stat_proc_t)();
 
+/* result of ca_proc_describe (min and max hold the values of element type) */
+
+#define CA_DESCRIBE_BLOCK 256
+
+/* holds a value of element type */
+
+typedef union { 
+  uint64_t u; 
+  float64_t d; 
+  float128_t q; 
+} CAStatValue;
+
+typedef struct {
+  ca_size_t    count;
+  ca_size_t    min_addr;
+  ca_size_t    max_addr;
+  float64_t    sum;
+  float64_t    mean;
+  float64_t    variance;
+  float64_t    m2;        /* sum of squared deviations from mean */
+  CAStatValue  min, max;
+} CAStatDescribe;
+
+/* buffer size on stack for median and percentile */
+
+#define CA_SELECT_BUFSIZE 256
+
+/* percentiles requested in rb_ca_percentile(), valid while the procs
+   are called (with GVL held) */
+
+typedef struct {
+  int        n;
+  float64_t *per;
+  int       *order;   /* indices of per in ascending order of per */
+} CAStatPercentileSpec;
+
+static CAStatPercentileSpec ca_stat_percentile_spec;
+
+/* request of rb_ca_nlargest() and rb_ca_nsmallest(). The result of 
+   ca_proc_topk for a group is k addresses (-1 for the missing entries) 
+   followed by k values of the element type. */
+
+typedef struct {
+  ca_size_t  k;
+  int        dir;      /* 1 for the largest, -1 for the smallest */
+  int        sorted;   /* sorts the result from the best */
+} CAStatTopKSpec;
+
+static CAStatTopKSpec ca_stat_topk_spec;
+
+/* running statistics of CAStatAccumulator (atype of TYPEINFO) */
+
+typedef #{have_type_long_double ? 'long double' : 'double'} ca_stat_atype_t;
+
+typedef struct {
+  ca_size_t       count;
+  ca_stat_atype_t sum;
+  ca_stat_atype_t mean;
+  ca_stat_atype_t m2;
+  CAStatValue     min, max;
+} CAStatMoment;
+
+/* reductions of rb_ca_group_reduce() */
+
+enum {
+  CA_GROUP_SUM,
+  CA_GROUP_MEAN,
+  CA_GROUP_MIN,
+  CA_GROUP_MAX,
+  CA_GROUP_COUNT,
+};
+
+/* the integer keys are coded densely when the range of the keys is 
+   not larger than this */
+
+#define CA_GROUP_DENSE_MAX(n)  ( 2*(n) + 65536 )
+
+typedef VALUE (*ca_group_dense_t)();
+
 #define iterator_rewind(it)                   \
   { \
     if ( (it)->step ) { \
@@ -350,6 +429,11 @@ static ID id_lt, id_gt, id_plus, id_minus, id_star, id_quo;
 #define div_c(x, y)     ( (x) / (y) )
 #define div_VALUE(x, y) rb_funcall((x), id_quo, 1, (y))
 
+#define lt_nan(x, y)    ( (x) < (y) || ( isnan(y) && ! isnan(x) ) )
+
+#define nan_c(x)        ( 0 )
+#define nan_f(x)        isnan(x)
+
 #define sqrt_c(x)       sqrt(x)
 #define sqrt_VALUE(x)   rb_funcall((x), rb_intern("sqrt"), 0)
 
@@ -358,6 +442,202 @@ HERE_END
 puts header
 
 
+# --------------------------------------------------------------------------
+#
+# STAT Part 0 (summation)
+#
+# --------------------------------------------------------------------------
+
+text = <<'HERE_END'
+
+/* ============================= */
+/* ca_stat_sum                   */
+/* ============================= */
+
+/*
+  ca_stat_psum_<type>() sums up the valid elements (or the squared deviations
+  from "center" if "squared" is true) by the pairwise summation, so the
+  rounding error grows as O(log n) instead of O(n). The elements are summed
+  in the blocks of CA_PSUM_BLOCK elements in <stype>, and the block sums are
+  combined by ca_psum_push(). The number of the masked elements is stored
+  in *count.
+*/
+
+static <atype>
+ca_stat_psum_<type> (ca_size_t elements, boolean8_t *m, <type> *p,
+                     CAStatIterator *it, int squared, <atype> center,
+                     ca_size_t *count)
+{
+  <stype> buf[CA_PSUM_BLOCK];
+  <stype> x, c = (<stype>) center, s;
+  <atype> stack[CA_PSUM_DEPTH], t;
+  ca_size_t *a = (ca_size_t *) it;
+  ca_size_t nblock = 0, cnt = 0;
+  ca_size_t i;
+  int nb = 0, top = 0, k;
+  if ( ( ! m ) && ( ! it->step ) ) {
+    for (i=0; i<elements; i+=nb) {
+      nb = ( elements - i < CA_PSUM_BLOCK ) ? (int)(elements - i) : CA_PSUM_BLOCK;
+      if ( squared ) {
+        for (k=0; k<nb; k++) {
+          x = (<stype>)<dat2type>(p[i+k]) - c;
+          buf[k] = x * x;
+        }
+        ca_psum_block(<stype>, buf, nb, s);
+      }
+      else {
+        ca_psum_block(<stype>, p + i, nb, s);
+      }
+      t = s;
+      ca_psum_push(stack, top, nblock, t);
+    }
+    nb = 0;
+  }
+  else {
+    iterator_rewind(it);
+    for (i=0; i<elements; i++) {
+      if ( m && *(m + *a) ) {
+        cnt++;
+      }
+      else {
+        x = (<stype>)<dat2type>(*(p + *a));
+        if ( squared ) {
+          x -= c;
+          x *= x;
+        }
+        buf[nb++] = x;
+        if ( nb == CA_PSUM_BLOCK ) {
+          ca_psum_block(<stype>, buf, nb, s);
+          t = s;
+          ca_psum_push(stack, top, nblock, t);
+          nb = 0;
+        }
+      }
+      iterator_succ(it);
+    }
+  }
+  ca_psum_block(<stype>, buf, nb, s);
+  t = s;
+  ca_psum_finish(stack, top, t);
+  *count = cnt;
+  return t;
+}
+
+typedef struct {
+  boolean8_t *m;
+  <type>     *p;
+  int         squared;
+  <atype>     center;
+  <atype>     sum[CA_PARALLEL_THREADS_MAX];
+  ca_size_t   count[CA_PARALLEL_THREADS_MAX];
+} CAStatSum_<type>;
+
+static void
+ca_stat_sum_chunk_<type> (int i, ca_size_t start, ca_size_t end, void *arg)
+{
+  CAStatSum_<type> *s = (CAStatSum_<type> *) arg;
+  CAStatIterator it;
+  it.step = 0;
+  s->sum[i] = ca_stat_psum_<type>(end - start, ( s->m ) ? s->m + start : NULL,
+                                  s->p + start, &it, s->squared, s->center,
+                                  &s->count[i]);
+}
+
+/*
+  For the contiguous elements, ca_stat_sum_<type>() divides the elements
+  into the chunks of ca_parallel_reduce(), sums up the chunks in parallel,
+  and adds the partial sums pairwise in the order of the chunks. The result
+  is reproducible as long as the number of threads is not changed.
+*/
+
+static <atype>
+ca_stat_sum_<type> (ca_size_t elements, boolean8_t *m, <type> *p,
+                    CAStatIterator *it, int squared, <atype> center,
+                    ca_size_t *count)
+{
+  CAStatSum_<type> s;
+  int n, i, w;
+  if ( it->step ) {
+    return ca_stat_psum_<type>(elements, m, p, it, squared, center, count);
+  }
+  s.m       = m;
+  s.p       = p;
+  s.squared = squared;
+  s.center  = center;
+  n = ca_parallel_reduce(elements, 1, ca_stat_sum_chunk_<type>, &s);
+  if ( n == 0 ) {
+    *count = 0;
+    return <azero>;
+  }
+  for (w=1; w<n; w*=2) {
+    for (i=0; i+w<n; i+=2*w) {
+      s.sum[i]   += s.sum[i+w];
+      s.count[i] += s.count[i+w];
+    }
+  }
+  *count = s.count[0];
+  return s.sum[0];
+}
+
+HERE_END
+
+# the blocks are summed up in double (vectorizable) except for the types 
+# of which values are not exactly represented by double
+
+[
+  ['boolean8_t', 'double'],
+  ['int8_t',     'double'],
+  ['uint8_t',    'double'],
+  ['int16_t',    'double'],
+  ['uint16_t',   'double'],
+  ['int32_t',    'double'],
+  ['uint32_t',   'double'],
+  ['int64_t',    '<atype>'],
+  ['uint64_t',   '<atype>'],
+  ['float32_t',  'double'],
+  ['float64_t',  'double'],
+  ['float128_t', '<atype>'],
+].each do |type, stype|
+  puts macro_expand(text.gsub("<stype>", stype), TYPEINFO[type])
+end
+
+# object arrays are summed up sequentially with the GVL held
+
+text = <<'HERE_END'
+
+static VALUE
+ca_stat_sum_VALUE (ca_size_t elements, boolean8_t *m, VALUE *p,
+                   CAStatIterator *it, int squared, VALUE center,
+                   ca_size_t *count)
+{
+  volatile VALUE sum = rb_float_new(0.0), x;
+  ca_size_t *a = (ca_size_t *) it;
+  ca_size_t cnt = 0;
+  ca_size_t i;
+  iterator_rewind(it);
+  for (i=0; i<elements; i++) {
+    if ( m && *(m + *a) ) {
+      cnt++;
+    }
+    else {
+      x = *(p + *a);
+      if ( squared ) {
+        x = sub_VALUE(x, center);
+        x = mul_VALUE(x, x);
+      }
+      sum = add_VALUE(sum, x);
+    }
+    iterator_succ(it);
+  }
+  *count = cnt;
+  return sum;
+}
+
+HERE_END
+
+puts text
+
+
 # --------------------------------------------------------------------------
 #
 # STAT Part 1
@@ -419,7 +699,7 @@ static void
 ca_proc_count_<type> (ca_size_t elements, ca_size_t min_count,
                       boolean8_t *m, void *ptr, CAStatIterator *it,
                       int return_object, VALUE *retobj,
-                      boolean8_t *retmask, ca_size_t *retval)
+                      boolean8_t *retmask, int32_t *retval)
 {
   ca_size_t *a = (ca_size_t *) it;
   ca_size_t count = 0;
@@ -440,7 +720,7 @@ ca_proc_count_<type> (ca_size_t elements, ca_size_t min_count,
     if ( retmask ) {
       *retmask = ( count > min_count ) ? 1 : 0;
     }
-    *retval  = elements - count;
+    *retval  = (int32_t) (elements - count);
   }
 }
 
@@ -450,29 +730,10 @@ ca_proc_sum_<type> (ca_size_t elements, ca_size_t min_count,
                     int return_object, VALUE *retobj,
                     boolean8_t *retmask, float64_t *retval)
 {
-  volatile <atype> sum = <azero>;
+  volatile <atype> sum;
   <type> *p = (<type> *) ptr;
-  ca_size_t *a = (ca_size_t *)it;
-  ca_size_t count = 0;
-  ca_size_t i;
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        count++;
-      }
-      else {
-        sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      iterator_succ(it);
-    }
-  }
+  ca_size_t count;
+  sum = ca_stat_sum_<type>(elements, m, p, it, 0, <azero>, &count);
   if ( return_object ) {
     *retobj = ( count > min_count ) ? CA_UNDEF : <atype2obj>(sum);
   }
@@ -495,29 +756,10 @@ ca_proc_mean_<type> (ca_size_t elements, ca_size_t min_count,
                      int return_object, VALUE *retobj,
                      boolean8_t *retmask, float64_t *retval)
 {
-  volatile <atype> sum = <azero>, ave;
+  volatile <atype> sum, ave;
   <type> *p = (<type> *) ptr;
-  ca_size_t *a = (ca_size_t *) it;
-  ca_size_t count = 0;
-  ca_size_t i;
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        count++;
-      }
-      else {
-        sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      iterator_succ(it);
-    }
-  }
+  ca_size_t count;
+  sum = ca_stat_sum_<type>(elements, m, p, it, 0, <azero>, &count);
   ave = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
   if ( return_object ) {
     *retobj = ( count > min_count ) ? CA_UNDEF : <atype2obj>(ave);
@@ -540,51 +782,12 @@ ca_proc_variancep_<type> (ca_size_t elements, ca_size_t min_count,
                      int return_object, VALUE *retobj,
                      boolean8_t *retmask, float64_t *retval)
 {
-  volatile <atype> sum = <azero>, sum2 = <azero>, ave, var, diff;
+  volatile <atype> sum, sum2, ave, var;
   <type> *p = (<type> *) ptr;
-  ca_size_t *a = (ca_size_t *) it;
-  ca_size_t count = 0;
-  ca_size_t i;
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        count++;
-      }
-      else {
-        sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      iterator_succ(it);
-    }
-  }
-  ave = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
-
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        ;
-      }
-      else {
-        diff = sub_<op_type>((<atype>)<dat2type>(*(p + *a)), ave);
-        sum2 = add_<op_type>(sum2, mul_<op_type>(diff,diff));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      diff = sub_<op_type>((<atype>)<dat2type>(*(p + *a)), ave);
-      sum2 = add_<op_type>(sum2, mul_<op_type>(diff,diff));
-      iterator_succ(it);
-    }
-  }
+  ca_size_t count;
+  sum  = ca_stat_sum_<type>(elements, m, p, it, 0, <azero>, &count);
+  ave  = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
+  sum2 = ca_stat_sum_<type>(elements, m, p, it, 1, ave, &count);
 
   var = div_<op_type>(sum2, (<atype>)<int2type>(elements-count));
   
@@ -609,51 +812,12 @@ ca_proc_stddevp_<type> (ca_size_t elements, ca_size_t min_count,
                      int return_object, VALUE *retobj,
                      boolean8_t *retmask, float64_t *retval)
 {
-  volatile <atype> sum = <azero>, sum2 = <azero>, ave, var, diff;
+  volatile <atype> sum, sum2, ave, var;
   <type> *p = (<type> *) ptr;
-  ca_size_t *a = (ca_size_t *) it;
-  ca_size_t count = 0;
-  ca_size_t i;
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        count++;
-      }
-      else {
-        sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      iterator_succ(it);
-    }
-  }
-  ave = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
-
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        ;
-      }
-      else {
-        diff = sub_<op_type>((<atype>)<dat2type>(*(p + *a)), ave);
-        sum2 = add_<op_type>(sum2, mul_<op_type>(diff,diff));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      diff = sub_<op_type>((<atype>)<dat2type>(*(p + *a)), ave);
-      sum2 = add_<op_type>(sum2, mul_<op_type>(diff,diff));
-      iterator_succ(it);
-    }
-  }
+  ca_size_t count;
+  sum  = ca_stat_sum_<type>(elements, m, p, it, 0, <azero>, &count);
+  ave  = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
+  sum2 = ca_stat_sum_<type>(elements, m, p, it, 1, ave, &count);
 
   var = div_<op_type>(sum2, (<atype>)<int2type>(elements-count));
   
@@ -678,51 +842,12 @@ ca_proc_variance_<type> (ca_size_t elements, ca_size_t min_count,
                      int return_object, VALUE *retobj,
                      boolean8_t *retmask, float64_t *retval)
 {
-  volatile <atype> sum = <azero>, sum2 = <azero>, ave, var, diff;
+  volatile <atype> sum, sum2, ave, var;
   <type> *p = (<type> *) ptr;
-  ca_size_t *a = (ca_size_t *) it;
-  ca_size_t count = 0;
-  ca_size_t i;
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        count++;
-      }
-      else {
-        sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      iterator_succ(it);
-    }
-  }
-  ave = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
-
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        ;
-      }
-      else {
-        diff = sub_<op_type>((<atype>)<dat2type>(*(p + *a)), ave);
-        sum2 = add_<op_type>(sum2, mul_<op_type>(diff,diff));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      diff = sub_<op_type>((<atype>)<dat2type>(*(p + *a)), ave);
-      sum2 = add_<op_type>(sum2, mul_<op_type>(diff,diff));
-      iterator_succ(it);
-    }
-  }
+  ca_size_t count;
+  sum  = ca_stat_sum_<type>(elements, m, p, it, 0, <azero>, &count);
+  ave  = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
+  sum2 = ca_stat_sum_<type>(elements, m, p, it, 1, ave, &count);
 
   var = div_<op_type>(sum2, (<atype>)<int2type>(elements-count-1));
 
@@ -747,51 +872,12 @@ ca_proc_stddev_<type> (ca_size_t elements, ca_size_t min_count,
                      int return_object, VALUE *retobj,
                      boolean8_t *retmask, float64_t *retval)
 {
-  volatile <atype> sum = <azero>, sum2 = <azero>, ave, var, diff;
+  volatile <atype> sum, sum2, ave, var;
   <type> *p = (<type> *) ptr;
-  ca_size_t *a = (ca_size_t *) it;
-  ca_size_t count = 0;
-  ca_size_t i;
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        count++;
-      }
-      else {
-        sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      sum = add_<op_type>(sum, (<atype>)<dat2type>(*(p + *a)));
-      iterator_succ(it);
-    }
-  }
-  ave = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
-
-  iterator_rewind(it);
-  if ( m ) {
-    for (i=0; i<elements; i++) {
-      if ( *(m + *a) ) {
-        ;
-      }
-      else {
-        diff = sub_<op_type>((<atype>)<dat2type>(*(p + *a)), ave);
-        sum2 = add_<op_type>(sum2, mul_<op_type>(diff,diff));
-      }
-      iterator_succ(it);
-    }
-  }
-  else {
-    for (i=0; i<elements; i++) {
-      diff = sub_<op_type>((<atype>)<dat2type>(*(p + *a)), ave);
-      sum2 = add_<op_type>(sum2, mul_<op_type>(diff,diff));
-      iterator_succ(it);
-    }
-  }
+  ca_size_t count;
+  sum  = ca_stat_sum_<type>(elements, m, p, it, 0, <azero>, &count);
+  ave  = div_<op_type>(sum, (<atype>)<int2type>(elements-count));
+  sum2 = ca_stat_sum_<type>(elements, m, p, it, 1, ave, &count);
 
   var = div_<op_type>(sum2, (<atype>)<int2type>(elements-count-1));
   
@@ -882,7 +968,7 @@ static void
 ca_proc_min_addr_<type> (ca_size_t elements, ca_size_t min_count,
                          boolean8_t *m, void *ptr, CAStatIterator *it,
                          int return_object, VALUE *retobj,
-                         boolean8_t *retmask, ca_size_t *retval)
+                         boolean8_t *retmask, int32_t *retval)
 {
   <type> min = <zero>;
   <type> *p = (<type> *) ptr;
@@ -939,7 +1025,7 @@ ca_proc_min_addr_<type> (ca_size_t elements, ca_size_t min_count,
     if ( retmask ) {
       *retmask = ( count > min_count ) ? 1 : 0;
     }
-    *retval  = addr;
+    *retval  = (int32_t) (addr);
   }
 }
 
@@ -1019,7 +1105,7 @@ static void
 ca_proc_max_addr_<type> (ca_size_t elements, ca_size_t min_count,
                          boolean8_t *m, void *ptr, CAStatIterator *it,
                          int return_object, VALUE *retobj,
-                         boolean8_t *retmask, ca_size_t *retval)
+                         boolean8_t *retmask, int32_t *retval)
 {
   <type> max = 0;
   <type> *p = (<type> *) ptr;
@@ -1076,7 +1162,7 @@ ca_proc_max_addr_<type> (ca_size_t elements, ca_size_t min_count,
     if ( retmask ) {
       *retmask = ( count > min_count ) ? 1 : 0;
     }
-    *retval  = addr;
+    *retval  = (int32_t) (addr);
   }
 }
 
@@ -1325,187 +1411,1190 @@ puts macro_expand(text, "name" => "accum")
 
 # --------------------------------------------------------------------------
 #
-# METHOD DEFINITIONS (after __END__)
+# STAT Part 3 (describe)
 #
 # --------------------------------------------------------------------------
 
-puts DATA.read
-
-__END__
-
-static VALUE
-rb_ca_stat_1d (VALUE self, VALUE rmc, VALUE vfval,
-               ca_stat_proc_t *ca_proc)
-{
-  volatile VALUE out;
-  CArray *ca;
-  CAStatIterator it;
-  boolean8_t *m;
-  ca_size_t mc;
-
-  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
-
-  if ( ! ca_proc[ca->data_type] ) {
-    rb_raise(rb_eCADataTypeError,
-             "this method is not implemented for data_type %s",
-             ca_type_name[ca->data_type]);
-  }
-
-  if ( ca->elements == 0 ) {
-    out = CA_UNDEF;
-  }
-  else {
-    ca_attach(ca);
-    m = ( ca->mask ) ? (boolean8_t *)ca->mask->ptr : NULL;
-    mc = ( ( ! ca_has_mask(ca) ) || NIL_P(rmc)) ? ca->elements - 1 : NUM2SIZE(rmc);
-    if ( mc < 0 ) {
-      mc += ca->elements;
-    }
-    it.step = 0;
-    ca_proc[ca->data_type](ca->elements, mc, m, ca->ptr, &it, 1, &out, NULL, NULL);
-    ca_detach(ca);
-  }
+text = <<'HERE_END'
 
-  if ( out == CA_UNDEF && ( vfval != CA_NIL ) ) {
-    out = vfval;
-  }
+/* ============================= */
+/* ca_proc_describe              */
+/* ============================= */
 
-  return out;
-}
+/*
+  The valid elements are copied into a small buffer block by block while 
+  the mask, min and max are checked. The sum and the sum of squared 
+  deviations of each block are computed from the buffer (two-pass in 
+  cache), and merged into the totals by the pairwise update of Chan et al. 
+  So the array is read only once.
+*/
 
 static void
-ca_stat_nd_contig_loop (CArray *ca, CArray *co, ca_size_t mc,
-                        ca_stat_proc_t *ca_proc,
-                        int level, ca_size_t *idx, char **op, boolean8_t **om)
+ca_proc_describe_<type> (ca_size_t elements, ca_size_t min_count,
+                         boolean8_t *m, void *ptr, CAStatIterator *it,
+                         int return_object, VALUE *retobj,
+                         boolean8_t *retmask, CAStatDescribe *retval)
 {
-  void *p;
-  boolean8_t *m;
-  ca_size_t i, n;
-  if ( level == co->ndim ) {
-    CAStatIterator it;
-    n = ca->elements/co->elements;
-    idx[level] = 0;
-    p = ca_ptr_at_index(ca, idx);
-    m = ( ca->mask && ca->mask->ptr ) ?
-                          (boolean8_t *)ca_ptr_at_index(ca->mask, idx) : NULL;
-		it.step = 0;
-    ca_proc[ca->data_type](n, mc, m, p, &it, 0, NULL, *om, *op);
-    if ( *om ) {
-      *om += 1;
+  <atype> buf[CA_DESCRIBE_BLOCK];
+  <atype> sum = <azero>, mean = <azero>, m2 = <azero>;
+  <atype> bsum, bmean, bm2, diff;
+  <type> *p = (<type> *) ptr;
+  <type> val, min = <zero>, max = <zero>;
+  ca_size_t *a = (ca_size_t *) it;
+  ca_size_t count = 0, valid = 0;
+  ca_size_t min_addr = -1, max_addr = -1;
+  ca_size_t i, j, k, len, nb;
+  iterator_rewind(it);
+  for (i=0; i<elements; i+=CA_DESCRIBE_BLOCK) {
+    len = ( elements - i < CA_DESCRIBE_BLOCK ) ? elements - i : CA_DESCRIBE_BLOCK;
+    nb = 0;
+    for (j=0; j<len; j++) {
+      if ( m && *(m + *a) ) {
+        count++;
+      }
+      else {
+        val = *(p + *a);
+        if ( min_addr < 0 ) {
+          min = max = val;
+          min_addr = max_addr = i + j;
+        }
+        else if ( lt_<op_type>(val, min) ) {
+          min = val;
+          min_addr = i + j;
+        }
+        else if ( gt_<op_type>(val, max) ) {
+          max = val;
+          max_addr = i + j;
+        }
+        buf[nb++] = (<atype>)<dat2type>(val);
+      }
+      iterator_succ(it);
     }
-    *op += co->bytes;
-  }
-  else {
-    for (i=0; i<ca->dim[level]; i++) {
-      idx[level] = i;
-      ca_stat_nd_contig_loop(ca, co, mc, ca_proc, level+1, idx, op, om);
+    if ( nb == 0 ) {
+      continue;
+    }
+    bsum = <azero>;
+    for (k=0; k<nb; k++) {
+      bsum += buf[k];
+    }
+    bmean = bsum / nb;
+    bm2 = <azero>;
+    for (k=0; k<nb; k++) {
+      diff = buf[k] - bmean;
+      bm2 += diff * diff;
+    }
+    if ( valid == 0 ) {
+      mean = bmean;
+      m2   = bm2;
     }
+    else {
+      diff  = bmean - mean;
+      mean += diff * nb / (valid + nb);
+      m2   += bm2 + diff * diff * valid * nb / (valid + nb);
+    }
+    sum   += bsum;
+    valid += nb;
   }
+  if ( retmask ) {
+    *retmask = ( count > min_count || valid == 0 ) ? 1 : 0;
+  }
+  retval->count    = valid;
+  retval->min_addr = min_addr;
+  retval->max_addr = max_addr;
+  retval->sum      = (float64_t) sum;
+  retval->mean     = (float64_t) (sum / valid);
+  retval->variance = (float64_t) (m2 / (valid - 1));
+  retval->m2       = (float64_t) m2;
+  memcpy(&retval->min, &min, sizeof(<type>));
+  memcpy(&retval->max, &max, sizeof(<type>));
 }
 
-static VALUE
-rb_ca_stat_nd_contig (VALUE self, VALUE vaxis, VALUE rmc, VALUE vfval,
-                      int8_t data_type, ca_stat_proc_t *ca_proc)
-{
-  volatile VALUE out;
-  CArray *ca, *co;
-  ca_size_t mc, ndim;
-
-  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
-
-  if ( ! ca_proc[ca->data_type] ) {
-    rb_raise(rb_eCADataTypeError,
-             "this method is not implemented for data_type %s",
-             ca_type_name[ca->data_type]);
-  }
+HERE_END
 
-  ndim = ca->ndim - RARRAY_LEN(vaxis);
-  if ( ndim <= 0 || ndim > ca->ndim ) {
-    rb_raise(rb_eRuntimeError, "invalid dimension specified");
-  }
+puts macro_expand(text, TYPEINFO['boolean8_t'])
+puts macro_expand(text, TYPEINFO['int8_t'])
+puts macro_expand(text, TYPEINFO['uint8_t'])
+puts macro_expand(text, TYPEINFO['int16_t'])
+puts macro_expand(text, TYPEINFO['uint16_t'])
+puts macro_expand(text, TYPEINFO['int32_t'])
+puts macro_expand(text, TYPEINFO['uint32_t'])
+puts macro_expand(text, TYPEINFO['int64_t'])
+puts macro_expand(text, TYPEINFO['uint64_t'])
+puts macro_expand(text, TYPEINFO['float32_t'])
+puts macro_expand(text, TYPEINFO['float64_t'])
+puts macro_expand(text, TYPEINFO['float128_t'])
 
-  out = rb_carray_new(data_type, ndim, ca->dim, 0, NULL);
-  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+text = <<'HERE_END'
+static ca_stat_proc_t
+ca_proc_<name>[CA_NTYPE] = {
+  NULL,
+  ca_proc_<name>_boolean8_t,
+  ca_proc_<name>_int8_t,
+  ca_proc_<name>_uint8_t,
+  ca_proc_<name>_int16_t,
+  ca_proc_<name>_uint16_t,
+  ca_proc_<name>_int32_t,
+  ca_proc_<name>_uint32_t,
+  ca_proc_<name>_int64_t,
+  ca_proc_<name>_uint64_t,
+  ca_proc_<name>_float32_t,
+  ca_proc_<name>_float64_t,
+  ca_proc_<name>_float128_t,
+  NULL, /* ca_proc_<name>_cmplx64_t,  */
+  NULL, /* ca_proc_<name>_cmplx128_t,    */
+  NULL, /* ca_proc_<name>_cmplx256_t,      */
+  NULL, /* ca_proc_<name>_VALUE,      */
+};
 
-	if ( ca_has_mask(ca) ) {
-		ca_create_mask(co);
-	}
+HERE_END
 
-  if ( NIL_P(rmc) ) {
-    mc = ca->elements/co->elements - 1;
-  }
-  else {
-    mc = NUM2SIZE(rmc);
-  }
+puts macro_expand(text, "name" => "describe")
 
-  if ( mc < 0 ) {
-    mc += ca->elements;
-  }
+# --------------------------------------------------------------------------
+#
+# STAT Part 4 (CAStatAccumulator)
+#
+# --------------------------------------------------------------------------
 
-  {
-    ca_size_t idx[CA_RANK_MAX];
-    char *op;
-    boolean8_t *om;
-    int8_t i;
-    for (i=0; i<ca->ndim; i++) {
-      idx[i] = 0;
-    }
-    ca_attach_n(2, ca, co);
-    op = co->ptr;
-    om = ( co->mask && co->mask->ptr ) ? (boolean8_t *)co->mask->ptr : NULL;
-    ca_stat_nd_contig_loop(ca, co, mc, ca_proc, 0, idx, &op, &om);
-    ca_sync(co);
-    ca_detach_n(2, ca, co);
-  }
+text = <<'HERE_END'
 
-  if ( ca_has_mask(co) && ( vfval != CA_NIL ) ) {
-    out = rb_ca_mask_fill_copy(out, vfval);
-  }
+/* ============================= */
+/* ca_proc_moment_push           */
+/* ============================= */
 
-  return out;
-}
+/* updates the running statistics st[i] with the element p[i] (Welford) */
 
 static void
-ca_stat_get_offset_loop (CArray *ca, ca_size_t *dm,
-                        int level, ca_size_t *idx,
-                        int level1, ca_size_t *idx1,
-                        CArray *offset)
+ca_proc_moment_push_<type> (ca_size_t elements, boolean8_t *m, void *ptr,
+                            CAStatMoment *st)
 {
+  <type> *p = (<type> *) ptr;
+  <type> min, max;
+  <atype> x, delta;
   ca_size_t i;
-  if ( level == ca->ndim - 1 ) {
-    if ( dm[level] == 0 ) {
-      idx[level] = 0;
-      *(ca_size_t *)ca_ptr_at_index(offset, idx1) = ca_index2addr(ca, idx);
+  for (i=0; i<elements; i++, st++) {
+    if ( m && m[i] ) {
+      continue;
+    }
+    if ( st->count == 0 ) {
+      memcpy(&st->min, &p[i], sizeof(<type>));
+      memcpy(&st->max, &p[i], sizeof(<type>));
     }
     else {
-      for (i=0; i<ca->dim[level]; i++) {
-        idx[level] = i;
-        idx1[level1] = i;
-        *(ca_size_t *)ca_ptr_at_index(offset, idx1) = ca_index2addr(ca, idx);
+      memcpy(&min, &st->min, sizeof(<type>));
+      memcpy(&max, &st->max, sizeof(<type>));
+      if ( lt_<op_type>(p[i], min) ) {
+        memcpy(&st->min, &p[i], sizeof(<type>));
+      }
+      else if ( gt_<op_type>(p[i], max) ) {
+        memcpy(&st->max, &p[i], sizeof(<type>));
       }
     }
+    x = (<atype>)<dat2type>(p[i]);
+    st->count += 1;
+    delta     = x - st->mean;
+    st->mean += delta / st->count;
+    st->m2   += delta * (x - st->mean);
+    st->sum  += x;
   }
-  else {
-    if ( dm[level] == 0 ) {
-      idx[level] = 0;
-      ca_stat_get_offset_loop(ca, dm, level+1, idx, level1, idx1, offset);
+}
+
+/* ============================= */
+/* ca_proc_moment_merge          */
+/* ============================= */
+
+/* merges the statistics src[i] into st[i] (Chan et al.) */
+
+static void
+ca_proc_moment_merge_<type> (ca_size_t elements, CAStatMoment *src,
+                             CAStatMoment *st)
+{
+  <type> min, max, smin, smax;
+  <atype> delta;
+  ca_size_t i, n;
+  for (i=0; i<elements; i++, src++, st++) {
+    if ( src->count == 0 ) {
+      continue;
     }
-    else {
-      for (i=0; i<ca->dim[level]; i++) {
-        idx[level] = i;
-        idx1[level1] = i;
-        ca_stat_get_offset_loop(ca, dm, level+1, idx, level1+1, idx1, offset);
-      }
+    if ( st->count == 0 ) {
+      *st = *src;
+      continue;
+    }
+    memcpy(&min,  &st->min,  sizeof(<type>));
+    memcpy(&max,  &st->max,  sizeof(<type>));
+    memcpy(&smin, &src->min, sizeof(<type>));
+    memcpy(&smax, &src->max, sizeof(<type>));
+    if ( lt_<op_type>(smin, min) ) {
+      st->min = src->min;
     }
+    if ( gt_<op_type>(smax, max) ) {
+      st->max = src->max;
+    }
+    n = st->count + src->count;
+    delta     = src->mean - st->mean;
+    st->mean += delta * src->count / n;
+    st->m2   += src->m2 + delta * delta * st->count * src->count / n;
+    st->sum  += src->sum;
+    st->count = n;
   }
 }
 
-static VALUE
-rb_ca_stat_nd_discrete (VALUE self, VALUE vaxis, VALUE rmc, VALUE vfval,
-                        int8_t data_type, ca_stat_proc_t *ca_proc)
-{
-  volatile VALUE out;
-  ca_size_t idx[CA_RANK_MAX];
+HERE_END
+
+puts macro_expand(text, TYPEINFO['boolean8_t'])
+puts macro_expand(text, TYPEINFO['int8_t'])
+puts macro_expand(text, TYPEINFO['uint8_t'])
+puts macro_expand(text, TYPEINFO['int16_t'])
+puts macro_expand(text, TYPEINFO['uint16_t'])
+puts macro_expand(text, TYPEINFO['int32_t'])
+puts macro_expand(text, TYPEINFO['uint32_t'])
+puts macro_expand(text, TYPEINFO['int64_t'])
+puts macro_expand(text, TYPEINFO['uint64_t'])
+puts macro_expand(text, TYPEINFO['float32_t'])
+puts macro_expand(text, TYPEINFO['float64_t'])
+puts macro_expand(text, TYPEINFO['float128_t'])
+
+text = <<'HERE_END'
+static ca_stat_proc_t
+ca_proc_<name>[CA_NTYPE] = {
+  NULL,
+  ca_proc_<name>_boolean8_t,
+  ca_proc_<name>_int8_t,
+  ca_proc_<name>_uint8_t,
+  ca_proc_<name>_int16_t,
+  ca_proc_<name>_uint16_t,
+  ca_proc_<name>_int32_t,
+  ca_proc_<name>_uint32_t,
+  ca_proc_<name>_int64_t,
+  ca_proc_<name>_uint64_t,
+  ca_proc_<name>_float32_t,
+  ca_proc_<name>_float64_t,
+  ca_proc_<name>_float128_t,
+  NULL, /* ca_proc_<name>_cmplx64_t,  */
+  NULL, /* ca_proc_<name>_cmplx128_t,    */
+  NULL, /* ca_proc_<name>_cmplx256_t,      */
+  NULL, /* ca_proc_<name>_VALUE,      */
+};
+
+HERE_END
+
+puts macro_expand(text, "name" => "moment_push")
+puts macro_expand(text, "name" => "moment_merge")
+
+# --------------------------------------------------------------------------
+#
+# STAT Part 5 (median, percentile)
+#
+# --------------------------------------------------------------------------
+
+text = <<'HERE_END'
+
+/* ============================= */
+/* ca_stat_select                */
+/* ============================= */
+
+static void
+ca_stat_heapsort_<type> (<type> *a, ca_size_t n)
+{
+  ca_size_t i, j, k;
+  <type> t;
+  for (i=n/2; i-- > 0; ) {
+    for (j=i; (k=2*j+1) < n; j=k) {
+      if ( k+1 < n && <lt>(a[k], a[k+1]) ) {
+        k++;
+      }
+      if ( ! <lt>(a[j], a[k]) ) {
+        break;
+      }
+      t = a[j]; a[j] = a[k]; a[k] = t;
+    }
+  }
+  for (i=n-1; i>0; i--) {
+    t = a[0]; a[0] = a[i]; a[i] = t;
+    for (j=0; (k=2*j+1) < i; j=k) {
+      if ( k+1 < i && <lt>(a[k], a[k+1]) ) {
+        k++;
+      }
+      if ( ! <lt>(a[j], a[k]) ) {
+        break;
+      }
+      t = a[j]; a[j] = a[k]; a[k] = t;
+    }
+  }
+}
+
+/*
+  ca_stat_select_<type>() rearranges a[lo..hi] so that a[k] is the value 
+  at k in the sorted order, a[lo..k-1] <= a[k] and a[k] <= a[k+1..hi] 
+  (introselect). The range is narrowed by quickselect with the median of 
+  three pivots, and falls back to heapsort when the partitions do not 
+  shrink, so the time is O(n) expected and O(n log n) in the worst case.
+*/
+
+static void
+ca_stat_select_<type> (<type> *a, ca_size_t lo, ca_size_t hi, ca_size_t k)
+{
+  ca_size_t i, j, mid, n;
+  int depth = 0;
+  <type> t, pivot;
+  for (n=hi-lo+1; n > 1; n >>= 1) {
+    depth += 2;
+  }
+  while ( hi - lo > 16 ) {
+    if ( depth-- == 0 ) {
+      ca_stat_heapsort_<type>(a + lo, hi - lo + 1);
+      return;
+    }
+    mid = lo + (hi - lo)/2;
+    if ( <lt>(a[mid], a[lo]) ) { t = a[mid]; a[mid] = a[lo]; a[lo] = t; }
+    if ( <lt>(a[hi], a[lo]) )  { t = a[hi];  a[hi]  = a[lo]; a[lo] = t; }
+    if ( <lt>(a[hi], a[mid]) ) { t = a[hi];  a[hi]  = a[mid]; a[mid] = t; }
+    pivot = a[mid];
+    i = lo;
+    j = hi;
+    while ( i <= j ) {
+      while ( <lt>(a[i], pivot) ) {
+        i++;
+      }
+      while ( <lt>(pivot, a[j]) ) {
+        j--;
+      }
+      if ( i <= j ) {
+        t = a[i]; a[i] = a[j]; a[j] = t;
+        i++;
+        j--;
+      }
+    }
+    if ( k <= j ) {
+      hi = j;
+    }
+    else if ( k >= i ) {
+      lo = i;
+    }
+    else {
+      return;
+    }
+  }
+  for (i=lo+1; i<=hi; i++) {
+    t = a[i];
+    for (j=i; j>lo && <lt>(t, a[j-1]); j--) {
+      a[j] = a[j-1];
+    }
+    a[j] = t;
+  }
+}
+
+/* returns the minimum of a[lo..hi] */
+
+static <type>
+ca_stat_select_min_<type> (<type> *a, ca_size_t lo, ca_size_t hi)
+{
+  <type> min = a[lo];
+  ca_size_t i;
+  for (i=lo+1; i<=hi; i++) {
+    if ( <lt>(a[i], min) ) {
+      min = a[i];
+    }
+  }
+  return min;
+}
+
+/* copies the valid elements into buf, returns the number of them */
+
+static ca_size_t
+ca_stat_gather_<type> (ca_size_t elements, boolean8_t *m, <type> *p, 
+                       CAStatIterator *it, <type> *buf)
+{
+  ca_size_t *a = (ca_size_t *) it;
+  ca_size_t i, n = 0;
+  iterator_rewind(it);
+  for (i=0; i<elements; i++) {
+    if ( ! ( m && *(m + *a) ) ) {
+      buf[n++] = *(p + *a);
+    }
+    iterator_succ(it);
+  }
+  return n;
+}
+
+/* ============================= */
+/* ca_proc_median                */
+/* ============================= */
+
+static void
+ca_proc_median_<type> (ca_size_t elements, ca_size_t min_count,
+                       boolean8_t *m, void *ptr, CAStatIterator *it,
+                       int return_object, VALUE *retobj,
+                       boolean8_t *retmask, float64_t *retval)
+{
+  <type> sbuf[CA_SELECT_BUFSIZE];
+  <type> *buf = ( elements > CA_SELECT_BUFSIZE ) ? 
+                      ALLOC_N(<type>, elements) : sbuf;
+  <atype> med = <azero>;
+  ca_size_t n, k;
+  n = ca_stat_gather_<type>(elements, m, (<type> *) ptr, it, buf);
+  if ( n > 0 ) {
+    k = (n-1)/2;
+    ca_stat_select_<type>(buf, 0, n-1, k);
+    if ( n % 2 ) {
+      med = (<atype>)<dat2type>(buf[k]);
+    }
+    else {
+      med = ( (<atype>)<dat2type>(buf[k]) + 
+              (<atype>)<dat2type>(ca_stat_select_min_<type>(buf, k+1, n-1)) )/2;
+    }
+  }
+  if ( buf != sbuf ) {
+    xfree(buf);
+  }
+  if ( return_object ) {
+    *retobj = ( elements - n > min_count || n == 0 ) ? CA_UNDEF : <atype2obj>(med);
+  }
+  else {
+    if ( retmask ) {
+      *retmask = ( elements - n > min_count || n == 0 ) ? 1 : 0;
+    }
+    *retval = <type2dbl>(med);
+  }
+}
+
+/* ============================= */
+/* ca_proc_percentile            */
+/* ============================= */
+
+/* selects the sorted ranks[0...nr] in a[lo..hi] (lo <= ranks[i] <= hi),
+   the middle rank first, and the ranks on each side in the sub-ranges */
+
+static void
+ca_stat_multiselect_<type> (<type> *a, ca_size_t lo, ca_size_t hi,
+                            ca_size_t *ranks, int nr)
+{
+  int mid;
+  ca_size_t k;
+  while ( nr > 0 ) {
+    mid = nr/2;
+    k = ranks[mid];
+    ca_stat_select_<type>(a, lo, hi, k);
+    if ( mid > 0 && k > lo ) {
+      ca_stat_multiselect_<type>(a, lo, k-1, ranks, mid);
+    }
+    ranks += mid + 1;
+    nr    -= mid + 1;
+    lo     = k + 1;
+  }
+}
+
+/*
+  The percentiles in ca_stat_percentile_spec are computed from one buffer.
+  The ranks needed for all percentiles (and the next ranks for the 
+  interpolation) are selected by ca_stat_multiselect_<type>(), so the 
+  buffer is partitioned only partially. retval is an array of 
+  ca_stat_percentile_spec.n values.
+*/
+
+static void
+ca_proc_percentile_<type> (ca_size_t elements, ca_size_t min_count,
+                           boolean8_t *m, void *ptr, CAStatIterator *it,
+                           int return_object, VALUE *retobj,
+                           boolean8_t *retmask, float64_t *retval)
+{
+  CAStatPercentileSpec *spec = &ca_stat_percentile_spec;
+  <type> sbuf[CA_SELECT_BUFSIZE];
+  <type> *buf = ( elements > CA_SELECT_BUFSIZE ) ? 
+                      ALLOC_N(<type>, elements) : sbuf;
+  ca_size_t *ranks = ALLOCA_N(ca_size_t, 2*spec->n + 1);
+  <atype> x0, x1;
+  float64_t per, f, r;
+  ca_size_t n, k;
+  int i, q, nr = 0;
+  n = ca_stat_gather_<type>(elements, m, (<type> *) ptr, it, buf);
+  for (q=0; q<spec->n && n > 0; q++) {
+    per = spec->per[spec->order[q]];
+    if ( ! ( per >= 0 && per <= 100 ) ) {
+      continue;
+    }
+    k = (ca_size_t) floor((n-1)*per/100.0);
+    if ( nr == 0 || ranks[nr-1] < k ) {
+      ranks[nr++] = k;
+    }
+    if ( k+1 < n && ranks[nr-1] < k+1 ) {
+      ranks[nr++] = k+1;
+    }
+  }
+  ca_stat_multiselect_<type>(buf, 0, n-1, ranks, nr);
+  for (i=0; i<spec->n; i++) {
+    per = spec->per[i];
+    if ( n == 0 || ! ( per >= 0 && per <= 100 ) ) {
+      retval[i] = NAN;
+      continue;
+    }
+    f = (n-1)*per/100.0;
+    k = (ca_size_t) floor(f);
+    r = f - k;
+    x0 = (<atype>)<dat2type>(buf[k]);
+    if ( r > 0 && k+1 < n ) {
+      x1 = (<atype>)<dat2type>(buf[k+1]);
+      retval[i] = (float64_t) ((1-r)*x0 + r*x1);
+    }
+    else {
+      retval[i] = (float64_t) x0;
+    }
+  }
+  if ( buf != sbuf ) {
+    xfree(buf);
+  }
+  if ( retmask ) {
+    *retmask = ( elements - n > min_count || n == 0 ) ? 1 : 0;
+  }
+}
+
+HERE_END
+
+# NaN is placed after all numbers in the selection of float types
+
+puts macro_expand(text, TYPEINFO['boolean8_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['int8_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['uint8_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['int16_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['uint16_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['int32_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['uint32_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['int64_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['uint64_t'].merge('lt' => 'lt_c'))
+puts macro_expand(text, TYPEINFO['float32_t'].merge('lt' => 'lt_nan'))
+puts macro_expand(text, TYPEINFO['float64_t'].merge('lt' => 'lt_nan'))
+puts macro_expand(text, TYPEINFO['float128_t'].merge('lt' => 'lt_nan'))
+
+text = <<'HERE_END'
+static ca_stat_proc_t
+ca_proc_<name>[CA_NTYPE] = {
+  NULL,
+  ca_proc_<name>_boolean8_t,
+  ca_proc_<name>_int8_t,
+  ca_proc_<name>_uint8_t,
+  ca_proc_<name>_int16_t,
+  ca_proc_<name>_uint16_t,
+  ca_proc_<name>_int32_t,
+  ca_proc_<name>_uint32_t,
+  ca_proc_<name>_int64_t,
+  ca_proc_<name>_uint64_t,
+  ca_proc_<name>_float32_t,
+  ca_proc_<name>_float64_t,
+  ca_proc_<name>_float128_t,
+  NULL, /* ca_proc_<name>_cmplx64_t,  */
+  NULL, /* ca_proc_<name>_cmplx128_t,    */
+  NULL, /* ca_proc_<name>_cmplx256_t,      */
+  NULL, /* ca_proc_<name>_VALUE,      */
+};
+
+HERE_END
+
+puts macro_expand(text, "name" => "median")
+puts macro_expand(text, "name" => "percentile")
+
+# --------------------------------------------------------------------------
+#
+# STAT Part 6 (nlargest, nsmallest)
+#
+# --------------------------------------------------------------------------
+
+text = <<'HERE_END'
+
+/* ============================= */
+/* ca_proc_topk                  */
+/* ============================= */
+
+/* true if (x, ix) should be placed after (y, iy) in the result. 
+   The earlier element is preferred for the same values. NaN is placed 
+   after all numbers for both of the directions, so that it is skipped 
+   by nlargest as by max_addr. */
+
+#define ca_topk_worse_<type>(dir, x, ix, y, iy)                   \
+  ( ( <nan>(x) != <nan>(y) ) ? <nan>(x) :                          \
+    ( (dir) > 0 ) ? ( <lt>((x), (y)) || ( ! <lt>((y), (x)) && (ix) > (iy) ) ) \
+                  : ( <lt>((y), (x)) || ( ! <lt>((x), (y)) && (ix) > (iy) ) ) )
+
+/* sifts down v[j] in the heap v[0..n-1] with the worst entry at the top */
+
+static void
+ca_topk_sift_<type> (<type> *v, ca_size_t *ix, ca_size_t n, ca_size_t j, 
+                     int dir)
+{
+  <type> t;
+  ca_size_t c, s;
+  while ( (c = 2*j+1) < n ) {
+    if ( c+1 < n && ca_topk_worse_<type>(dir, v[c+1], ix[c+1], v[c], ix[c]) ) {
+      c++;
+    }
+    if ( ! ca_topk_worse_<type>(dir, v[c], ix[c], v[j], ix[j]) ) {
+      break;
+    }
+    t = v[j]; v[j] = v[c]; v[c] = t;
+    s = ix[j]; ix[j] = ix[c]; ix[c] = s;
+    j = c;
+  }
+}
+
+/* sorts v[0..n-1] from the best (heapsort) */
+
+static void
+ca_topk_sort_<type> (<type> *v, ca_size_t *ix, ca_size_t n, int dir)
+{
+  <type> t;
+  ca_size_t s, j;
+  for (j=n/2; j-- > 0; ) {
+    ca_topk_sift_<type>(v, ix, n, j, dir);
+  }
+  for (j=n; j-- > 1; ) {
+    t = v[0]; v[0] = v[j]; v[j] = t;
+    s = ix[0]; ix[0] = ix[j]; ix[j] = s;
+    ca_topk_sift_<type>(v, ix, j, 0, dir);
+  }
+}
+
+/* rearranges v[lo..hi] so that the k-th best entry is at k, and the better 
+   entries are before it (quickselect falling back to heapsort) */
+
+static void
+ca_topk_select_<type> (<type> *v, ca_size_t *ix, 
+                       ca_size_t lo, ca_size_t hi, ca_size_t k, int dir)
+{
+  ca_size_t i, j, mid, n, ip, s;
+  int depth = 0;
+  <type> t, pv;
+  for (n=hi-lo+1; n > 1; n >>= 1) {
+    depth += 2;
+  }
+  while ( hi > lo ) {
+    if ( depth-- == 0 ) {
+      ca_topk_sort_<type>(v + lo, ix + lo, hi - lo + 1, dir);
+      return;
+    }
+    mid = lo + (hi - lo)/2;
+    pv = v[mid]; ip = ix[mid];
+    v[mid] = v[hi]; ix[mid] = ix[hi];
+    v[hi] = pv; ix[hi] = ip;
+    for (i=j=lo; j<hi; j++) {
+      if ( ca_topk_worse_<type>(dir, pv, ip, v[j], ix[j]) ) {
+        t = v[i]; v[i] = v[j]; v[j] = t;
+        s = ix[i]; ix[i] = ix[j]; ix[j] = s;
+        i++;
+      }
+    }
+    v[hi] = v[i]; ix[hi] = ix[i];
+    v[i] = pv; ix[i] = ip;
+    if ( k < i ) {
+      hi = i - 1;
+    }
+    else if ( k > i ) {
+      lo = i + 1;
+    }
+    else {
+      return;
+    }
+  }
+}
+
+/*
+  ca_proc_topk_<type>() collects the candidates into a buffer of 2k 
+  entries. When the buffer is full, the k best entries are selected and 
+  the k-th best one becomes the threshold, so that most of the elements 
+  are rejected by one comparison with the threshold. The time is O(n) 
+  even for the sorted data, and the memory is O(k).
+*/
+
+static void
+ca_proc_topk_<type> (ca_size_t elements, ca_size_t min_count,
+                     boolean8_t *m, void *ptr, CAStatIterator *it,
+                     int return_object, VALUE *retobj,
+                     boolean8_t *retmask, char *retval)
+{
+  CAStatTopKSpec *spec = &ca_stat_topk_spec;
+  ca_size_t k = spec->k;
+  int dir = spec->dir;
+  <type> *p = (<type> *) ptr;
+  ca_size_t *a = (ca_size_t *) it;
+  ca_size_t *raddr = (ca_size_t *) retval;
+  char *rval = retval + k * sizeof(ca_size_t);
+  ca_size_t nbuf = ( k > 0 ) ? 2*k : 0;
+  <type> *v = ALLOC_N(<type>, nbuf + 1);
+  ca_size_t *ix = ALLOC_N(ca_size_t, nbuf + 1);
+  <type> x, thr = <zero>;
+  int has_thr = 0;
+  ca_size_t n = 0, i, j;
+  iterator_rewind(it);
+  for (i=0; i<elements && k > 0; i++) {
+    if ( ! ( m && *(m + *a) ) ) {
+      x = *(p + *a);
+      if ( ! has_thr || ca_topk_worse_<type>(dir, thr, i, x, i) ) {
+        v[n]  = x;
+        ix[n] = i;
+        n++;
+        if ( n == nbuf ) {
+          ca_topk_select_<type>(v, ix, 0, n-1, k-1, dir);
+          thr = v[k-1];
+          has_thr = 1;
+          n = k;
+        }
+      }
+    }
+    iterator_succ(it);
+  }
+  if ( n > k ) {
+    ca_topk_select_<type>(v, ix, 0, n-1, k-1, dir);
+    n = k;
+  }
+  if ( spec->sorted ) {
+    ca_topk_sort_<type>(v, ix, n, dir);
+  }
+  for (j=0; j<k; j++) {
+    if ( j < n ) {
+      raddr[j] = ix[j];
+      memcpy(rval + j * sizeof(<type>), &v[j], sizeof(<type>));
+    }
+    else {
+      raddr[j] = -1;
+      memset(rval + j * sizeof(<type>), 0, sizeof(<type>));
+    }
+  }
+  xfree(v);
+  xfree(ix);
+  if ( retmask ) {
+    *retmask = 0;
+  }
+}
+
+HERE_END
+
+
+puts macro_expand(text, TYPEINFO['boolean8_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['int8_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['uint8_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['int16_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['uint16_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['int32_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['uint32_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['int64_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['uint64_t'].merge('lt' => 'lt_c', 'nan' => 'nan_c'))
+puts macro_expand(text, TYPEINFO['float32_t'].merge('lt' => 'lt_c', 'nan' => 'nan_f'))
+puts macro_expand(text, TYPEINFO['float64_t'].merge('lt' => 'lt_c', 'nan' => 'nan_f'))
+puts macro_expand(text, TYPEINFO['float128_t'].merge('lt' => 'lt_c', 'nan' => 'nan_f'))
+puts macro_expand(text, TYPEINFO['VALUE'].merge('lt' => 'lt_VALUE', 'nan' => 'nan_c'))
+
+text = <<'HERE_END'
+static ca_stat_proc_t
+ca_proc_<name>[CA_NTYPE] = {
+  NULL,
+  ca_proc_<name>_boolean8_t,
+  ca_proc_<name>_int8_t,
+  ca_proc_<name>_uint8_t,
+  ca_proc_<name>_int16_t,
+  ca_proc_<name>_uint16_t,
+  ca_proc_<name>_int32_t,
+  ca_proc_<name>_uint32_t,
+  ca_proc_<name>_int64_t,
+  ca_proc_<name>_uint64_t,
+  ca_proc_<name>_float32_t,
+  ca_proc_<name>_float64_t,
+  ca_proc_<name>_float128_t,
+  NULL, /* ca_proc_<name>_cmplx64_t,  */
+  NULL, /* ca_proc_<name>_cmplx128_t,    */
+  NULL, /* ca_proc_<name>_cmplx256_t,      */
+  ca_proc_<name>_VALUE,
+};
+
+HERE_END
+
+puts macro_expand(text, "name" => "topk")
+
+# --------------------------------------------------------------------------
+#
+# STAT Part 7 (group_reduce)
+#
+# --------------------------------------------------------------------------
+
+text = <<'HERE_END'
+
+/* ============================= */
+/* ca_proc_group                 */
+/* ============================= */
+
+/* accumulates p[i] into st[code[i]], skipping the elements with negative 
+   code or masked by m. Only the fields used by op are updated. */
+
+static void
+ca_proc_group_<type> (ca_size_t elements, boolean8_t *m, void *ptr,
+                      ca_size_t *code, int op, CAStatMoment *st)
+{
+  <type> *p = (<type> *) ptr;
+  <type> v;
+  CAStatMoment *s;
+  ca_size_t i;
+  switch ( op ) {
+  case CA_GROUP_MIN:
+    for (i=0; i<elements; i++) {
+      if ( code[i] < 0 || ( m && m[i] ) ) {
+        continue;
+      }
+      s = st + code[i];
+      if ( s->count ) {
+        memcpy(&v, &s->min, sizeof(<type>));
+      }
+      if ( s->count == 0 || lt_<op_type>(p[i], v) ) {
+        memcpy(&s->min, &p[i], sizeof(<type>));
+      }
+      s->count += 1;
+    }
+    break;
+  case CA_GROUP_MAX:
+    for (i=0; i<elements; i++) {
+      if ( code[i] < 0 || ( m && m[i] ) ) {
+        continue;
+      }
+      s = st + code[i];
+      if ( s->count ) {
+        memcpy(&v, &s->max, sizeof(<type>));
+      }
+      if ( s->count == 0 || gt_<op_type>(p[i], v) ) {
+        memcpy(&s->max, &p[i], sizeof(<type>));
+      }
+      s->count += 1;
+    }
+    break;
+  default:
+    for (i=0; i<elements; i++) {
+      if ( code[i] < 0 || ( m && m[i] ) ) {
+        continue;
+      }
+      s = st + code[i];
+      s->count += 1;
+      s->sum   += (<atype>)<dat2type>(p[i]);
+    }
+    break;
+  }
+}
+
+HERE_END
+
+puts macro_expand(text, TYPEINFO['boolean8_t'])
+puts macro_expand(text, TYPEINFO['int8_t'])
+puts macro_expand(text, TYPEINFO['uint8_t'])
+puts macro_expand(text, TYPEINFO['int16_t'])
+puts macro_expand(text, TYPEINFO['uint16_t'])
+puts macro_expand(text, TYPEINFO['int32_t'])
+puts macro_expand(text, TYPEINFO['uint32_t'])
+puts macro_expand(text, TYPEINFO['int64_t'])
+puts macro_expand(text, TYPEINFO['uint64_t'])
+puts macro_expand(text, TYPEINFO['float32_t'])
+puts macro_expand(text, TYPEINFO['float64_t'])
+puts macro_expand(text, TYPEINFO['float128_t'])
+
+text = <<'HERE_END'
+
+/* ============================= */
+/* ca_proc_group_dense           */
+/* ============================= */
+
+/* codes the valid keys k[i] by their rank in the keys present, when 
+   the range of the keys is small (see CA_GROUP_DENSE_MAX). Returns the 
+   keys present in ascending order, or Qnil for the range too large. */
+
+static VALUE
+ca_proc_group_dense_<type> (CArray *ck, boolean8_t *mk, ca_size_t *code,
+                            ca_size_t *ngroup)
+{
+  volatile VALUE out;
+  CArray *co;
+  <type> *k = (<type> *) ck->ptr;
+  <type> *g;
+  <type> min = 0, max = 0;
+  uint64_t range;
+  ca_size_t *map;
+  ca_size_t i, j, n, valid = 0;
+  for (i=0; i<ck->elements; i++) {
+    if ( mk && mk[i] ) {
+      continue;
+    }
+    if ( ! valid ) {
+      min = max = k[i];
+      valid = 1;
+    }
+    else if ( k[i] < min ) {
+      min = k[i];
+    }
+    else if ( k[i] > max ) {
+      max = k[i];
+    }
+  }
+  range = ( valid ) ? (uint64_t) max - (uint64_t) min + 1 : 0;
+  if ( ( valid && range == 0 ) || 
+       range > (uint64_t) CA_GROUP_DENSE_MAX(ck->elements) ) {
+    return Qnil;
+  }
+  map = malloc_with_check(sizeof(ca_size_t)*(range+1));
+  memset(map, 0, sizeof(ca_size_t)*range);
+  for (i=0; i<ck->elements; i++) {
+    if ( ! ( mk && mk[i] ) ) {
+      map[(uint64_t) k[i] - (uint64_t) min] = 1;
+    }
+  }
+  for (j=0, n=0; j<(ca_size_t) range; j++) {
+    map[j] = ( map[j] ) ? n++ : -1;
+  }
+  out = rb_carray_new(ck->data_type, 1, &n, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+  g = (<type> *) co->ptr;
+  for (j=0; j<(ca_size_t) range; j++) {
+    if ( map[j] >= 0 ) {
+      g[map[j]] = (<type>) ((uint64_t) min + j);
+    }
+  }
+  for (i=0; i<ck->elements; i++) {
+    code[i] = ( mk && mk[i] ) ? -1 : map[(uint64_t) k[i] - (uint64_t) min];
+  }
+  free(map);
+  *ngroup = n;
+  return out;
+}
+
+HERE_END
+
+puts macro_expand(text, TYPEINFO['boolean8_t'])
+puts macro_expand(text, TYPEINFO['int8_t'])
+puts macro_expand(text, TYPEINFO['uint8_t'])
+puts macro_expand(text, TYPEINFO['int16_t'])
+puts macro_expand(text, TYPEINFO['uint16_t'])
+puts macro_expand(text, TYPEINFO['int32_t'])
+puts macro_expand(text, TYPEINFO['uint32_t'])
+puts macro_expand(text, TYPEINFO['int64_t'])
+puts macro_expand(text, TYPEINFO['uint64_t'])
+
+text = <<'HERE_END'
+static ca_stat_proc_t
+ca_proc_group[CA_NTYPE] = {
+  NULL,
+  ca_proc_group_boolean8_t,
+  ca_proc_group_int8_t,
+  ca_proc_group_uint8_t,
+  ca_proc_group_int16_t,
+  ca_proc_group_uint16_t,
+  ca_proc_group_int32_t,
+  ca_proc_group_uint32_t,
+  ca_proc_group_int64_t,
+  ca_proc_group_uint64_t,
+  ca_proc_group_float32_t,
+  ca_proc_group_float64_t,
+  ca_proc_group_float128_t,
+  NULL, /* ca_proc_group_cmplx64_t,  */
+  NULL, /* ca_proc_group_cmplx128_t,    */
+  NULL, /* ca_proc_group_cmplx256_t,      */
+  NULL, /* ca_proc_group_VALUE,      */
+};
+
+static ca_group_dense_t
+ca_proc_group_dense[CA_NTYPE] = {
+  NULL,
+  ca_proc_group_dense_boolean8_t,
+  ca_proc_group_dense_int8_t,
+  ca_proc_group_dense_uint8_t,
+  ca_proc_group_dense_int16_t,
+  ca_proc_group_dense_uint16_t,
+  ca_proc_group_dense_int32_t,
+  ca_proc_group_dense_uint32_t,
+  ca_proc_group_dense_int64_t,
+  ca_proc_group_dense_uint64_t,
+  NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+};
+
+HERE_END
+
+puts text
+
+# --------------------------------------------------------------------------
+#
+# METHOD DEFINITIONS (after __END__)
+#
+# --------------------------------------------------------------------------
+
+puts DATA.read
+
+__END__
+
+static VALUE
+rb_ca_stat_1d (VALUE self, VALUE rmc, VALUE vfval,
+               ca_stat_proc_t *ca_proc)
+{
+  volatile VALUE out;
+  CArray *ca;
+  CAStatIterator it;
+  boolean8_t *m;
+  ca_size_t mc;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
+  }
+
+  if ( ca->elements == 0 ) {
+    out = CA_UNDEF;
+  }
+  else {
+    ca_attach(ca);
+    m = ca_mask_ptr_any(ca);
+    mc = ( ( ! ca_has_mask(ca) ) || NIL_P(rmc)) ? ca->elements - 1 : NUM2SIZE(rmc);
+    if ( mc < 0 ) {
+      mc += ca->elements;
+    }
+    it.step = 0;
+    ca_proc[ca->data_type](ca->elements, mc, m, ca->ptr, &it, 1, &out, NULL, NULL);
+    ca_detach(ca);
+  }
+
+  if ( out == CA_UNDEF && ( vfval != CA_NIL ) ) {
+    out = vfval;
+  }
+
+  return out;
+}
+
+static void
+ca_stat_nd_contig_loop (CArray *ca, CArray *co, ca_size_t mc,
+                        ca_stat_proc_t *ca_proc,
+                        int level, ca_size_t *idx, char **op, boolean8_t **om)
+{
+  void *p;
+  boolean8_t *m;
+  ca_size_t i, n;
+  if ( level == co->ndim ) {
+    CAStatIterator it;
+    n = ca->elements/co->elements;
+    idx[level] = 0;
+    p = ca_ptr_at_index(ca, idx);
+    m = ( ca->mask && ca->mask->ptr ) ?
+                          (boolean8_t *)ca_ptr_at_index(ca->mask, idx) : NULL;
+		it.step = 0;
+    ca_proc[ca->data_type](n, mc, m, p, &it, 0, NULL, *om, *op);
+    if ( *om ) {
+      *om += 1;
+    }
+    *op += co->bytes;
+  }
+  else {
+    for (i=0; i<ca->dim[level]; i++) {
+      idx[level] = i;
+      ca_stat_nd_contig_loop(ca, co, mc, ca_proc, level+1, idx, op, om);
+    }
+  }
+}
+
+static VALUE
+rb_ca_stat_nd_contig (VALUE self, VALUE vaxis, VALUE rmc, VALUE vfval,
+                      int8_t data_type, ca_size_t bytes, 
+                      ca_stat_proc_t *ca_proc)
+{
+  volatile VALUE out;
+  CArray *ca, *co;
+  ca_size_t mc, ndim;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
+  }
+
+  ndim = ca->ndim - RARRAY_LEN(vaxis);
+  if ( ndim <= 0 || ndim > ca->ndim ) {
+    rb_raise(rb_eRuntimeError, "invalid dimension specified");
+  }
+
+  out = rb_carray_new(data_type, ndim, ca->dim, bytes, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+	if ( ca_has_mask(ca) ) {
+		ca_create_mask(co);
+	}
+
+  if ( NIL_P(rmc) ) {
+    mc = ca->elements/co->elements - 1;
+  }
+  else {
+    mc = NUM2SIZE(rmc);
+  }
+
+  if ( mc < 0 ) {
+    mc += ca->elements;
+  }
+
+  {
+    ca_size_t idx[CA_RANK_MAX];
+    char *op;
+    boolean8_t *om;
+    int8_t i;
+    for (i=0; i<ca->ndim; i++) {
+      idx[i] = 0;
+    }
+    ca_attach_n(2, ca, co);
+    op = co->ptr;
+    om = ( co->mask && co->mask->ptr ) ? (boolean8_t *)co->mask->ptr : NULL;
+    ca_stat_nd_contig_loop(ca, co, mc, ca_proc, 0, idx, &op, &om);
+    ca_sync(co);
+    ca_detach_n(2, ca, co);
+  }
+
+  if ( ca_has_mask(co) && ( vfval != CA_NIL ) ) {
+    out = rb_ca_mask_fill_copy(out, vfval);
+  }
+
+  return out;
+}
+
+static void
+ca_stat_get_offset_loop (CArray *ca, ca_size_t *dm,
+                        int level, ca_size_t *idx,
+                        int level1, ca_size_t *idx1,
+                        CArray *offset)
+{
+  ca_size_t i;
+  if ( level == ca->ndim - 1 ) {
+    if ( dm[level] == 0 ) {
+      idx[level] = 0;
+      *(ca_size_t *)ca_ptr_at_index(offset, idx1) = ca_index2addr(ca, idx);
+    }
+    else {
+      for (i=0; i<ca->dim[level]; i++) {
+        idx[level] = i;
+        idx1[level1] = i;
+        *(ca_size_t *)ca_ptr_at_index(offset, idx1) = ca_index2addr(ca, idx);
+      }
+    }
+  }
+  else {
+    if ( dm[level] == 0 ) {
+      idx[level] = 0;
+      ca_stat_get_offset_loop(ca, dm, level+1, idx, level1, idx1, offset);
+    }
+    else {
+      for (i=0; i<ca->dim[level]; i++) {
+        idx[level] = i;
+        idx1[level1] = i;
+        ca_stat_get_offset_loop(ca, dm, level+1, idx, level1+1, idx1, offset);
+      }
+    }
+  }
+}
+
+static VALUE
+rb_ca_stat_nd_discrete (VALUE self, VALUE vaxis, VALUE rmc, VALUE vfval,
+                        int8_t data_type, ca_size_t bytes, 
+                        ca_stat_proc_t *ca_proc)
+{
+  volatile VALUE out;
+  ca_size_t idx[CA_RANK_MAX];
   ca_size_t idx1[CA_RANK_MAX];
   ca_size_t out_dim[CA_RANK_MAX];
   ca_size_t loop_dim[CA_RANK_MAX];
@@ -1517,451 +2606,1783 @@ rb_ca_stat_nd_discrete (VALUE self, VALUE vaxis, VALUE rmc, VALUE vfval,
 
   TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
 
-  for (i=0; i<ca->ndim; i++) {
-    dm[i] = 0;
-    dn[i] = 1;
+  for (i=0; i<ca->ndim; i++) {
+    dm[i] = 0;
+    dn[i] = 1;
+  }
+
+  for (i=0; i<RARRAY_LEN(vaxis); i++) {
+    k = NUM2SIZE(rb_ary_entry(vaxis, i));
+    dm[k] = 1;
+    dn[k] = 0;
+  }
+
+  out_ndim  = 0;
+  loop_ndim = 0;
+  for (i=0; i<ca->ndim; i++) {
+    if ( dm[i] ) {
+      loop_dim[loop_ndim] = ca->dim[i];
+      loop_ndim += 1;
+    }
+    else {
+      out_dim[out_ndim] = ca->dim[i];
+      out_ndim += 1;
+    }
+  }
+
+  out    = rb_carray_new(data_type, out_ndim, out_dim, bytes, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+  
+  first  = carray_new(CA_SIZE, out_ndim, out_dim, 0, NULL);
+  first->ptr = realloc(first->ptr, first->bytes*(first->elements+1));
+
+  offset = carray_new(CA_SIZE, loop_ndim, loop_dim, 0, NULL);
+  offset->ptr = realloc(offset->ptr, offset->bytes*(offset->elements+1));
+
+  ca_stat_get_offset_loop(ca, dn, 0, idx, 0, idx1, first);
+  ca_stat_get_offset_loop(ca, dm, 0, idx, 0, idx1, offset);
+
+	if ( ca_has_mask(ca) ) {
+		ca_create_mask(co);
+	}
+
+  if ( NIL_P(rmc) ) {
+    mc = offset->elements - 1;
+  }
+  else {
+    mc = NUM2SIZE(rmc);
+  }
+
+  if ( mc < 0 ) {
+    mc += offset->elements;
+  }
+
+  ca_attach_n(2, ca, co);
+
+  {
+    CAStatIterator it, jt;
+    ca_size_t *a = (ca_size_t *) (&it);
+    boolean8_t *m0, *m, *om;
+    char *p, *op;
+
+    it.step = 1;
+    it.addr = (ca_size_t *)first->ptr;
+    jt.step = 1;
+    jt.addr = (ca_size_t *)offset->ptr;
+
+    m0 = ( ca->mask && ca->mask->ptr ) ? (boolean8_t *)ca->mask->ptr : NULL;
+    om = ( co->mask && co->mask->ptr ) ? (boolean8_t *)co->mask->ptr : NULL;
+    op = co->ptr;
+
+    iterator_rewind(&it);
+    for (i=0; i<co->elements; i++) {
+      m = ( m0 ) ? m0 + (*a) : NULL;
+      p = ca->ptr + (*a) * ca->bytes;
+      ca_proc[ca->data_type](offset->elements, mc, m, p, &jt, 0, NULL, om, op);
+      if ( om ) {
+        om += 1;
+      }
+      op += co->bytes;
+      iterator_succ(&it);
+    }
+  }
+
+  ca_sync(co);
+  ca_detach_n(2, ca, co);
+
+  if ( ca_has_mask(co) && ( vfval != CA_NIL ) ) {
+    out = rb_ca_mask_fill_copy(out, vfval);
+  }
+
+  ca_free(first);
+  ca_free(offset);
+
+  return out;
+}
+
+/* parses the arguments (axis..., mask_limit:, fill_value:, min_count:) 
+   common to the statistical methods, returns the sorted axes or nil */
+
+static VALUE
+rb_ca_stat_scan_args (int argc, VALUE *argv, VALUE self, 
+                      VALUE *rmc, VALUE *vfval)
+{
+  volatile VALUE ropt, rmask_limit = Qnil, rmin_count = Qnil, vaxis;
+  CArray *ca;
+  ca_size_t i, k;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  *vfval = CA_NIL;
+
+  ropt = rb_pop_options(&argc, &argv);
+  rb_scan_options(ropt,
+                  "mask_limit,fill_value,min_count",
+                  &rmask_limit, vfval, &rmin_count);
+
+  if ( ( ! NIL_P(rmask_limit) ) && ( ! NIL_P(rmin_count) ) ) {
+    rb_raise(rb_eArgError,
+             "don't specify mask_limit and min_count simaltaniously");
+  }
+  else if ( ! NIL_P(rmin_count) ) {
+    ca_size_t min_count = NUM2SIZE(rmin_count);
+    if ( min_count == 0 ) {
+      *rmc = Qnil;
+    }
+    else {
+      *rmc = SIZE2NUM(-min_count);
+    }
+  }
+  else if ( ! NIL_P(rmask_limit) ) {
+    ca_size_t mask_limit = NUM2SIZE(rmask_limit);
+    if ( mask_limit == 0 ) {
+      *rmc = Qnil;
+    }
+    else {
+      *rmc = SIZE2NUM(mask_limit-1);
+    }
+  }
+  else {
+    *rmc = Qnil;
+  }
+
+  if ( argc > 0 ) {
+    vaxis = rb_ary_new4(argc, argv);
+    for (i=0; i<RARRAY_LEN(vaxis); i++) {
+      k = NUM2SIZE(rb_ary_entry(vaxis, i));
+      CA_CHECK_INDEX(k, ca->ndim);
+      rb_ary_store(vaxis, i, SIZE2NUM(k));
+    }
+    vaxis = rb_funcall(vaxis, rb_intern("sort"), 0);
+    vaxis = rb_funcall(vaxis, rb_intern("uniq"), 0);
+  }
+  else {
+    vaxis = Qnil;
+  }
+
+  return vaxis;
+}
+
+/* returns 1 if the sorted axes are the last dimensions of the array */
+
+static int
+ca_stat_axis_is_contig (CArray *ca, VALUE vaxis)
+{
+  ca_size_t i, k;
+  for (i=0; i<RARRAY_LEN(vaxis); i++) {
+    k = NUM2SIZE(rb_ary_entry(vaxis, RARRAY_LEN(vaxis)-1-i));
+    if ( k != ca->ndim-1-i ) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static VALUE
+rb_ca_stat_general (int argc, VALUE *argv, VALUE self,
+                    int8_t data_type, ca_stat_proc_t *ca_proc)
+{
+  volatile VALUE rmc, vfval, vaxis;
+  CArray *ca;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  vaxis = rb_ca_stat_scan_args(argc, argv, self, (VALUE *) &rmc, (VALUE *) &vfval);
+
+  if ( NIL_P(vaxis) ) {
+    return rb_ca_stat_1d(self, rmc, vfval, ca_proc);
+  }
+  else if ( ca_stat_axis_is_contig(ca, vaxis) ) {
+    if ( RARRAY_LEN(vaxis) == ca->ndim ) {
+      return rb_ca_stat_1d(self, rmc, vfval, ca_proc);
+    }
+    else {
+      return rb_ca_stat_nd_contig(self, vaxis, rmc, vfval,
+                                  data_type, 0, ca_proc);
+    }
+  }
+  else {
+    return rb_ca_stat_nd_discrete(self, vaxis, rmc, vfval,
+                                  data_type, 0, ca_proc);
+  }
+}
+
+
+static VALUE
+rb_ca_prod (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_prod);
+}
+
+static VALUE
+rb_ca_count (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_INT32, ca_proc_count);
+}
+
+static VALUE
+rb_ca_sum (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_sum);
+}
+
+static VALUE
+rb_ca_mean (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_mean);
+}
+
+static VALUE
+rb_ca_variancep (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_variancep);
+}
+
+static VALUE
+rb_ca_stddevp (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_stddevp);
+}
+
+static VALUE
+rb_ca_variance (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_variance);
+}
+
+static VALUE
+rb_ca_stddev (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_stddev);
+}
+
+static VALUE
+rb_ca_min (int argc, VALUE *argv, VALUE self)
+{
+  CArray *ca;
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  return rb_ca_stat_general(argc, argv, self, ca->data_type, ca_proc_min);
+}
+
+static VALUE
+rb_ca_min_addr (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_INT32, ca_proc_min_addr);
+}
+
+static VALUE
+rb_ca_max (int argc, VALUE *argv, VALUE self)
+{
+  CArray *ca;
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  return rb_ca_stat_general(argc, argv, self, ca->data_type, ca_proc_max);
+}
+
+static VALUE
+rb_ca_max_addr (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_INT32, ca_proc_max_addr);
+}
+
+static VALUE
+rb_ca_accum (int argc, VALUE *argv, VALUE self)
+{
+  CArray *ca;
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  return rb_ca_stat_general(argc, argv, self, ca->data_type, ca_proc_accum);
+}
+
+static VALUE
+rb_ca_stat_type2 (int argc, VALUE *argv, VALUE self,
+                  int8_t data_type, ca_stat_proc_t *ca_proc)
+{
+  volatile VALUE out, rmc, rfval;
+  CArray *ca, *co;
+  ca_size_t mc;
+
+  rb_scan_args(argc, argv, "02", (VALUE *) &rmc, (VALUE *) &rfval);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
+  }
+
+  out = rb_carray_new(data_type, 1, &ca->elements, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  if ( ca->elements == 0 ) {
+    ;
+  }
+  else {
+    CAStatIterator it;
+    boolean8_t *m = NULL;
+    boolean8_t *om = NULL;
+    ca_attach(ca);
+    if ( ca->mask ) {
+      m = (boolean8_t *)ca->mask->ptr;
+    }
+    mc = ( (! ca->mask) || NIL_P(rmc) ) ? ca->elements - 1 : NUM2SIZE(rmc);
+    if ( mc < 0 ) {
+      mc += ca->elements;
+    }
+    if ( m ) {
+      ca_create_mask(co);
+      om = (boolean8_t *) co->mask->ptr;
+    }
+    it.step = 0;
+    ca_proc[ca->data_type](ca->elements, mc, m, ca->ptr, &it,
+                           om, co->ptr);
+    ca_detach(ca);
+  }
+
+  if ( ca_has_mask(co) && ( ! NIL_P(rfval) ) ) {
+    out = rb_ca_mask_fill_copy(out, rfval);
+  }
+
+  return out;
+}
+
+static void
+ca_dimstat_type2_loop (CArray *ca, CArray *co, ca_size_t mc,
+                       ca_stat_proc_t *ca_proc,
+                       int level, ca_size_t *idx, char **op, boolean8_t **om)
+{
+  void *p;
+  boolean8_t *m;
+  ca_size_t i, n;
+  if ( level == co->ndim ) {
+    CAStatIterator it;
+    n = ca->elements/co->elements;
+    idx[level] = 0;
+    p = ca_ptr_at_index(ca, idx);
+    m = ( ca->mask && ca->mask->ptr ) ?
+                                (boolean8_t *)ca_ptr_at_index(ca->mask, idx) : NULL;
+    it.step = 0;
+    ca_proc[ca->data_type](n, mc, m, p, &it, 0, NULL, *om, *op);
+    printf("world\n");
+    if ( *om ) {
+      *om += n;
+    }
+    *op += n*co->bytes;
+  }
+  else {
+    for (i=0; i<ca->dim[level]; i++) {
+      idx[level] = i;
+      ca_dimstat_type2_loop(ca, co, mc, ca_proc, level+1, idx, op, om);
+    }
+  }
+}
+
+static void
+ca_dimstat_type2 (CArray *ca, CArray *co, ca_size_t mc, ca_stat_proc_t *ca_proc)
+{
+  ca_size_t idx[CA_RANK_MAX];
+  char *op;
+  boolean8_t *om;
+  int8_t i;
+  for (i=0; i<ca->ndim; i++) {
+    idx[i] = 0;
+  }
+  ca_attach_n(2, ca, co);
+  op = co->ptr;
+  om = ( co->mask && co->mask->ptr ) ? (boolean8_t *)co->mask->ptr : NULL;
+  ca_dimstat_type2_loop(ca, co, mc, ca_proc, 0, idx, &op, &om);
+  ca_sync(co);
+  ca_detach_n(2, ca, co);
+}
+
+static VALUE
+rb_ca_dimstat_type2 (int argc, VALUE *argv, VALUE self,
+                    int8_t data_type, ca_stat_proc_t *ca_proc)
+{
+  volatile VALUE rndim, rmc, rfval;
+  volatile VALUE out;
+  CArray *ca, *co;
+  ca_size_t odim[CA_RANK_MAX], n;
+  ca_size_t mc, ndim;
+  int32_t i;
+
+  rb_scan_args(argc, argv, "12", (VALUE *) &rndim, (VALUE *) &rmc, (VALUE *) &rfval);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
+  }
+
+  ndim = NUM2SIZE(rndim);
+  if ( ndim <= 0 || ndim > ca->ndim ) {
+    rb_raise(rb_eRuntimeError, "invalid dimension specified");
+  }
+
+  n = 1;
+  for (i=0; i<ndim; i++) {
+    odim[i] = ca->dim[i];
+    n *= odim[i];
+  }
+  odim[ndim] = ca->elements/n;
+
+  out = rb_carray_new(data_type, ndim+1, odim, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+	if ( ca_has_mask(ca) ) {
+		ca_create_mask(co);
+	}
+
+  if ( NIL_P(rmc) ) {
+    mc = ca->elements/co->elements - 1;
+  }
+  else {
+    mc = NUM2SIZE(rmc);
+  }
+
+  if ( mc < 0 ) {
+    mc += ca->elements;
+  }
+
+  ca_dimstat_type2(ca, co, mc, ca_proc);
+
+  if ( ca_has_mask(co) && ( ! NIL_P(rfval) ) ) {
+    out = rb_ca_mask_fill_copy(out, rfval);
+  }
+
+  return out;
+}
+
+static VALUE
+rb_ca_cumcount (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_type2(argc, argv, self, CA_INT32, ca_proc_cumcount);
+}
+
+static VALUE
+rb_ca_dimcumcount (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_dimstat_type2(argc, argv, self, CA_INT32, ca_proc_cumcount);
+}
+
+static VALUE
+rb_ca_cumsum (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_type2(argc, argv, self, CA_FLOAT64, ca_proc_cumsum);
+}
+
+static VALUE
+rb_ca_dimcumsum (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_dimstat_type2(argc, argv, self, CA_FLOAT64, ca_proc_cumsum);
+}
+
+/* builds the Hash returned by describe for the whole array */
+
+static VALUE
+rb_ca_describe_scalar (CArray *ca, CAStatDescribe *d, boolean8_t masked,
+                       VALUE vfval)
+{
+  volatile VALUE hash = rb_hash_new();
+  VALUE undef = ( vfval != CA_NIL ) ? vfval : CA_UNDEF;
+
+  if ( masked ) {
+    rb_hash_aset(hash, ID2SYM(rb_intern("count")),    undef);
+    rb_hash_aset(hash, ID2SYM(rb_intern("min")),      undef);
+    rb_hash_aset(hash, ID2SYM(rb_intern("max")),      undef);
+    rb_hash_aset(hash, ID2SYM(rb_intern("min_addr")), undef);
+    rb_hash_aset(hash, ID2SYM(rb_intern("max_addr")), undef);
+    rb_hash_aset(hash, ID2SYM(rb_intern("sum")),      undef);
+    rb_hash_aset(hash, ID2SYM(rb_intern("mean")),     undef);
+    rb_hash_aset(hash, ID2SYM(rb_intern("variance")), undef);
+    rb_hash_aset(hash, ID2SYM(rb_intern("stddev")),   undef);
+  }
+  else {
+    rb_hash_aset(hash, ID2SYM(rb_intern("count")),    SIZE2NUM(d->count));
+    rb_hash_aset(hash, ID2SYM(rb_intern("min")),      ca_ptr2obj(ca, &d->min));
+    rb_hash_aset(hash, ID2SYM(rb_intern("max")),      ca_ptr2obj(ca, &d->max));
+    rb_hash_aset(hash, ID2SYM(rb_intern("min_addr")), SIZE2NUM(d->min_addr));
+    rb_hash_aset(hash, ID2SYM(rb_intern("max_addr")), SIZE2NUM(d->max_addr));
+    rb_hash_aset(hash, ID2SYM(rb_intern("sum")),      rb_float_new(d->sum));
+    rb_hash_aset(hash, ID2SYM(rb_intern("mean")),     rb_float_new(d->mean));
+    rb_hash_aset(hash, ID2SYM(rb_intern("variance")), rb_float_new(d->variance));
+    rb_hash_aset(hash, ID2SYM(rb_intern("stddev")),   rb_float_new(sqrt(d->variance)));
+  }
+
+  return hash;
+}
+
+/* builds the Hash returned by describe from the array of CAStatDescribe */
+
+static VALUE
+rb_ca_describe_array (CArray *ca, CArray *co, VALUE vfval)
+{
+  volatile VALUE hash = rb_hash_new();
+  const char *names[] = { "count", "min", "max", "min_addr", "max_addr",
+                          "sum", "mean", "variance", "stddev" };
+  int8_t types[] = { CA_INT32, ca->data_type, ca->data_type, CA_INT32, CA_INT32,
+                     CA_FLOAT64, CA_FLOAT64, CA_FLOAT64, CA_FLOAT64 };
+  VALUE outs[9];
+  CArray *cs[9];
+  CAStatDescribe *d = (CAStatDescribe *) co->ptr;
+  ca_size_t i;
+  int k;
+
+  for (k=0; k<9; k++) {
+    outs[k] = rb_carray_new(types[k], co->ndim, co->dim, 0, NULL);
+    TypedData_Get_Struct(outs[k], CArray, &carray_data_type, cs[k]);
+    rb_hash_aset(hash, ID2SYM(rb_intern(names[k])), outs[k]);
+  }
+
+  for (i=0; i<co->elements; i++, d++) {
+    ((int32_t *) cs[0]->ptr)[i] = (int32_t) d->count;
+    memcpy(cs[1]->ptr + i * ca->bytes, &d->min, ca->bytes);
+    memcpy(cs[2]->ptr + i * ca->bytes, &d->max, ca->bytes);
+    ((int32_t *) cs[3]->ptr)[i] = (int32_t) d->min_addr;
+    ((int32_t *) cs[4]->ptr)[i] = (int32_t) d->max_addr;
+    ((float64_t *) cs[5]->ptr)[i] = d->sum;
+    ((float64_t *) cs[6]->ptr)[i] = d->mean;
+    ((float64_t *) cs[7]->ptr)[i] = d->variance;
+    ((float64_t *) cs[8]->ptr)[i] = sqrt(d->variance);
+  }
+
+  if ( ca_has_mask(co) ) {
+    for (k=0; k<9; k++) {
+      ca_copy_mask_overwrite(cs[k], co->elements, 1, co);
+      if ( vfval != CA_NIL ) {
+        rb_hash_aset(hash, ID2SYM(rb_intern(names[k])), 
+                     rb_ca_mask_fill_copy(outs[k], vfval));
+      }
+    }
+  }
+
+  return hash;
+}
+
+/* @overload describe (*axis, mask_limit: nil, min_count: nil, fill_value: nil)
+
+Computes count (of valid elements), min, max, min_addr, max_addr, sum,
+mean, variance and stddev in a single pass over the array, and returns
+them as a Hash. The options and the axes are treated as same as #sum,
+#min, etc. If the axes are given, each value of the Hash is an array.
+*/
+
+static VALUE
+rb_ca_describe (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE rmc, vfval, vaxis, out;
+  CArray *ca, *co;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc_describe[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
+  }
+
+  vaxis = rb_ca_stat_scan_args(argc, argv, self, (VALUE *) &rmc, (VALUE *) &vfval);
+
+  if ( NIL_P(vaxis) || 
+       ( ca_stat_axis_is_contig(ca, vaxis) && RARRAY_LEN(vaxis) == ca->ndim ) ) {
+    CAStatDescribe d;
+    CAStatIterator it;
+    boolean8_t masked = 1;
+    boolean8_t *m;
+    ca_size_t mc;
+    if ( ca->elements > 0 ) {
+      ca_attach(ca);
+      m = ca_mask_ptr_any(ca);
+      mc = ( ( ! ca_has_mask(ca) ) || NIL_P(rmc)) ? ca->elements - 1 : NUM2SIZE(rmc);
+      if ( mc < 0 ) {
+        mc += ca->elements;
+      }
+      it.step = 0;
+      ca_proc_describe[ca->data_type](ca->elements, mc, m, ca->ptr, &it, 
+                                      0, NULL, &masked, &d);
+      ca_detach(ca);
+    }
+    return rb_ca_describe_scalar(ca, &d, masked, vfval);
+  }
+  else if ( ca_stat_axis_is_contig(ca, vaxis) ) {
+    out = rb_ca_stat_nd_contig(self, vaxis, rmc, CA_NIL, CA_FIXLEN,
+                               sizeof(CAStatDescribe), ca_proc_describe);
+  }
+  else {
+    out = rb_ca_stat_nd_discrete(self, vaxis, rmc, CA_NIL, CA_FIXLEN,
+                                 sizeof(CAStatDescribe), ca_proc_describe);
+  }
+
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  return rb_ca_describe_array(ca, co, vfval);
+}
+
+/* @overload dimdescribe (ndim, mask_limit: nil, min_count: nil, fill_value: nil)
+
+Same as #describe for the dimensions after the first ndim dimensions.
+*/
+
+static VALUE
+rb_ca_dimdescribe (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE ropt, rndim, args;
+  CArray *ca;
+  ca_size_t ndim, i;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  ropt = rb_pop_options(&argc, &argv);
+  rb_scan_args(argc, argv, "1", (VALUE *) &rndim);
+
+  ndim = NUM2SIZE(rndim);
+  if ( ndim <= 0 || ndim >= ca->ndim ) {
+    rb_raise(rb_eRuntimeError, "invalid dimension specified");
+  }
+
+  args = rb_ary_new();
+  for (i=ndim; i<ca->ndim; i++) {
+    rb_ary_push(args, SIZE2NUM(i));
+  }
+  if ( ! NIL_P(ropt) ) {
+    rb_ary_push(args, ropt);
+  }
+
+  return rb_ca_describe((int) RARRAY_LEN(args), RARRAY_PTR(args), self);
+}
+
+/* @overload median (*axis, mask_limit: nil, min_count: nil, fill_value: nil)
+
+Returns the median of the valid elements (the mean of the two middle 
+values for the even number of elements). The options and the axes are 
+treated as same as #sum. The median is found by the selection 
+(introselect) without sorting the whole array.
+*/
+
+static VALUE
+rb_ca_median (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_median);
+}
+
+static int
+ca_stat_percentile_cmp (const void *a, const void *b)
+{
+  float64_t *per = ca_stat_percentile_spec.per;
+  float64_t x = per[*(const int *) a], y = per[*(const int *) b];
+  return ( x < y ) ? -1 : ( x > y ) ? 1 : 0;
+}
+
+/* @overload percentile (*per, axis: nil, mask_limit: nil, min_count: nil, fill_value: nil)
+
+Returns the percentiles per (0..100) of the valid elements as an Array.
+The values between the elements are linearly interpolated. If the axis 
+(Integer or Array) is given, returns an Array of the arrays reduced 
+along the axes as #sum(*axis). All percentiles are computed from one 
+partial partition of the elements.
+*/
+
+static VALUE
+rb_ca_percentile (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE ropt, raxis = Qnil, rmask_limit = Qnil, rfval = Qnil,
+                 rmin_count = Qnil, args, out, list;
+  CAStatPercentileSpec *spec = &ca_stat_percentile_spec;
+  float64_t *per, *val;
+  int *order;
+  CArray *ca, *co, *cs;
+  ca_size_t i;
+  int n, k;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc_percentile[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
+  }
+
+  ropt = rb_pop_options(&argc, &argv);
+  rb_scan_options(ropt, "axis,mask_limit,min_count,fill_value",
+                  &raxis, &rmask_limit, &rmin_count, &rfval);
+
+  n = argc;
+  per   = ALLOCA_N(float64_t, n + 1);
+  order = ALLOCA_N(int, n + 1);
+  for (k=0; k<n; k++) {
+    per[k]   = NUM2DBL(argv[k]);
+    order[k] = k;
+  }
+
+  /* the options are passed to rb_ca_stat_scan_args() with the axes */
+  args = rb_ary_new();
+  if ( ! NIL_P(raxis) ) {
+    rb_ary_concat(args, rb_Array(raxis));
+  }
+  {
+    volatile VALUE opt = rb_hash_new();
+    if ( ! NIL_P(rmask_limit) ) {
+      rb_hash_aset(opt, ID2SYM(rb_intern("mask_limit")), rmask_limit);
+    }
+    if ( ! NIL_P(rmin_count) ) {
+      rb_hash_aset(opt, ID2SYM(rb_intern("min_count")), rmin_count);
+    }
+    if ( ! NIL_P(rfval) ) {
+      rb_hash_aset(opt, ID2SYM(rb_intern("fill_value")), rfval);
+    }
+    rb_ary_push(args, opt);
+  }
+  raxis = rb_ca_stat_scan_args((int) RARRAY_LEN(args), RARRAY_PTR(args), self, 
+                               (VALUE *) &rmin_count, (VALUE *) &rfval);
+
+  spec->n     = n;
+  spec->per   = per;
+  spec->order = order;
+  qsort(order, n, sizeof(int), ca_stat_percentile_cmp);
+
+  list = rb_ary_new();
+
+  if ( NIL_P(raxis) || 
+       ( ca_stat_axis_is_contig(ca, raxis) && RARRAY_LEN(raxis) == ca->ndim ) ) {
+    CAStatIterator it;
+    boolean8_t masked = 1;
+    ca_size_t mc;
+    val = ALLOCA_N(float64_t, n + 1);
+    if ( ca->elements > 0 ) {
+      ca_attach(ca);
+      mc = ( ( ! ca_has_mask(ca) ) || NIL_P(rmin_count) ) ? 
+                                  ca->elements - 1 : NUM2SIZE(rmin_count);
+      if ( mc < 0 ) {
+        mc += ca->elements;
+      }
+      it.step = 0;
+      ca_proc_percentile[ca->data_type](ca->elements, mc, 
+                            ca_mask_ptr_any(ca),
+                            ca->ptr, &it, 0, NULL, &masked, val);
+      ca_detach(ca);
+    }
+    for (k=0; k<n; k++) {
+      if ( masked ) {
+        rb_ary_push(list, ( rfval != CA_NIL ) ? rfval : CA_UNDEF);
+      }
+      else {
+        rb_ary_push(list, rb_float_new(val[k]));
+      }
+    }
+    return list;
+  }
+
+  if ( n == 0 ) {
+    return list;
+  }
+
+  if ( ca_stat_axis_is_contig(ca, raxis) ) {
+    out = rb_ca_stat_nd_contig(self, raxis, rmin_count, CA_NIL, CA_FIXLEN,
+                               n * sizeof(float64_t), ca_proc_percentile);
+  }
+  else {
+    out = rb_ca_stat_nd_discrete(self, raxis, rmin_count, CA_NIL, CA_FIXLEN,
+                                 n * sizeof(float64_t), ca_proc_percentile);
+  }
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  for (k=0; k<n; k++) {
+    volatile VALUE obj = rb_carray_new(CA_FLOAT64, co->ndim, co->dim, 0, NULL);
+    TypedData_Get_Struct(obj, CArray, &carray_data_type, cs);
+    val = (float64_t *) co->ptr;
+    for (i=0; i<co->elements; i++) {
+      ((float64_t *) cs->ptr)[i] = val[i*n+k];
+    }
+    if ( ca_has_mask(co) ) {
+      ca_copy_mask_overwrite(cs, co->elements, 1, co);
+      if ( rfval != CA_NIL ) {
+        obj = rb_ca_mask_fill_copy(obj, rfval);
+      }
+    }
+    rb_ary_push(list, obj);
+  }
+
+  return list;
+}
+
+/* @overload quantile (axis: nil, mask_limit: nil, min_count: nil, fill_value: nil)
+
+Returns the percentiles 0, 25, 50, 75 and 100.
+*/
+
+static VALUE
+rb_ca_quantile (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE ropt, args;
+  ropt = rb_pop_options(&argc, &argv);
+  rb_check_arity(argc, 0, 0);
+  args = rb_ary_new3(5, INT2NUM(0), INT2NUM(25), INT2NUM(50), 
+                        INT2NUM(75), INT2NUM(100));
+  if ( ! NIL_P(ropt) ) {
+    rb_ary_push(args, ropt);
+  }
+  return rb_ca_percentile((int) RARRAY_LEN(args), RARRAY_PTR(args), self);
+}
+
+/* ----------------------------------------------------------------- */
+
+/*
+  rb_ca_topk() is the body of nlargest, nsmallest and their _addr 
+  versions. For the whole array, the result has only the found entries 
+  (at most n valid elements). Along the axes, the result has the last 
+  dimension of n appended to the remaining dimensions, and the entries 
+  not found (fewer valid elements than n) are masked.
+*/
+
+static VALUE
+rb_ca_topk (int argc, VALUE *argv, VALUE self, int dir, int want_addr)
+{
+  volatile VALUE ropt, rsorted = Qnil, rn, raxis, rmc = Qnil, 
+                 vfval = CA_NIL, out, obj;
+  CAStatTopKSpec *spec = &ca_stat_topk_spec;
+  CArray *ca, *co, *cs;
+  ca_size_t odim[CA_RANK_MAX];
+  ca_size_t k, n, bytes, i, j;
+  ca_size_t *raddr;
+  char *rval, *op;
+  boolean8_t *om = NULL;
+  int8_t data_type, ndim;
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc_topk[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
   }
 
-  for (i=0; i<RARRAY_LEN(vaxis); i++) {
-    k = NUM2SIZE(rb_ary_entry(vaxis, i));
-    dm[k] = 1;
-    dn[k] = 0;
+  ropt = rb_pop_options(&argc, &argv);
+  rb_scan_options(ropt, "sorted", &rsorted);
+  rb_scan_args(argc, argv, "1*", (VALUE *) &rn, (VALUE *) &raxis);
+
+  k = NUM2SIZE(rn);
+  if ( k < 0 ) {
+    rb_raise(rb_eArgError, "negative number of elements");
   }
 
-  out_ndim  = 0;
-  loop_ndim = 0;
-  for (i=0; i<ca->ndim; i++) {
-    if ( dm[i] ) {
-      loop_dim[loop_ndim] = ca->dim[i];
-      loop_ndim += 1;
+  raxis = rb_ca_stat_scan_args((int) RARRAY_LEN(raxis), RARRAY_PTR(raxis), 
+                               self, (VALUE *) &rmc, (VALUE *) &vfval);
+
+  spec->k      = k;
+  spec->dir    = dir;
+  spec->sorted = NIL_P(rsorted) || RTEST(rsorted);
+
+  data_type = ( want_addr ) ? CA_SIZE : ca->data_type;
+  bytes     = k * ( sizeof(ca_size_t) + ca->bytes );
+
+  if ( NIL_P(raxis) || 
+       ( ca_stat_axis_is_contig(ca, raxis) && RARRAY_LEN(raxis) == ca->ndim ) ) {
+    CAStatIterator it;
+    char *buf = ALLOC_N(char, bytes + 1);
+    it.step = 0;
+    ca_attach(ca);
+    ca_proc_topk[ca->data_type](ca->elements, 0, 
+                        ca_mask_ptr_any(ca),
+                        ca->ptr, &it, 0, NULL, NULL, buf);
+    ca_detach(ca);
+    raddr = (ca_size_t *) buf;
+    rval  = buf + k * sizeof(ca_size_t);
+    for (n=0; n<k && raddr[n] >= 0; n++) {
+      ;
     }
-    else {
-      out_dim[out_ndim] = ca->dim[i];
-      out_ndim += 1;
+    out = rb_carray_new(data_type, 1, &n, 0, NULL);
+    TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+    memcpy(co->ptr, ( want_addr ) ? (char *) raddr : rval, n * co->bytes);
+    xfree(buf);
+    return out;
+  }
+
+  if ( ca_stat_axis_is_contig(ca, raxis) ) {
+    obj = rb_ca_stat_nd_contig(self, raxis, Qnil, CA_NIL, CA_FIXLEN,
+                               ( bytes > 0 ) ? bytes : 1, ca_proc_topk);
+  }
+  else {
+    obj = rb_ca_stat_nd_discrete(self, raxis, Qnil, CA_NIL, CA_FIXLEN,
+                                 ( bytes > 0 ) ? bytes : 1, ca_proc_topk);
+  }
+  TypedData_Get_Struct(obj, CArray, &carray_data_type, co);
+
+  ndim = co->ndim + 1;
+  if ( ndim > CA_RANK_MAX ) {
+    rb_raise(rb_eRuntimeError, "too large rank of the result");
+  }
+  for (i=0; i<co->ndim; i++) {
+    odim[i] = co->dim[i];
+  }
+  odim[co->ndim] = k;
+
+  out = rb_carray_new(data_type, ndim, odim, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, cs);
+
+  op = cs->ptr;
+  for (i=0; i<co->elements; i++) {
+    raddr = (ca_size_t *) (co->ptr + i * co->bytes);
+    rval  = co->ptr + i * co->bytes + k * sizeof(ca_size_t);
+    for (j=0; j<k; j++, op+=cs->bytes) {
+      if ( raddr[j] < 0 ) {
+        if ( ! om ) {
+          ca_create_mask(cs);
+          om = (boolean8_t *) cs->mask->ptr;
+        }
+        om[i*k+j] = 1;
+      }
+      else if ( want_addr ) {
+        memcpy(op, &raddr[j], cs->bytes);
+      }
+      else {
+        memcpy(op, rval + j * cs->bytes, cs->bytes);
+      }
     }
   }
 
-  out    = rb_carray_new(data_type, out_ndim, out_dim, 0, NULL);
-  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
-  
-  first  = carray_new(CA_SIZE, out_ndim, out_dim, 0, NULL);
-  first->ptr = realloc(first->ptr, first->bytes*(first->elements+1));
+  return out;
+}
 
-  offset = carray_new(CA_SIZE, loop_ndim, loop_dim, 0, NULL);
-  offset->ptr = realloc(offset->ptr, offset->bytes*(offset->elements+1));
+/* @overload nlargest (n, *axis, sorted: true)
 
-  ca_stat_get_offset_loop(ca, dn, 0, idx, 0, idx1, first);
-  ca_stat_get_offset_loop(ca, dm, 0, idx, 0, idx1, offset);
+Returns the n largest valid elements (in descending order unless 
+sorted: false). The earlier element comes first for the same values, 
+and NaN comes after all numbers (skipped as by #max_addr). If the axes 
+are given, returns the array of the n largest elements along the axes 
+as the last dimension, where the entries not found are masked.
+The elements are selected in O(size) time and O(n) memory without 
+sorting the whole array.
+*/
 
-	if ( ca_has_mask(ca) ) {
-		ca_create_mask(co);
-	}
+static VALUE
+rb_ca_nlargest (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_topk(argc, argv, self, 1, 0);
+}
 
-  if ( NIL_P(rmc) ) {
-    mc = offset->elements - 1;
+/* @overload nlargest_addr (n, *axis, sorted: true)
+
+Returns the addresses of the elements returned by #nlargest. Along the 
+axes, the addresses are counted in the elements reduced (as #max_addr).
+*/
+
+static VALUE
+rb_ca_nlargest_addr (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_topk(argc, argv, self, 1, 1);
+}
+
+/* @overload nsmallest (n, *axis, sorted: true)
+
+Returns the n smallest valid elements (in ascending order unless 
+sorted: false). See #nlargest for the details.
+*/
+
+static VALUE
+rb_ca_nsmallest (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_topk(argc, argv, self, -1, 0);
+}
+
+/* @overload nsmallest_addr (n, *axis, sorted: true)
+
+Returns the addresses of the elements returned by #nsmallest.
+*/
+
+static VALUE
+rb_ca_nsmallest_addr (int argc, VALUE *argv, VALUE self)
+{
+  return rb_ca_topk(argc, argv, self, -1, 1);
+}
+
+/* ----------------------------------------------------------------- */
+
+static int
+rb_ca_group_op (VALUE rop)
+{
+  ID id;
+  if ( NIL_P(rop) ) {
+    return CA_GROUP_SUM;
   }
-  else {
-    mc = NUM2SIZE(rmc);
+  id = ( SYMBOL_P(rop) ) ? SYM2ID(rop) : rb_intern(StringValueCStr(rop));
+  if ( id == rb_intern("sum") ) {
+    return CA_GROUP_SUM;
+  }
+  else if ( id == rb_intern("mean") ) {
+    return CA_GROUP_MEAN;
+  }
+  else if ( id == rb_intern("min") ) {
+    return CA_GROUP_MIN;
   }
+  else if ( id == rb_intern("max") ) {
+    return CA_GROUP_MAX;
+  }
+  else if ( id == rb_intern("count") ) {
+    return CA_GROUP_COUNT;
+  }
+  rb_raise(rb_eArgError, "unknown reduction '%s' for group_reduce", 
+           rb_id2name(id));
+}
 
-  if ( mc < 0 ) {
-    mc += offset->elements;
+/* @overload group_reduce (keys, op = :sum, sorted: true)
+
+Reduces the elements grouped by the values of keys (an array with the 
+same number of elements as self) in a single pass. op is one of :sum, 
+:mean, :min, :max and :count. Returns the pair of the distinct keys 
+(in ascending order, or in the order of the first occurrence if 
+sorted: false) and the reduced values for them.
+
+The integer keys of a small range are coded by a dense table, the other 
+keys (including float, fixlen and object) by the hash table of #uniq. 
+The masked elements of self and keys are skipped. :sum and :mean are 
+computed in float64 (as #sum), :min and :max in the data type of self, 
+and :count gives the number of valid elements in int64. The groups 
+without any valid element are 0 for :sum and :count, and masked for 
+the others.
+
+    v = CA_FLOAT64([1, 2, 3, 4, 5])
+    k = CA_INT32([2, 0, 2, 1, 0])
+    v.group_reduce(k)              # => [<0, 1, 2>, <7.0, 4.0, 4.0>]
+    v.group_reduce(k, :max)        # => [<0, 1, 2>, <5.0, 4.0, 3.0>]
+*/
+
+static VALUE
+rb_ca_group_reduce (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE ropt, rsorted = Qnil, rkeys, rop = Qnil;
+  volatile VALUE rgroups = Qnil, rcode, out;
+  CArray *ca, *ck, *cc, *co;
+  CAStatMoment *st;
+  boolean8_t *m, *om = NULL;
+  ca_size_t *code;
+  ca_size_t ngroup = 0, g;
+  int8_t data_type;
+  int op, sorted;
+
+  ropt = rb_pop_options(&argc, &argv);
+  rb_scan_options(ropt, "sorted", &rsorted);
+  rb_scan_args(argc, argv, "11", (VALUE *) &rkeys, (VALUE *) &rop);
+  sorted = NIL_P(rsorted) || RTEST(rsorted);
+  op = rb_ca_group_op(rop);
+
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc_group[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
   }
 
-  ca_attach_n(2, ca, co);
+  rb_check_carray_object(rkeys);
+  TypedData_Get_Struct(rkeys, CArray, &carray_data_type, ck);
 
-  {
-    CAStatIterator it, jt;
-    ca_size_t *a = (ca_size_t *) (&it);
-    boolean8_t *m0, *m, *om;
-    char *p, *op;
+  if ( ck->elements != ca->elements ) {
+    rb_raise(rb_eArgError, "elements mismatch between self and keys");
+  }
 
-    it.step = 1;
-    it.addr = (ca_size_t *)first->ptr;
-    jt.step = 1;
-    jt.addr = (ca_size_t *)offset->ptr;
+  rcode = rb_carray_new(CA_SIZE, 1, &ca->elements, 0, NULL);
+  TypedData_Get_Struct(rcode, CArray, &carray_data_type, cc);
+  code = (ca_size_t *) cc->ptr;
 
-    m0 = ( ca->mask && ca->mask->ptr ) ? (boolean8_t *)ca->mask->ptr : NULL;
-    om = ( co->mask && co->mask->ptr ) ? (boolean8_t *)co->mask->ptr : NULL;
-    op = co->ptr;
+  /* codes of the keys */
 
-    iterator_rewind(&it);
-    for (i=0; i<co->elements; i++) {
-      m = ( m0 ) ? m0 + (*a) : NULL;
-      p = ca->ptr + (*a) * ca->bytes;
-      ca_proc[ca->data_type](offset->elements, mc, m, p, &jt, 0, NULL, om, op);
-      if ( om ) {
-        om += 1;
+  if ( sorted && ca_proc_group_dense[ck->data_type] ) {
+    ca_attach(ck);
+    rgroups = ca_proc_group_dense[ck->data_type](ck, 
+                   ca_mask_ptr_any(ck),
+                   code, &ngroup);
+    ca_detach(ck);
+  }
+
+  if ( NIL_P(rgroups) ) {
+    rgroups = rb_ca_uniq_codes(rkeys, sorted, code, &ngroup);
+  }
+
+  /* reduction */
+
+  switch ( op ) {
+  case CA_GROUP_MIN:
+  case CA_GROUP_MAX:
+    data_type = ca->data_type;
+    break;
+  case CA_GROUP_COUNT:
+    data_type = CA_SIZE;
+    break;
+  default:
+    data_type = CA_FLOAT64;
+  }
+
+  out = rb_carray_new(data_type, 1, &ngroup, 0, NULL);
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  st = malloc_with_check(sizeof(CAStatMoment)*(ngroup+1));
+  memset(st, 0, sizeof(CAStatMoment)*(ngroup+1));
+
+  ca_attach(ca);
+  m = ca_mask_ptr_any(ca);
+  ca_proc_group[ca->data_type](ca->elements, m, ca->ptr, code, op, st);
+  ca_detach(ca);
+
+  for (g=0; g<ngroup; g++) {
+    if ( st[g].count == 0 && op != CA_GROUP_SUM && op != CA_GROUP_COUNT ) {
+      if ( ! om ) {
+        ca_create_mask(co);
+        om = (boolean8_t *) co->mask->ptr;
       }
-      op += co->bytes;
-      iterator_succ(&it);
+      om[g] = 1;
+      memset(co->ptr + g*co->bytes, 0, co->bytes);
+      continue;
+    }
+    switch ( op ) {
+    case CA_GROUP_SUM:
+      ((float64_t *) co->ptr)[g] = (float64_t) st[g].sum;
+      break;
+    case CA_GROUP_MEAN:
+      ((float64_t *) co->ptr)[g] = (float64_t) (st[g].sum / st[g].count);
+      break;
+    case CA_GROUP_MIN:
+      memcpy(co->ptr + g*co->bytes, &st[g].min, co->bytes);
+      break;
+    case CA_GROUP_MAX:
+      memcpy(co->ptr + g*co->bytes, &st[g].max, co->bytes);
+      break;
+    case CA_GROUP_COUNT:
+      ((ca_size_t *) co->ptr)[g] = st[g].count;
+      break;
     }
   }
 
-  ca_sync(co);
-  ca_detach_n(2, ca, co);
+  free(st);
 
-  if ( ca_has_mask(co) && ( vfval != CA_NIL ) ) {
-    out = rb_ca_mask_fill_copy(out, vfval);
-  }
+  return rb_assoc_new(rgroups, out);
+}
 
-  ca_free(first);
-  ca_free(offset);
+/* ----------------------------------------------------------------- */
+
+/*
+  CAStatAccumulator keeps the running count, sum, min, max, mean and M2 
+  (sum of squared deviations from the mean) of the chunks given by #<<, 
+  so that the statistics of a stream are computed in constant memory.
+  The statistics of a chunk are computed by ca_proc_describe (or
+  ca_proc_moment_push element by element), and merged into the running
+  statistics by ca_proc_moment_merge.
+*/
+
+enum {
+  CA_STAT_ACCUM_ALL,       /* all elements of the chunks are reduced */
+  CA_STAT_ACCUM_AXIS,      /* the given axes of the chunks are reduced */
+  CA_STAT_ACCUM_ELEMENT,   /* the statistics for each element */
+};
 
-  return out;
+typedef struct {
+  int8_t        mode;
+  int8_t        data_type;               /* -1 until the first chunk */
+  int8_t        naxis;
+  ca_size_t     axis[CA_RANK_MAX];       /* reduced axes */
+  int8_t        chunk_ndim;
+  ca_size_t     chunk_dim[CA_RANK_MAX];
+  int8_t        ndim;                    /* 0 for the scalar statistics */
+  ca_size_t     dim[CA_RANK_MAX];
+  ca_size_t     elements;
+  CAStatMoment *moment;
+} CAStatAccumulator;
+
+static VALUE rb_cCAStatAccumulator;
+
+static void
+ca_stat_accum_free (void *ptr)
+{
+  CAStatAccumulator *acc = (CAStatAccumulator *) ptr;
+  if ( acc->moment ) {
+    xfree(acc->moment);
+  }
+  xfree(acc);
 }
 
+static size_t
+ca_stat_accum_memsize (const void *ptr)
+{
+  const CAStatAccumulator *acc = (const CAStatAccumulator *) ptr;
+  return sizeof(CAStatAccumulator) + 
+         ( ( acc->moment ) ? acc->elements * sizeof(CAStatMoment) : 0 );
+}
+
+static const rb_data_type_t ca_stat_accum_data_type = {
+    .wrap_struct_name = "CAStatAccumulator",
+    .function = {
+        .dmark = NULL,
+        .dfree = ca_stat_accum_free,
+        .dsize = ca_stat_accum_memsize,
+        .dcompact = NULL
+    },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
 static VALUE
-rb_ca_stat_general (int argc, VALUE *argv, VALUE self,
-                    int8_t data_type, ca_stat_proc_t *ca_proc)
+rb_stat_accum_s_allocate (VALUE klass)
 {
-  volatile VALUE ropt, rmc = Qnil, rmask_limit = Qnil, rmin_count = Qnil, 
-                 vfval = CA_NIL, vaxis;
-  CArray *ca;
+  CAStatAccumulator *acc;
+  VALUE obj;
+  obj = TypedData_Make_Struct(klass, CAStatAccumulator, 
+                              &ca_stat_accum_data_type, acc);
+  acc->mode      = CA_STAT_ACCUM_ALL;
+  acc->data_type = -1;
+  acc->moment    = NULL;
+  return obj;
+}
 
-  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+static CAStatAccumulator *
+ca_stat_accum_get (VALUE obj)
+{
+  CAStatAccumulator *acc;
+  TypedData_Get_Struct(obj, CAStatAccumulator, &ca_stat_accum_data_type, acc);
+  return acc;
+}
 
-  ropt = rb_pop_options(&argc, &argv);
-  rb_scan_options(ropt,
-                  "mask_limit,fill_value,min_count",
-                  &rmask_limit, &vfval, &rmin_count);
+/* @overload initialize (axis = nil)
 
-  if ( ( ! NIL_P(rmask_limit) ) && ( ! NIL_P(rmin_count) ) ) {
-    rb_raise(rb_eArgError,
-             "don't specify mask_limit and min_count simaltaniously");
+Creates an accumulator of the statistics of the chunks given by #<<.
+If axis is nil, all elements of the chunks are reduced to the scalar
+statistics. If axis is an Integer or an Array of Integer, the axes of
+the chunks are reduced as #sum(*axis) (the other dimensions should be 
+same for all chunks). If axis is an empty Array, the statistics are 
+computed for each element of the chunks of same shape.
+*/
+
+static VALUE
+rb_stat_accum_initialize (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE raxis = Qnil;
+  CAStatAccumulator *acc = ca_stat_accum_get(self);
+  int i;
+
+  rb_scan_args(argc, argv, "01", (VALUE *) &raxis);
+
+  if ( NIL_P(raxis) ) {
+    acc->mode  = CA_STAT_ACCUM_ALL;
+    acc->naxis = 0;
   }
-  else if ( ! NIL_P(rmin_count) ) {
-    ca_size_t min_count = NUM2SIZE(rmin_count);
-    if ( min_count == 0 ) {
-      rmc = Qnil;
+  else {
+    raxis = rb_Array(raxis);
+    if ( RARRAY_LEN(raxis) > CA_RANK_MAX ) {
+      rb_raise(rb_eArgError, "too many axes");
     }
-    else {
-      rmc = SIZE2NUM(-min_count);
+    acc->mode  = ( RARRAY_LEN(raxis) == 0 ) ? 
+                           CA_STAT_ACCUM_ELEMENT : CA_STAT_ACCUM_AXIS;
+    acc->naxis = (int8_t) RARRAY_LEN(raxis);
+    for (i=0; i<acc->naxis; i++) {
+      acc->axis[i] = NUM2SIZE(rb_ary_entry(raxis, i));
     }
   }
-  else if ( ! NIL_P(rmask_limit) ) {
-    ca_size_t mask_limit = NUM2SIZE(rmask_limit);
-    if ( mask_limit == 0 ) {
-      rmc = Qnil;
+
+  return Qnil;
+}
+
+/* fixes the data type and the shape of the statistics by the first chunk */
+
+static void
+ca_stat_accum_setup (CAStatAccumulator *acc, CArray *ca)
+{
+  int8_t reduce[CA_RANK_MAX];
+  ca_size_t k;
+  int i, j;
+
+  acc->data_type  = ca->data_type;
+  acc->chunk_ndim = ca->ndim;
+  for (i=0; i<ca->ndim; i++) {
+    acc->chunk_dim[i] = ca->dim[i];
+    reduce[i] = 0;
+  }
+
+  acc->ndim = 0;
+
+  switch ( acc->mode ) {
+  case CA_STAT_ACCUM_AXIS:
+    for (i=0; i<acc->naxis; i++) {
+      k = acc->axis[i];
+      CA_CHECK_INDEX(k, ca->ndim);
+      reduce[k] = 1;
     }
-    else {
-      rmc = SIZE2NUM(mask_limit-1);
+    j = 0;
+    for (i=0; i<ca->ndim; i++) {
+      if ( reduce[i] ) {
+        acc->axis[j++] = i;
+      }
+      else {
+        acc->dim[acc->ndim++] = ca->dim[i];
+      }
     }
+    acc->naxis = j;
+    if ( acc->ndim == 0 ) {
+      acc->mode = CA_STAT_ACCUM_ALL;
+    }
+    break;
+  case CA_STAT_ACCUM_ELEMENT:
+    for (i=0; i<ca->ndim; i++) {
+      acc->dim[acc->ndim++] = ca->dim[i];
+    }
+    break;
   }
-  else {
-    rmc = Qnil;
+
+  acc->elements = 1;
+  for (i=0; i<acc->ndim; i++) {
+    acc->elements *= acc->dim[i];
   }
 
-  if ( argc > 0 ) {
-    vaxis = rb_ary_new4(argc, argv);
+  acc->moment = ALLOC_N(CAStatMoment, acc->elements);
+  MEMZERO(acc->moment, CAStatMoment, acc->elements);
+}
+
+static void
+ca_stat_accum_check (CAStatAccumulator *acc, CArray *ca)
+{
+  int i, j;
+
+  if ( acc->mode == CA_STAT_ACCUM_ALL ) {
+    return;
   }
-  else {
-    vaxis = Qnil;
+
+  if ( ca->ndim != acc->chunk_ndim ) {
+    rb_raise(rb_eRuntimeError, 
+             "rank mismatch (%i for %i)", ca->ndim, acc->chunk_ndim);
   }
 
-  if ( NIL_P(vaxis) ) {
-    return rb_ca_stat_1d(self, rmc, vfval, ca_proc);
+  for (i=0, j=0; i<ca->ndim; i++) {
+    if ( acc->mode == CA_STAT_ACCUM_AXIS && 
+         j < acc->naxis && acc->axis[j] == i ) {
+      j++;
+      continue;
+    }
+    if ( ca->dim[i] != acc->chunk_dim[i] ) {
+      rb_raise(rb_eRuntimeError, 
+               "dimension mismatch at dim[%i] (%lld for %lld)", 
+               i, (long long) ca->dim[i], (long long) acc->chunk_dim[i]);
+    }
+  }
+}
+
+static void
+ca_stat_accum_describe_merge (CAStatAccumulator *acc, 
+                              ca_size_t n, CAStatDescribe *d)
+{
+  CAStatMoment *src;
+  ca_size_t i;
+  src = ALLOC_N(CAStatMoment, n);
+  for (i=0; i<n; i++, d++) {
+    src[i].count = d->count;
+    src[i].sum   = d->sum;
+    src[i].mean  = d->mean;
+    src[i].m2    = d->m2;
+    src[i].min   = d->min;
+    src[i].max   = d->max;
+  }
+  ca_proc_moment_merge[acc->data_type](n, src, acc->moment);
+  xfree(src);
+}
+
+/* @overload << (chunk)
+
+Updates the statistics with the valid elements of chunk. The chunk is 
+converted to the data type of the first chunk.
+*/
+
+static VALUE
+rb_stat_accum_push (VALUE self, VALUE rchunk)
+{
+  volatile VALUE chunk, vaxis, out;
+  CAStatAccumulator *acc = ca_stat_accum_get(self);
+  CArray *ca, *co;
+  int i;
+
+  chunk = rb_ca_wrap_readonly(rchunk, 
+                  ( acc->data_type < 0 ) ? Qnil : INT2NUM(acc->data_type));
+  TypedData_Get_Struct(chunk, CArray, &carray_data_type, ca);
+
+  if ( ! ca_proc_describe[ca->data_type] ) {
+    rb_raise(rb_eCADataTypeError,
+             "this method is not implemented for data_type %s",
+             ca_type_name[ca->data_type]);
+  }
+
+  if ( acc->data_type < 0 ) {
+    ca_stat_accum_setup(acc, ca);
   }
   else {
-    int is_contig = 1;
-    ca_size_t i, k;
+    ca_stat_accum_check(acc, ca);
+  }
 
-    vaxis = rb_funcall(vaxis, rb_intern("sort"), 0);
-    vaxis = rb_funcall(vaxis, rb_intern("uniq"), 0);
+  if ( ca->elements == 0 ) {
+    return self;
+  }
 
-    for (i=0; i<RARRAY_LEN(vaxis); i++) {
-      k = NUM2SIZE(rb_ary_entry(vaxis, RARRAY_LEN(vaxis)-1-i));
-      CA_CHECK_INDEX(k, ca->ndim);
-      if ( k != ca->ndim-1-i ) {
-        is_contig = 0;
-      }
+  switch ( acc->mode ) {
+  case CA_STAT_ACCUM_ALL: {
+    CAStatDescribe d;
+    CAStatIterator it;
+    ca_attach(ca);
+    it.step = 0;
+    ca_proc_describe[ca->data_type](ca->elements, ca->elements, 
+                                    ca_mask_ptr_any(ca),
+                                    ca->ptr, &it, 0, NULL, NULL, &d);
+    ca_detach(ca);
+    ca_stat_accum_describe_merge(acc, 1, &d);
+    break;
+  }
+  case CA_STAT_ACCUM_AXIS:
+    vaxis = rb_ary_new();
+    for (i=0; i<acc->naxis; i++) {
+      rb_ary_push(vaxis, SIZE2NUM(acc->axis[i]));
     }
-
-    if ( is_contig ) {
-      if ( RARRAY_LEN(vaxis) == ca->ndim ) {
-        return rb_ca_stat_1d(self, rmc, vfval, ca_proc);
-      }
-      else {
-        return rb_ca_stat_nd_contig(self, vaxis, rmc, vfval,
-                                    data_type, ca_proc);
-      }
+    if ( ca_stat_axis_is_contig(ca, vaxis) ) {
+      out = rb_ca_stat_nd_contig(chunk, vaxis, Qnil, CA_NIL, CA_FIXLEN,
+                                 sizeof(CAStatDescribe), ca_proc_describe);
     }
     else {
-      return rb_ca_stat_nd_discrete(self, vaxis, rmc, vfval,
-                                    data_type, ca_proc);
+      out = rb_ca_stat_nd_discrete(chunk, vaxis, Qnil, CA_NIL, CA_FIXLEN,
+                                   sizeof(CAStatDescribe), ca_proc_describe);
     }
+    TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+    ca_stat_accum_describe_merge(acc, co->elements, (CAStatDescribe *) co->ptr);
+    break;
+  case CA_STAT_ACCUM_ELEMENT:
+    ca_attach(ca);
+    ca_proc_moment_push[ca->data_type](ca->elements,
+                           ca_mask_ptr_any(ca),
+                           ca->ptr, acc->moment);
+    ca_detach(ca);
+    break;
   }
+
+  return self;
 }
 
+/* @overload merge! (other)
 
-static VALUE
-rb_ca_prod (int argc, VALUE *argv, VALUE self)
-{
-  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_prod);
-}
+Merges the statistics of other accumulator into self. Both should have 
+same data type and same shape of the statistics. An accumulator without
+any chunk is merged as is.
+*/
 
 static VALUE
-rb_ca_count (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_merge_bang (VALUE self, VALUE other)
 {
-  return rb_ca_stat_general(argc, argv, self, CA_INT32, ca_proc_count);
-}
+  CAStatAccumulator *acc = ca_stat_accum_get(self);
+  CAStatAccumulator *src = ca_stat_accum_get(other);
+  int i;
 
-static VALUE
-rb_ca_sum (int argc, VALUE *argv, VALUE self)
-{
-  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_sum);
-}
+  if ( src->data_type < 0 ) {
+    return self;
+  }
 
-static VALUE
-rb_ca_mean (int argc, VALUE *argv, VALUE self)
-{
-  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_mean);
-}
+  if ( acc->data_type < 0 ) {
+    CAStatMoment *moment = ALLOC_N(CAStatMoment, src->elements);
+    MEMCPY(moment, src->moment, CAStatMoment, src->elements);
+    *acc = *src;
+    acc->moment = moment;
+    return self;
+  }
 
-static VALUE
-rb_ca_variancep (int argc, VALUE *argv, VALUE self)
-{
-  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_variancep);
-}
+  if ( acc->data_type != src->data_type ) {
+    rb_raise(rb_eCADataTypeError, "data type mismatch (%s for %s)",
+             ca_type_name[src->data_type], ca_type_name[acc->data_type]);
+  }
 
-static VALUE
-rb_ca_stddevp (int argc, VALUE *argv, VALUE self)
-{
-  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_stddevp);
-}
+  if ( acc->ndim != src->ndim ) {
+    rb_raise(rb_eRuntimeError, "rank mismatch (%i for %i)",
+             src->ndim, acc->ndim);
+  }
 
-static VALUE
-rb_ca_variance (int argc, VALUE *argv, VALUE self)
-{
-  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_variance);
+  for (i=0; i<acc->ndim; i++) {
+    if ( acc->dim[i] != src->dim[i] ) {
+      rb_raise(rb_eRuntimeError, 
+               "dimension mismatch at dim[%i] (%lld for %lld)", 
+               i, (long long) src->dim[i], (long long) acc->dim[i]);
+    }
+  }
+
+  ca_proc_moment_merge[acc->data_type](acc->elements, src->moment, acc->moment);
+
+  return self;
 }
 
 static VALUE
-rb_ca_stddev (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_initialize_copy (VALUE self, VALUE other)
 {
-  return rb_ca_stat_general(argc, argv, self, CA_FLOAT64, ca_proc_stddev);
+  CAStatAccumulator *acc = ca_stat_accum_get(self);
+  CAStatAccumulator *src = ca_stat_accum_get(other);
+  if ( acc->moment ) {
+    xfree(acc->moment);
+  }
+  *acc = *src;
+  if ( src->moment ) {
+    acc->moment = ALLOC_N(CAStatMoment, src->elements);
+    MEMCPY(acc->moment, src->moment, CAStatMoment, src->elements);
+  }
+  return self;
 }
 
+/* @overload merge (other)
+
+Returns a new accumulator which has the statistics of self and other.
+*/
+
 static VALUE
-rb_ca_min (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_merge (VALUE self, VALUE other)
 {
-  CArray *ca;
-  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
-  return rb_ca_stat_general(argc, argv, self, ca->data_type, ca_proc_min);
+  volatile VALUE obj = rb_obj_dup(self);
+  return rb_stat_accum_merge_bang(obj, other);
 }
 
+/* @overload reset
+
+Clears the statistics (the data type and the shape are kept).
+*/
+
 static VALUE
-rb_ca_min_addr (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_reset (VALUE self)
 {
-  return rb_ca_stat_general(argc, argv, self, CA_INT32, ca_proc_min_addr);
+  CAStatAccumulator *acc = ca_stat_accum_get(self);
+  if ( acc->moment ) {
+    MEMZERO(acc->moment, CAStatMoment, acc->elements);
+  }
+  return self;
 }
 
+/* @overload data_type
+
+Returns the data type of the chunks (nil before the first chunk).
+*/
+
 static VALUE
-rb_ca_max (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_data_type (VALUE self)
 {
-  CArray *ca;
-  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
-  return rb_ca_stat_general(argc, argv, self, ca->data_type, ca_proc_max);
+  CAStatAccumulator *acc = ca_stat_accum_get(self);
+  return ( acc->data_type < 0 ) ? Qnil : INT2NUM(acc->data_type);
 }
 
+/* @overload dim
+
+Returns the shape of the statistics ([] for the scalar statistics).
+*/
+
 static VALUE
-rb_ca_max_addr (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_dim (VALUE self)
 {
-  return rb_ca_stat_general(argc, argv, self, CA_INT32, ca_proc_max_addr);
+  CAStatAccumulator *acc = ca_stat_accum_get(self);
+  volatile VALUE dim = rb_ary_new();
+  int i;
+  for (i=0; i<acc->ndim; i++) {
+    rb_ary_push(dim, SIZE2NUM(acc->dim[i]));
+  }
+  return dim;
 }
 
-static VALUE
-rb_ca_accum (int argc, VALUE *argv, VALUE self)
+enum {
+  CA_STAT_ACCUM_COUNT,
+  CA_STAT_ACCUM_SUM,
+  CA_STAT_ACCUM_MEAN,
+  CA_STAT_ACCUM_M2,
+  CA_STAT_ACCUM_VARIANCE,
+  CA_STAT_ACCUM_VARIANCEP,
+  CA_STAT_ACCUM_STDDEV,
+  CA_STAT_ACCUM_STDDEVP,
+  CA_STAT_ACCUM_MIN,
+  CA_STAT_ACCUM_MAX,
+};
+
+static float64_t
+ca_stat_accum_value (CAStatMoment *st, int kind)
 {
-  CArray *ca;
-  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
-  return rb_ca_stat_general(argc, argv, self, ca->data_type, ca_proc_accum);
+  switch ( kind ) {
+  case CA_STAT_ACCUM_SUM:       return (float64_t) st->sum;
+  case CA_STAT_ACCUM_MEAN:      return (float64_t) st->mean;
+  case CA_STAT_ACCUM_M2:        return (float64_t) st->m2;
+  case CA_STAT_ACCUM_VARIANCE:  return (float64_t) (st->m2 / (st->count - 1));
+  case CA_STAT_ACCUM_VARIANCEP: return (float64_t) (st->m2 / st->count);
+  case CA_STAT_ACCUM_STDDEV:    return sqrt((float64_t) (st->m2 / (st->count - 1)));
+  case CA_STAT_ACCUM_STDDEVP:   return sqrt((float64_t) (st->m2 / st->count));
+  }
+  return 0.0;
 }
 
+/* returns the statistics as a CArray (masked where no valid element),
+   or as a scalar value (UNDEF if no valid element) */
+
 static VALUE
-rb_ca_stat_type2 (int argc, VALUE *argv, VALUE self,
-                  int8_t data_type, ca_stat_proc_t *ca_proc)
+rb_stat_accum_result (VALUE self, int kind)
 {
-  volatile VALUE out, rmc, rfval;
-  CArray *ca, *co;
-  ca_size_t mc;
-
-  rb_scan_args(argc, argv, "02", (VALUE *) &rmc, (VALUE *) &rfval);
-
-  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  volatile VALUE out;
+  CAStatAccumulator *acc = ca_stat_accum_get(self);
+  CAStatMoment *st = acc->moment;
+  CArray *co;
+  ca_size_t one = 1;
+  boolean8_t *m = NULL;
+  int8_t data_type;
+  ca_size_t i;
 
-  if ( ! ca_proc[ca->data_type] ) {
-    rb_raise(rb_eCADataTypeError,
-             "this method is not implemented for data_type %s",
-             ca_type_name[ca->data_type]);
+  if ( acc->data_type < 0 ) {
+    return ( kind == CA_STAT_ACCUM_COUNT ) ? INT2NUM(0) : CA_UNDEF;
   }
 
-  out = rb_carray_new(data_type, 1, &ca->elements, 0, NULL);
-  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+  switch ( kind ) {
+  case CA_STAT_ACCUM_COUNT:
+    data_type = CA_SIZE;
+    break;
+  case CA_STAT_ACCUM_MIN:
+  case CA_STAT_ACCUM_MAX:
+    data_type = acc->data_type;
+    break;
+  default:
+    data_type = CA_FLOAT64;
+  }
 
-  if ( ca->elements == 0 ) {
-    ;
+  if ( acc->ndim == 0 ) {
+    out = rb_carray_new(data_type, 1, &one, 0, NULL);
   }
   else {
-    CAStatIterator it;
-    boolean8_t *m = NULL;
-    boolean8_t *om = NULL;
-    ca_attach(ca);
-    if ( ca->mask ) {
-      m = (boolean8_t *)ca->mask->ptr;
-    }
-    mc = ( (! ca->mask) || NIL_P(rmc) ) ? ca->elements - 1 : NUM2SIZE(rmc);
-    if ( mc < 0 ) {
-      mc += ca->elements;
+    out = rb_carray_new(data_type, acc->ndim, acc->dim, 0, NULL);
+  }
+  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+
+  for (i=0; i<acc->elements; i++, st++) {
+    switch ( kind ) {
+    case CA_STAT_ACCUM_COUNT:
+      ((ca_size_t *) co->ptr)[i] = st->count;
+      break;
+    case CA_STAT_ACCUM_MIN:
+      memcpy(co->ptr + i * co->bytes, &st->min, co->bytes);
+      break;
+    case CA_STAT_ACCUM_MAX:
+      memcpy(co->ptr + i * co->bytes, &st->max, co->bytes);
+      break;
+    default:
+      ((float64_t *) co->ptr)[i] = ca_stat_accum_value(st, kind);
     }
-    if ( m ) {
-      ca_create_mask(co);
-      om = (boolean8_t *) co->mask->ptr;
+    if ( kind != CA_STAT_ACCUM_COUNT && st->count == 0 ) {
+      if ( ! m ) {
+        ca_create_mask(co);
+        m = (boolean8_t *) co->mask->ptr;
+      }
+      m[i] = 1;
     }
-    it.step = 0;
-    ca_proc[ca->data_type](ca->elements, mc, m, ca->ptr, &it,
-                           om, co->ptr);
-    ca_detach(ca);
   }
 
-  if ( ca_has_mask(co) && ( ! NIL_P(rfval) ) ) {
-    out = rb_ca_mask_fill_copy(out, rfval);
+  if ( acc->ndim == 0 ) {
+    return ( m ) ? CA_UNDEF : rb_ca_ptr2obj(out, co->ptr);
   }
 
   return out;
 }
 
-static void
-ca_dimstat_type2_loop (CArray *ca, CArray *co, ca_size_t mc,
-                       ca_stat_proc_t *ca_proc,
-                       int level, ca_size_t *idx, char **op, boolean8_t **om)
-{
-  void *p;
-  boolean8_t *m;
-  ca_size_t i, n;
-  if ( level == co->ndim ) {
-    CAStatIterator it;
-    n = ca->elements/co->elements;
-    idx[level] = 0;
-    p = ca_ptr_at_index(ca, idx);
-    m = ( ca->mask && ca->mask->ptr ) ?
-                                (boolean8_t *)ca_ptr_at_index(ca->mask, idx) : NULL;
-    it.step = 0;
-    ca_proc[ca->data_type](n, mc, m, p, &it, 0, NULL, *om, *op);
-    printf("world\n");
-    if ( *om ) {
-      *om += n;
-    }
-    *op += n*co->bytes;
-  }
-  else {
-    for (i=0; i<ca->dim[level]; i++) {
-      idx[level] = i;
-      ca_dimstat_type2_loop(ca, co, mc, ca_proc, level+1, idx, op, om);
-    }
-  }
-}
+/* @overload count
 
-static void
-ca_dimstat_type2 (CArray *ca, CArray *co, ca_size_t mc, ca_stat_proc_t *ca_proc)
+Returns the number of the valid elements.
+*/
+
+static VALUE
+rb_stat_accum_count (VALUE self)
 {
-  ca_size_t idx[CA_RANK_MAX];
-  char *op;
-  boolean8_t *om;
-  int8_t i;
-  for (i=0; i<ca->ndim; i++) {
-    idx[i] = 0;
-  }
-  ca_attach_n(2, ca, co);
-  op = co->ptr;
-  om = ( co->mask && co->mask->ptr ) ? (boolean8_t *)co->mask->ptr : NULL;
-  ca_dimstat_type2_loop(ca, co, mc, ca_proc, 0, idx, &op, &om);
-  ca_sync(co);
-  ca_detach_n(2, ca, co);
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_COUNT);
 }
 
+/* @overload sum
+
+Returns the sum of the valid elements.
+*/
+
 static VALUE
-rb_ca_dimstat_type2 (int argc, VALUE *argv, VALUE self,
-                    int8_t data_type, ca_stat_proc_t *ca_proc)
+rb_stat_accum_sum (VALUE self)
 {
-  volatile VALUE rndim, rmc, rfval;
-  volatile VALUE out;
-  CArray *ca, *co;
-  ca_size_t odim[CA_RANK_MAX], n;
-  ca_size_t mc, ndim;
-  int32_t i;
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_SUM);
+}
 
-  rb_scan_args(argc, argv, "12", (VALUE *) &rndim, (VALUE *) &rmc, (VALUE *) &rfval);
+/* @overload mean
 
-  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+Returns the mean of the valid elements.
+*/
 
-  if ( ! ca_proc[ca->data_type] ) {
-    rb_raise(rb_eCADataTypeError,
-             "this method is not implemented for data_type %s",
-             ca_type_name[ca->data_type]);
-  }
+static VALUE
+rb_stat_accum_mean (VALUE self)
+{
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_MEAN);
+}
 
-  ndim = NUM2SIZE(rndim);
-  if ( ndim <= 0 || ndim > ca->ndim ) {
-    rb_raise(rb_eRuntimeError, "invalid dimension specified");
-  }
+/* @overload m2
 
-  n = 1;
-  for (i=0; i<ndim; i++) {
-    odim[i] = ca->dim[i];
-    n *= odim[i];
-  }
-  odim[ndim] = ca->elements/n;
+Returns the sum of squared deviations from the mean.
+*/
 
-  out = rb_carray_new(data_type, ndim+1, odim, 0, NULL);
-  TypedData_Get_Struct(out, CArray, &carray_data_type, co);
+static VALUE
+rb_stat_accum_m2 (VALUE self)
+{
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_M2);
+}
 
-	if ( ca_has_mask(ca) ) {
-		ca_create_mask(co);
-	}
+/* @overload variance
 
-  if ( NIL_P(rmc) ) {
-    mc = ca->elements/co->elements - 1;
-  }
-  else {
-    mc = NUM2SIZE(rmc);
-  }
+Returns the unbiased variance (m2/(count-1)).
+*/
 
-  if ( mc < 0 ) {
-    mc += ca->elements;
-  }
+static VALUE
+rb_stat_accum_variance (VALUE self)
+{
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_VARIANCE);
+}
 
-  ca_dimstat_type2(ca, co, mc, ca_proc);
+/* @overload variancep
 
-  if ( ca_has_mask(co) && ( ! NIL_P(rfval) ) ) {
-    out = rb_ca_mask_fill_copy(out, rfval);
-  }
+Returns the population variance (m2/count).
+*/
 
-  return out;
+static VALUE
+rb_stat_accum_variancep (VALUE self)
+{
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_VARIANCEP);
 }
 
+/* @overload stddev
+
+Returns the square root of #variance.
+*/
+
 static VALUE
-rb_ca_cumcount (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_stddev (VALUE self)
 {
-  return rb_ca_stat_type2(argc, argv, self, CA_INT32, ca_proc_cumcount);
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_STDDEV);
 }
 
+/* @overload stddevp
+
+Returns the square root of #variancep.
+*/
+
 static VALUE
-rb_ca_dimcumcount (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_stddevp (VALUE self)
 {
-  return rb_ca_dimstat_type2(argc, argv, self, CA_INT32, ca_proc_cumcount);
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_STDDEVP);
 }
 
+/* @overload min
+
+Returns the minimum of the valid elements.
+*/
+
 static VALUE
-rb_ca_cumsum (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_min (VALUE self)
 {
-  return rb_ca_stat_type2(argc, argv, self, CA_FLOAT64, ca_proc_cumsum);
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_MIN);
 }
 
+/* @overload max
+
+Returns the maximum of the valid elements.
+*/
+
 static VALUE
-rb_ca_dimcumsum (int argc, VALUE *argv, VALUE self)
+rb_stat_accum_max (VALUE self)
 {
-  return rb_ca_dimstat_type2(argc, argv, self, CA_FLOAT64, ca_proc_cumsum);
+  return rb_stat_accum_result(self, CA_STAT_ACCUM_MAX);
 }
 
 void
@@ -1993,6 +4414,43 @@ Init_carray_stat_proc ()
   rb_define_method(rb_cCArray, "dimcumcount", rb_ca_dimcumcount, -1);
   rb_define_method(rb_cCArray, "cumsum",    rb_ca_cumsum, -1);
   rb_define_method(rb_cCArray, "dimcumsum", rb_ca_dimcumsum, -1);
+
+  rb_define_method(rb_cCArray, "describe",    rb_ca_describe, -1);
+  rb_define_method(rb_cCArray, "dimdescribe", rb_ca_dimdescribe, -1);
+
+  rb_define_method(rb_cCArray, "median",     rb_ca_median, -1);
+  rb_define_method(rb_cCArray, "percentile", rb_ca_percentile, -1);
+  rb_define_method(rb_cCArray, "quantile",   rb_ca_quantile, -1);
+
+  rb_define_method(rb_cCArray, "nlargest",       rb_ca_nlargest, -1);
+  rb_define_method(rb_cCArray, "nlargest_addr",  rb_ca_nlargest_addr, -1);
+  rb_define_method(rb_cCArray, "nsmallest",      rb_ca_nsmallest, -1);
+  rb_define_method(rb_cCArray, "nsmallest_addr", rb_ca_nsmallest_addr, -1);
+
+  rb_define_method(rb_cCArray, "group_reduce", rb_ca_group_reduce, -1);
+
+  rb_cCAStatAccumulator = rb_define_class("CAStatAccumulator", rb_cObject);
+  rb_define_alloc_func(rb_cCAStatAccumulator, rb_stat_accum_s_allocate);
+  rb_define_method(rb_cCAStatAccumulator, "initialize", 
+                   rb_stat_accum_initialize, -1);
+  rb_define_method(rb_cCAStatAccumulator, "initialize_copy", 
+                   rb_stat_accum_initialize_copy, 1);
+  rb_define_method(rb_cCAStatAccumulator, "<<", rb_stat_accum_push, 1);
+  rb_define_method(rb_cCAStatAccumulator, "merge!", rb_stat_accum_merge_bang, 1);
+  rb_define_method(rb_cCAStatAccumulator, "merge", rb_stat_accum_merge, 1);
+  rb_define_method(rb_cCAStatAccumulator, "reset", rb_stat_accum_reset, 0);
+  rb_define_method(rb_cCAStatAccumulator, "data_type", rb_stat_accum_data_type, 0);
+  rb_define_method(rb_cCAStatAccumulator, "dim", rb_stat_accum_dim, 0);
+  rb_define_method(rb_cCAStatAccumulator, "count", rb_stat_accum_count, 0);
+  rb_define_method(rb_cCAStatAccumulator, "sum", rb_stat_accum_sum, 0);
+  rb_define_method(rb_cCAStatAccumulator, "mean", rb_stat_accum_mean, 0);
+  rb_define_method(rb_cCAStatAccumulator, "m2", rb_stat_accum_m2, 0);
+  rb_define_method(rb_cCAStatAccumulator, "variance", rb_stat_accum_variance, 0);
+  rb_define_method(rb_cCAStatAccumulator, "variancep", rb_stat_accum_variancep, 0);
+  rb_define_method(rb_cCAStatAccumulator, "stddev", rb_stat_accum_stddev, 0);
+  rb_define_method(rb_cCAStatAccumulator, "stddevp", rb_stat_accum_stddevp, 0);
+  rb_define_method(rb_cCAStatAccumulator, "min", rb_stat_accum_min, 0);
+  rb_define_method(rb_cCAStatAccumulator, "max", rb_stat_accum_max, 0);
 }
 
 
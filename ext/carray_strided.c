@@ -0,0 +1,667 @@
+/* ---------------------------------------------------------------------------
+
+  carray_strided.c
+
+  This file is part of Ruby/CArray extension library.
+
+  Copyright (C) 2005-2025 Hiroki Motoyoshi
+
+---------------------------------------------------------------------------- */
+
+/*
+  Strided view of the arrays (see CAStrided in carray.h). A virtual array
+  is usually attached before the operation, that is, its elements are
+  gathered from the parent into a private buffer (and scattered back by
+  ca_sync). When the virtual array is a regular slice of an entity array,
+  the elements are located by per-dimension strides over the buffer of
+  the entity, and the operation can run on the buffer directly.
+
+  ca_strided_view() returns 0 if the array can not be viewed in this way
+  (other kinds of virtual arrays, reinterpreted bytes, or a virtual array
+  attached at the moment somewhere in the parent chain).
+*/
+
+#include "carray.h"
+
+extern int8_t CA_OBJ_TRANSPOSE;
+
+/* sets the row-major contiguous strides for the shape (sv->bytes is given) */
+
+void
+ca_strided_set_contiguous (CAStrided *sv, int8_t ndim, ca_size_t *dim)
+{
+  ca_size_t s = sv->bytes;
+  int8_t i;
+  sv->ndim = ndim;
+  for (i=ndim-1; i>=0; i--) {
+    sv->dim[i]    = dim[i];
+    sv->stride[i] = s;
+    s *= dim[i];
+  }
+}
+
+/* returns true if the view is row-major contiguous */
+
+int
+ca_strided_is_contiguous (CAStrided *sv)
+{
+  ca_size_t s = sv->bytes;
+  int8_t i;
+  for (i=sv->ndim-1; i>=0; i--) {
+    if ( sv->dim[i] != 1 && sv->stride[i] != s ) {
+      return 0;
+    }
+    s *= sv->dim[i];
+  }
+  return 1;
+}
+
+/*
+  Locates the elements at the linear addresses base + sum(idx[i]*d[i])
+  (0 <= idx[i] < count[i]) of the parent viewed by p. The addresses are
+  decomposed into the index of p, and the view is strided if no digit of
+  the index carries over within the range. Returns 0 otherwise.
+*/
+
+static int
+ca_strided_affine (CAStrided *p, ca_size_t base,
+                   int8_t ndim, ca_size_t *count, ca_size_t *d, CAStrided *sv)
+{
+  ca_size_t lo[CA_RANK_MAX], hi[CA_RANK_MAX], c[CA_RANK_MAX];
+  ca_size_t a, ext, stride;
+  int8_t i, k;
+
+  sv->root = p->root;
+  sv->ptr  = p->ptr;
+  sv->ndim = ndim;
+
+  if ( ca_strided_is_contiguous(p) ) {
+    sv->ptr += base * p->bytes;
+    for (i=0; i<ndim; i++) {
+      sv->dim[i]    = count[i];
+      sv->stride[i] = d[i] * p->bytes;
+    }
+    return 1;
+  }
+
+  for (k=0; k<p->ndim; k++) {
+    if ( p->dim[k] <= 0 ) {
+      return 0;
+    }
+  }
+
+  a = base;
+  for (k=p->ndim-1; k>=0; k--) {
+    lo[k] = hi[k] = a % p->dim[k];
+    sv->ptr += lo[k] * p->stride[k];
+    a /= p->dim[k];
+  }
+  if ( a != 0 ) {
+    return 0;
+  }
+
+  for (i=0; i<ndim; i++) {
+    sv->dim[i] = count[i];
+    stride = 0;
+    if ( count[i] > 1 ) {
+      a = ( d[i] < 0 ) ? -d[i] : d[i];
+      for (k=p->ndim-1; k>=0; k--) {
+        c[k] = a % p->dim[k];
+        a /= p->dim[k];
+      }
+      if ( a != 0 ) {
+        return 0;
+      }
+      for (k=0; k<p->ndim; k++) {
+        if ( d[i] < 0 ) {
+          c[k] = -c[k];
+        }
+        ext = ( count[i] - 1 ) * c[k];
+        if ( ext < 0 ) {
+          lo[k] += ext;
+        }
+        else {
+          hi[k] += ext;
+        }
+        stride += c[k] * p->stride[k];
+      }
+    }
+    sv->stride[i] = stride;
+  }
+
+  for (k=0; k<p->ndim; k++) {
+    if ( lo[k] < 0 || hi[k] >= p->dim[k] ) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* address in the parent is offset + sum((start[i]+idx[i]*step[i])*size0[i+1...]) */
+
+static int
+ca_block_strided_view (CABlock *cb, CAStrided *sv)
+{
+  CAStrided p;
+  ca_size_t d[CA_RANK_MAX];
+  ca_size_t base, s;
+  int8_t i;
+
+  if ( ! ca_strided_view(cb->parent, &p) ) {
+    return 0;
+  }
+
+  base = cb->offset;
+  s = 1;
+  for (i=cb->ndim-1; i>=0; i--) {
+    base += cb->start[i] * s;
+    d[i]  = cb->step[i] * s;
+    s *= cb->size0[i];
+  }
+
+  sv->bytes = cb->bytes;
+  return ca_strided_affine(&p, base, cb->ndim, cb->count, d, sv);
+}
+
+/* address in the parent is offset + (address in the reference) */
+
+static int
+ca_refer_strided_view (CARefer *cr, CAStrided *sv)
+{
+  CAStrided p;
+  ca_size_t d[CA_RANK_MAX];
+  ca_size_t s;
+  int8_t i;
+
+  /* CARefer with the different bytes reinterprets the elements */
+  if ( cr->is_deformed != 0 && cr->is_deformed != 1 ) {
+    return 0;
+  }
+
+  if ( ! ca_strided_view(cr->parent, &p) ) {
+    return 0;
+  }
+
+  s = 1;
+  for (i=cr->ndim-1; i>=0; i--) {
+    d[i] = s;
+    s *= cr->dim[i];
+  }
+
+  sv->bytes = cr->bytes;
+  return ca_strided_affine(&p, cr->offset, cr->ndim, cr->dim, d, sv);
+}
+
+static int
+ca_strided_view_virtual (CArray *ca, CAStrided *sv)
+{
+  if ( ca->obj_type == CA_OBJ_BLOCK ) {
+    return ca_block_strided_view((CABlock *) ca, sv);
+  }
+  else if ( ca->obj_type == CA_OBJ_REFER ) {
+    return ca_refer_strided_view((CARefer *) ca, sv);
+  }
+  else if ( ca->obj_type == CA_OBJ_TRANSPOSE ) {
+    return ca_trans_strided_view(ca, sv);
+  }
+  else {
+    return 0;
+  }
+}
+
+int
+ca_strided_view (void *ap, CAStrided *sv)
+{
+  CArray *ca = (CArray *) ap;
+
+  if ( ca_is_entity(ca) ) {
+    sv->root  = ca;
+    sv->ptr   = ca->ptr;
+    sv->bytes = ca->bytes;
+    ca_strided_set_contiguous(sv, ca->ndim, ca->dim);
+    return 1;
+  }
+
+  /* the attached virtual array has the private buffer to be synchronized */
+  if ( CAVIRTUAL(ca)->attach ) {
+    return 0;
+  }
+
+  return ca_strided_view_virtual(ca, sv);
+}
+
+/*
+  Collapsing the chain of views. Attaching a virtual array attaches its
+  parent first, so the virtual array over a virtual array copies the
+  elements once for every level of the chain (and the whole of each
+  ancestor, not only the part viewed). When the chain collapses into a
+  strided view of the root entity array, ca_attach(), ca_sync(),
+  ca_detach(), ca_copy_data(), ca_sync_data() and ca_fill_data() move
+  the elements between the root and the buffer directly in one pass.
+  The array attached in this way carries CA_FLAG_STRIDED_ATTACH.
+*/
+
+static int
+ca_strided_chain (CArray *ca, CAStrided *sv)
+{
+  if ( ! ca_is_virtual(ca) || ca_is_entity(CAVIRTUAL(ca)->parent) ) {
+    return 0;
+  }
+  return ca_strided_view_virtual(ca, sv);
+}
+
+enum {
+  CA_STRIDED_GATHER,
+  CA_STRIDED_SCATTER,
+  CA_STRIDED_FILL,
+};
+
+/* fills n elements at the stride with the value q */
+
+#define proc_strided_fill_row(type)                              \
+  {                                                              \
+    type v_ = *(type *) q;                                       \
+    for (i=0; i<n; i++, p+=stride) { *(type *) p = v_; }         \
+  }
+
+static void
+ca_strided_fill_row (char *p, ca_size_t stride,
+                     char *q, ca_size_t bytes, ca_size_t n)
+{
+  ca_size_t i;
+  switch ( bytes ) {
+  case 1: proc_strided_fill_row(int8_t);  break;
+  case 2: proc_strided_fill_row(int16_t); break;
+  case 4: proc_strided_fill_row(int32_t); break;
+  case 8: proc_strided_fill_row(int64_t); break;
+  default:
+    for (i=0; i<n; i++, p+=stride) {
+      memcpy(p, q, bytes);
+    }
+  }
+}
+
+/*
+  Copies the elements between two strided views of the same shape.
+  After dropping the unit dimensions and merging the dimensions
+  contiguous in both views, the dimension "a" fastest in the destination
+  and the dimension "b" fastest in the source are taken. If they are the
+  same, the elements are copied row by row along it. Otherwise (general
+  axis permutations, the transposes) the plane (b, a) is copied in square
+  tiles small enough for the L1 cache, so that both the reads and the
+  writes stay on a few cache lines and pages. The units (one row, or one
+  tile for each index of the other dimensions) are distributed over the
+  worker pool.
+*/
+
+typedef struct { uint64_t w[2]; } ca_strided_e16_t;
+
+#define proc_strided_copy_row(type)                                 \
+  for (i=0; i<n; i++, p+=ps, q+=qs) { *(type *) p = *(type *) q; }
+
+static void
+ca_strided_copy_row (char *p, ca_size_t ps, char *q, ca_size_t qs,
+                     ca_size_t bytes, ca_size_t n)
+{
+  ca_size_t i;
+
+  if ( ps == bytes && qs == bytes ) {
+    memcpy(p, q, n * bytes);
+    return;
+  }
+
+  switch ( bytes ) {
+  case 1:  proc_strided_copy_row(int8_t);  break;
+  case 2:  proc_strided_copy_row(int16_t); break;
+  case 4:  proc_strided_copy_row(int32_t); break;
+  case 8:  proc_strided_copy_row(int64_t); break;
+  case 16: proc_strided_copy_row(ca_strided_e16_t); break;
+  default:
+    for (i=0; i<n; i++, p+=ps, q+=qs) {
+      memcpy(p, q, bytes);
+    }
+  }
+}
+
+typedef struct {
+  char     *dst;
+  char     *src;
+  ca_size_t bytes;
+  int8_t    a;                      /* fastest in dst */
+  int8_t    b;                      /* fastest in src (-1 for rows) */
+  int8_t    nouter;
+  int8_t    outer[CA_RANK_MAX];
+  ca_size_t dim[CA_RANK_MAX];
+  ca_size_t ds[CA_RANK_MAX];
+  ca_size_t ss[CA_RANK_MAX];
+  ca_size_t ta;                     /* tile size along a */
+  ca_size_t tb;                     /* tile size along b */
+  ca_size_t nta;                    /* number of tiles along a */
+  ca_size_t ntb;                    /* number of tiles along b */
+  ca_size_t nunit;
+  ca_size_t width;                  /* elements per unit for the pool */
+} ca_strided_copy_t;
+
+static void
+ca_strided_copy_unit (ca_strided_copy_t *c, ca_size_t u)
+{
+  char *p = c->dst, *q = c->src;
+  ca_size_t a0, a1, b0, b1, ia, ib, k;
+  int8_t l, j;
+
+  if ( c->b < 0 ) {
+    for (j=c->nouter-1; j>=0; j--) {
+      l = c->outer[j];
+      k = u % c->dim[l];
+      u /= c->dim[l];
+      p += k * c->ds[l];
+      q += k * c->ss[l];
+    }
+    ca_strided_copy_row(p, c->ds[c->a], q, c->ss[c->a], c->bytes,
+                        c->dim[c->a]);
+    return;
+  }
+
+  a0 = ( u % c->nta ) * c->ta;
+  u /= c->nta;
+  b0 = ( u % c->ntb ) * c->tb;
+  u /= c->ntb;
+  for (j=c->nouter-1; j>=0; j--) {
+    l = c->outer[j];
+    k = u % c->dim[l];
+    u /= c->dim[l];
+    p += k * c->ds[l];
+    q += k * c->ss[l];
+  }
+
+  a1 = ( a0 + c->ta < c->dim[c->a] ) ? a0 + c->ta : c->dim[c->a];
+  b1 = ( b0 + c->tb < c->dim[c->b] ) ? b0 + c->tb : c->dim[c->b];
+
+  /* the rows run along the longer side of the tile */
+  if ( a1 - a0 >= b1 - b0 ) {
+    p += a0 * c->ds[c->a];
+    q += a0 * c->ss[c->a];
+    for (ib=b0; ib<b1; ib++) {
+      ca_strided_copy_row(p + ib * c->ds[c->b], c->ds[c->a],
+                          q + ib * c->ss[c->b], c->ss[c->a],
+                          c->bytes, a1 - a0);
+    }
+  }
+  else {
+    p += b0 * c->ds[c->b];
+    q += b0 * c->ss[c->b];
+    for (ia=a0; ia<a1; ia++) {
+      ca_strided_copy_row(p + ia * c->ds[c->a], c->ds[c->b],
+                          q + ia * c->ss[c->a], c->ss[c->b],
+                          c->bytes, b1 - b0);
+    }
+  }
+}
+
+static void
+ca_strided_copy_chunk (ca_size_t start, ca_size_t end, void *arg)
+{
+  ca_strided_copy_t *c = (ca_strided_copy_t *) arg;
+  ca_size_t u;
+  for (u=start/c->width; u<end/c->width; u++) {
+    ca_strided_copy_unit(c, u);
+  }
+}
+
+#define CA_ABS(x) ( ( (x) < 0 ) ? -(x) : (x) )
+
+void
+ca_strided_copy (CAStrided *dst, CAStrided *src, int nogvl)
+{
+  ca_strided_copy_t c;
+  ca_size_t elements = 1, tile;
+  int8_t nd = 0, l;
+
+  for (l=0; l<dst->ndim; l++) {
+    if ( dst->dim[l] == 0 ) {
+      return;
+    }
+    if ( dst->dim[l] == 1 ) {
+      continue;
+    }
+    elements *= dst->dim[l];
+    if ( nd > 0 && c.ds[nd-1] == dst->stride[l] * dst->dim[l]
+                && c.ss[nd-1] == src->stride[l] * dst->dim[l] ) {
+      c.dim[nd-1] *= dst->dim[l];
+      c.ds[nd-1]   = dst->stride[l];
+      c.ss[nd-1]   = src->stride[l];
+      continue;
+    }
+    c.dim[nd] = dst->dim[l];
+    c.ds[nd]  = dst->stride[l];
+    c.ss[nd]  = src->stride[l];
+    nd++;
+  }
+  if ( nd == 0 ) {
+    c.dim[0] = 1;
+    c.ds[0]  = dst->bytes;
+    c.ss[0]  = src->bytes;
+    nd = 1;
+  }
+
+  c.dst   = dst->ptr;
+  c.src   = src->ptr;
+  c.bytes = dst->bytes;
+  c.a     = nd - 1;
+  c.b     = nd - 1;
+  for (l=nd-1; l>=0; l--) {
+    if ( CA_ABS(c.ds[l]) < CA_ABS(c.ds[c.a]) ) {
+      c.a = l;
+    }
+    if ( CA_ABS(c.ss[l]) < CA_ABS(c.ss[c.b]) ) {
+      c.b = l;
+    }
+  }
+  if ( c.a == c.b ) {
+    c.b = -1;
+  }
+
+  c.nouter = 0;
+  c.nunit  = 1;
+  for (l=0; l<nd; l++) {
+    if ( l != c.a && l != c.b ) {
+      c.outer[c.nouter++] = l;
+      c.nunit *= c.dim[l];
+    }
+  }
+
+  if ( c.b >= 0 ) {
+    /* square tiles of tile x tile elements, stretched along the other
+       side when one of the dimensions is narrower than the tile */
+    tile = ( c.bytes <= 2 ) ? 64 : ( c.bytes <= 8 ) ? 32 : 16;
+    c.ta = ( c.dim[c.a] < tile ) ? c.dim[c.a] : tile;
+    c.tb = ( c.dim[c.b] < tile ) ? c.dim[c.b] : tile;
+    if ( c.ta < tile ) {
+      c.tb = ( c.dim[c.b] < tile*tile/c.ta ) ? c.dim[c.b] : tile*tile/c.ta;
+    }
+    else if ( c.tb < tile ) {
+      c.ta = ( c.dim[c.a] < tile*tile/c.tb ) ? c.dim[c.a] : tile*tile/c.tb;
+    }
+    c.nta  = ( c.dim[c.a] + c.ta - 1 ) / c.ta;
+    c.ntb  = ( c.dim[c.b] + c.tb - 1 ) / c.tb;
+    c.nunit *= c.nta * c.ntb;
+  }
+
+  c.width = elements / c.nunit;
+  if ( c.width < 1 ) {
+    c.width = 1;
+  }
+
+  ca_parallel_for(c.nunit * c.width, nogvl, ca_strided_copy_chunk, &c);
+}
+
+/* walks the view row by row after merging the contiguous dimensions,
+   the elements are gathered or scattered by ca_strided_copy() */
+
+static void
+ca_strided_walk (CAStrided *sv, int mode, char *q)
+{
+  ca_size_t dim[CA_RANK_MAX], stride[CA_RANK_MAX], idx[CA_RANK_MAX];
+  ca_size_t rows = 1, r;
+  int8_t nd = 0, l, last;
+  char *p;
+
+  if ( mode != CA_STRIDED_FILL ) {
+    CAStrided cv;
+    cv.root  = sv->root;
+    cv.ptr   = q;
+    cv.bytes = sv->bytes;
+    ca_strided_set_contiguous(&cv, sv->ndim, sv->dim);
+    if ( mode == CA_STRIDED_GATHER ) {
+      ca_strided_copy(&cv, sv, ! ca_is_object_type(sv->root));
+    }
+    else {
+      ca_strided_copy(sv, &cv, ! ca_is_object_type(sv->root));
+    }
+    return;
+  }
+
+  for (l=0; l<sv->ndim; l++) {
+    if ( sv->dim[l] == 0 ) {
+      return;
+    }
+    if ( sv->dim[l] == 1 ) {
+      continue;
+    }
+    if ( nd > 0 && stride[nd-1] == sv->stride[l] * sv->dim[l] ) {
+      dim[nd-1]   *= sv->dim[l];
+      stride[nd-1] = sv->stride[l];
+      continue;
+    }
+    dim[nd]    = sv->dim[l];
+    stride[nd] = sv->stride[l];
+    nd++;
+  }
+  if ( nd == 0 ) {
+    dim[0]    = 1;
+    stride[0] = sv->bytes;
+    nd = 1;
+  }
+
+  last = nd - 1;
+  for (l=0; l<last; l++) {
+    idx[l] = 0;
+    rows *= dim[l];
+  }
+
+  for (r=0; r<rows; r++) {
+    p = sv->ptr;
+    for (l=0; l<last; l++) {
+      p += idx[l] * stride[l];
+    }
+    ca_strided_fill_row(p, stride[last], q, sv->bytes, dim[last]);
+    for (l=last-1; l>=0; l--) {
+      if ( ++idx[l] < dim[l] ) {
+        break;
+      }
+      idx[l] = 0;
+    }
+  }
+}
+
+int
+ca_strided_attach (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  CAStrided sv;
+  /* attached CARefer shares the buffer of the attached parent */
+  if ( ca->obj_type == CA_OBJ_REFER || ! ca_strided_chain(ca, &sv) ) {
+    return 0;
+  }
+  ca->ptr = malloc_with_check(ca_length(ca));
+  ca_strided_walk(&sv, CA_STRIDED_GATHER, ca->ptr);
+  ca_set_flag(ca, CA_FLAG_STRIDED_ATTACH);
+  return 1;
+}
+
+int
+ca_strided_sync (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  CAStrided sv;
+  if ( ! ca_test_flag(ca, CA_FLAG_STRIDED_ATTACH) ) {
+    return 0;
+  }
+  if ( ca_strided_chain(ca, &sv) ) {
+    ca_strided_walk(&sv, CA_STRIDED_SCATTER, ca->ptr);
+  }
+  else {   /* an ancestor has been attached after ca */
+    ca_func[ca->obj_type].sync_data(ca, ca->ptr);
+  }
+  return 1;
+}
+
+int
+ca_strided_detach (void *ap)
+{
+  CArray *ca = (CArray *) ap;
+  if ( ! ca_test_flag(ca, CA_FLAG_STRIDED_ATTACH) ) {
+    return 0;
+  }
+  free(ca->ptr);
+  ca->ptr = NULL;
+  ca_unset_flag(ca, CA_FLAG_STRIDED_ATTACH);
+  return 1;
+}
+
+int
+ca_strided_copy_data (void *ap, char *ptr)
+{
+  CAStrided sv;
+  if ( ! ca_strided_chain((CArray *) ap, &sv) ) {
+    return 0;
+  }
+  ca_strided_walk(&sv, CA_STRIDED_GATHER, ptr);
+  return 1;
+}
+
+int
+ca_strided_sync_data (void *ap, char *ptr)
+{
+  CAStrided sv;
+  if ( ! ca_strided_chain((CArray *) ap, &sv) ) {
+    return 0;
+  }
+  ca_strided_walk(&sv, CA_STRIDED_SCATTER, ptr);
+  return 1;
+}
+
+int
+ca_strided_fill_data (void *ap, char *val)
+{
+  CAStrided sv;
+  if ( ! ca_strided_chain((CArray *) ap, &sv) ) {
+    return 0;
+  }
+  ca_strided_walk(&sv, CA_STRIDED_FILL, val);
+  return 1;
+}
+
+/* @overload strided?
+
+(Inquiry) Returns true if the elements of `self` are located by
+per-dimension strides over the buffer of an entity array (entity arrays,
+and CABlock, CARefer and CATranspose of them). The operators work on such
+arrays without copying the elements into a temporary buffer.
+*/
+
+static VALUE
+rb_ca_is_strided (VALUE self)
+{
+  CArray *ca;
+  CAStrided sv;
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  return ca_strided_view(ca, &sv) ? Qtrue : Qfalse;
+}
+
+void
+Init_carray_strided ()
+{
+  rb_define_method(rb_cCArray, "strided?", rb_ca_is_strided, 0);
+}
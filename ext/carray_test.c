@@ -519,7 +519,7 @@ ca_hash (CArray *ca)
 
   if ( ca_is_any_masked(ca) ) {
     ca_size_t bytes = ca->bytes;
-    boolean8_t *m = (boolean8_t*) ca->mask->ptr;
+    boolean8_t *m = ca_mask_ptr(ca);
     /* char *tptr = ALLOC_N(char, ca_length(ca)); */
     char *tptr = malloc_with_check(ca_length(ca));
     char *p;
@@ -570,9 +570,12 @@ rb_ca_hash (VALUE self)
 void
 rb_ca_modify (VALUE self)
 {
+  CArray *ca;
   if ( OBJ_FROZEN(self) ) {
     rb_error_frozen("CArray object");
   }
+  TypedData_Get_Struct(self, CArray, &carray_data_type, ca);
+  ca_mask_touch(ca);     /* forget the cached state of mask */
   /*
   if ( ( ! OBJ_TAINTED(self) ) && rb_safe_level() >= 4 ) {
     rb_raise(rb_eSecurityError, "Insecure: can't modify carray");
@@ -67,6 +67,41 @@ end
 # --- seting $CFLAGS
 
 $CFLAGS += " -Wall -O2"
+
+# --- enable "#pragma omp simd" for vectorizing the contiguous loops 
+#     of the kernels generated by mkmath.rb (OpenMP runtime is not required)
+
+if try_cflags("-fopenmp-simd")
+  $CFLAGS += " -fopenmp-simd"
+  $defs.push "-DHAVE_OPENMP_SIMD"
+end
+# --- math functions like sqrt() can be inlined when errno is not required
+
+if try_cflags("-fno-math-errno")
+  $CFLAGS += " -fno-math-errno"
+end
+
+# --- build the kernels in several ISA variants selected at runtime by
+#     CPU features (see carray_simd.c). The contraction to FMA is disabled
+#     so that all the variants give the same results.
+
+if try_compile(<<HERE_END)
+__attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+static int f512 (void) { return 0; }
+__attribute__((target("avx2")))
+static int f256 (void) { return 0; }
+__attribute__((target("sse4.2")))
+static int f128 (void) { return 0; }
+int main () {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? f256() : ( f512() + f128() );
+}
+HERE_END
+  $defs.push "-DHAVE_CA_SIMD_DISPATCH"
+  if try_cflags("-ffp-contract=off")
+    $CFLAGS += " -ffp-contract=off"
+  end
+end
 # $CFLAGS += " -m128bit-long-double"  ### gcc only
 # $CFLAGS += " -Wno-absolute-value"
 # $LDFLAGS += " -L/usr/local/opt/llvm/lib -Wl,-rpath,/usr/local/opt/llvm/lib"
@@ -152,6 +187,12 @@ have_func("strptime", "time.h")
 
 have_func("rb_arithmetic_sequence_extract")
 
+# --- check the worker pool support (carray_parallel.c)
+
+have_header("unistd.h")
+have_header("pthread.h")
+have_func("rb_thread_call_without_gvl", "ruby/thread.h")
+
 # --- setup install files
 
 $INSTALLFILES = []
@@ -192,7 +233,8 @@ if ( not File.exist?("carray_cast_func.c") ) or
 end
 
 if ( not File.exist?("carray_math.c") ) or
-    File.stat("carray_math.rb").mtime > File.stat("carray_math.c").mtime
+    File.stat("carray_math.rb").mtime > File.stat("carray_math.c").mtime or
+    File.stat("mkmath.rb").mtime > File.stat("carray_math.c").mtime
   system("ruby carray_math.rb")
 end
 
@@ -228,7 +270,7 @@ carray_cast_func.c: carray_cast_func.rb
 carray_stat_proc.c: carray_stat_proc.rb
 	${RUBY} carray_stat_proc.rb > carray_stat_proc.c
 
-carray_math.c: carray_math.rb
+carray_math.c: carray_math.rb mkmath.rb
 	${RUBY} carray_math.rb
 
 yard:
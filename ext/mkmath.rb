@@ -12,10 +12,157 @@
 
 require 'stringio'
 
+#
+# Contiguous (stride-1), mask-free loops are emitted as separate branches
+# in each kernel so that the compiler can vectorize them. The pointer
+# variables are declared inside the loop body so that no loop-carried
+# dependency exists for the vectorizer.
+#
+# The kernels themselves are serial. Large arrays are split into chunks
+# and processed by the worker pool in carray_parallel.c (see
+# carray_operator.c), so the kernels for VALUE (which call Ruby API) are
+# never called outside of GVL.
+#
+
+def simd_branch (simd_ok, cond, ptrs, expr)
+  return "" if simd_ok == 0
+  decls = ptrs.select { |type, var, init| expr =~ /\b#{var}\b/ }.
+               map { |type, var, init| "#{type} *#{var} = #{init};" }.join(" ")
+  return %{else if ( #{cond} ) {
+    CA_PRAGMA_SIMD
+    for (k=0; k<n; k++) {
+      #{decls}
+      {
+        #{expr}
+      }
+    }
+  }
+  }
+end
+
+#
+# The pointer variables not referenced by the expression (e.g. p1 of zero
+# or is_nan for the integer types) are neither declared nor assigned.
+#
+
+def ptr_used (expr, var)
+  return expr =~ /\b#{var}\b/
+end
+
+def ptr_decls (expr, ptrs)
+  return ptrs.select { |type, var, init| ptr_used(expr, "p#{var}") }.
+              map { |type, var, init| "#{type} *q#{var} = #{init}, *p#{var} = q#{var};" }.
+              join("\n  ")
+end
+
+def ptr_assigns (expr, ptrs, sep = " ")
+  return ptrs.select { |var, step| ptr_used(expr, "p#{var}") }.
+              map { |var, step| "p#{var} = q#{var} + k*#{step};" }.join(sep)
+end
+
+#
+# The kernels take the mask as the packed words (1 bit per element, see
+# carray.h and carray_bitmask.c), and the masked loops read a word per 64
+# elements. A block without masked elements runs without the test of each
+# element, a fully masked block is skipped, and the unmasked elements of
+# the other blocks are visited by the trailing zero count.
+#
+
+def masked_loop (assigns, expr)
+  return %{    ca_size_t k0, kn;
+    uint64_t w;
+    for (k0=0; k0<n; k0+=CA_MASK_WORD_BITS) {
+      kn = ( n - k0 < CA_MASK_WORD_BITS ) ? n - k0 : CA_MASK_WORD_BITS;
+      w = m[k0 / CA_MASK_WORD_BITS] & ca_mask_word_fill(kn);
+      if ( w == 0 ) {
+        for (k=k0; k<k0+kn; k++) {
+          #{assigns}
+          {
+            #{expr}
+          }
+        }
+      }
+      else {
+        w = ~w & ca_mask_word_fill(kn);
+        while ( w ) {
+          k = k0 + ca_ctz64(w);
+          w &= w - 1;
+          #{assigns}
+          {
+            #{expr}
+          }
+        }
+      }
+    }
+}
+end
+
+#
+# The kernels for the types in SIMD_TYPES are also emitted in the ISA
+# variants listed in SIMD_VARIANTS (compiled with the target attributes
+# CA_TARGET_*). carray_simd.c detects the CPU features at the initialization
+# and copies the best variants into the kernel tables through
+# ca_math_simd_setup(). The order of SIMD_VARIANTS follows CA_SIMD_*
+# in carray.h (the level 0 is the baseline kernel).
+#
+
+SIMD_VARIANTS = [
+  ["sse42",  "CA_TARGET_SSE42"],
+  ["avx2",   "CA_TARGET_AVX2"],
+  ["avx512", "CA_TARGET_AVX512"],
+]
+
+SIMD_TYPES = %w[boolean8_t int8_t uint8_t int16_t uint16_t int32_t uint32_t
+                int64_t uint64_t float32_t float64_t cmplx64_t cmplx128_t]
+
+SIMD_TABLES = []
+
+def simd_variants (type, kernel)
+  return "" if not SIMD_TYPES.include?(type)
+  return SIMD_VARIANTS.map { |suffix, target| kernel.call("_#{suffix}", "#{target} ") }.join
+end
+
+def simd_table (kind, name, hash, variants)
+  return "" if variants.empty?
+  table_types = ALL_TYPES.each_index.map { |i|
+    type = nil
+    hash.each do |types, expr|
+      if not expr
+        next
+      end
+      type ||= types[i]
+    end
+    type
+  }
+  rows = ([nil] + SIMD_VARIANTS.map { |suffix, target| suffix }).map { |suffix|
+    list = table_types.map { |type|
+      if not type
+        "ca_#{kind}_not_implement"
+      elsif suffix and SIMD_TYPES.include?(type)
+        "ca_#{kind}_#{name}_#{type}_#{suffix}"
+      else
+        "ca_#{kind}_#{name}_#{type}"
+      end
+    }
+    "  {\n    " + list.join(",\n    ") + "\n  }"
+  }
+  SIMD_TABLES << "ca_#{kind}_#{name}"
+  return %{
+#ifdef HAVE_CA_SIMD_DISPATCH
+#{variants}
+static ca_#{kind}_bits_func_t
+ca_#{kind}_#{name}_simd[CA_SIMD_NLEVEL][CA_NTYPE] = {
+#{rows.join(",\n")}
+};
+#endif
+}
+end
+
 def monfunc (op, name, hash)
   io = StringIO.new
   io.puts
   io.puts "/*----------------------- #{name} --------------------------*/"
+  variants = ""
   hash.each do |types, expr0|
     if not expr0
       next
@@ -24,37 +171,22 @@ def monfunc (op, name, hash)
     types.each do |type|
       if type
         expr = expr0.gsub(/<type>/, type)
-        omp_ok = ( type != "VALUE" ) ? 1 : 0
-        io.print %{
-static void
-ca_monop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1, char *ptr2, ca_size_t i2)
+        simd_ok = ( type != "VALUE" ) ? 1 : 0
+        fast = simd_branch(simd_ok, "i1 == 1 && i2 == 1",
+                           [[type, "p1", "q1 + k"], [type, "p2", "q2 + k"]], expr) +
+               simd_branch(simd_ok, "i1 == 0 && i2 == 1",
+                           [[type, "p1", "q1"], [type, "p2", "q2 + k"]], expr)
+        kernel = lambda { |suffix, target| %{
+static #{target}void
+ca_monop_#{name}_#{type}#{suffix} (ca_size_t n, uint64_t *m, char *ptr1, ca_size_t i1, char *ptr2, ca_size_t i2)
 {
-  #{type} *q1 = (#{type} *) ptr1, *q2 = (#{type} *) ptr2;
-  #{type} *p1 = q1, *p2 = q2;
+  #{ptr_decls(expr, [[type, 1, "(#{type} *) ptr1"], [type, 2, "(#{type} *) ptr2"]])}
   ca_size_t k;
   if ( m ) {
-    boolean8_t *pm;
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(pm,p1,p2)
-    #endif
+#{masked_loop(ptr_assigns(expr, [[1, "i1"], [2, "i2"]]), expr)}  }
+  #{fast}else {
     for (k=0; k<n; k++) {
-      pm = m + k;
-      if ( ! *pm ) {
-        p1 = q1 + k*i1;
-        p2 = q2 + k*i2;
-        {
-          #{expr} 
-        }
-      }
-    }
-  }
-  else {
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(p1,p2)
-    #endif
-    for (k=0; k<n; k++) {
-      p1 = q1 + k*i1;
-      p2 = q2 + k*i2;
+      #{ptr_assigns(expr, [[1, "i1"], [2, "i2"]], "\n      ")}
       {
         #{expr}
       }
@@ -62,11 +194,14 @@ ca_monop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1,
   }
 }
 }
+        }
+        io.print kernel.call("", "")
+        variants << simd_variants(type, kernel)
       end
     end
   end
   io.puts
-  io.puts "ca_monop_func_t"
+  io.puts "ca_monop_bits_func_t"
   io.puts "ca_monop_#{name}[CA_NTYPE] = {"
   ALL_TYPES.each_index do |i|
     type = nil
@@ -84,10 +219,22 @@ ca_monop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1,
   end
   io.puts "};"
   io.puts
-  if hash.has_key?(INT_TYPES) or hash.has_key?(ALL_TYPES)
+  io.print simd_table("monop", name, hash, variants)
+  float_only = ! [INT_TYPES, SINT_TYPES, UINT_TYPES, ALL_TYPES].any? { |t| hash.has_key?(t) }
+  MONOP_ENTRIES << [op, name, float_only]
+  if not float_only
     io.print %{
 static VALUE rb_ca_#{name} (VALUE self)
 { return rb_ca_call_monop(self, ca_monop_#{name}); }
+static VALUE rb_ca_#{name}_method (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 0, 0);
+  if ( NIL_P(rout) ) {
+    return rb_ca_#{name}(self);
+  }
+  return rb_ca_call_monop_to(self, rout, ca_monop_#{name});
+}
 }
   else
     io.print %{
@@ -98,6 +245,18 @@ static VALUE rb_ca_#{name} (VALUE self)
   }
   return rb_ca_call_monop(self, ca_monop_#{name}); 
 }
+static VALUE rb_ca_#{name}_method (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 0, 0);
+  if ( NIL_P(rout) ) {
+    return rb_ca_#{name}(self);
+  }
+  if ( rb_ca_is_integer_type(self) ) {
+    self = rb_ca_wrap_readonly(self, INT2NUM(CA_FLOAT64));
+  }
+  return rb_ca_call_monop_to(self, rout, ca_monop_#{name});
+}
 }
   end
   io.print %{
@@ -107,18 +266,18 @@ static VALUE rb_ca_#{name}_bang (VALUE self)
   DEFINITIONS << io.string
   if op
     METHODS     << %{
-  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}, 0);
+  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}_method, -1);
 }
   end
   METHODS     << %{
   rb_define_method(rb_cCArray, "#{name}!", rb_ca_#{name}_bang, 0);
 }
   DEFINITIONS << %{
-static VALUE rb_cmath_#{name} (VALUE mod, VALUE arg)
-{ return ca_math_call(mod, arg, rb_intern("#{name}")); }
+static VALUE rb_cmath_#{name} (int argc, VALUE *argv, VALUE mod)
+{ return ca_math_call_with_options(mod, argc, argv, rb_intern("#{name}")); }
 }
   METHODS << %{
-  rb_define_module_function(rb_mCAMath, "#{name}", rb_cmath_#{name}, 1);
+  rb_define_module_function(rb_mCAMath, "#{name}", rb_cmath_#{name}, -1);
 }
 end
 
@@ -127,6 +286,7 @@ def monop (op, name, hash)
   io = StringIO.new
   io.puts
   io.puts "/*----------------------- #{name} --------------------------*/"
+  variants = ""
   hash.each do |types, expr0|
     if not expr0
       next
@@ -135,37 +295,22 @@ def monop (op, name, hash)
     types.each do |type|
       if type
         expr = expr0.gsub(/<type>/, type)
-        omp_ok = ( type != "VALUE" ) ? 1 : 0
-        io.print %{
-static void
-ca_monop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1, char *ptr2, ca_size_t i2)
+        simd_ok = ( type != "VALUE" ) ? 1 : 0
+        fast = simd_branch(simd_ok, "i1 == 1 && i2 == 1",
+                           [[type, "p1", "q1 + k"], [type, "p2", "q2 + k"]], expr) +
+               simd_branch(simd_ok, "i1 == 0 && i2 == 1",
+                           [[type, "p1", "q1"], [type, "p2", "q2 + k"]], expr)
+        kernel = lambda { |suffix, target| %{
+static #{target}void
+ca_monop_#{name}_#{type}#{suffix} (ca_size_t n, uint64_t *m, char *ptr1, ca_size_t i1, char *ptr2, ca_size_t i2)
 {
-  #{type} *q1 = (#{type} *) ptr1, *q2 = (#{type} *) ptr2;
-  #{type} *p1 = q1, *p2 = q2;
+  #{ptr_decls(expr, [[type, 1, "(#{type} *) ptr1"], [type, 2, "(#{type} *) ptr2"]])}
   ca_size_t k;
   if ( m ) {
-    boolean8_t *pm;
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(pm,p1,p2)
-    #endif
-    for (k=0; k<n; k++) {
-      pm = m + k;
-      if ( ! *pm ) {
-        p1 = q1 + k*i1;
-        p2 = q2 + k*i2;
-        {
-          #{expr} 
-        }
-      }
-    }
-  }
-  else {
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(p1,p2)
-    #endif
+#{masked_loop(ptr_assigns(expr, [[1, "i1"], [2, "i2"]]), expr)}  }
+  #{fast}else {
     for (k=0; k<n; k++) {
-      p1 = q1 + k*i1;
-      p2 = q2 + k*i2;
+      #{ptr_assigns(expr, [[1, "i1"], [2, "i2"]], "\n      ")}
       {
         #{expr} 
       }
@@ -173,11 +318,14 @@ ca_monop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1,
   }
 }
 }
+        }
+        io.print kernel.call("", "")
+        variants << simd_variants(type, kernel)
       end
     end
   end
   io.puts
-  io.puts "ca_monop_func_t"
+  io.puts "ca_monop_bits_func_t"
   io.puts "ca_monop_#{name}[CA_NTYPE] = {"
   ALL_TYPES.each_index do |i|
     type = nil
@@ -195,16 +343,27 @@ ca_monop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1,
   end
   io.puts "};"
   io.puts
+  io.print simd_table("monop", name, hash, variants)
+  MONOP_ENTRIES << [op, name, false]
   io.print %{
 static VALUE rb_ca_#{name} (VALUE self)
 { return rb_ca_call_monop(self, ca_monop_#{name}); }
+static VALUE rb_ca_#{name}_method (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 0, 0);
+  if ( NIL_P(rout) ) {
+    return rb_ca_#{name}(self);
+  }
+  return rb_ca_call_monop_to(self, rout, ca_monop_#{name});
+}
 static VALUE rb_ca_#{name}_bang (VALUE self)
 { return rb_ca_call_monop_bang(self, ca_monop_#{name}); }
   }
   DEFINITIONS << io.string
   if op
     METHODS     << %{
-  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}, 0);
+  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}_method, -1);
 }
   end
   METHODS     << %{
@@ -217,6 +376,7 @@ def binop (op, name, hash)
   io = StringIO.new
   io.puts
   io.puts "/*----------------------- #{name} --------------------------*/"
+  variants = ""
   hash.each do |types, expr0|
     if not expr0
       next
@@ -225,39 +385,24 @@ def binop (op, name, hash)
     types.each do |type|
       if type
         expr = expr0.gsub(/<type>/, type)
-        omp_ok = ( type != "VALUE" ) ? 1 : 0
-        io.print %{
-static void
-ca_binop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1, char *ptr2, ca_size_t i2, char *ptr3, ca_size_t i3)
+        simd_ok = ( type != "VALUE" ) ? 1 : 0
+        fast = simd_branch(simd_ok, "i1 == 1 && i2 == 1 && i3 == 1",
+                           [[type, "p1", "q1 + k"], [type, "p2", "q2 + k"], [type, "p3", "q3 + k"]], expr) +
+               simd_branch(simd_ok, "i1 == 1 && i2 == 0 && i3 == 1",
+                           [[type, "p1", "q1 + k"], [type, "p2", "q2"], [type, "p3", "q3 + k"]], expr) +
+               simd_branch(simd_ok, "i1 == 0 && i2 == 1 && i3 == 1",
+                           [[type, "p1", "q1"], [type, "p2", "q2 + k"], [type, "p3", "q3 + k"]], expr)
+        kernel = lambda { |suffix, target| %{
+static #{target}void
+ca_binop_#{name}_#{type}#{suffix} (ca_size_t n, uint64_t *m, char *ptr1, ca_size_t i1, char *ptr2, ca_size_t i2, char *ptr3, ca_size_t i3)
 {
-  #{type} *q1 = (#{type} *) ptr1, *q2 = (#{type} *) ptr2, *q3 = (#{type} *) ptr3;
-  #{type} *p1 = q1, *p2 = q2, *p3 = q3;
+  #{ptr_decls(expr, [[type, 1, "(#{type} *) ptr1"], [type, 2, "(#{type} *) ptr2"], [type, 3, "(#{type} *) ptr3"]])}
   ca_size_t k;
   if ( m ) {
-    boolean8_t *pm;
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(pm,p1,p2,p3)
-    #endif
+#{masked_loop(ptr_assigns(expr, [[1, "i1"], [2, "i2"], [3, "i3"]]), expr)}  }
+  #{fast}else {
     for (k=0; k<n; k++) {
-      pm = m + k;
-      if ( ! *pm ) {
-        p1 = q1 + k*i1;
-        p2 = q2 + k*i2;
-        p3 = q3 + k*i3;
-        {
-          #{expr} 
-        }
-      }
-    }
-  }
-  else {
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(p1,p2,p3)
-    #endif
-    for (k=0; k<n; k++) {
-      p1 = q1 + k*i1;
-      p2 = q2 + k*i2;
-      p3 = q3 + k*i3;
+      #{ptr_assigns(expr, [[1, "i1"], [2, "i2"], [3, "i3"]], "\n      ")}
       {
         #{expr}
       }
@@ -265,11 +410,14 @@ ca_binop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1,
   }
 }
 }
+        }
+        io.print kernel.call("", "")
+        variants << simd_variants(type, kernel)
       end
     end
   end
   io.puts
-  io.puts "ca_binop_func_t"
+  io.puts "ca_binop_bits_func_t"
   io.puts "ca_binop_#{name}[CA_NTYPE] = {"
   ALL_TYPES.each_index do |i|
     type = nil
@@ -287,6 +435,8 @@ ca_binop_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1,
   end
   io.puts "};"
   io.puts
+  io.print simd_table("binop", name, hash, variants)
+  BINOP_ENTRIES << [op, name]
   io.print %{
 static VALUE rb_ca_#{name} (VALUE self, VALUE other)
 { 
@@ -295,13 +445,22 @@ static VALUE rb_ca_#{name} (VALUE self, VALUE other)
   }
   return rb_ca_call_binop(self, other, ca_binop_#{name}); 
 }
+static VALUE rb_ca_#{name}_method (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 1, 1);
+  if ( NIL_P(rout) ) {
+    return rb_ca_#{name}(self, argv[0]);
+  }
+  return rb_ca_call_binop_to(self, argv[0], rout, ca_binop_#{name});
+}
 static VALUE rb_ca_#{name}_bang (VALUE self, VALUE other)
 { return rb_ca_call_binop_bang(self, other, ca_binop_#{name}); }
   }
   DEFINITIONS << io.string
   if op
     METHODS     << %{
-  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}, 1);
+  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}_method, -1);
 }
   end
   METHODS     << %{
@@ -314,6 +473,7 @@ def moncmp (op, name, hash)
   io = StringIO.new
   io.puts
   io.puts "/*----------------------- #{name} --------------------------*/"
+  variants = ""
   hash.each do |types, expr0|
     if not expr0
       next
@@ -322,39 +482,20 @@ def moncmp (op, name, hash)
     types.each do |type|
       if type
         expr = expr0.gsub(/<type>/, type)
-        omp_ok = ( type != "VALUE" ) ? 1 : 0
-        io.print %{
-static void
-ca_moncmp_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1, boolean8_t *ptr2, ca_size_t i2)
+        simd_ok = ( type != "VALUE" ) ? 1 : 0
+        fast = simd_branch(simd_ok, "i1 == 1 && i2 == 1",
+                           [[type, "p1", "q1 + k"], ["boolean8_t", "p2", "q2 + k"]], expr)
+        kernel = lambda { |suffix, target| %{
+static #{target}void
+ca_moncmp_#{name}_#{type}#{suffix} (ca_size_t n, uint64_t *m, char *ptr1, ca_size_t i1, boolean8_t *ptr2, ca_size_t i2)
 {
-  #{type} *q1 = (#{type} *) ptr1;
-  #{type} *p1 = q1;
-  boolean8_t *q2 = (boolean8_t *) ptr2;
-  boolean8_t *p2 = q2;
+  #{ptr_decls(expr, [[type, 1, "(#{type} *) ptr1"], ["boolean8_t", 2, "(boolean8_t *) ptr2"]])}
   ca_size_t k;
   if ( m ) {
-    boolean8_t *pm = m;
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(pm,p1,p2)
-    #endif
-    for (k=0; k<n; k++) {
-      pm = m + k;
-      if ( ! *pm ) {
-        p1 = q1 + k*i1;
-        p2 = q2 + k*i2;
-        {
-          #{expr} 
-        }
-      }
-    }
-  }
-  else {
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(p1,p2)
-    #endif
+#{masked_loop(ptr_assigns(expr, [[1, "i1"], [2, "i2"]]), expr)}  }
+  #{fast}else {
     for (k=0; k<n; k++) {
-      p1=q1+k*i1;
-      p2=q2+k*i2;
+      #{ptr_assigns(expr, [[1, "i1"], [2, "i2"]], "\n      ")}
       {
         #{expr}
       }
@@ -362,11 +503,14 @@ ca_moncmp_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1,
   }
 }
 }
+        }
+        io.print kernel.call("", "")
+        variants << simd_variants(type, kernel)
       end
     end
   end
   io.puts
-  io.puts "ca_moncmp_func_t"
+  io.puts "ca_moncmp_bits_func_t"
   io.puts "ca_moncmp_#{name}[CA_NTYPE] = {"
   ALL_TYPES.each_index do |i|
     type = nil
@@ -384,14 +528,24 @@ ca_moncmp_#{name}_#{type} (ca_size_t n, boolean8_t *m, char *ptr1, ca_size_t i1,
   end
   io.puts "};"
   io.puts
+  io.print simd_table("moncmp", name, hash, variants)
   io.print %{
 static VALUE rb_ca_#{name} (VALUE self)
 { return rb_ca_call_moncmp(self, ca_moncmp_#{name}); }
+static VALUE rb_ca_#{name}_method (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 0, 0);
+  if ( NIL_P(rout) ) {
+    return rb_ca_#{name}(self);
+  }
+  return rb_ca_call_moncmp_to(self, rout, ca_moncmp_#{name});
+}
   }
   DEFINITIONS << io.string
   if op
     METHODS     << %{
-  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}, 0);
+  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}_method, -1);
 }
   end
 end
@@ -406,6 +560,7 @@ def bincmp (op, name, hash)
   io = StringIO.new
   io.puts
   io.puts "/*----------------------- #{name} --------------------------*/"
+  variants = ""
   hash.each do |types, expr0|
     if not expr0
       next
@@ -417,44 +572,27 @@ def bincmp (op, name, hash)
         expr.gsub!(/<type>/, type)
         expr.gsub!(/<epsilon>/, EPSILON[type]||"")
         if type != "fixlen"
-          omp_ok = ( type != "VALUE" ) ? 1 : 0
-          io.print %{
-static void
-ca_bincmp_#{name}_#{type} (ca_size_t n, boolean8_t *m, 
+          simd_ok = ( type != "VALUE" ) ? 1 : 0
+          fast = simd_branch(simd_ok, "i1 == 1 && i2 == 1 && i3 == 1",
+                             [[type, "p1", "q1 + k"], [type, "p2", "q2 + k"], ["boolean8_t", "p3", "q3 + k"]], expr) +
+                 simd_branch(simd_ok, "i1 == 1 && i2 == 0 && i3 == 1",
+                             [[type, "p1", "q1 + k"], [type, "p2", "q2"], ["boolean8_t", "p3", "q3 + k"]], expr) +
+                 simd_branch(simd_ok, "i1 == 0 && i2 == 1 && i3 == 1",
+                             [[type, "p1", "q1"], [type, "p2", "q2 + k"], ["boolean8_t", "p3", "q3 + k"]], expr)
+          kernel = lambda { |suffix, target| %{
+static #{target}void
+ca_bincmp_#{name}_#{type}#{suffix} (ca_size_t n, uint64_t *m, 
                            char *ptr1, ca_size_t b1, ca_size_t i1, 
                            char *ptr2, ca_size_t b2, ca_size_t i2, 
                            char *ptr3, ca_size_t b3, ca_size_t i3)
 {
-  #{type} *q1 = (#{type} *) ptr1, *q2 = (#{type} *) ptr2;
-  #{type} *p1 = q1, *p2 = q2;
-  boolean8_t *q3 = (boolean8_t *) ptr3;
-  boolean8_t *p3 = q3;
+  #{ptr_decls(expr, [[type, 1, "(#{type} *) ptr1"], [type, 2, "(#{type} *) ptr2"], ["boolean8_t", 3, "(boolean8_t *) ptr3"]])}
   ca_size_t k;
   if ( m ) {
-    boolean8_t *pm = m;
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(pm,p1,p2,p3)
-    #endif
+#{masked_loop(ptr_assigns(expr, [[1, "i1"], [2, "i2"], [3, "i3"]]), expr)}  }
+  #{fast}else {
     for (k=0; k<n; k++) {
-      pm = m + k;
-      if ( ! *pm ) {
-        p1 = q1 + k*i1;
-        p2 = q2 + k*i2;
-        p3 = q3 + k*i3;
-        {
-          #{expr} 
-        }
-      }
-    }
-  }
-  else {
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(p1,p2,p3)
-    #endif
-    for (k=0; k<n; k++) {
-      p1=q1+k*i1;
-      p2=q2+k*i2;
-      p3=q3+k*i3;
+      #{ptr_assigns(expr, [[1, "i1"], [2, "i2"], [3, "i3"]], "\n      ")}
       {
         #{expr}
       }
@@ -462,11 +600,13 @@ ca_bincmp_#{name}_#{type} (ca_size_t n, boolean8_t *m,
   }
 }
 }
+          }
+          io.print kernel.call("", "")
+          variants << simd_variants(type, kernel)
         else ### fixlen
-          omp_ok = 1
           io.print %{
 static void
-ca_bincmp_#{name}_#{type} (ca_size_t n, boolean8_t *m, 
+ca_bincmp_#{name}_#{type} (ca_size_t n, uint64_t *m, 
                            char *ptr1, ca_size_t b1, ca_size_t i1, 
                            char *ptr2, ca_size_t b2, ca_size_t i2, 
                            char *ptr3, ca_size_t b3, ca_size_t i3)
@@ -478,26 +618,8 @@ ca_bincmp_#{name}_#{type} (ca_size_t n, boolean8_t *m,
   ca_size_t s1 = b1*i1, s2 = b2*i2, s3 = b3*i3;
   ca_size_t k;
   if ( m ) {
-    boolean8_t *pm = m;
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(pm,p1,p2,p3)
-    #endif
-    for (k=0; k<n; k++) {
-      pm = m + k;
-      if ( ! *pm ) {
-        p1 = q1 + k*s1;
-        p2 = q2 + k*s2;
-        p3 = q3 + k*s3;
-        {
-          #{expr} 
-        }
-      }
-    }
-  }
+#{masked_loop("p1 = q1 + k*s1; p2 = q2 + k*s2; p3 = q3 + k*s3;", expr)}  }
   else {
-    #if defined(_OPENMP) && #{omp_ok}
-    #pragma omp parallel for private(p1,p2,p3)
-    #endif
     for (k=0; k<n; k++) {
       p1=q1+k*s1;
       p2=q2+k*s2;
@@ -514,7 +636,7 @@ ca_bincmp_#{name}_#{type} (ca_size_t n, boolean8_t *m,
     end
   end
   io.puts
-  io.puts "ca_bincmp_func_t"
+  io.puts "ca_bincmp_bits_func_t"
   io.puts "ca_bincmp_#{name}[CA_NTYPE] = {"
   ALL_TYPES.each_index do |i|
     type = nil
@@ -532,6 +654,7 @@ ca_bincmp_#{name}_#{type} (ca_size_t n, boolean8_t *m,
   end
   io.puts "};"
   io.puts
+  io.print simd_table("bincmp", name, hash, variants)
   io.print %{
 static VALUE rb_ca_#{name} (VALUE self, VALUE other)
 { 
@@ -539,12 +662,21 @@ static VALUE rb_ca_#{name} (VALUE self, VALUE other)
     return rb_ca_binop_pass_to_other(self, other, rb_intern("#{op}"));
   }
   return rb_ca_call_bincmp(self, other, ca_bincmp_#{name});
+}
+static VALUE rb_ca_#{name}_method (int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE rout = rb_ca_pop_out(&argc, &argv);
+  rb_check_arity(argc, 1, 1);
+  if ( NIL_P(rout) ) {
+    return rb_ca_#{name}(self, argv[0]);
+  }
+  return rb_ca_call_bincmp_to(self, argv[0], rout, ca_bincmp_#{name});
 }
   }
   DEFINITIONS << io.string
   if op
     METHODS     << %{
-  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}, 1);
+  rb_define_method(rb_cCArray, "#{op}", rb_ca_#{name}_method, -1);
 }
   end
 end
@@ -615,6 +747,9 @@ INT_TYPES = [
   nil,
 ]
 
+SINT_TYPES = INT_TYPES.map { |t| ( t and t !~ /\Au/ ) ? t : nil }
+UINT_TYPES = INT_TYPES.map { |t| ( t and t =~ /\Au/ ) ? t : nil }
+
 FLOAT_TYPES = [
   nil,
   nil,
@@ -712,6 +847,9 @@ HEADERS     = ""
 DEFINITIONS = ""
 METHODS     = ""
 
+MONOP_ENTRIES = []
+BINOP_ENTRIES = []
+
 CODETEXT    = <<HERE
 <headers>
 
@@ -728,11 +866,56 @@ Init_<name> ()
 
 HERE
 
+#
+# The tables of monop/binop kernels looked up by method name (used by CALazy)
+#
+
+def entry_tables
+  io = StringIO.new
+  io.puts
+  io.puts "ca_monop_entry_t"
+  io.puts "ca_monop_entries[] = {"
+  MONOP_ENTRIES.each do |op, name, float_only|
+    io.puts %{  { "#{op}", ca_monop_#{name}, #{float_only ? 1 : 0} },}
+  end
+  io.puts "  { NULL, NULL, 0 }"
+  io.puts "};"
+  io.puts
+  io.puts "ca_binop_entry_t"
+  io.puts "ca_binop_entries[] = {"
+  BINOP_ENTRIES.each do |op, name|
+    io.puts %{  { "#{op}", ca_binop_#{name} },}
+  end
+  io.puts "  { NULL, NULL }"
+  io.puts "};"
+  return io.string
+end
+
+#
+# ca_math_simd_setup() copies the kernels of the given simd level into the
+# kernel tables (called from carray_simd.c)
+#
+
+def simd_setup
+  io = StringIO.new
+  io.puts
+  io.puts "void"
+  io.puts "ca_math_simd_setup (int level)"
+  io.puts "{"
+  io.puts "#ifdef HAVE_CA_SIMD_DISPATCH"
+  SIMD_TABLES.each do |table|
+    io.puts "  memcpy(#{table}, #{table}_simd[level], sizeof(#{table}));"
+  end
+  io.puts "#endif"
+  io.puts "}"
+  return io.string
+end
+
 def create_code (name, filename)
   code = CODETEXT.clone
   code.sub!("<name>", name)
   code.sub!("<headers>", HEADERS)
-  code.sub!("<definitions>", DEFINITIONS)
+  code.sub!("<definitions>", DEFINITIONS + entry_tables + simd_setup)
   code.sub!("<methods>", METHODS)
   open(filename, "w") { |io|
     io.write code
@@ -74,6 +74,19 @@ void Init_ca_iter_window ();
 
 void Init_carray_mathfunc ();
 
+void Init_carray_lazy ();
+
+void Init_carray_parallel ();
+
+void Init_carray_simd ();
+
+void Init_carray_hash ();
+
+void Init_carray_set ();
+void Init_carray_sorted_index ();
+void Init_carray_bitmask ();
+void Init_carray_strided ();
+
 void
 Init_carray_ext ()
 {
@@ -269,6 +282,19 @@ Init_carray_ext ()
 
   Init_carray_mathfunc();
 
+  Init_carray_lazy();
+
+  Init_carray_parallel();
+
+  Init_carray_simd();
+
+  Init_carray_hash();
+
+  Init_carray_set();
+  Init_carray_sorted_index();
+  Init_carray_bitmask();
+  Init_carray_strided();
+
 
 }
 
@@ -33,6 +33,7 @@ require 'carray/ordering'
 require 'carray/broadcast'
 
 require 'carray/math'
+require 'carray/lazy'
 require 'carray/iterator'
 require 'carray/struct'
 require 'carray/table'
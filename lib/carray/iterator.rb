@@ -314,7 +314,7 @@ class CAClassIterator < CAIterator # :nodoc:
   
   def initialize (reference, classifier = nil)
     @reference = reference
-    @classifier = classifier || @reference.uniq.sort
+    @classifier = classifier || @reference.uniq(sorted: true)
     @null = CArray.new(@reference.data_type,[0])
     @null.data_class = @reference.data_class if @reference.has_data_class?
     @table = {}
@@ -0,0 +1,80 @@
+# ----------------------------------------------------------------------------
+#
+#  carray/lazy.rb
+#
+#  This file is part of Ruby/CArray extension library.
+#
+#  Copyright (C) 2005-2025 Hiroki Motoyoshi
+#
+# ----------------------------------------------------------------------------
+
+#
+# CALazy records elementwise operations on CArray objects as an expression
+# and evaluates them at once in chunks when #evaluate (or #to_ca) is called.
+#
+#   a = CArray.float64(1000000).seq
+#   b = CArray.float64(1000000).random
+#   c = (a.lazy * b + 1).sin.to_ca   # no intermediate arrays are created
+#
+class CALazy
+
+  monop_names.each do |name|
+    define_method(name) {
+      monop(name)
+    }
+  end
+
+  binop_names.each do |name|
+    define_method(name) { |other|
+      binop(name, other)
+    }
+  end
+
+  def -@
+    monop("neg")
+  end
+
+  def ~
+    monop("bit_neg")
+  end
+
+  def +@
+    self
+  end
+
+  def ** (other)
+    binop("power", other)
+  end
+
+  def abs
+    case data_type
+    when CA_CMPLX64, CA_CMPLX128, CA_CMPLX256
+      raise CArray::DataTypeError, "abs for complex type is not supported in lazy evaluation"
+    else
+      monop("abs_i")
+    end
+  end
+
+  def castable_to_carray?
+    false
+  end
+
+  def inspect
+    "#<CALazy data_type=#{CArray.data_type_name(data_type)}>"
+  end
+
+end
+
+module CA
+
+  # Evaluates the block with the given arrays wrapped by CArray#lazy, and
+  # returns the evaluated result as a new array.
+  #
+  #   c = CA.expr(a, b) { |x, y| (x * y + 1).sqrt }
+  #
+  def self.expr (*args)
+    res = yield(*args.map { |a| a.is_a?(CArray) ? a.lazy : a })
+    return res.is_a?(CALazy) ? res.evaluate : res
+  end
+
+end
@@ -30,18 +30,16 @@ class CArray
   # Returns the number of masked elements.
   # 
   def count_masked (*axis)
-    if has_mask?  
+    if axis.empty?
+      return __count_masked__
+    elsif has_mask?  
       return mask.int64.accumulate(*axis)
     else
-      if axis.empty?
-        return 0
-      else
-        spec = shape.map{:i}
-        axis.each do |k|
-          spec[k] = nil
-        end
-        return self[*spec].ca.template(:int64) { 0 }
+      spec = shape.map{:i}
+      axis.each do |k|
+        spec[k] = nil
       end
+      return self[*spec].ca.template(:int64) { 0 }
     end
   end
 
@@ -49,20 +47,18 @@ class CArray
   # Returns the number of not-masked elements.
   #
   def count_not_masked (*axis)
-    if has_mask?
+    if axis.empty?
+      return __count_not_masked__
+    elsif has_mask?
       return mask.not.int64.accumulate(*axis)
     else
-      if axis.empty?
-        return elements
-      else
-        spec = shape.map {:i}
-        axis.each do |k|
-          spec[k] = nil
-        end
-        it = self[*spec].ca
-        count = self.elements/it.elements
-        return it.template(:int64) { count }
+      spec = shape.map {:i}
+      axis.each do |k|
+        spec[k] = nil
       end
+      it = self[*spec].ca
+      count = self.elements/it.elements
+      return it.template(:int64) { count }
     end
   end
 
@@ -234,79 +234,6 @@ class CArray
 
   alias anom anomaly
 
-  def median (*argv)
-    opt = argv.last.is_a?(Hash) ? argv.pop : {}
-    min_count  = opt[:mask_limit]
-    if min_count and min_count < 0
-      min_count += elements
-    end
-    fill_value = opt[:fill_value]
-    if argv.empty?
-      if has_mask?
-        if min_count and count_masked() > min_count
-          return fill_value || UNDEF
-        end
-        c = self[:is_not_masked].sort
-        n = self.count_not_masked
-      else
-        c = self.sort
-        n = c.elements
-      end
-      if n == 0
-        return fill_value || UNDEF
-      else
-        return (c[(n-1)/2] + c[n/2])/2.0
-      end
-    else
-      raise "CArray#median is not implemented for multiple ndims"
-    end
-
-  end
-
-  def percentile (*argv)
-    opt = argv.last.is_a?(Hash) ? argv.pop : {}
-    pers = argv
-    min_count  = opt[:mask_limit]
-    if min_count and min_count < 0
-      min_count += elements
-    end
-    fill_value = opt[:fill_value]
-    if has_mask?
-      if min_count and count_masked() > min_count
-        return argv.map { fill_value || UNDEF }
-      end
-      ca = self[:is_not_masked].sort
-      n  = self.count_not_masked
-    else
-      ca = self.sort
-      n  = ca.elements
-    end
-    out = []
-    begin
-      pers.each do |per|
-        if per == 100
-          out << ca[n-1]
-        elsif per >= 0 and per < 100
-          if n > 1
-            f = (n-1)*per/100.0
-            k = f.floor
-            r = f - k
-            out << (1-r)*ca[k] + r*ca[k+1]
-          else
-            out << ca[0]
-          end
-        else
-          out << CA_NAN
-        end
-      end
-    end
-    return out
-  end
-  
-  def quantile 
-    return percentile(0, 25, 50, 75, 100)
-  end
-
   def covariancep (y, min_count = nil, fill_value = nil)
     x = self.double
     y = y.double
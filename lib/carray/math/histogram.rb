@@ -99,15 +99,12 @@ class CAHistogram < CArray
 
   def add (*values)
     val = CArray.wrap_readonly(values.pop, self.data_type)
-    sel = val.ne(0)
-    val = val[sel].to_ca
     idx = Array.new(ndim) {|i|
-      vi = CArray.wrap_readonly(values[i], CA_DOUBLE)[sel]
+      vi = CArray.wrap_readonly(values[i], CA_DOUBLE)
       @scales[i].bin(vi, @include_upper, @include_lowest, @offsets[i]).to_ca
     }
-    index2addr(*idx).each_with_addr do |addr, i|
-      self[addr] += val[i]
-    end
+    addr, sum = val.group_reduce(index2addr(*idx), :sum)
+    self[addr] += sum
     self
   end
 
@@ -31,11 +31,6 @@ class CArray
     return shifted(*argv)
   end
 
-  def roll! (*argv)
-    self[] = self.rolled(*argv)
-    return self
-  end
-
   def roll (*argv)
     return self.rolled(*argv).to_ca
   end
@@ -108,50 +103,6 @@ class CArray
     return (self.min)..(self.max)
   end
 
-  def nlargest (n)
-    obj = self.to_ca
-    list = []
-    n.times do |i|
-      k = obj.max_addr
-      list << obj[k]
-      obj[k] = UNDEF
-    end
-    list.to_ca.to_type(data_type)
-  end
-
-  def nlargest_addr (n)
-    obj = self.to_ca
-    list = []
-    n.times do |i|
-      k = obj.max_addr
-      list << k
-      obj[k] = UNDEF
-    end
-    CA_INT64(list)
-  end
-
-  def nsmallest (n)
-    obj = self.to_ca
-    list = []
-    n.times do |i|
-      k = obj.min_addr
-      list << obj[k]
-      obj[k] = UNDEF
-    end
-    list.to_ca.to_type(data_type)
-  end
-
-  def nsmallest_addr (n)
-    obj = self.to_ca
-    list = []
-    n.times do |i|
-      k = obj.min_addr
-      list << k
-      obj[k] = UNDEF
-    end
-    CA_INT64(list)
-  end
-
   def order (dir = 1)
     if dir >= 0   ### ascending order
       if has_mask?
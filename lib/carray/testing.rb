@@ -36,16 +36,5 @@ class CArray
     end
     return list
   end
-  
-  # Returns the array eliminated all the duplicated elements.
-  def uniq
-    ary = flatten.to_a.uniq
-    if has_mask?
-      ary.delete(UNDEF)
-    end
-    out = CArray.new(data_type, [ary.length], :bytes=>bytes) { ary }
-    out.data_class = data_class if has_data_class?
-    return out
-  end
 
 end
\ No newline at end of file
@@ -47,11 +47,6 @@ class CArray
     return reshape(elements).to_ca
   end
 
-  def transpose! (*argv)
-    self[] = self.transposed(*argv)
-    return self
-  end
-
   def transpose (*argv)
     return self.transposed(*argv).to_ca
   end
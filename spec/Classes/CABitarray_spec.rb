@@ -0,0 +1,59 @@
+require 'carray'
+require "rspec-power_assert"
+
+describe "TestCArrayCABitarray " do
+
+  example "virtual_array" do
+    a = CArray.uint8(3) { 5 }
+    b = a.bits
+    is_asserted_by { b.class == CABitarray }
+    is_asserted_by { true == b.virtual? }
+    is_asserted_by { b.dim == [3, 8] }
+    is_asserted_by { b.parent == a }
+  end
+
+  example "expand and pack" do
+    a = CA_INT16([1, -1, 0x1234, 0])
+    b = a.bits
+    is_asserted_by { b[0, nil].to_a == [1] + [0]*15 }
+    is_asserted_by { b[1, nil].to_a == [1]*16 }
+    is_asserted_by { b[2, nil].to_a == (0...16).map { |i| (0x1234 >> i) & 1 } }
+    # ---
+    c = CArray.int32(100).seq!.mul!(7919)
+    d = c.to_ca
+    d.bits[] = c.bits.to_ca
+    is_asserted_by { d == c }
+    d.bits[nil, 0] = 1
+    d.bits[nil, 31] = 0
+    is_asserted_by { d == (c | 1) & 0x7fffffff }
+    # --- bits of virtual array
+    c0 = c.to_ca
+    e = c[10..19]
+    e.bits[nil, 1] = 0
+    is_asserted_by { c[10..19] == c0[10..19] & ~2 }
+    is_asserted_by { c[0..9] == c0[0..9] }
+  end
+
+  example "count_true, any? and all?" do
+    a = CArray.uint8(1000).seq!
+    b = a.bits
+    is_asserted_by { b.count_true == b.to_ca.count_true }
+    is_asserted_by { b.count_true == (0...1000).sum { |i| (i % 256).to_s(2).count("1") } }
+    is_asserted_by { b.any? }
+    is_asserted_by { ! b.all? }
+    is_asserted_by { ! CArray.uint8(100).bits.any? }
+    # --- masked elements of the parent are not counted
+    x = CArray.uint8(4) { 255 }
+    is_asserted_by { x.bits.all? }
+    x[1] = 254
+    is_asserted_by { ! x.bits.all? }
+    is_asserted_by { x.bits.count_true == 31 }
+    x[1] = UNDEF
+    is_asserted_by { x.bits.all? }
+    is_asserted_by { x.bits.count_true == 24 }
+    is_asserted_by { x.bits.count_true == x.bits.to_ca.count_true }
+    # --- bits of virtual array
+    is_asserted_by { a[100..199].bits.count_true == a[100..199].to_ca.bits.count_true }
+  end
+
+end
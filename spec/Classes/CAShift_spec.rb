@@ -13,4 +13,37 @@ describe "TestCArrayCAShift " do
     is_asserted_by { a == r }
   end
 
+  example "shift_and_roll" do
+    a = CArray.int(3,4).seq!
+    is_asserted_by { a.shift(1,0) == CA_INT([[0,0,0,0],[0,1,2,3],[4,5,6,7]]) }
+    is_asserted_by { a.shift(0,-1) { 9 } == CA_INT([[1,2,3,9],[5,6,7,9],[9,10,11,9]]) }
+    is_asserted_by { a.shift(5,0) == CArray.int(3,4).zero }
+    is_asserted_by { a.roll(1,-1) == CA_INT([[9,10,11,8],[1,2,3,0],[5,6,7,4]]) }
+    is_asserted_by { a.roll(-2,9) == a.roll(1,1) }
+    b = CArray.float64(3,4).seq!
+    b.shifted(0,1)[] = 7.5
+    is_asserted_by { b == CA_DOUBLE([[7.5,7.5,7.5,3],[7.5,7.5,7.5,7],[7.5,7.5,7.5,11]]) }
+    b = CArray.int(3,4).seq!
+    b.rolled(1,0)[] = CArray.int(3,4).seq!(100)
+    is_asserted_by { b == CA_INT([[104,105,106,107],[108,109,110,111],[100,101,102,103]]) }
+  end
+
+  example "roll!" do
+    a = CArray.int(3,4).seq!
+    is_asserted_by { a.roll!(1,-1).equal?(a) }
+    is_asserted_by { a == CA_INT([[9,10,11,8],[1,2,3,0],[5,6,7,4]]) }
+    a = CArray.float64(4,5,6).seq!
+    b = a.roll(-3,2,7)
+    a.roll!(-3,2,7)
+    is_asserted_by { a == b }
+    a = CArray.int(2,3).seq!
+    a[0,1] = UNDEF
+    a.roll!(0,1)
+    _ = UNDEF
+    is_asserted_by { a == CA_INT([[2,0,_],[5,3,4]]) }
+    a = CArray.int(4,4).seq!
+    a[1..2,1..2].roll!(1,1)
+    is_asserted_by { a[1..2,1..2] == CA_INT([[10,9],[6,5]]) }
+  end
+
 end
@@ -57,4 +57,41 @@ describe "TestCArrayCATranspose " do
 
   end
 
+  example "tiled_copy" do
+    # --- sizes over the tile, element sizes 1, 4, 8, 16
+    [CA_UINT8, CA_FLOAT32, CA_FLOAT64, CA_CMPLX128].each do |type|
+      a = CArray.new(type, [70, 45]).seq!
+      t = a.transposed.to_ca
+      is_asserted_by { t.dim == [45, 70] }
+      is_asserted_by { t[44, 69] == a[69, 44] }
+      is_asserted_by { t[17, 33] == a[33, 17] }
+      is_asserted_by { t.transposed.to_ca == a }
+    end
+    # --- (H,W,C) -> (C,H,W) and back
+    a = CArray.float32(40, 50, 3).seq!
+    t = a.transposed(2, 0, 1).to_ca
+    is_asserted_by { t[2, 39, 49] == a[39, 49, 2] }
+    is_asserted_by { t[1, 7, 30] == a[7, 30, 1] }
+    is_asserted_by { t.transposed(1, 2, 0).to_ca == a }
+    # --- store through transposed view
+    b = CArray.float32(40, 50, 3)
+    b.transposed(2, 0, 1)[] = t
+    is_asserted_by { b == a }
+  end
+
+  example "transpose!" do
+    a = CArray.int(3,4).seq!
+    is_asserted_by { a.transpose!.equal?(a) }
+    is_asserted_by { a == CA_INT([[0,4,8,1],[5,9,2,6],[10,3,7,11]]) }
+    a = CArray.int(3,3).seq!
+    a[1,2] = UNDEF
+    a.transpose!
+    _ = UNDEF
+    is_asserted_by { a == CA_INT([[0,3,6],[1,4,7],[2,_,8]]) }
+    a = CArray.float64(2,3,4).seq!
+    b = a.to_ca
+    a.transpose!(2,0,1)
+    is_asserted_by { a == b.transposed(2,0,1).to_ca.reshape(2,3,4) }
+  end
+
 end
@@ -31,6 +31,34 @@ describe "TestCArrayCAWindow " do
                          [_,3,4]]) == b }
   end
 
+  example "interior_and_boundary" do
+    a = CArray.float64(6,7).seq!
+    w = a.window(-2..3, 3..9, :bounds=>"periodic")
+    is_asserted_by { w.to_ca == a[CA_INT([4,5,0,1,2,3]), CA_INT([3,4,5,6,0,1,2])] }
+    w = a.window(-2..3, -1..8, :bounds=>"reflect")
+    is_asserted_by { w.to_ca == a[CA_INT([1,0,0,1,2,3]), CA_INT([0,0,1,2,3,4,5,6,6,5])] }
+    w = a.window(4..7, -1..2, :bounds=>"nearest")
+    is_asserted_by { w.to_ca == a[CA_INT([4,5,5,5]), CA_INT([0,0,1,2])] }
+    w = a.window(2..3, nil)
+    is_asserted_by { w.to_ca == a[2..3, nil] }
+    w = a.window(5..6, nil) { -1 }
+    is_asserted_by { w.to_ca == CA_DOUBLE([a[5,nil].to_a, [-1]*7]) }
+  end
+
+  example "store_through_window" do
+    a = CArray.float64(4,5).seq!
+    b = a.to_ca
+    a.window(-1..1, 3..6, :bounds=>"fill")[] = 7.5
+    b[0..1, 3..4] = 7.5
+    is_asserted_by { a == b }
+    a = CArray.float64(4,5).seq!
+    a.window(-1..1, 3..5, :bounds=>"periodic")[] = CArray.float64(3,3).seq!(100)
+    is_asserted_by { a == CA_DOUBLE([[105,  1,  2, 103, 104],
+                                      [108,  6,  7, 106, 107],
+                                      [ 10, 11, 12,  13,  14],
+                                      [102, 16, 17, 100, 101]]) }
+  end
+
   example "invalid_args" do
     # ---
     a = CArray.int(3,3).seq
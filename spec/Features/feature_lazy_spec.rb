@@ -0,0 +1,71 @@
+require 'carray'
+require "rspec-power_assert"
+
+describe "Feature: Lazy evaluation" do
+
+  example "arithmetic" do
+    a = CArray.float64(10000).seq!
+    b = CArray.float64(10000).seq!(1, 0.5)
+    x = (a.lazy * b + 1 - a / b).to_ca
+    y = a * b + 1 - a / b
+    is_asserted_by { x.data_type == CA_FLOAT64 }
+    is_asserted_by { x == y }
+  end
+
+  example "math functions and casting" do
+    a = CArray.int32(3, 5000).seq!
+    x = (a.lazy.sin * 2 + a.sqrt).to_ca
+    y = a.sin * 2 + a.sqrt
+    is_asserted_by { x.data_type == CA_FLOAT64 }
+    is_asserted_by { x.dim == [3, 5000] }
+    is_asserted_by { x == y }
+    c = CArray.float32(100).seq!
+    is_asserted_by { (c.lazy + a[0,0..99]).to_ca == c + a[0,0..99] }
+    is_asserted_by { (a[0,0..99].lazy + c).to_ca == a[0,0..99] + c }
+    is_asserted_by { (a.lazy + 1.5).data_type == CA_FLOAT64 }
+  end
+
+  example "scalar and numeric operands" do
+    a = CArray.int32(10).seq!
+    is_asserted_by { (2 * a.lazy - 1).to_ca == 2 * a - 1 }
+    is_asserted_by { (1 - a.lazy).to_ca == 1 - a }
+    is_asserted_by { (-a.lazy).to_ca == -a }
+    is_asserted_by { (a.lazy ** 2).to_ca == a ** 2 }
+    is_asserted_by { (a + a.lazy).to_ca == a + a }
+    s = CScalar.float64 { 3 }
+    x = (s.lazy * 2).to_ca
+    is_asserted_by { x.is_a?(CScalar) }
+    is_asserted_by { x[0] == 6.0 }
+    is_asserted_by { CA.expr(a, 3) { |u, v| (u * v + u).abs } == (a * 3 + a).abs }
+  end
+
+  example "masks" do
+    a = CArray.float64(10).seq!
+    b = CArray.float64(10).seq!
+    a[2] = UNDEF
+    b[5] = UNDEF
+    x = ((a.lazy + b) * 2).to_ca
+    y = (a + b) * 2
+    is_asserted_by { x.count_masked == 2 }
+    is_asserted_by { x == y }
+  end
+
+  example "virtual array operands" do
+    a = CArray.float64(10, 10).seq!
+    x = (a[0..4, nil].lazy + a[5..9, nil].lazy.exp).to_ca
+    is_asserted_by { x == a[0..4, nil] + a[5..9, nil].exp }
+    is_asserted_by { a[0..4, nil].lazy.to_ca == a[0..4, nil] }
+  end
+
+  example "errors" do
+    a = CArray.float64(10).seq!
+    b = CArray.float64(5).seq!
+    expect { (a.lazy + b).to_ca }.to raise_error(RuntimeError)
+    expect { a.lazy & 1 }.to raise_error(CArray::DataTypeError)
+    expect { CArray.object(3).lazy }.to raise_error(CArray::DataTypeError)
+    i = CArray.int32(3) { 0 }
+    expect { (1 / i.lazy).to_ca }.to raise_error(ZeroDivisionError)
+    is_asserted_by { (i.lazy + 1).to_ca == i + 1 }
+  end
+
+end
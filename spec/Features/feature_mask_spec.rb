@@ -565,6 +565,137 @@ describe "Feature: Masking" do
                  a.cumprod(1) }
   end
 
+  example "mask_bits" do
+    a = CArray.int32(200).seq!
+    is_asserted_by { a.mask_bits == 0 }
+    a[CA_INT64([0, 63, 64, 130, 199])] = UNDEF
+    bits = a.mask_bits
+    is_asserted_by { bits.data_type == CA_UINT64 }
+    is_asserted_by { bits.to_a == [1 + 2**63, 1, 4, 2**7] }
+    b = CArray.int32(200).seq!
+    b.mask_bits = bits
+    is_asserted_by { b.is_masked == a.is_masked }
+    expect { b.mask_bits = CArray.uint64(3) }.to raise_error(ArgumentError)
+  end
+
+  example "packed mask" do
+    packed, threads, threshold =
+      CArray.packed_mask, CArray.num_threads, CArray.parallel_threshold
+    begin
+      a = CArray.float64(1000).seq!
+      b = CArray.float64(1000).seq!(1)
+      a[CA_INT64([10, 63, 64, 999])] = UNDEF
+      b[CA_INT64([130, 500])] = UNDEF
+      CArray.packed_mask = false
+      ref = a * b + 1
+
+      # --- results of the operators hold the packed mask
+      CArray.packed_mask = true
+      CArray.num_threads = 4
+      CArray.parallel_threshold = 37    # chunks not aligned to the words
+      x = a * b + 1
+      is_asserted_by { x.mask_packed? }
+      is_asserted_by { x.count_masked == 6 }
+      is_asserted_by { x.count_not_masked == 994 }
+      is_asserted_by { x.any_masked? }
+      is_asserted_by { not x.all_masked? }
+      is_asserted_by { x.has_mask? }
+      is_asserted_by { x.mask_bits == ref.mask_bits }
+      is_asserted_by { (x > 500).mask_packed? }
+      is_asserted_by { (x > 500).count_true == (ref > 500).count_true }
+      is_asserted_by { x.lazy.sqrt.evaluate.mask_packed? }
+      is_asserted_by { x.mask_packed? }
+
+      # --- copies keep the packed mask
+      is_asserted_by { x.to_ca.mask_packed? }
+      is_asserted_by { x.clone.mask_packed? }
+      is_asserted_by { x.dup.mask_packed? }
+      is_asserted_by { x.to_ca.mask_bits == ref.mask_bits }
+
+      # --- zero division is not raised for the masked elements
+      c = CArray.int32(1000) { 1 }
+      d = CArray.int32(1000) { 1 }
+      d[700] = 0
+      m = CArray.int32(1000) { 0 }
+      m[700] = UNDEF
+      e = d + m
+      is_asserted_by { e.mask_packed? }
+      is_asserted_by { (c / e).count_masked == 1 }
+
+      # --- expanded into the mask array when it is referred
+      y = x.to_ca
+      is_asserted_by { y[10] == UNDEF }
+      is_asserted_by { not y.mask_packed? }
+      is_asserted_by { y.mask == ref.mask }
+      is_asserted_by { y == ref }
+      z = x.to_ca
+      z.mask = 0
+      is_asserted_by { z.count_masked == 0 }
+      is_asserted_by { not z.mask_packed? }
+
+      # --- mask_bits=
+      w = CArray.float64(1000).seq!
+      w.mask_bits = ref.mask_bits
+      is_asserted_by { w.mask_packed? }
+      is_asserted_by { w.count_masked == 6 }
+      is_asserted_by { w.is_masked == ref.is_masked }
+
+      CArray.packed_mask = false
+      is_asserted_by { not (a * b).mask_packed? }
+    ensure
+      CArray.packed_mask = packed
+      CArray.num_threads = threads
+      CArray.parallel_threshold = threshold
+    end
+  end
+
+  example "masked kernels" do
+    # --- blocks of 64 elements (unmasked, fully masked, partially masked)
+    a = CArray.float32(300).seq!
+    a[64...128] = UNDEF
+    a[CA_INT64([5, 130, 255, 256, 299])] = UNDEF
+    b = CArray.float32(300).seq!(1000)
+    m = a.is_masked.to_a
+    is_asserted_by { (a + b).is_masked.to_a == m }
+    is_asserted_by { (a + b).to_a == a.to_a.zip(b.to_a).map { |x, y| x == UNDEF ? UNDEF : x + y } }
+    is_asserted_by { (a > 150).to_a == a.to_a.map { |x| x == UNDEF ? UNDEF : (x > 150 ? 1 : 0) } }
+    is_asserted_by { (-a).to_a == a.to_a.map { |x| x == UNDEF ? UNDEF : -x } }
+  end
+
+  example "cached mask state" do
+    a = CArray.float64(100).seq!
+    a[3] = UNDEF
+    a.unmask
+    is_asserted_by { a.has_mask? }
+    is_asserted_by { ! a.any_masked? }
+    is_asserted_by { a.count_masked == 0 }
+    is_asserted_by { (a + 1).to_a == (1..100).to_a }
+    # --- direct store
+    a[5] = UNDEF
+    is_asserted_by { a.any_masked? }
+    is_asserted_by { (a + 1)[5] == UNDEF }
+    # --- store via virtual array
+    a.unmask
+    is_asserted_by { ! a.any_masked? }
+    a[10..20][1] = UNDEF
+    is_asserted_by { a.count_masked == 1 }
+    is_asserted_by { a.sum == (0...100).sum - 11 }
+    # --- store via refer and mask array
+    a.unmask
+    is_asserted_by { ! a.any_masked? }
+    a.refer[7] = UNDEF
+    is_asserted_by { a.is_masked[7] == 1 }
+    a.unmask
+    is_asserted_by { ! a.any_masked? }
+    a.mask[8] = 1
+    is_asserted_by { a.count_masked == 1 }
+    a.unmask
+    is_asserted_by { ! a.any_masked? }
+    a.mask = a > 97
+    is_asserted_by { a.count_masked == 2 }
+    is_asserted_by { (a * 0).is_masked.count_true == 2 }
+  end
+
   example "count_xxx" do
     # TODO
   end
@@ -80,13 +80,91 @@ describe "TestCArrayOrder " do
                                [0,1,2]]) == a.order(-1) }
   end
 
-#  example "uniq" do
-#    a = CArray.int(100).random!(10)
-#
-#    # ---
-#    is_asserted_by { a.to_a.uniq, a.uniq.to_a)
-#
-#  end
+  example "uniq" do
+    a = CA_INT32([3, 1, 3, 2, 1, 3, 7, 2])
+    # ---
+    is_asserted_by { a.uniq.to_a == a.to_a.uniq }
+    is_asserted_by { a.uniq(sorted: true).to_a == [1, 2, 3, 7] }
+    v, c = a.uniq_counts
+    is_asserted_by { v.to_a == [3, 1, 2, 7] }
+    is_asserted_by { c.to_a == [3, 2, 2, 1] }
+    v, c = a.uniq_counts(sorted: true)
+    is_asserted_by { c.to_a == [2, 2, 3, 1] }
+    v, inv = a.reshape(2, 4).uniq_inverse(sorted: true)
+    is_asserted_by { inv.dim == [2, 4] }
+    is_asserted_by { v[inv].flatten == a }
+    # --- masked elements are ignored
+    a[1] = UNDEF
+    v, inv = a.uniq_inverse
+    is_asserted_by { v.to_a == [3, 2, 1, 7] }
+    is_asserted_by { inv.is_masked.to_a == a.is_masked.to_a }
+    # --- 0.0 and -0.0 are same, NaNs are one value
+    f = CA_FLOAT64([0.0, -0.0, 0.0/0.0, 1.5, 0.0/0.0])
+    is_asserted_by { f.uniq.size == 3 }
+    is_asserted_by { f.uniq(sorted: true)[2].nan? }
+    # --- fixlen and object
+    s = CArray.fixlen(4, :bytes => 2)
+    s[] = ["ab", "cd", "ab", "b\0"]
+    is_asserted_by { s.uniq.to_a == ["ab", "cd", "b\0"] }
+    is_asserted_by { s.uniq(sorted: true).to_a == ["ab", "b\0", "cd"] }
+    o = CA_OBJECT(["x", :y, "x", 1, 1])
+    is_asserted_by { o.uniq.to_a == ["x", :y, 1] }
+  end
+
+  example "isin and set operations" do
+    a = CA_INT32([3, 1, 2, 3, 9])
+    b = CA_INT64([3, 4, 1, 4])
+    # ---
+    is_asserted_by { a.isin(b).to_a == [1, 1, 0, 1, 0] }
+    is_asserted_by { a.isin([9]).to_a == [0, 0, 0, 0, 1] }
+    is_asserted_by { a.intersect1d(b).to_a == [1, 3] }
+    is_asserted_by { a.setdiff1d(b).to_a == [2, 9] }
+    is_asserted_by { a.union1d(b).to_a == [1, 2, 3, 4, 9] }
+    # --- masked elements
+    a[0] = UNDEF
+    b[1] = UNDEF
+    is_asserted_by { a.isin(b).is_masked.to_a == [1, 0, 0, 0, 0] }
+    is_asserted_by { a.union1d(b).to_a == [1, 2, 3, 4, 9] }
+    # --- float, fixlen and object
+    f = CA_FLOAT64([0.0, -0.0, 0.0/0.0, 1.5])
+    is_asserted_by { f.isin([0.0, 0.0/0.0]).to_a == [1, 1, 1, 0] }
+    s = CArray.fixlen(3, :bytes => 2)
+    s[] = ["ab", "cd", "ef"]
+    t = CArray.fixlen(2, :bytes => 2)
+    t[] = ["cd", "zz"]
+    is_asserted_by { s.isin(t).to_a == [0, 1, 0] }
+    is_asserted_by { s.setdiff1d(t).to_a == ["ab", "ef"] }
+    is_asserted_by { CA_OBJECT(["x", 1, :y]).isin(["x", :y]).to_a == [1, 0, 1] }
+    # --- merge of the sorted arrays for large arrays
+    x = CArray.int32(3_000_000).seq!.mul!(3)
+    y = CA_INT32([0, 1, 2, 3, 8_999_997, 9_000_000])
+    is_asserted_by { y.isin(x).to_a == [1, 0, 0, 1, 1, 0] }
+    is_asserted_by { y.intersect1d(x).to_a == [0, 3, 8_999_997] }
+    z = CArray.int32(100_000).seq!.mod!(1000)
+    is_asserted_by { z.union1d(y).to_a == ((0...1000).to_a + [8_999_997, 9_000_000]) }
+  end
+
+  example "set operations with mixed data types" do
+    a = CA_INT32([1, 2, 3, 4])
+    is_asserted_by { a.isin(CA_DOUBLE([2.0, 3.5])).to_a == [0, 1, 0, 0] }
+    is_asserted_by { a.isin([2.0, 3.5]).to_a == [0, 1, 0, 0] }
+    is_asserted_by { CA_INT32([1, 2, 3]).setdiff1d([2.7]).to_a == [1, 2, 3] }
+    is_asserted_by { CA_INT32([1, 2, 3]).intersect1d([2.0, 2.7]).to_a == [2] }
+    u = CA_INT32([1, 2, 3]).union1d([2.5])
+    is_asserted_by { u.data_type == CA_FLOAT64 and u.to_a == [1.0, 2.0, 2.5, 3.0] }
+    is_asserted_by { CA_INT32([1, 2, 3]).union1d([4]).data_type == CA_INT32 }
+    # --- out of range values
+    b = CA_UINT8([0, 1, 255])
+    c = CA_INT32([256, -1])
+    is_asserted_by { b.isin(c).to_a == [0, 0, 0] }
+    is_asserted_by { b.intersect1d(c).to_a == [] }
+    is_asserted_by { b.setdiff1d(c).to_a == [0, 1, 255] }
+    is_asserted_by { b.union1d(c).to_a == [-1, 0, 1, 255, 256] }
+    is_asserted_by { CA_INT32([1, 2]).isin(CA_DOUBLE([1e30, 2])).to_a == [0, 1] }
+    # --- float32 vs float64
+    f = CA_FLOAT32([0.5, 0.1, 0.0/0.0])
+    is_asserted_by { f.isin(CA_DOUBLE([0.5, 0.1, 0.0/0.0])).to_a == [1, 0, 1] }
+  end
 
   example "search" do
     # ---
@@ -143,4 +221,106 @@ describe "TestCArrayOrder " do
     is_asserted_by { [5, 4] == a.search_nearest_index(49.5) }
     
   end
+
+  example "radix sort" do
+    [:int8, :uint8, :int16, :uint16, :int32, :uint32, 
+     :int64, :uint64, :float32, :float64, :float128].each do |type|
+      a = CArray.new(type, [3000]).seq!
+      a.mul!(7919).add!(13) if a.integer?
+      a.mul!(7919).sin!.mul!(100) if a.float?
+      ref = a.to_a
+      is_asserted_by { a.sort.to_a == ref.sort }
+      is_asserted_by { a.sort_addr.to_a == (0...3000).sort_by { |i| [ref[i], i] } }
+    end
+    # --- NaN, -0.0 and infinities
+    f = CArray.float64(1000).seq!.cos!
+    f[10] = 0.0/0.0
+    f[20] = -1.0/0.0
+    f[30] = 1.0/0.0
+    f[40] = -0.0
+    s = f.sort
+    is_asserted_by { s[0] == -1.0/0.0 }
+    is_asserted_by { s[-2] == 1.0/0.0 }
+    is_asserted_by { s[-1].nan? }
+    is_asserted_by { f.sort_addr[-1] == 10 }
+    # --- stable with mask
+    m = CArray.int32(10) { [5, 3, 9, 1, 3, 7, 2, 8, 0, 4] }
+    m[2] = UNDEF
+    m[5] = UNDEF
+    is_asserted_by { m.sort_addr.to_a == [8, 3, 6, 1, 4, 9, 0, 7, 2, 5] }
+  end
+
+  example "lexsort" do
+    name = CArray.fixlen(8, :bytes => 2)
+    name[] = ["bb", "ab", "b\0", "ab", "a\0", "bb", "ab", "b\0"]
+    age  = CA_INT32([30, 20, 10, 20, 50, 10, 10, 40])
+    w    = CA_FLOAT128([1, 2, 3, 1, 2, 3, 1, 2])
+    idx  = CArray.lexsort(name, age, w)
+    na, aa, wa = name.to_a, age.to_a, w.to_a
+    is_asserted_by { idx.to_a == (0...8).sort_by { |i| [na[i], aa[i], wa[i], i] } }
+    is_asserted_by { idx.to_a == [4, 6, 3, 1, 2, 7, 5, 0] }
+    is_asserted_by { CArray.lexsort(age, name) == CA.sort_addr(age, name) }
+    # --- masked elements are placed at the end for each key
+    age[0] = UNDEF
+    is_asserted_by { CArray.lexsort(age, w).to_a == [6, 2, 5, 3, 1, 7, 4, 0] }
+    # --- object array is compared by <=>
+    o = CA_OBJECT([3, 1, 2, 1])
+    is_asserted_by { CArray.lexsort(o).to_a == [1, 3, 2, 0] }
+    expect { CArray.lexsort(CArray.int32(3), CArray.int32(4)) }.to raise_error(ArgumentError)
+  end
+
+  example "sorted_index" do
+    k = CA_DOUBLE([1, 2, 2, 4, 8, 16, 32])
+    si = k.sorted_index
+    q = CA_DOUBLE([0, 1, 2, 3, 4, 5, 31, 32, 33])
+    is_asserted_by { si.size == 7 }
+    is_asserted_by { si.keys == k }
+    is_asserted_by { si.lower_bound(q).to_a == [0, 0, 1, 3, 3, 4, 6, 6, 7] }
+    is_asserted_by { si.upper_bound(q).to_a == [0, 1, 3, 3, 4, 4, 6, 7, 7] }
+    is_asserted_by { si.bsearch(q) == k.bsearch(q) }
+    is_asserted_by { si.bsearch(4) == 3 }
+    is_asserted_by { si.bsearch(3) == nil }
+    # ---
+    x = CArray.float64(10001).seq!.sqrt
+    y = CArray.float64(1000).span!(-1..101)
+    y[10] = UNDEF
+    s = x.sorted_index
+    is_asserted_by { s.section(y) == x.section(y) }
+    is_asserted_by { s.section(y).is_masked.to_a == y.is_masked.to_a }
+    is_asserted_by { s.section(2.5) == x.section(2.5) }
+    is_asserted_by { s.lower_bound(x).to_a == (0...10001).to_a }
+    is_asserted_by { s.upper_bound(x[0..-2]).to_a == (1...10001).to_a }
+    # ---
+    expect { CA_DOUBLE([3, 1]).sorted_index }.to raise_error(ArgumentError)
+    expect { CA_DOUBLE([1, 0.0/0.0]).sorted_index }.to raise_error(ArgumentError)
+  end
+
+  example "sorted_index with duplicated keys" do
+    k = CA_DOUBLE([0, 1, 5, 5, 5, 6])
+    si = k.sorted_index
+    is_asserted_by { si.bsearch(5) == 2 }
+    is_asserted_by { si.bsearch(CA_DOUBLE([5, 1, 6])).to_a == [2, 1, 5] }
+    is_asserted_by { si.section(5) == 2.0 }
+    is_asserted_by { si.section(5.5) == 4.5 }
+    is_asserted_by { CA_DOUBLE([5, 5, 6]).sorted_index.section(5) == 0.0 }
+    is_asserted_by { CA_INT([0, 1, 5, 5, 5, 6]).sorted_index.section(5) == 2.0 }
+  end
+
+  example "sorted_index with int64 keys" do
+    b = 2**53
+    k = CA_INT64([b, b+1, b+2])
+    si = k.sorted_index
+    is_asserted_by { si.keys == k }
+    is_asserted_by { si.bsearch(b+1) == k.bsearch(b+1) }
+    is_asserted_by { si.bsearch(CA_INT64([b+2, b+3])).to_a == [2, UNDEF] }
+    is_asserted_by { si.lower_bound(b+1) == 1 }
+    is_asserted_by { si.upper_bound(b+1) == 2 }
+    is_asserted_by { si.section(b+1) == 1.0 }
+    is_asserted_by { si.section(CA_DOUBLE([0.5, 3.5])).to_a == [0.5, 3.5].map { (_1 - b)*1.0 } }
+    is_asserted_by { CA_INT([1, 2, 4]).sorted_index.bsearch(2.5) == nil }
+    is_asserted_by { CA_INT([1, 2, 4]).sorted_index.lower_bound(2.5) == 2 }
+    is_asserted_by { CA_INT([1, 2, 4]).sorted_index.section(3.0) == 1.5 }
+    expect { CArray.uint64(2) { 2**63 }.sorted_index }.to raise_error(ArgumentError)
+  end
+
 end
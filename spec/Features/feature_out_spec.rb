@@ -0,0 +1,88 @@
+require 'carray'
+require "rspec-power_assert"
+
+describe "Feature: out option" do
+
+  example "binop" do
+    a = CArray.float64(10).seq!
+    b = CArray.float64(10).seq!(1)
+    c = CArray.float64(10)
+    r = a.add(b, out: c)
+    is_asserted_by { r.equal?(c) }
+    is_asserted_by { c == a + b }
+    a.send(:*, 2, out: c)
+    is_asserted_by { c == a * 2 }
+    a.sub(b, out: a)
+    is_asserted_by { a == CArray.float64(10) { -1 } }
+  end
+
+  example "scalar operand and casting" do
+    a = CArray.int32(5).seq!
+    c = CArray.int32(5)
+    a.mul(3, out: c)
+    is_asserted_by { c == a * 3 }
+    d = CArray.float64(5)
+    a.add(1.5, out: d)
+    is_asserted_by { d == a + 1.5 }
+    expect { a.add(1.5, out: c) }.to raise_error(CArray::DataTypeError)
+    expect { a.add(1, out: CArray.int32(6)) }.to raise_error(RuntimeError)
+  end
+
+  example "monop, math function and comparison" do
+    a = CArray.float64(3, 3).seq!
+    c = CArray.float64(3, 3)
+    a.neg(out: c)
+    is_asserted_by { c == -a }
+    a.sqrt(out: c)
+    is_asserted_by { c == a.sqrt }
+    CAMath.sin(a, out: c)
+    is_asserted_by { c == CAMath.sin(a) }
+    i = CArray.int32(3, 3).seq!
+    i.exp(out: c)
+    is_asserted_by { c == i.exp }
+    b = CArray.boolean(3, 3)
+    a.gt(4, out: b)
+    is_asserted_by { b == (a > 4) }
+    a.lt(a.reverse, out: b)
+    is_asserted_by { b == (a < a.reverse) }
+    expect { CAMath.sin(1.0, out: c) }.to raise_error(ArgumentError)
+  end
+
+  example "virtual array as out" do
+    a = CArray.float64(4, 4).seq!
+    x = CArray.float64(4, 4) { 0 }
+    a[0..1, nil].add(a[2..3, nil], out: x[1..2, nil])
+    is_asserted_by { x[1..2, nil] == a[0..1, nil] + a[2..3, nil] }
+    is_asserted_by { x[0, nil].all_equal?(0) }
+    is_asserted_by { x[3, nil].all_equal?(0) }
+  end
+
+  example "mask" do
+    a = CArray.float64(5).seq!
+    a[1] = UNDEF
+    c = CArray.float64(5)
+    c[3] = UNDEF
+    a.mul(2, out: c)
+    is_asserted_by { c.is_masked == a.is_masked }
+    is_asserted_by { c == a * 2 }
+  end
+
+  example "CAMath functions written in C" do
+    a = CArray.float64(5).seq!(1)
+    a[1] = UNDEF
+    b = CArray.float64(5).seq!(2)
+    c = CArray.float64(5)
+    is_asserted_by { CAMath.atan2(a, b, out: c).equal?(c) }
+    is_asserted_by { c == CAMath.atan2(a, b) }
+    is_asserted_by { c.is_masked == a.is_masked }
+    CAMath.hypot(b, 3.0, out: c)
+    is_asserted_by { c == CAMath.hypot(b, 3.0) }
+    x = CArray.float64(2, 5)
+    CAMath.lgamma(b, out: x[1, nil])
+    is_asserted_by { x[1, nil] == CAMath.lgamma(b) }
+    expect { CAMath.atan2(a, b, out: CArray.float32(5)) }.to raise_error(CArray::DataTypeError)
+    expect { CAMath.hypot(a, b, out: CArray.float64(4)) }.to raise_error(RuntimeError)
+    expect { CAMath.atan2(a) }.to raise_error(ArgumentError)
+  end
+
+end
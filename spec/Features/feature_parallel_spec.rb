@@ -0,0 +1,98 @@
+require 'carray'
+require "rspec-power_assert"
+
+describe "Feature: Parallel execution of kernels" do
+
+  before do
+    @threads   = CArray.num_threads
+    @threshold = CArray.parallel_threshold
+    CArray.num_threads = 4
+    CArray.parallel_threshold = 16
+  end
+
+  after do
+    CArray.num_threads = @threads
+    CArray.parallel_threshold = @threshold
+  end
+
+  example "operators" do
+    a = CArray.float64(1000).seq!
+    b = CArray.float64(1000).seq!(1)
+    a[10] = UNDEF
+    x = a * b + 1
+    is_asserted_by { x.count_masked == 1 }
+    is_asserted_by { x[11..-1].to_a == (11..999).map { |i| i * (i + 1) + 1.0 } }
+    is_asserted_by { (a > 500).count_true == 499 }
+    is_asserted_by { a.sqrt[999] == Math.sqrt(999) }
+    c = CArray.int32(1000).seq!
+    c.add!(1)
+    is_asserted_by { c[0] == 1 and c[999] == 1000 }
+  end
+
+  example "zero division in parallel region" do
+    a = CArray.int32(1000) { 1 }
+    b = CArray.int32(1000) { 1 }
+    b[700] = 0
+    expect { a / b }.to raise_error(ZeroDivisionError)
+    expect { a % b }.to raise_error(ZeroDivisionError)
+    b[700] = UNDEF
+    is_asserted_by { (a / b).count_masked == 1 }
+  end
+
+  example "mapping array" do
+    a = CArray.int32(1000).seq!
+    idx = CArray.int64(1000).seq!.reverse
+    is_asserted_by { a[idx].to_ca == a.reverse }
+    a[idx] = a.reverse
+    is_asserted_by { a == CArray.int32(1000).seq! }
+  end
+
+  example "mapping array with duplicated index" do
+    idx = CArray.int64(1000).seq! % 10
+    v = CArray.int32(1000).seq!
+    5.times do
+      a = CArray.int32(10) { -1 }
+      a[idx] = v
+      is_asserted_by { a.to_a == (990..999).to_a }
+    end
+  end
+
+  example "reductions" do
+    a = CArray.float64(1000).seq!.sin!
+    a[10] = UNDEF
+    sum = a.sum
+    is_asserted_by { 3.times.all? { a.sum == sum } }
+    is_asserted_by { (sum - (a.to_a - [UNDEF]).sum).abs < 1e-12 }
+    is_asserted_by { a.count_valid == 999 }
+    is_asserted_by { (a.mean - sum/999).abs < 1e-15 }
+    is_asserted_by { a.variance == a.variance }
+    is_asserted_by { (a.wsum(a) - (a*a).sum).abs < 1e-12 }
+    b = CArray.float64(4, 1000).seq!.cos!
+    is_asserted_by { (b.sum(1)[2] - b[2, nil].to_a.sum).abs < 1e-12 }
+    CArray.num_threads = 1
+    is_asserted_by { (a.sum - sum).abs < 1e-12 }
+  end
+
+  example "sort" do
+    a = CArray.int32(10007).seq!.mul!(7919).add!(13)
+    is_asserted_by { a.sort.to_a == a.to_a.sort }
+    f = CArray.float64(10007).seq!.sin!
+    f[100] = 0.0/0.0
+    s = f.sort
+    is_asserted_by { s[0..-2].to_a == f.to_a.reject(&:nan?).sort }
+    is_asserted_by { s[-1].nan? }
+    r = f.to_a
+    is_asserted_by { f.sort_addr.to_a == (0...10007).sort_by { |i| [r[i].nan? ? 1 : 0, r[i].nan? ? 0 : r[i], i] } }
+    k = a % 5
+    is_asserted_by { CA.sort_addr(k, f).to_a == (0...10007).sort_by { |i| [k[i], r[i].nan? ? 1 : 0, r[i].nan? ? 0 : r[i], i] } }
+    x, y = k.sort_with(a)
+    is_asserted_by { x == k.sort }
+    is_asserted_by { y == a[CA.sort_addr(k)] }
+  end
+
+  example "configuration" do
+    expect { CArray.num_threads = 0 }.to raise_error(ArgumentError)
+    expect { CArray.parallel_threshold = 0 }.to raise_error(ArgumentError)
+  end
+
+end
@@ -0,0 +1,53 @@
+require 'carray'
+require "rspec-power_assert"
+
+describe "Feature: SIMD level" do
+
+  before do
+    @level = CArray.simd_level
+  end
+
+  after do
+    CArray.simd_level = @level
+  end
+
+  example "levels" do
+    is_asserted_by { CArray.simd_levels.first == "none" }
+    is_asserted_by { CArray.simd_levels.include?(CArray.simd_level) }
+    CArray.simd_level = :none
+    is_asserted_by { CArray.simd_level == "none" }
+    expect { CArray.simd_level = "sse2" }.to raise_error(ArgumentError)
+  end
+
+  example "all levels give the same results" do
+    a = CArray.float64(1001).seq!(-3, 0.01)
+    b = CArray.float64(1001).seq!(1, 0.5)
+    i = CArray.int32(1001).seq!(-500)
+    x = CArray.cmplx128(1001).seq!(1)
+    m = a.to_ca
+    m[[1, 7, 100]] = UNDEF
+    calc = lambda {
+      [ a + b, a * b - a / b, a.abs.sqrt, a.exp, a < b, a.abs, m * 2 + 1,
+        i * 3 + i % 7, i / 7, i & 0xff, i.float32 + 0.5, a.int16,
+        x * x, x.int32, b.float32.cmplx64, i.abs, i.uint8.abs, i.is_nan ]
+    }
+    expected = nil
+    CArray.simd_levels.each do |level|
+      CArray.simd_level = level
+      res = calc.call
+      expected ||= res
+      res.zip(expected).each do |r, e|
+        is_asserted_by { r.data_type == e.data_type }
+        is_asserted_by { r.is_masked == e.is_masked }
+        is_asserted_by { r == e }
+      end
+    end
+  end
+
+  example "abs of integer types" do
+    is_asserted_by { CA_INT64([-5_000_000_000, 3]).abs.to_a == [5_000_000_000, 3] }
+    is_asserted_by { CA_UINT8([200, 1]).abs.to_a == [200, 1] }
+    is_asserted_by { CA_INT8([-3, 4]).abs.data_type == CA_INT8 }
+  end
+
+end
@@ -0,0 +1,68 @@
+require 'carray'
+require "rspec-power_assert"
+
+describe "Feature: CAStatAccumulator" do
+
+  example "scalar statistics" do
+    a = CArray.float64(1000).seq!.sin!
+    acc = CAStatAccumulator.new
+    10.times { |i| acc << a[[i*100, 100]] }
+    is_asserted_by { acc.count == 1000 }
+    is_asserted_by { (acc.sum - a.sum).abs < 1e-12 }
+    is_asserted_by { (acc.mean - a.mean).abs < 1e-15 }
+    is_asserted_by { (acc.variance - a.variance).abs < 1e-15 }
+    is_asserted_by { (acc.stddevp - a.stddevp).abs < 1e-15 }
+    is_asserted_by { acc.min == a.min }
+    is_asserted_by { acc.max == a.max }
+  end
+
+  example "axis" do
+    x = CArray.float64(6, 4).seq!
+    x[2, 1] = UNDEF
+    acc = CAStatAccumulator.new(0)
+    acc << x[0..2, nil] << x[3..5, nil]
+    is_asserted_by { acc.dim == [4] }
+    is_asserted_by { acc.count.to_a == [6, 5, 6, 6] }
+    is_asserted_by { acc.mean == x.mean(0) }
+    is_asserted_by { acc.variance == x.variance(0) }
+    is_asserted_by { acc.min == x.min(0) }
+    is_asserted_by { acc.max == x.max(0) }
+    expect { acc << CArray.float64(3, 5) }.to raise_error(RuntimeError)
+  end
+
+  example "element by element" do
+    acc = CAStatAccumulator.new([])
+    5.times { |i| acc << CArray.int32(2, 2) { i } }
+    is_asserted_by { acc.dim == [2, 2] }
+    is_asserted_by { acc.mean.to_a == [[2.0, 2.0], [2.0, 2.0]] }
+    is_asserted_by { acc.variance.to_a == [[2.5, 2.5], [2.5, 2.5]] }
+    is_asserted_by { acc.min.data_type == CA_INT32 }
+    is_asserted_by { acc.max.to_a == [[4, 4], [4, 4]] }
+  end
+
+  example "merge" do
+    a = CArray.float64(1000).seq!.cos!
+    b1 = CAStatAccumulator.new
+    b1 << a[0...300]
+    b2 = CAStatAccumulator.new
+    b2 << a[300..-1]
+    m = b1.merge(b2)
+    is_asserted_by { m.count == 1000 and b1.count == 300 }
+    is_asserted_by { (m.mean - a.mean).abs < 1e-15 }
+    is_asserted_by { (m.variance - a.variance).abs < 1e-15 }
+    b1.merge!(b2)
+    is_asserted_by { b1.count == 1000 }
+    is_asserted_by { CAStatAccumulator.new.merge(b2).count == 700 }
+  end
+
+  example "no valid element" do
+    acc = CAStatAccumulator.new
+    is_asserted_by { acc.count == 0 }
+    is_asserted_by { acc.mean == UNDEF }
+    acc << CArray.int32(3) { UNDEF }
+    is_asserted_by { acc.count == 0 }
+    is_asserted_by { acc.max == UNDEF }
+    expect { CAStatAccumulator.new << CArray.object(3) }.to raise_error(CArray::DataTypeError)
+  end
+
+end
@@ -394,4 +394,175 @@ describe "TestCArrayStat " do
     is_asserted_by {  false == a.any_close?(1, 1.0e-05) }
   end
 
+  example "pairwise summation" do
+    a = CArray.float32(1000000) { 0.1 }
+    x = [0.1].pack("f").unpack1("f")
+    is_asserted_by { (a.sum - x*1000000).abs < 1e-6 }
+    is_asserted_by { (a.mean - x).abs < 1e-12 }
+    is_asserted_by { a.variance.abs < 1e-12 }
+    is_asserted_by { (a.wsum(a) - x*x*1000000).abs < 1e-6 }
+  end
+
+  example "describe" do
+    # ---
+    a = CArray.float64(3, 1000).seq!.sin!
+    a[1, 5] = UNDEF
+    h = a.describe
+    is_asserted_by { h[:count] == a.count_valid }
+    is_asserted_by { h[:min] == a.min }
+    is_asserted_by { h[:max] == a.max }
+    is_asserted_by { h[:min_addr] == a.min_addr }
+    is_asserted_by { h[:max_addr] == a.max_addr }
+    is_asserted_by { (h[:sum] - a.sum).abs < 1.0e-10 }
+    is_asserted_by { (h[:mean] - a.mean).abs < 1.0e-12 }
+    is_asserted_by { (h[:variance] - a.variance).abs < 1.0e-12 }
+    is_asserted_by { (h[:stddev] - a.stddev).abs < 1.0e-12 }
+
+    # --- axis
+    h = a.describe(1)
+    is_asserted_by { h[:count] == a.count_valid(1) }
+    is_asserted_by { h[:min] == a.min(1) }
+    is_asserted_by { h[:max_addr] == a.max_addr(1) }
+    is_asserted_by { (h[:mean] - a.mean(1)).abs.max < 1.0e-12 }
+    is_asserted_by { (h[:variance] - a.variance(1)).abs.max < 1.0e-12 }
+    h = a.describe(0)
+    is_asserted_by { h[:min].dim == [1000] }
+    is_asserted_by { (h[:sum] - a.sum(0)).abs.max < 1.0e-12 }
+    is_asserted_by { a.dimdescribe(1)[:max] == a.max(1) }
+
+    # --- int
+    h = CArray.int8(5).seq!.describe
+    is_asserted_by { h[:min].class == Integer }
+    is_asserted_by { h[:sum] == 10.0 }
+    is_asserted_by { h[:variance] == 2.5 }
+  end
+
+  example "describe with mask_limit" do
+    a = CArray.float32(2, 3, 4).seq!
+    a[0, 1, 2] = UNDEF
+    is_asserted_by { a.describe(mask_limit: 1)[:mean] == UNDEF }
+    is_asserted_by { a.describe(mask_limit: 2)[:mean] == a.mean }
+    h = a.describe(0, 2, min_count: 2, fill_value: -1)
+    is_asserted_by { h[:mean] == a.mean(0, 2, min_count: 2, fill_value: -1) }
+    is_asserted_by { h[:count] == a.count_valid(0, 2, min_count: 2, fill_value: -1) }
+    is_asserted_by { CArray.int32(0).describe[:count] == UNDEF }
+    expect { CArray.object(3).describe }.to raise_error(CArray::DataTypeError)
+  end
+
+  example "median" do
+    a = CArray.float64(101).seq!.sin!
+    s = a.to_a.sort
+    is_asserted_by { a.median == s[50] }
+    b = a[0..99]
+    t = b.to_a.sort
+    is_asserted_by { b.median == (t[49] + t[50])/2 }
+    c = CArray.int32(7, 9).seq!.reverse
+    is_asserted_by { c.median(1) == CA_FLOAT64((0...7).map { |i| c[i, nil].to_a.sort[4] }) }
+    is_asserted_by { c.median(0) == CA_FLOAT64((0...9).map { |j| c[nil, j].to_a.sort[3] }) }
+    m = CArray.float64(5) { [5, 1, 4, 2, 3] }
+    m[0] = UNDEF
+    is_asserted_by { m.median == 2.5 }
+    is_asserted_by { m.median(mask_limit: 1) == UNDEF }
+    is_asserted_by { CArray.float64(0).median == UNDEF }
+    expect { CArray.object(3).median }.to raise_error(CArray::DataTypeError)
+  end
+
+  example "percentile and quantile" do
+    a = CArray.float64(1001).seq!.cos!
+    s = a.to_a.sort
+    is_asserted_by { a.percentile(0, 50, 100) == [s[0], s[500], s[1000]] }
+    is_asserted_by { (a.percentile(25.05)[0] - (0.5*s[250] + 0.5*s[251])).abs < 1.0e-12 }
+    is_asserted_by { a.quantile == a.percentile(0, 25, 50, 75, 100) }
+    is_asserted_by { a.percentile(90, 10) == a.percentile(10, 90).reverse }
+    b = CArray.int16(4, 11).seq!
+    p1 = b.percentile(0, 50, 100, axis: 1)
+    is_asserted_by { p1.size == 3 }
+    is_asserted_by { p1[0] == b.min(1).float64 }
+    is_asserted_by { p1[1] == b.median(1) }
+    is_asserted_by { p1[2] == b.max(1).float64 }
+    is_asserted_by { b.percentile(50, axis: 0)[0] == b.median(0) }
+  end
+
+  example "nlargest and nsmallest" do
+    a = CArray.float64(1000).seq!.sin!
+    s = a.to_a.sort
+    is_asserted_by { a.nlargest(5).to_a == s.reverse[0, 5] }
+    is_asserted_by { a.nsmallest(5).to_a == s[0, 5] }
+    is_asserted_by { a[a.nlargest_addr(3)].to_a == s.reverse[0, 3] }
+    is_asserted_by { a.nsmallest(7, sorted: false).to_a.sort == s[0, 7] }
+    is_asserted_by { a.nlargest(0).empty? }
+    # --- ties (earlier element first)
+    b = CArray.int32(10).seq! % 3
+    is_asserted_by { b.nlargest_addr(4).to_a == [2, 5, 8, 1] }
+    is_asserted_by { b.nsmallest_addr(4).to_a == [0, 3, 6, 9] }
+    # --- ascending data
+    c = CArray.int64(100000).seq!
+    is_asserted_by { c.nlargest(1000) == c[-1..-1000] }
+    # --- mask
+    m = CArray.float64(5).seq!
+    m[1] = UNDEF
+    m[3] = UNDEF
+    is_asserted_by { m.nlargest(10).to_a == [4.0, 2.0, 0.0] }
+    is_asserted_by { m.nsmallest_addr(2).to_a == [0, 2] }
+    # --- NaN is placed after all numbers
+    nan = 0.0/0.0
+    f = CA_DOUBLE([0.5, 0.97, 0.2, nan, 0.9, nan, 0.1])
+    is_asserted_by { f.nlargest(3).to_a == [0.97, 0.9, 0.5] }
+    is_asserted_by { f.nlargest_addr(3).to_a == [1, 4, 0] }
+    is_asserted_by { f.nlargest(1)[0] == f.max }
+    is_asserted_by { f.nlargest_addr(1)[0] == f.max_addr }
+    is_asserted_by { f.nsmallest(3).to_a == [0.1, 0.2, 0.5] }
+    is_asserted_by { f.nlargest_addr(7).to_a == [1, 4, 0, 2, 6, 3, 5] }
+    is_asserted_by { f.float32.nlargest_addr(2).to_a == [1, 4] }
+    expect { CArray.cmplx64(3).nlargest(1) }.to raise_error(CArray::DataTypeError)
+  end
+
+  example "nlargest and nsmallest along axes" do
+    a = CArray.float64(4, 50).seq!.sin!
+    x = a.nlargest(3, 1)
+    is_asserted_by { x.dim == [4, 3] }
+    4.times do |i|
+      is_asserted_by { x[i, nil].to_a == a[i, nil].to_a.sort.reverse[0, 3] }
+    end
+    y = a.nsmallest_addr(2, 0)
+    is_asserted_by { y.dim == [50, 2] }
+    is_asserted_by { y[nil, 0] == a.min_addr(0).int64 }
+    d = CArray.float64(2, 3).seq!
+    d[0, 0..1] = UNDEF
+    z = d.nlargest(2, 1)
+    is_asserted_by { z.is_masked.to_a == [[0, 1], [0, 0]] }
+    is_asserted_by { z[1, nil].to_a == [5.0, 4.0] }
+  end
+
+  example "group_reduce" do
+    v = CA_FLOAT64([1, 2, 3, 4, 5, 6])
+    k = CA_INT32([2, 0, 2, 1, 0, 7])
+    # --- dense integer keys
+    g, r = v.group_reduce(k)
+    is_asserted_by { g.to_a == [0, 1, 2, 7] }
+    is_asserted_by { r.to_a == [7.0, 4.0, 4.0, 6.0] }
+    is_asserted_by { v.group_reduce(k, :mean)[1].to_a == [3.5, 4.0, 2.0, 6.0] }
+    is_asserted_by { v.group_reduce(k, :min)[1].to_a == [2.0, 4.0, 1.0, 6.0] }
+    is_asserted_by { v.group_reduce(k, :max)[1].to_a == [5.0, 4.0, 3.0, 6.0] }
+    is_asserted_by { v.group_reduce(k, :count)[1].to_a == [2, 1, 2, 1] }
+    g, r = v.group_reduce(k, :sum, sorted: false)
+    is_asserted_by { g.to_a == [2, 0, 1, 7] }
+    is_asserted_by { r.to_a == [4.0, 7.0, 4.0, 6.0] }
+    # --- hashed keys agree with the dense keys
+    is_asserted_by { v.group_reduce(k.int64 * 10**12)[1] == v.group_reduce(k)[1] }
+    is_asserted_by { v.group_reduce(k.float64, :max)[1] == v.group_reduce(k, :max)[1] }
+    s = CArray.fixlen(6, :bytes => 1)
+    s[] = ["c", "a", "c", "b", "a", "z"]
+    is_asserted_by { v.group_reduce(s, :mean)[1] == v.group_reduce(k, :mean)[1] }
+    # --- masked elements are skipped
+    v[5] = UNDEF
+    k[3] = UNDEF
+    g, r = v.group_reduce(k, :mean)
+    is_asserted_by { g.to_a == [0, 2, 7] }
+    is_asserted_by { r.is_masked.to_a == [0, 0, 1] }
+    is_asserted_by { v.group_reduce(k)[1].to_a == [7.0, 4.0, 0.0] }
+    expect { v.group_reduce(k, :foo) }.to raise_error(ArgumentError)
+    expect { v.group_reduce(CArray.int32(3)) }.to raise_error(ArgumentError)
+  end
+
 end
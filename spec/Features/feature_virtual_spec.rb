@@ -45,4 +45,78 @@ describe "TestCArrayVirtual " do
                   e.object_id] == e.ancestors.map{|x| x.object_id} }
   end
 
+
+  example "strided views" do
+    a = CArray.float64(6,8).seq!
+    s = a[1..-2, [nil,2]]
+    t = a[[nil,2], nil].transposed
+    r = a.reshape(8,6)
+    is_asserted_by { s.strided? && t.strided? && r.strided? && a.strided? }
+    is_asserted_by { false == a[CA_INT64([0,2])].strided? }
+    is_asserted_by { (s + 1) == (s.to_ca + 1) }
+    is_asserted_by { (t * t) == (t.to_ca * t.to_ca) }
+    is_asserted_by { (-t) == (-t.to_ca) }
+    is_asserted_by { (t > 20) == (t.to_ca > 20) }
+    is_asserted_by { (r - 1) == (r.to_ca - 1) }
+    is_asserted_by { (a[[nil,-1], nil] + 0) == a[[nil,-1], nil].to_ca }
+
+    ### in-place operation writes into the parent
+    b = a.to_ca
+    b[1..-2, [nil,2]].add!(100)
+    c = a.to_ca
+    c[1..-2, [nil,2]] = a[1..-2, [nil,2]].to_ca + 100
+    is_asserted_by { b == c }
+
+    ### overlapping operands give the same result as the copies
+    x = CArray.int32(10).seq!
+    x[1..-1].add!(x[0..-2])
+    is_asserted_by { x == CA_INT32([0, 1, 3, 5, 7, 9, 11, 13, 15, 17]) }
+
+    ### masked elements are handled by the attached operation
+    m = a.to_ca
+    m[0, 1] = UNDEF
+    is_asserted_by { 1 == (m[0..1, nil] + 1).count_masked }
+    is_asserted_by { 1 == (m[0..1, nil] > 0).count_masked }
+  end
+
+  example "view chains" do
+    a = CArray.int32(100, 8).seq!
+
+    ### nested blocks and transposes are folded on creation
+    b = a[10..99, nil][0..9, [2,2,2]]
+    is_asserted_by { b.start == [10, 2] && b.step == [1, 2] && b.size0 == [100, 8] }
+    is_asserted_by { b.parent.parent.equal?(a) }
+    is_asserted_by { b == a[10..19, [2,2,2]] }
+    b[] = 0
+    is_asserted_by { 0 == a[10..19, [2,2,2]].sum }
+    t = a.transposed.transposed
+    is_asserted_by { t == a }
+    r = a.reshape(8, 100)[1..2, 0..9]
+    is_asserted_by { r == a.to_ca.reshape(8, 100)[1..2, 0..9] }
+
+    ### the other chains are attached from the root in one pass
+    x = CArray.float64(30, 40).seq!
+    y = x.transposed[5..9, [nil,3]][1..3, nil]
+    z = x.to_ca.transposed.to_ca[5..9, [nil,3]].to_ca[1..3, nil].to_ca
+    is_asserted_by { y.strided? }
+    is_asserted_by { y.to_ca == z }
+    is_asserted_by { y.sum == z.sum }
+    is_asserted_by { x.transposed[1, nil].to_ca == x[nil, 1].to_ca }
+    y[] = 0
+    is_asserted_by { x.transposed[6..8, [nil,3]].to_ca == CArray.float64(3, 10) { 0 } }
+    y.fill(7)
+    is_asserted_by { x.transposed[6..8, [nil,3]].to_ca == CArray.float64(3, 10) { 7 } }
+    y.add!(1)
+    is_asserted_by { x.transposed[6..8, [nil,3]].to_ca == CArray.float64(3, 10) { 8 } }
+
+    ### masks
+    m = CArray.float64(6, 6).seq!
+    m[2, 3] = UNDEF
+    w = m.transposed[1..4, nil][nil, 1..4]
+    is_asserted_by { 1 == w.count_masked }
+    is_asserted_by { 1 == w.to_ca.count_masked }
+    w[0, 0] = UNDEF
+    is_asserted_by { 2 == m.count_masked }
+  end
+
 end